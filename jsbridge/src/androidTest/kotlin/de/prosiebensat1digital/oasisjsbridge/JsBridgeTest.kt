@@ -31,6 +31,8 @@ import org.junit.Before
 import org.junit.BeforeClass
 import org.junit.Test
 import timber.log.Timber
+import java.util.Collections
+import kotlin.concurrent.thread
 import kotlin.test.*
 
 interface TestJavaApiInterface : JsToJavaInterface {
@@ -89,6 +91,27 @@ class JsBridgeTest {
 
     companion object {
         const val ITERATION_COUNT = 1000  // for miniBenchmark
+        const val DEFERRED_ITERATION_COUNT = 10000  // for deferredBenchmark
+        const val JSON_ITERATION_COUNT = 10  // for jsonStringifyBenchmark
+        const val LIST_CONVERSION_SIZE = 10000  // for listConversionBenchmark
+        const val STRING_CONVERSION_LENGTH = 100000  // for stringConversionBenchmark
+        const val STRING_CONVERSION_ITERATION_COUNT = 20  // for stringConversionBenchmark
+
+        // Former JS implementation of the JSON serialization (used as reference)
+        const val REFERENCE_STRINGIFY_JS = """
+            function referenceStringify(value) {
+              if (value === undefined) return "";
+              return JSON.stringify(value, function(_key, value) {
+                if (value instanceof Error) {
+                  return Object.getOwnPropertyNames(value).reduce(function(acc, key) {
+                    acc[key] = value[key];
+                    return acc;
+                  }, {});
+                }
+                return value;
+              });
+            }
+        """
 
         @BeforeClass
         @JvmStatic
@@ -308,6 +331,24 @@ class JsBridgeTest {
         verify { jsToJavaFunctionMock(eq("localFileString")) }
     }
 
+    @Test
+    fun testEvaluateFile() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val file = context.cacheDir.resolve("testEvaluateFile.js")
+        file.writeText("globalThis.fileString = 'mapped file \u00e4\u00f6\u00fc \uD83D\uDE00';")
+
+        // WHEN
+        val ret = runBlocking {
+            subject.evaluateFile(file)
+            subject.evaluate<String>("globalThis.fileString")
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals("mapped file \u00e4\u00f6\u00fc \uD83D\uDE00", ret)
+    }
+
     @Test
     fun testEvaluateLocalFileNonExisting() {
         // GIVEN
@@ -555,6 +596,55 @@ class JsBridgeTest {
         assertEquals("Eagle name: EAGLE as a BIRD", ret)
     }
 
+    @Test
+    fun testSetJsModuleLoaderWithPrefetch() {
+        if (BuildConfig.FLAVOR == "duktape") {
+            // ES6 modules are not supported on Duktape
+            return
+        }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val moduleContents = mapOf(
+            "main.js" to """
+                import * as eagle from "animals/eagle.js";
+                import { getName as getSparrowName } from "./animals/sparrow.js";
+                export default function main() { return eagle.getName() + ", " + getSparrowName() };
+            """.trimIndent(),
+            "animals/eagle.js" to """
+                import * as bird from "./bird.js"
+                export function getName() { return "EAGLE as a " + bird.getName() };
+            """.trimIndent(),
+            "animals/sparrow.js" to "export { getName } from '../animals/bird.js';",
+            "animals/bird.js" to "export function getName() { return 'BIRD' };"
+        )
+        val loadedModules = Collections.synchronizedList(mutableListOf<String>())
+        val cacheDir = InstrumentationRegistry.getInstrumentation().targetContext.cacheDir.resolve("testSetJsModuleLoaderWithPrefetch")
+
+        // WHEN
+        subject.setJsModuleLoader(prefetchImports = true, compiledModuleCacheDir = cacheDir) { moduleName ->
+            loadedModules.add(moduleName)
+            moduleContents[moduleName] ?: throw JsBridgeError.JsFileEvaluationError(moduleName)
+        }
+
+        val ret = runBlocking {
+            subject.evaluateFileContent("""
+                    import main from "main.js"
+                    globalThis.entryPoint = function() {
+                        return main();
+                    }
+                """.trimIndent(), "moduleLoader", JsBridge.JsFileEvaluationType.Module)
+
+            subject.evaluate<String>("globalThis.entryPoint()");
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals("EAGLE as a BIRD, BIRD", ret)
+        assertEquals(moduleContents.keys.sorted(), loadedModules.sorted())
+        assertTrue(cacheDir.list().orEmpty().isNotEmpty())
+    }
+
     @Test
     fun testSetJsModuleLoaderError() {
         if (BuildConfig.FLAVOR == "duktape") {
@@ -596,6 +686,91 @@ class JsBridgeTest {
         assertEquals("non-existing.js", rootCause.fileName)
     }
 
+    @Test
+    fun testJsValuePropertiesAndCalls() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val jsObject = JsValue(subject, """({
+            a: 1,
+            b: "two",
+            list: [1, 2, 3],
+            get broken() { throw new Error("Broken getter"); },
+            sum: function(x, y) { return this.a + x + y; },
+            later: function() { return Promise.resolve(this.b); }
+        })""")
+        val jsFunction = JsValue(subject, "(function(s, o) { return s + (o ? o.a : 0); })")
+        val jsPrimitive = JsValue(subject, "42")
+
+        runBlocking {
+            // WHEN
+            val a: Int = jsObject.getProperty("a")
+            val b: String = jsObject.getProperty("b")
+            val list: List<Int> = jsObject.getProperty("list")
+            val missing: String? = jsObject.getProperty("missing")
+            jsObject.setProperty("c", TestDataPoint(1, 2.5, "p", null))
+            jsObject.setProperty("d", listOf("x", "y"))
+            val c: TestDataPoint = jsObject.getProperty("c")
+            val cLabel: String = subject.evaluate("$jsObject.c.label")
+            val d: List<String> = subject.evaluate("$jsObject.d")
+            val keys = jsObject.keys()
+            val sum: Int = jsObject.callMethod("sum", 2, 3)
+            val later: String = jsObject.callMethod("later")
+            val called: String = jsFunction.callFunction("a", jsObject)
+
+            // THEN
+            assertEquals(1, a)
+            assertEquals("two", b)
+            assertEquals(listOf(1, 2, 3), list)
+            assertNull(missing)
+            assertEquals(TestDataPoint(1, 2.5, "p", null), c)
+            assertEquals("p", cLabel)
+            assertEquals(listOf("x", "y"), d)
+            assertEquals(listOf("a", "b", "list", "broken", "sum", "later", "c", "d"), keys)
+            assertTrue(jsObject.hasProperty("sum"))
+            assertTrue(jsObject.hasProperty("toString"))  // inherited, like "in"
+            assertFalse(jsObject.hasProperty("missing"))
+            assertFalse(jsPrimitive.hasProperty("a"))
+            assertEquals(emptyList(), jsPrimitive.keys())
+            assertEquals(6, sum)
+            assertEquals("two", later)
+            assertEquals("a1", called)
+
+            val getterError = assertFailsWith<JsException> {
+                jsObject.getProperty<Int>("broken")
+            }
+            assertTrue(getterError.message?.contains("Broken getter") == true)
+            assertFailsWith<IllegalArgumentException> {
+                jsObject.callMethod<Unit>("b")  // not a function
+            }
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testJsValueBatchedRelease() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val jsValues = (0 until 200).map { JsValue(subject, "({ index: $it })") }
+        val jsNames = jsValues.map { it.toString() }
+        runBlocking { jsValues.last().evaluate<Any?>() }
+
+        // WHEN
+        // Released from several threads (like finalizers)
+        jsValues.chunked(50).map { chunk ->
+            Thread { chunk.forEach { it.release() } }.apply { start() }
+        }.forEach { it.join() }
+        val keptValue = JsValue(subject, "123")
+
+        // THEN
+        val remainingCount: Int = subject.evaluateBlocking(
+            "${jsNames.joinToString(prefix = "[", postfix = "]") { "\"$it\"" }}.filter(function(name) { return name in globalThis; }).length")
+        assertEquals(0, remainingCount)
+        assertEquals(123, keptValue.evaluateBlocking<Int>())
+
+        assertTrue(errors.isEmpty())
+    }
+
     @Test
     fun testJsValue() {
         // GIVEN
@@ -710,6 +885,161 @@ class JsBridgeTest {
         assertTrue(errors.isEmpty())
     }
 
+    @Test
+    fun testLargeJsonObjectWrapper() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val stringifyJsonObject: suspend (JsonObjectWrapper) -> String =
+            JsValue.newFunction(subject, "o", "return JSON.stringify(o);")
+                .createJavaToJsProxyFunction1()
+
+        runBlocking {
+            // WHEN
+            // (several hundred KB with non-ASCII and supplementary characters)
+            val jsonObject: JsonObjectWrapper = subject.evaluate("""
+                var largeObject = { items: [] };
+                for (var i = 0; i < 5000; i++) {
+                  largeObject.items.push({ id: i, title: "Tïtle \u65e5\u672c #" + i, emoji: "\ud83d\ude00", text: "Lorem ipsum dolor sit amet, consectetur adipiscing elit" });
+                }
+                largeObject""".trimIndent()
+            )
+            val jsonString: String = subject.evaluate("JSON.stringify(largeObject)")
+
+            // THEN
+            assertTrue(jsonObject.jsonString.length > 400_000)
+            assertEquals(jsonString, jsonObject.jsonString)
+            assertTrue(jsonObject.jsonString.contains("\uD83D\uDE00"))
+            assertEquals(jsonString, stringifyJsonObject(jsonObject))
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testJsonObjectWrapperSerialization() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        subject.evaluateBlocking<Unit>(REFERENCE_STRINGIFY_JS)
+        val values = listOf(
+            "({a: 1, b: 'x', c: [1, 2, {d: null}], e: undefined, f: function() {}})",
+            "[undefined, function() {}, 1.5, -0, 1e21, 1e-7, NaN, Infinity, 9007199254740993]",
+            "({'2': 1, '1': 2, b: 3, a: 4})",
+            "'\\b\\f\\n\\r\\t\\u0001 \\\"quoted\\\" \\\\ \\u2028 h\\u00e9llo \\ud83d\\ude00'",
+            "({d: new Date(0), o: {toJSON: function(key) { return 'key=' + key; }}})",
+            "[new Number(1), new String('s'), new Boolean(false)]",
+            "(function() { var e = new TypeError('bad'); e.code = 42; e.cause = new Error('inner'); delete e.stack; delete e.cause.stack; return {error: e}; })()",
+            "Object.defineProperty({visible: 1}, 'hidden', {value: 2, enumerable: false})"
+        )
+
+        runBlocking {
+            values.forEach { value ->
+                // WHEN
+                val jsonObject: JsonObjectWrapper = subject.evaluate(value)
+                val expectedJsonString: String = subject.evaluate("referenceStringify($value)")
+
+                // THEN
+                assertEquals(expectedJsonString, jsonObject.jsonString)
+            }
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testJsonObjectWrapperSerializationOfBigInt() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        runBlocking {
+            // BigInt is only available when the JS engine is built with it
+            if (!subject.evaluate<Boolean>("typeof BigInt === 'function'")) return@runBlocking
+
+            // WHEN
+            val bigIntError = assertFailsWith<JsException> {
+                subject.evaluate<JsonObjectWrapper>("({a: 1, b: BigInt(2)})")
+            }
+
+            // THEN (same as JSON.stringify())
+            assertTrue(bigIntError.message?.contains("BigInt value can't be serialized") == true)
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testPayload() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val stringifyPayloadObject: suspend (PayloadObject) -> String =
+            JsValue.newFunction(subject, "o", "return JSON.stringify(o);")
+                .createJavaToJsProxyFunction1()
+        val objectJs = """({
+            a: 1, b: "x", c: [1, 2.5, {d: null}, undefined, function() {}], e: undefined, f: function() {},
+            g: 3000000000, h: true, i: "h\u00e9llo \ud83d\ude00", j: new Date(0), k: {l: {m: [[]]}}
+        })"""
+
+        runBlocking {
+            // WHEN
+            val payloadObject: PayloadObject = subject.evaluate(objectJs)
+            val payloadArray: PayloadArray = subject.evaluate("""[1, "two", [3], {four: 4}, null]""")
+            val jsonObject: JsonObjectWrapper = subject.evaluate(objectJs)
+            val roundTripJsonString = stringifyPayloadObject(payloadObject)
+
+            // THEN
+            assertEquals(jsonObject.toPayloadObject(), payloadObject)
+            assertEquals("""[1, "two", [3], {"four": 4}, null]""".toPayloadArray(), payloadArray)
+            assertEquals(jsonObject.toPayloadObject(), roundTripJsonString.toPayloadObject())
+            assertNull(subject.evaluate<PayloadObject?>("null"))
+
+            assertFailsWith<IllegalArgumentException> { subject.evaluate<PayloadObject>("[1, 2]") }
+            assertFailsWith<IllegalArgumentException> { subject.evaluate<PayloadArray>("({})") }
+            assertFailsWith<IllegalArgumentException> { subject.evaluate<PayloadObject>("var o = {}; o.self = o; o") }
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    data class TestDataPoint(val x: Int, val y: Double, val label: String?, val weight: Int?)
+    data class TestDataShape(val name: String, val points: List<TestDataPoint>, val parent: TestDataShape?)
+
+    @Test
+    fun testDataClass() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val shapeJs = """({
+            name: "triangle",
+            points: [{x: 1, y: 2.5, label: "a", weight: 3}, {x: 4, y: 5.5, label: null}, {x: 7, y: 8}],
+            parent: {name: "root", points: [], parent: null}
+        })"""
+        val expectedShape = TestDataShape("triangle", listOf(
+            TestDataPoint(1, 2.5, "a", 3),
+            TestDataPoint(4, 5.5, null, null),
+            TestDataPoint(7, 8.0, null, null),
+        ), TestDataShape("root", listOf(), null))
+        val stringifyShape: suspend (TestDataShape) -> String =
+            JsValue.newFunction(subject, "o", "return JSON.stringify(o);")
+                .createJavaToJsProxyFunction1()
+
+        runBlocking {
+            // WHEN
+            val shape: TestDataShape = subject.evaluate(shapeJs)
+            val point: TestDataPoint = subject.evaluate("({x: 1, y: 2, label: \"p\", weight: null})")
+            val shapeJson = stringifyShape(expectedShape)
+
+            // THEN
+            assertEquals(expectedShape, shape)
+            assertEquals(TestDataPoint(1, 2.0, "p", null), point)
+            assertEquals(
+                """{"name":"triangle","points":[{"x":1,"y":2.5,"label":"a","weight":3},{"x":4,"y":5.5,"label":null,"weight":null},{"x":7,"y":8,"label":null,"weight":null}],"parent":{"name":"root","points":[],"parent":null}}""",
+                shapeJson
+            )
+            assertNull(subject.evaluate<TestDataPoint?>("null"))
+            assertFailsWith<IllegalArgumentException> { subject.evaluate<TestDataPoint>("12") }
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
     @Test
     fun testGenericJavaObject() {
         // GIVEN
@@ -748,6 +1078,66 @@ class JsBridgeTest {
         }
     }
 
+    @Test
+    fun testSettledPromiseFastPath() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val fulfilledValue: Int = subject.evaluateBlocking("Promise.resolve(42)")
+        val fulfilledDeferred: Deferred<String> = subject.evaluateBlocking("Promise.resolve('done')")
+        val pendingDeferred: Deferred<Int> = subject.evaluateBlocking(
+            "new Promise(function(resolve) { setTimeout(function() { resolve(69); }, 10); })")
+
+        // THEN
+        assertEquals(42, fulfilledValue)
+        assertTrue(fulfilledDeferred.isCompleted)
+        assertEquals("done", runBlocking { fulfilledDeferred.await() })
+        assertEquals(69, runBlocking { pendingDeferred.await() })
+        assertFailsWith<JsException> {
+            subject.evaluateBlocking<Int>("Promise.reject(new Error('rejected'))")
+        }
+        assertTrue(unhandledPromiseErrors.isEmpty())
+        assertTrue(errors.isEmpty())
+    }
+
+    interface BatchedDeferredJavaApi: JsToJavaInterface {
+        fun getValueAsync(i: Int): Deferred<Int>
+    }
+
+    @Test
+    fun testBatchedJavaDeferredCompletion() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val deferreds = (0 until 20).map { CompletableDeferred<Int>() }
+        val javaApi = object: BatchedDeferredJavaApi {
+            override fun getValueAsync(i: Int): Deferred<Int> = deferreds[i]
+        }
+        val javaApiJsValue = JsValue.createJsToJavaProxy(subject, javaApi)
+        val resultDeferred: Deferred<String> = subject.evaluateBlocking("""
+            |var promises = [];
+            |for (var i = 0; i < 20; i++) {
+            |  promises.push($javaApiJsValue.getValueAsync(i).then(
+            |    function(v) { return 'ok' + v; },
+            |    function(e) { return 'error:' + e.message; }
+            |  ));
+            |}
+            |Promise.all(promises).then(function(results) { return results.join(','); });
+            |""".trimMargin())
+
+        // WHEN
+        // Settled at the same time (completed in JS in a single batch)
+        deferreds.forEachIndexed { i, deferred ->
+            if (i == 5) deferred.completeExceptionally(Exception("failed5")) else deferred.complete(i)
+        }
+
+        // THEN
+        val expected = (0 until 20).joinToString(",") { if (it == 5) "error:failed5" else "ok$it" }
+        assertEquals(expected, runBlocking { resultDeferred.await() })
+        assertTrue(errors.isEmpty())
+        javaApiJsValue.hold()
+    }
+
     @Test
     fun testUnhandledPromiseRejection() {
         // GIVEN
@@ -771,6 +1161,35 @@ class JsBridgeTest {
         assertEquals("Test unhandled promise rejection", unhandledJsPromiseError?.jsException?.jsonValue?.toPayloadObject()?.getString("message"))
     }
 
+    @Test
+    fun testRunJobs() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        runBlocking {
+            val initialDrainedJobCount = subject.getDrainedJobCount()
+
+            // WHEN
+            subject.evaluate<Unit>("""
+                globalThis.promiseChainResult = 0;
+                var p = Promise.resolve();
+                for (var i = 0; i < 10; i++) {
+                  p = p.then(function() { globalThis.promiseChainResult++; });
+                }""".trimIndent()
+            )
+
+            // THEN
+            // (pending jobs are automatically executed after the evaluation)
+            assertEquals(10, subject.evaluate<Int>("globalThis.promiseChainResult"))
+            assertFalse(subject.runJobs())
+            if (BuildConfig.HAS_BUILTIN_PROMISE) {
+                assertTrue(subject.getDrainedJobCount() - initialDrainedJobCount >= 10)
+            }
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
     @Test
     fun testJsErrorStack() {
         // GIVEN
@@ -1132,85 +1551,526 @@ class JsBridgeTest {
             m
         }
 
-        // Java loop, evaluate JS string
-        // -> 78s (Duktape, Samsung S5, 100000 iterations, from main thread)
-        // -> 53s (Duktape, Samsung S5, 100000 iterations, from JS thread)
-        // -> 216s (QuickJS, Samsung S5, 100000 iterations, from main thread)
-        // -> 54s (QuickJS, Samsung S5, 100000 iterations, from JS thread)
-        val calcMagicEvaluateJsInsideJavaLoop: suspend () -> Int = {
-            var m = 0
-            for (i in 0 until ITERATION_COUNT) {
-                m = subject.evaluate("""
-                  |var n = $m + $i * 2;
-                  |if (n > 1000000) n = -n;
-                  |n;
-                """.trimMargin())
-            }
-            m
+        // Java loop, evaluate JS string
+        // -> 78s (Duktape, Samsung S5, 100000 iterations, from main thread)
+        // -> 53s (Duktape, Samsung S5, 100000 iterations, from JS thread)
+        // -> 216s (QuickJS, Samsung S5, 100000 iterations, from main thread)
+        // -> 54s (QuickJS, Samsung S5, 100000 iterations, from JS thread)
+        val calcMagicEvaluateJsInsideJavaLoop: suspend () -> Int = {
+            var m = 0
+            for (i in 0 until ITERATION_COUNT) {
+                m = subject.evaluate("""
+                  |var n = $m + $i * 2;
+                  |if (n > 1000000) n = -n;
+                  |n;
+                """.trimMargin())
+            }
+            m
+        }
+
+        // JS loop, call Java functions (191ms for 20000 iterations)
+        // -> 3.7s ms (Duktape, Samsung S5, 100000 iterations)
+        // -> 5.5s ms (QuickJS, Samsung S5, 100000 iterations)
+        val updateMagicJavaFuncJsValue = JsValue.createJsToJavaProxyFunction2(subject) { a: Int, i: Int ->
+            var n = a + i * 2
+            if (n > 1000000) n = -n
+            n
+        }
+        val calcMagicCallJavaFunctionInsideJsLoop: suspend () -> Int = JsValue.newFunction(subject, """
+            |var m = 0
+            |for (var i = 0; i < $ITERATION_COUNT; ++i) {
+            |  m = $updateMagicJavaFuncJsValue(m, i)
+            |}
+            |return m;
+            |""".trimMargin()
+        ).createJavaToJsProxyFunction0()
+
+        runBlocking {
+            delay(500)
+
+            Timber.i("Executing calcMagicJavaFunc()...")
+            val expectedResult = calcMagicJavaFunc()
+            Timber.i("-> result is $expectedResult")
+
+            Timber.i("Executing calcMagicJsFunc()...")
+            var result = calcMagicJsFunc()
+            Timber.i("-> result is $result")
+            assertEquals(expectedResult, result)
+
+            Timber.i("Executing calcMagicCallJsFunctionInsideJavaLoop()...")
+            result = calcMagicCallJsFunctionInsideJavaLoop()
+            Timber.i("-> result is $result")
+            assertEquals(expectedResult, result)
+
+            Timber.i("Executing calcMagicCallJsFunctionInsideJavaLoop() in JS thread...")
+            withContext(subject.coroutineContext) {
+                result = calcMagicCallJsFunctionInsideJavaLoop()
+                Timber.i("-> result is $result")
+                assertEquals(expectedResult, result)
+            }
+
+            Timber.i("Executing calcMagicEvaluateJsInsideJavaLoop()...")
+            result = calcMagicEvaluateJsInsideJavaLoop()
+            Timber.i("-> result is $result")
+            assertEquals(expectedResult, result)
+
+            Timber.i("Executing calcMagicEvaluateJsInsideJavaLoop() in JS thread...")
+            withContext(subject.coroutineContext) {
+                result = calcMagicEvaluateJsInsideJavaLoop()
+                Timber.i("-> result is $result")
+                assertEquals(expectedResult, result)
+            }
+
+            Timber.i("Executing calcMagicCallJavaFunctionInsideJsLoop()...")
+            result = calcMagicCallJavaFunctionInsideJsLoop()
+            Timber.i("-> result is $result")
+            assertEquals(expectedResult, result)
+
+            // Make sure that the JS value does not create garbage-collected as calcMagicMixed3Func()
+            // access the value by its name!
+            updateMagicJavaFuncJsValue.hold()
+        }
+    }
+
+    interface DeferredBenchmarkJavaApi: JsToJavaInterface {
+        fun getValueAsync(i: Int): Deferred<Int>
+    }
+
+    @Test
+    fun deferredBenchmark() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val javaApi = object: DeferredBenchmarkJavaApi {
+            override fun getValueAsync(i: Int): Deferred<Int> = CompletableDeferred(i)
+        }
+        val javaApiJsValue = JsValue.createJsToJavaProxy(subject, javaApi)
+
+        // JS loop, each iteration awaits a Java Deferred (= Java -> JS promise completion)
+        val js = """
+            |var promises = [];
+            |for (var i = 0; i < $DEFERRED_ITERATION_COUNT; i++) {
+            |  promises.push($javaApiJsValue.getValueAsync(i));
+            |}
+            |Promise.all(promises).then(function(values) {
+            |  var sum = 0;
+            |  for (var i = 0; i < values.length; i++) sum += values[i];
+            |  return sum;
+            |});
+            |""".trimMargin()
+
+        runBlocking {
+            delay(500)
+
+            // WHEN
+            Timber.i("Completing $DEFERRED_ITERATION_COUNT Java Deferreds in JS...")
+            val startTime = System.currentTimeMillis()
+            val result: Long = subject.evaluate(js)
+            Timber.i("-> result is $result (${System.currentTimeMillis() - startTime}ms)")
+
+            // THEN
+            val expectedResult = (0 until DEFERRED_ITERATION_COUNT).sumOf { it.toLong() }
+            assertEquals(expectedResult, result)
+        }
+
+        assertTrue(errors.isEmpty())
+        javaApiJsValue.hold()
+    }
+
+    @Test
+    fun jsonStringifyBenchmark() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        subject.evaluateBlocking<Unit>(REFERENCE_STRINGIFY_JS)
+        subject.evaluateBlocking<Unit>("""
+            |function createNestedObject(depth) {
+            |  if (depth == 0) return {id: 12345, name: "n\u00e9me", ratio: 0.75, ok: true, tags: ["a", "b"], nil: null};
+            |  var o = {list: [1, 2, 3.5]};
+            |  for (var i = 0; i < 6; i++) o["child" + i] = createNestedObject(depth - 1);
+            |  return o;
+            |}
+            |var nestedObject = createNestedObject(5);
+            |""".trimMargin()
+        )
+
+        runBlocking {
+            delay(500)
+
+            // JSON.stringify() with a JS replacer function called for each value
+            Timber.i("Stringifying nested object in JS (x$JSON_ITERATION_COUNT)...")
+            var startTime = System.currentTimeMillis()
+            var expectedJsonString = ""
+            for (i in 0 until JSON_ITERATION_COUNT) {
+                expectedJsonString = subject.evaluate("referenceStringify(nestedObject)")
+            }
+            Timber.i("-> ${expectedJsonString.length} chars (${System.currentTimeMillis() - startTime}ms)")
+
+            // Native serializer
+            Timber.i("Stringifying nested object natively (x$JSON_ITERATION_COUNT)...")
+            startTime = System.currentTimeMillis()
+            var jsonObject = JsonObjectWrapper.Undefined as JsonObjectWrapper
+            for (i in 0 until JSON_ITERATION_COUNT) {
+                jsonObject = subject.evaluate("nestedObject")
+            }
+            Timber.i("-> ${jsonObject.jsonString.length} chars (${System.currentTimeMillis() - startTime}ms)")
+
+            // THEN
+            assertEquals(expectedJsonString, jsonObject.jsonString)
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun listConversionBenchmark() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val javaList = List(LIST_CONVERSION_SIZE) { "item$it" }
+        val jsLength: suspend (List<String>) -> Int =
+            JsValue.newFunction(subject, "l", "return l.length;")
+                .createJavaToJsProxyFunction1()
+        subject.evaluateBlocking<Unit>("""var jsList = Array.from({length: $LIST_CONVERSION_SIZE}, function(_, i) { return "item" + i; });""")
+
+        runBlocking {
+            delay(500)
+
+            // WHEN
+            Timber.i("Converting a list of $LIST_CONVERSION_SIZE strings from JS to Java...")
+            var startTime = System.currentTimeMillis()
+            val listFromJs: List<String> = subject.evaluate("jsList")
+            Timber.i("-> ${System.currentTimeMillis() - startTime}ms")
+
+            Timber.i("Converting a list of $LIST_CONVERSION_SIZE strings from Java to JS...")
+            startTime = System.currentTimeMillis()
+            val length = jsLength(javaList)
+            Timber.i("-> ${System.currentTimeMillis() - startTime}ms")
+
+            // THEN
+            assertEquals(javaList, listFromJs)
+            assertEquals(LIST_CONVERSION_SIZE, length)
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun stringConversionBenchmark() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val corpora = mapOf(
+            "ASCII" to buildString { repeat(STRING_CONVERSION_LENGTH) { append('a' + it % 26) } },
+            "Latin-1" to buildString { repeat(STRING_CONVERSION_LENGTH) { append('\u00e0' + it % 32) } },
+            "CJK" to buildString { repeat(STRING_CONVERSION_LENGTH) { append('\u4e00' + it % 2000) } },
+            "mixed" to buildString {
+                repeat(STRING_CONVERSION_LENGTH) {
+                    when {
+                        it % 1000 == 0 -> append("\u0000\uD83D\uDE00")  // NUL and non-BMP character
+                        it % 10 < 7 -> append('a' + it % 26)
+                        else -> append('\u4e00' + it % 2000)
+                    }
+                }
+            }
+        )
+        val jsIdentity: suspend (String) -> String =
+            JsValue.newFunction(subject, "s", "return s;")
+                .createJavaToJsProxyFunction1()
+
+        runBlocking {
+            delay(500)
+
+            corpora.forEach { (name, corpus) ->
+                // WHEN
+                Timber.i("Converting a $name string (${corpus.length} chars) from Java to JS and back (x$STRING_CONVERSION_ITERATION_COUNT)...")
+                val startTime = System.currentTimeMillis()
+                var result = ""
+                for (i in 0 until STRING_CONVERSION_ITERATION_COUNT) {
+                    result = jsIdentity(corpus)
+                }
+                Timber.i("-> ${System.currentTimeMillis() - startTime}ms")
+
+                // THEN
+                assertEquals(corpus, result)
+            }
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testNulCharactersInCode() {
+        // GIVEN
+        val subjects = listOf(
+            createAndSetUpJsBridge(),
+            createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+                xhrConfig.okHttpClient = okHttpClient
+                scriptCacheConfig.enabled = true
+            })
+        )
+
+        subjects.forEach { subject ->
+            runBlocking {
+                // WHEN
+                val evaluated: String = subject.evaluate("'a\u0000b' + 'c'")
+                val assigned: String = JsValue(subject, "'d\u0000e'").evaluate()
+                val jsConcat: suspend (String) -> String =
+                    JsValue.newFunction(subject, "s", "return s + '\u0000' + s;")
+                        .createJavaToJsProxyFunction1()
+                val concatenated = jsConcat("f")
+                val jsObject = JsValue(subject, "({ 'g\u0000h': 1 })")
+                jsObject.setProperty("i\u0000j", 2)
+                val g: Int = jsObject.getProperty("g\u0000h")
+                val i: Int = jsObject.getProperty("i\u0000j")
+                val keys = jsObject.keys()
+
+                // THEN
+                assertEquals("a\u0000bc", evaluated)
+                assertEquals("d\u0000e", assigned)
+                assertEquals("f\u0000f", concatenated)
+                assertEquals(1, g)
+                assertEquals(2, i)
+                assertEquals(listOf("g\u0000h", "i\u0000j"), keys)
+                assertFalse(jsObject.hasProperty("g"))
+            }
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testScriptCache() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.okHttpClient = okHttpClient
+            scriptCacheConfig.enabled = true
+            scriptCacheConfig.maxEntryCount = 2
+        })
+
+        runBlocking {
+            val initialStats = subject.getScriptCacheStats()
+
+            // WHEN
+            val results = listOf("1 + 1", "2 + 2", "1 + 1", "3 + 3", "2 + 2")
+                .map { subject.evaluate<Int>(it) }
+            val jsAdd: suspend (Int, Int) -> Int = JsValue.newFunction(subject, "a", "b", "return a + b;")
+                .createJavaToJsProxyFunction2()
+            val jsAdd2: suspend (Int, Int) -> Int = JsValue.newFunction(subject, "a", "b", "return a + b;")
+                .createJavaToJsProxyFunction2()
+            val sums = listOf(jsAdd(1, 2), jsAdd2(3, 4))
+            val stats = subject.getScriptCacheStats()
+
+            // THEN
+            assertEquals(listOf(2, 4, 2, 6, 4), results)
+            assertEquals(listOf(3, 7), sums)
+            // "1 + 1" (2nd) and the 2nd function, "2 + 2" (2nd) has been evicted by "3 + 3"
+            assertEquals(initialStats.hitCount + 2, stats.hitCount)
+            assertEquals(2, stats.entryCount)
+            assertTrue(stats.evictionCount > initialStats.evictionCount)
+        }
+
+        // GIVEN
+        val subjectNoCache = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.okHttpClient = okHttpClient
+            scriptCacheConfig.enabled = false
+        })
+
+        runBlocking {
+            // WHEN
+            val results = listOf("1 + 1", "1 + 1").map { subjectNoCache.evaluate<Int>(it) }
+            val stats = subjectNoCache.getScriptCacheStats()
+
+            // THEN
+            assertEquals(listOf(2, 2), results)
+            assertEquals(JsBridge.ScriptCacheStats(0, 0, 0, 0), stats)
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testStringInterning() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            stringInternConfig.enabled = true
+            stringInternConfig.maxEntryCount = 2
+            stringInternConfig.maxStringLength = 8
+        })
+        val jsConcat: suspend (String, String) -> String =
+            JsValue.newFunction(subject, "a", "b", "return a + '|' + b;")
+                .createJavaToJsProxyFunction2()
+        val longString = "not interned because too long"
+
+        runBlocking {
+            // WHEN
+            val strings = listOf("click", "scroll", "click", "\u00e9t\u00e9", "\u00e9t\u00e9", "scroll")
+            val results = strings.map { jsConcat(it, longString) }
+            val stats = subject.getStringInternStats()
+
+            // THEN
+            assertEquals(strings.map { "$it|$longString" }, results)
+            assertEquals(2L, stats.hitCount)  // 2nd "click" and 2nd "\u00e9t\u00e9" ("scroll" is evicted in between)
+            assertEquals(4L, stats.missCount)
+            assertEquals(2, stats.entryCount)
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testNoJniIdLookupAfterInit() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val javaApi = object : SimpleJsToJavaInterface {
+            override fun ping() = "pong"
         }
+        val jsJavaApi = JsValue.createJsToJavaProxy(subject, javaApi)
+        val jsConcat: suspend (List<String>, Int) -> String =
+            JsValue.newFunction(subject, "l", "i", "return l.join(',') + i;")
+                .createJavaToJsProxyFunction2()
 
-        // JS loop, call Java functions (191ms for 20000 iterations)
-        // -> 3.7s ms (Duktape, Samsung S5, 100000 iterations)
-        // -> 5.5s ms (QuickJS, Samsung S5, 100000 iterations)
-        val updateMagicJavaFuncJsValue = JsValue.createJsToJavaProxyFunction2(subject) { a: Int, i: Int ->
-            var n = a + i * 2
-            if (n > 1000000) n = -n
-            n
+        suspend fun convertValues() {
+            assertEquals(listOf("a", "b"), subject.evaluate<List<String>>("['a', 'b']"))
+            assertEquals(12, subject.evaluate<Int>("12"))
+            assertEquals(true, subject.evaluate<Boolean>("true"))
+            assertEquals(12.5, subject.evaluate<Any>("12.5"))
+            assertEquals(TestDataPoint(1, 2.5, "p", null), subject.evaluate<TestDataPoint>("({x: 1, y: 2.5, label: 'p', weight: null})"))
+            assertEquals("pong", subject.evaluate<String>("$jsJavaApi.ping()"))
+            assertEquals("a,b3", jsConcat(listOf("a", "b"), 3))
+            assertFailsWith<JsException> { subject.evaluate<Unit>("throw new Error('Expected error')") }
         }
-        val calcMagicCallJavaFunctionInsideJsLoop: suspend () -> Int = JsValue.newFunction(subject, """
-            |var m = 0
-            |for (var i = 0; i < $ITERATION_COUNT; ++i) {
-            |  m = $updateMagicJavaFuncJsValue(m, i)
-            |}
-            |return m;
-            |""".trimMargin()
-        ).createJavaToJsProxyFunction0()
 
         runBlocking {
-            delay(500)
+            convertValues()
+            val lookupCount = subject.getJniIdLookupCount()
 
-            Timber.i("Executing calcMagicJavaFunc()...")
-            val expectedResult = calcMagicJavaFunc()
-            Timber.i("-> result is $expectedResult")
+            // WHEN
+            convertValues()
 
-            Timber.i("Executing calcMagicJsFunc()...")
-            var result = calcMagicJsFunc()
-            Timber.i("-> result is $result")
-            assertEquals(expectedResult, result)
+            // THEN
+            assertEquals(lookupCount, subject.getJniIdLookupCount())
+        }
+    }
 
-            Timber.i("Executing calcMagicCallJsFunctionInsideJavaLoop()...")
-            result = calcMagicCallJsFunctionInsideJavaLoop()
-            Timber.i("-> result is $result")
-            assertEquals(expectedResult, result)
+    @Test
+    fun testEvaluateBlockingFromMultipleThreads() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val callingThreads = Collections.synchronizedSet(mutableSetOf<Thread>())
+        val javaApi = object : SimpleJsToJavaInterface {
+            override fun ping(): String {
+                callingThreads.add(Thread.currentThread())
+                return "pong"
+            }
+        }
+        val jsJavaApi = JsValue.createJsToJavaProxy(subject, javaApi)
+        subject.evaluateBlocking<Unit>("var counter = 0;")
+        runBlocking { waitForDone(subject) }
 
-            Timber.i("Executing calcMagicCallJsFunctionInsideJavaLoop() in JS thread...")
-            withContext(subject.coroutineContext) {
-                result = calcMagicCallJsFunctionInsideJavaLoop()
-                Timber.i("-> result is $result")
-                assertEquals(expectedResult, result)
+        // WHEN
+        val threads = List(4) {
+            thread {
+                repeat(250) {
+                    assertEquals("pong", subject.evaluateBlocking<String>("counter++; $jsJavaApi.ping()"))
+                }
             }
+        }
+        threads.forEach { it.join() }
 
-            Timber.i("Executing calcMagicEvaluateJsInsideJavaLoop()...")
-            result = calcMagicEvaluateJsInsideJavaLoop()
-            Timber.i("-> result is $result")
-            assertEquals(expectedResult, result)
+        // THEN
+        assertEquals(1000, subject.evaluateBlocking<Int>("counter"))
+        assertTrue(callingThreads.any { it in threads })  // evaluated without switching to the JS thread
+        assertTrue(errors.isEmpty())
+    }
 
-            Timber.i("Executing calcMagicEvaluateJsInsideJavaLoop() in JS thread...")
-            withContext(subject.coroutineContext) {
-                result = calcMagicEvaluateJsInsideJavaLoop()
-                Timber.i("-> result is $result")
-                assertEquals(expectedResult, result)
+    @Test
+    fun testWorker() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val worker = subject.createWorker("""
+            onmessage = function(e) {
+              var sum = e.data.values.reduce(function(a, b) { return a + b; }, 0);
+              postMessage({ id: e.data.id, sum: sum, self: self === globalThis, nested: [e.data.text, null, undefined] });
+            };
+        """.trimIndent())
+        worker.workerBridge.registerErrorListener(createErrorListener())
+
+        // WHEN
+        subject.evaluateBlocking<Unit>("""
+            var results = [];
+            $worker.onmessage = function(e) { results.push(e.data); };
+            for (var i = 0; i < 10; i++) {
+              $worker.postMessage({ id: i, values: [i, 0.5, -1], text: "héllo" });
             }
+        """.trimIndent())
 
-            Timber.i("Executing calcMagicCallJavaFunctionInsideJsLoop()...")
-            result = calcMagicCallJavaFunctionInsideJsLoop()
-            Timber.i("-> result is $result")
-            assertEquals(expectedResult, result)
+        var results = ""
+        runBlocking {
+            withTimeout(5000) {
+                while (subject.evaluate<Int>("results.length") < 10) {
+                    delay(10)
+                }
+            }
+            results = subject.evaluate("JSON.stringify(results[9])")
+        }
 
-            // Make sure that the JS value does not create garbage-collected as calcMagicMixed3Func()
-            // access the value by its name!
-            updateMagicJavaFuncJsValue.hold()
+        // THEN
+        assertEquals("""{"id":9,"sum":8.5,"self":true,"nested":["héllo",null,null]}""", results)
+        assertFailsWith<JsException> {
+            subject.evaluateBlocking<Unit>("$worker.postMessage({ f: function() {} })")
+        }
+        worker.terminate()
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testTransferJsValue() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val otherJsBridge = createAndSetUpJsBridge()
+        val hasMap = BuildConfig.FLAVOR != "duktape"
+        val jsValue = JsValue(subject, """
+            (function() {
+              var buffer = new ArrayBuffer(8);
+              var bytes = new Uint8Array(buffer, 2, 4);
+              bytes[0] = 42;
+              var view = new DataView(buffer, 1, 6);
+              // Own properties must not be used to read the view fields
+              Object.defineProperty(view, "byteOffset", { value: 100 });
+              Object.defineProperty(view, "byteLength", { value: 1000 });
+              var state = { date: new Date(1234567890), bytes: bytes, words: new Uint16Array(buffer), view: view, list: [1, "two"] };
+              state.self = state;
+              if ($hasMap) state.map = new Map([["key", state.list]]);
+              return state;
+            })()
+        """.trimIndent())
+
+        // Overridden globals must not be used to create the cloned objects
+        otherJsBridge.evaluateBlocking<Unit>("""
+            var RealDate = Date;
+            Date = function() { throw new Error("Overridden Date"); };
+            if ($hasMap) Map.prototype.set = function() { throw new Error("Overridden Map.set"); };
+        """.trimIndent())
+
+        // WHEN
+        val transferredJsValue = jsValue.transferTo(otherJsBridge)
+        val result: String = otherJsBridge.evaluateBlocking("""
+            var state = $transferredJsValue;
+            [
+              state.self === state,
+              state.date instanceof RealDate && state.date.getTime() === 1234567890,
+              state.bytes instanceof Uint8Array && state.bytes[0] === 42 && state.bytes.byteOffset === 2,
+              state.words.buffer === state.bytes.buffer && state.words.length === 4,
+              state.view.buffer === state.bytes.buffer && state.view.byteOffset === 1 && state.view.getUint8(1) === 42,
+              !$hasMap || (state.map.size === 1 && state.map.get("key") === state.list)
+            ].join()
+        """.trimIndent())
+
+        // THEN
+        assertEquals("true,true,true,true,true,true", result)
+        assertFailsWith<JsException> {
+            runBlocking {
+                JsValue(subject, "({ f: function() {} })").transferTo(otherJsBridge).evaluate<Unit>()
+            }
         }
+        assertTrue(errors.isEmpty())
     }
 
     interface StressJsApi: JavaToJsInterface {
@@ -2448,6 +3308,96 @@ class JsBridgeTest {
         assertTrue(errors.isEmpty())
     }
 
+    @Test
+    @Feature_SetTimeout
+    fun testSetTimeoutOrdering() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        runBlocking {
+            // WHEN
+            subject.evaluate<Unit>("""
+                globalThis.firedTimers = [];
+                globalThis.timerIdsAreNumbers = true;
+                for (var i = 0; i < 1000; i++) {
+                  var id = setTimeout(function(index) { globalThis.firedTimers.push(index); }, i % 10, i);
+                  if (typeof id !== "number") globalThis.timerIdsAreNumbers = false;
+                }""".trimIndent()
+            )
+            delay(500)
+
+            // THEN
+            assertTrue(subject.evaluate<Boolean>("globalThis.timerIdsAreNumbers"))
+            assertEquals(1000, subject.evaluate<Int>("globalThis.firedTimers.length"))
+
+            // Timers with the same delay are fired in creation order
+            assertTrue(subject.evaluate<Boolean>("""
+                var lastIndices = {};
+                globalThis.firedTimers.every(function(index) {
+                  var isOrdered = !(lastIndices[index % 10] > index);
+                  lastIndices[index % 10] = index;
+                  return isOrdered;
+                })""".trimIndent()
+            ))
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    @Feature_SetTimeout
+    fun testClearTimeoutWithSameDeadline() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        runBlocking {
+            // WHEN
+            // Both timers expire in the same batch and timerB is cleared before being fired
+            subject.evaluate<Unit>("""
+                globalThis.firedTimers = [];
+                var timerBId = null;
+                setTimeout(function() {
+                  globalThis.firedTimers.push("A");
+                  clearTimeout(timerBId);
+                }, 50);
+                timerBId = setTimeout(function() { globalThis.firedTimers.push("B"); }, 50);
+                """.trimIndent()
+            )
+            delay(500)
+
+            // THEN
+            assertEquals("A", subject.evaluate<String>("globalThis.firedTimers.join()"))
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testPromiseJobsDrainedAfterTimerError() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        runBlocking {
+            // WHEN
+            // Both timers expire in the same batch: timerA throws and timerB resolves a promise
+            subject.evaluate<Unit>("""
+                globalThis.continued = false;
+                setTimeout(function() { throw new Error("timerA error"); }, 50);
+                setTimeout(function() {
+                  Promise.resolve().then(function() { globalThis.continued = true; });
+                }, 50);
+                """.trimIndent()
+            )
+            delay(500)
+
+            // THEN
+            // The continuation already ran in the timer batch (and not at the end of this evaluation)
+            assertTrue(subject.evaluate<Boolean>("globalThis.continued"))
+        }
+
+        assertEquals(1, errors.size)
+    }
+
     @Test
     fun testXmlHttpRequest() {
         // GIVEN
@@ -2836,6 +3786,79 @@ class JsBridgeTest {
         assertTrue(errors.isEmpty())
     }
 
+    @Test
+    fun testConsole_formatAndMinPriority() {
+        // GIVEN
+        val messages = mutableListOf<Pair<Int, String>>()
+        val config = JsBridgeConfig.bareConfig().apply {
+            consoleConfig.enabled = true
+            consoleConfig.mode = JsBridgeConfig.ConsoleConfig.Mode.AsString
+            consoleConfig.minPriority = Log.INFO
+            consoleConfig.appendMessage = { priority, message ->
+                messages.add(priority to message)
+            }
+        }
+        val subject = JsBridge(config, context)
+        jsBridge = subject
+
+        // WHEN
+        val js = """
+            var isFormatted = false;
+            console.log("Filtered out:", { toString: function() { isFormatted = true; return "-"; } });
+            console.info("Formatted: %s", isFormatted);
+            console.info("%s has %d items costing %f%% (%o)%c", "cart", 3.7, 12.5, { a: 1 }, "color: red", "extra");
+            console.error("%s and %s", "only one");
+            """
+        subject.evaluateUnsync(js)
+
+        runBlocking { waitForDone(subject) }
+
+        // THEN
+        assertEquals(listOf(
+            Log.INFO to "Formatted: false",
+            Log.INFO to """cart has 3 items costing 12.5% ({"a":1}) extra""",
+            Log.ERROR to "only one and %s"
+        ), messages)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testConsole_traceAndRateLimit() {
+        // GIVEN
+        val messages = mutableListOf<Pair<Int, String>>()
+        val config = JsBridgeConfig.bareConfig().apply {
+            consoleConfig.enabled = true
+            consoleConfig.mode = JsBridgeConfig.ConsoleConfig.Mode.AsString
+            consoleConfig.maxMessagesPerSecond = 10
+            consoleConfig.appendMessage = { priority, message ->
+                messages.add(priority to message)
+            }
+        }
+        val subject = JsBridge(config, context)
+        jsBridge = subject
+
+        // WHEN
+        val js = """
+            function tracingFunction() { console.trace("traced"); }
+            tracingFunction();
+            for (var i = 0; i < 100; i++) {
+              console.log("Message " + i);
+            }
+            """
+        subject.evaluateUnsync(js)
+
+        runBlocking { waitForDone(subject) }
+
+        // THEN
+        assertEquals(11, messages.size)
+        assertEquals(Log.VERBOSE, messages[0].first)
+        assertTrue(messages[0].second.startsWith("Trace: traced\n"))
+        assertTrue(messages[0].second.contains("tracingFunction"))
+        assertEquals((0 until 9).map { Log.DEBUG to "Message $it" }, messages.subList(1, 10))
+        assertEquals(Log.WARN to "Suppressed 91 console messages (more than 10 per second)", messages[10])
+        assertTrue(errors.isEmpty())
+    }
+
     @Test
     fun testLocalStorage() {
         // GIVEN
@@ -2927,6 +3950,91 @@ class JsBridgeTest {
         }
     }
 
+    interface LazyListJavaApi: JsToJavaInterface {
+        fun getItems(): LazyList<String>
+        fun countItems(items: LazyList<String>): Int
+    }
+
+    @Test
+    fun testLazyList() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val requestedIndices = mutableListOf<Int>()
+        val items = LazyList(object : AbstractList<String>() {
+            override val size = 10000
+            override fun get(index: Int): String {
+                requestedIndices.add(index)
+                return "item$index"
+            }
+        })
+        var itemsBack: LazyList<String>? = null
+        val javaApi = object : LazyListJavaApi {
+            override fun getItems() = items
+            override fun countItems(items: LazyList<String>): Int {
+                itemsBack = items
+                return items.size
+            }
+        }
+        val javaApiJsValue = JsValue.createJsToJavaProxy(subject, javaApi)
+
+        // WHEN
+        val result: String = subject.evaluateBlocking("""
+            |var items = $javaApiJsValue.getItems();
+            |[items.length, items[0], items[9999], items[10000], items[0], items.slice(1, 3).join('+'),
+            |  $javaApiJsValue.countItems(['a', 'b']), $javaApiJsValue.countItems(items)].join(',');
+            |""".trimMargin())
+
+        // THEN
+        // Only the accessed elements have been converted (once)
+        assertEquals("10000,item0,item9999,,item0,item1+item2,2,10000", result)
+        assertEquals(listOf(0, 9999, 1, 2), requestedIndices)
+        assertSame(items, itemsBack)
+        assertTrue(errors.isEmpty())
+        javaApiJsValue.hold()
+    }
+
+    interface JsArrayLazyListJavaApi: JsToJavaInterface {
+        fun sum(items: LazyList<Int>, indices: IntArray): Int
+        fun echo(items: LazyList<Int>): LazyList<Int>
+    }
+
+    @Test
+    fun testJsArrayLazyList() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        var itemsSize = -1
+        val javaApi = object : JsArrayLazyListJavaApi {
+            override fun sum(items: LazyList<Int>, indices: IntArray): Int {
+                itemsSize = items.size
+                return indices.map { items[it] }.sum()
+            }
+            override fun echo(items: LazyList<Int>) = items
+        }
+        val javaApiJsValue = JsValue.createJsToJavaProxy(subject, javaApi)
+
+        // WHEN
+        val result: String = subject.evaluateBlocking("""
+            |var reads = 0;
+            |var arr = [];
+            |for (var i = 0; i < 10000; i++) arr.push(7);
+            |Object.defineProperty(arr, '0', { get: function() { reads++; return 42; }, enumerable: true });
+            |var sum = $javaApiJsValue.sum(arr, [0, 0, 9999]);
+            |[sum, reads, $javaApiJsValue.echo(arr) === arr].join(',');
+            |""".trimMargin())
+        val items: LazyList<Int> = subject.evaluateBlocking("arr")
+        val firstItems = items.subList(0, 3).toList()  // from the test thread
+        val readCount: Int = subject.evaluateBlocking("reads")
+
+        // THEN
+        // Only the accessed elements have been converted (once per list)
+        assertEquals("91,1,true", result)
+        assertEquals(10000, itemsSize)
+        assertEquals(listOf(42, 7, 7), firstItems)
+        assertEquals(2, readCount)
+        assertTrue(errors.isEmpty())
+        javaApiJsValue.hold()
+    }
+
     // JsExpectations
     // ---
 
@@ -0,0 +1,582 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Console.h"
+
+#include "ExceptionHandler.h"
+#include "JniCache.h"
+#include "JsBridgeContext.h"
+#include "JsStrings.h"
+#include "custom_stringify.h"
+#include "log.h"
+#include "exceptions/JniException.h"
+#include "jni-helpers/JArrayLocalRef.h"
+#include "jni-helpers/JObjectArrayLocalRef.h"
+#include "jni-helpers/JStringLocalRef.h"
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#if defined(DUKTAPE)
+# include "StackChecker.h"
+#endif
+
+namespace {
+  const char *LOG_TAG = "JavaScript";
+  const char *ASSERTION_FAILED_MESSAGE = "Assertion failed:";
+
+  const std::pair<const char *, Console::Method> CONSOLE_METHODS[] = {
+    { "log", Console::Method::Log },
+    { "debug", Console::Method::Debug },
+    { "trace", Console::Method::Trace },
+    { "info", Console::Method::Info },
+    { "warn", Console::Method::Warn },
+    { "error", Console::Method::Error },
+    { "exception", Console::Method::Exception },
+    { "assert", Console::Method::Assert },
+  };
+
+  // Format the arguments like console.log(): printf-like substitutions (%s, %d, %i, %f, %o, %O,
+  // %c and %%) in the first argument if it is a string, remaining arguments separated by a space
+  template <class FormatArgument>
+  std::string formatArguments(int argc, const std::string *formatString, FormatArgument &&formatArgument) {
+    std::string ret;
+    int argIndex = 0;
+
+    if (formatString != nullptr) {
+      const std::string &s = *formatString;
+      argIndex = 1;
+
+      for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] != '%' || i + 1 == s.size()) {
+          ret += s[i];
+          continue;
+        }
+
+        const char specifier = s[i + 1];
+        Console::Conversion conversion;
+        switch (specifier) {
+          case 's': conversion = Console::Conversion::String; break;
+          case 'd':
+          case 'i': conversion = Console::Conversion::Integer; break;
+          case 'f': conversion = Console::Conversion::Float; break;
+          case 'o':
+          case 'O': conversion = Console::Conversion::Object; break;
+          case 'c': conversion = Console::Conversion::Default; break;  // CSS: ignored
+          case '%':
+            ret += '%';
+            ++i;
+            continue;
+          default:
+            ret += '%';
+            continue;
+        }
+
+        if (argIndex >= argc) {
+          // Missing argument: keep the specifier as is
+          ret += '%';
+          continue;
+        }
+
+        ++i;
+        if (specifier != 'c') {
+          ret += formatArgument(argIndex, conversion);
+        }
+        ++argIndex;
+      }
+    }
+
+    for (; argIndex < argc; ++argIndex) {
+      if (argIndex > 0) {
+        ret += ' ';
+      }
+      ret += formatArgument(argIndex, Console::Conversion::Default);
+    }
+
+    return ret;
+  }
+
+  std::string assertionMessage(std::string &&message) {
+    return message.empty() ? ASSERTION_FAILED_MESSAGE : std::string(ASSERTION_FAILED_MESSAGE) + " " + message;
+  }
+
+  // Same output as console.trace() in browsers and Node.js: "Trace: <message>" + stack trace
+  std::string traceMessage(std::string &&message, const std::string &stackTrace) {
+    std::string ret = message.empty() ? std::string("Trace") : "Trace: " + message;
+    if (!stackTrace.empty()) {
+      ret += '\n';
+      ret += stackTrace;
+    }
+    return ret;
+  }
+
+  // Remove the given number of leading lines (and the trailing line breaks)
+  std::string dropLines(std::string s, int count) {
+    size_t pos = 0;
+    for (int i = 0; i < count && pos != std::string::npos; ++i) {
+      pos = s.find('\n', pos);
+      if (pos != std::string::npos) {
+        ++pos;
+      }
+    }
+    if (pos == std::string::npos) {
+      return {};
+    }
+
+    s.erase(0, pos);
+    while (!s.empty() && s.back() == '\n') {
+      s.pop_back();
+    }
+    return s;
+  }
+
+  int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+}
+
+Console::Console(const JsBridgeContext *jsBridgeContext)
+ : m_jsBridgeContext(jsBridgeContext)
+ , m_buffer(BUFFER_CAPACITY) {
+}
+
+int Console::getPriority(Method method) const {
+  switch (method) {
+    case Method::Log:
+      return ANDROID_LOG_DEBUG;
+    case Method::Debug:
+    case Method::Trace:
+      return m_mode == Mode::AsJson ? ANDROID_LOG_DEBUG : ANDROID_LOG_VERBOSE;
+    case Method::Info:
+      return ANDROID_LOG_INFO;
+    case Method::Warn:
+      return ANDROID_LOG_WARN;
+    case Method::Error:
+    case Method::Exception:
+      return ANDROID_LOG_ERROR;
+    case Method::Assert:
+      return ANDROID_LOG_FATAL;  // = android.util.Log.ASSERT
+  }
+  return ANDROID_LOG_DEBUG;
+}
+
+bool Console::countMessage() {
+  if (m_maxMessagesPerSecond <= 0) {
+    return true;
+  }
+
+  const int64_t now = nowMs();
+  if (now - m_intervalStartMs >= RATE_LIMIT_INTERVAL_MS) {
+    m_intervalStartMs = now;
+    m_intervalMessageCount = 0;
+  }
+
+  if (m_intervalMessageCount >= m_maxMessagesPerSecond) {
+    // Reported at the next flush
+    ++m_suppressedMessageCount;
+    return false;
+  }
+
+  ++m_intervalMessageCount;
+  return true;
+}
+
+void Console::append(int priority, std::string &&message) {
+  if (m_buffer.push(priority, std::move(message))) {
+    return;
+  }
+
+  // Buffer full: flush it now (message is only moved on success)
+  flush();
+  m_buffer.push(priority, std::move(message));
+}
+
+void Console::flush() {
+  if (m_buffer.isEmpty() && m_suppressedMessageCount == 0) {
+    return;
+  }
+
+  std::vector<LogRingBuffer::Entry> entries;
+  LogRingBuffer::Entry entry;
+  while (m_buffer.pop(entry)) {
+    entries.emplace_back(std::move(entry));
+  }
+
+  if (m_suppressedMessageCount > 0) {
+    entries.push_back({ ANDROID_LOG_WARN, "Suppressed " + std::to_string(m_suppressedMessageCount) +
+                                          " console messages (more than " + std::to_string(m_maxMessagesPerSecond) + " per second)" });
+    m_suppressedMessageCount = 0;
+  }
+
+  if (m_useNativeLog) {
+    for (const auto &e : entries) {
+      __android_log_write(e.priority, LOG_TAG, e.message.c_str());
+    }
+    return;
+  }
+
+  const JniContext *jniContext = m_jsBridgeContext->getJniContext();
+  const auto count = static_cast<jsize>(entries.size());
+
+  // Put a pending Java exception aside while calling Java
+  JniLocalRef<jthrowable> pendingException(jniContext, jniContext->exceptionOccurred());
+  if (!pendingException.isNull()) {
+    jniContext->exceptionClear();
+  }
+
+  JArrayLocalRef<jint> priorities(jniContext, count);
+  JObjectArrayLocalRef messages(jniContext, count, m_jsBridgeContext->getJniCache()->getStringClass());
+  jint *priorityElements = priorities.getMutableElements();
+  for (jsize i = 0; i < count; ++i) {
+    priorityElements[i] = entries[i].priority;
+    messages.setElement(i, JsStrings::toJava(jniContext, entries[i].message));
+  }
+  priorities.releaseArrayElements();
+
+  m_jsBridgeContext->getJniCache()->getJsBridgeInterface().appendConsoleMessages(priorities, messages);
+
+  if (!pendingException.isNull()) {
+    // Keep the original exception
+    if (jniContext->exceptionCheck()) {
+      jniContext->exceptionClear();
+      alog_warn("Exception while flushing the console messages (dropped because of a pending exception)");
+    }
+    jniContext->getJNIEnv()->Throw(pendingException.get());
+    return;
+  }
+
+  if (jniContext->exceptionCheck()) {
+    throw JniException(jniContext);
+  }
+}
+
+#if defined(DUKTAPE)
+
+namespace {
+  extern "C"
+  duk_ret_t consoleFunction(duk_context *ctx) {
+    const JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    Console *console = jsBridgeContext->getConsole();
+
+    const auto method = static_cast<Console::Method>(duk_get_current_magic(ctx));
+    const int priority = console->getPriority(method);
+    if (!console->isLoggable(priority)) {
+      // Filtered out before any formatting
+      return 0;
+    }
+
+    const duk_idx_t argc = duk_get_top(ctx);
+    if (method == Console::Method::Assert && argc >= 1 && duk_to_boolean(ctx, 0)) {
+      return 0;
+    }
+
+    if (!console->countMessage()) {
+      return 0;
+    }
+
+    std::string message;
+    if (method == Console::Method::Assert) {
+      message = assertionMessage(argc >= 1 ? console->format(1, argc - 1) : std::string());
+    } else if (method == Console::Method::Trace) {
+      message = traceMessage(console->format(0, argc), console->stackTrace());
+    } else {
+      message = console->format(0, argc);
+    }
+
+    try {
+      console->append(priority, std::move(message));
+    } catch (const std::exception &e) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(e);
+    }
+    return 0;
+  }
+
+  duk_ret_t safeToNumber(duk_context *ctx, void *) {
+    duk_to_number(ctx, -1);
+    return 1;
+  }
+}
+
+void Console::enable(Mode mode, int minPriority, bool useNativeLog, int maxMessagesPerSecond) {
+  duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+  CHECK_STACK(ctx);
+
+  m_mode = mode;
+  m_minPriority = mode == Mode::Empty ? INT_MAX : minPriority;
+  m_useNativeLog = useNativeLog;
+  m_maxMessagesPerSecond = maxMessagesPerSecond;
+
+  duk_push_object(ctx);
+  for (const auto &consoleMethod : CONSOLE_METHODS) {
+    duk_push_c_function(ctx, consoleFunction, DUK_VARARGS);
+    duk_set_magic(ctx, -1, static_cast<duk_int_t>(consoleMethod.second));
+    duk_put_prop_string(ctx, -2, consoleMethod.first);
+  }
+  duk_put_global_string(ctx, "console");
+}
+
+std::string Console::format(duk_idx_t idx, duk_idx_t count) const {
+  duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+  CHECK_STACK(ctx);
+
+  std::string formatString;
+  const bool hasFormatString = count > 0 && duk_is_string(ctx, idx);
+  if (hasFormatString) {
+    formatString = duk_get_string(ctx, idx);
+  }
+
+  return formatArguments(count, hasFormatString ? &formatString : nullptr, [&](int argIndex, Conversion conversion) {
+    return formatValue(idx + argIndex, conversion);
+  });
+}
+
+std::string Console::stackTrace() const {
+  duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+  CHECK_STACK(ctx);
+
+  duk_push_error_object(ctx, DUK_ERR_ERROR, "trace");
+  duk_get_prop_string(ctx, -1, "stack");
+  std::string stack = duk_is_string(ctx, -1) ? duk_get_string(ctx, -1) : "";
+  duk_pop_2(ctx);
+
+  // Skip the "Error: trace" line, the C call site and the console.trace() native frame
+  const size_t nativeFramePos = stack.find(") native");
+  const int nativeFrameLine = nativeFramePos == std::string::npos ? 0 : static_cast<int>(std::count(stack.begin(), stack.begin() + nativeFramePos, '\n'));
+  return dropLines(std::move(stack), nativeFrameLine + 1);
+}
+
+std::string Console::formatValue(duk_idx_t idx, Conversion conversion) const {
+  duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+  CHECK_STACK(ctx);
+
+  switch (conversion) {
+    case Conversion::Integer:
+    case Conversion::Float: {
+      duk_dup(ctx, idx);
+      double d = duk_safe_call(ctx, safeToNumber, nullptr, 1, 1) == DUK_EXEC_SUCCESS ? duk_get_number(ctx, -1) : NAN;
+      duk_pop(ctx);
+      if (conversion == Conversion::Integer && std::isfinite(d)) {
+        d = std::trunc(d);
+      }
+      duk_push_number(ctx, d);
+      std::string ret = duk_to_string(ctx, -1);
+      duk_pop(ctx);
+      return ret;
+    }
+
+    case Conversion::Object:
+      return toJsonString(idx);
+
+    case Conversion::Default:
+      if (m_mode == Mode::AsJson && !duk_is_string(ctx, idx)) {
+        return toJsonString(idx);
+      }
+      return toString(idx);
+
+    case Conversion::String:
+      return toString(idx);
+  }
+
+  return {};
+}
+
+std::string Console::toString(duk_idx_t idx) const {
+  duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+  CHECK_STACK(ctx);
+
+  duk_dup(ctx, idx);
+  std::string ret = duk_safe_to_string(ctx, -1);
+  duk_pop(ctx);
+  return ret;
+}
+
+std::string Console::toJsonString(duk_idx_t idx) const {
+  duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+  CHECK_STACK(ctx);
+
+  if (duk_is_undefined(ctx, idx)) {
+    return "undefined";
+  }
+
+  idx = duk_normalize_index(ctx, idx);
+  std::string json;
+  if (custom_stringify(ctx, idx, true /*keepErrorStack*/, json) != DUK_EXEC_SUCCESS) {
+    duk_pop(ctx);  // error
+    return toString(idx);
+  }
+
+  return json.empty() ? "undefined" : json;
+}
+
+#elif defined(QUICKJS)
+
+namespace {
+  JSValue consoleFunction(JSContext *ctx, JSValueConst, int argc, JSValueConst *argv, int magic) {
+    const JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    Console *console = jsBridgeContext->getConsole();
+
+    const auto method = static_cast<Console::Method>(magic);
+    const int priority = console->getPriority(method);
+    if (!console->isLoggable(priority)) {
+      // Filtered out before any formatting
+      return JS_UNDEFINED;
+    }
+
+    if (method == Console::Method::Assert && argc >= 1 && JS_ToBool(ctx, argv[0]) > 0) {
+      return JS_UNDEFINED;
+    }
+
+    if (!console->countMessage()) {
+      return JS_UNDEFINED;
+    }
+
+    std::string message;
+    if (method == Console::Method::Assert) {
+      message = assertionMessage(argc >= 1 ? console->format(argc - 1, argv + 1) : std::string());
+    } else if (method == Console::Method::Trace) {
+      message = traceMessage(console->format(argc, argv), console->stackTrace());
+    } else {
+      message = console->format(argc, argv);
+    }
+
+    try {
+      console->append(priority, std::move(message));
+    } catch (const std::exception &e) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return JS_EXCEPTION;
+    }
+    return JS_UNDEFINED;
+  }
+}
+
+void Console::enable(Mode mode, int minPriority, bool useNativeLog, int maxMessagesPerSecond) {
+  JSContext *ctx = m_jsBridgeContext->getQuickJsContext();
+
+  m_mode = mode;
+  m_minPriority = mode == Mode::Empty ? INT_MAX : minPriority;
+  m_useNativeLog = useNativeLog;
+  m_maxMessagesPerSecond = maxMessagesPerSecond;
+
+  JSValue consoleObj = JS_NewObject(ctx);
+  for (const auto &consoleMethod : CONSOLE_METHODS) {
+    JSValue functionObj = JS_NewCFunctionMagic(ctx, consoleFunction, consoleMethod.first, 0, JS_CFUNC_generic_magic, static_cast<int>(consoleMethod.second));
+    JS_SetPropertyStr(ctx, consoleObj, consoleMethod.first, functionObj);
+  }
+
+  JSValue globalObj = JS_GetGlobalObject(ctx);
+  JS_SetPropertyStr(ctx, globalObj, "console", consoleObj);
+  // No JS_FreeValue(ctx, consoleObj) after JS_SetPropertyStr()
+  JS_FreeValue(ctx, globalObj);
+}
+
+std::string Console::format(int argc, JSValueConst *argv) const {
+  std::string formatString;
+  const bool hasFormatString = argc > 0 && JS_IsString(argv[0]);
+  if (hasFormatString) {
+    formatString = toString(argv[0]);
+  }
+
+  return formatArguments(argc, hasFormatString ? &formatString : nullptr, [&](int argIndex, Conversion conversion) {
+    return formatValue(argv[argIndex], conversion);
+  });
+}
+
+std::string Console::stackTrace() const {
+  JSContext *ctx = m_jsBridgeContext->getQuickJsContext();
+
+  // Throwing from a C function captures the current backtrace
+  JS_ThrowInternalError(ctx, "trace");
+  JSValue error = JS_GetException(ctx);
+  JSValue stackValue = JS_GetPropertyStr(ctx, error, "stack");
+  std::string stack = JS_IsString(stackValue) ? toString(stackValue) : std::string();
+  JS_FreeValue(ctx, stackValue);
+  JS_FreeValue(ctx, error);
+
+  // Skip the console.trace() native frame
+  return dropLines(std::move(stack), 1);
+}
+
+std::string Console::formatValue(JSValueConst v, Conversion conversion) const {
+  JSContext *ctx = m_jsBridgeContext->getQuickJsContext();
+
+  switch (conversion) {
+    case Conversion::Integer:
+    case Conversion::Float: {
+      double d;
+      if (JS_ToFloat64(ctx, &d, v) < 0) {
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        d = NAN;
+      }
+      if (conversion == Conversion::Integer && std::isfinite(d)) {
+        d = std::trunc(d);
+      }
+      JSValue numberValue = JS_NewFloat64(ctx, d);
+      std::string ret = toString(numberValue);
+      JS_FreeValue(ctx, numberValue);
+      return ret;
+    }
+
+    case Conversion::Object:
+      return toJsonString(v);
+
+    case Conversion::Default:
+      if (m_mode == Mode::AsJson && !JS_IsString(v)) {
+        return toJsonString(v);
+      }
+      return toString(v);
+
+    case Conversion::String:
+      return toString(v);
+  }
+
+  return {};
+}
+
+std::string Console::toString(JSValueConst v) const {
+  JSContext *ctx = m_jsBridgeContext->getQuickJsContext();
+
+  size_t length;
+  const char *cstr = JS_ToCStringLen(ctx, &length, v);
+  if (cstr == nullptr) {
+    // e.g. Symbol
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    return "<unprintable>";
+  }
+
+  std::string ret(cstr, length);
+  JS_FreeCString(ctx, cstr);
+  return ret;
+}
+
+std::string Console::toJsonString(JSValueConst v) const {
+  JSContext *ctx = m_jsBridgeContext->getQuickJsContext();
+
+  if (JS_IsUndefined(v)) {
+    return "undefined";
+  }
+
+  std::string json;
+  if (custom_stringify(ctx, v, true /*keepErrorStack*/, json) < 0) {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    return toString(v);
+  }
+
+  return json.empty() ? "undefined" : json;
+}
+
+#endif
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_CONSOLE_H
+#define _JSBRIDGE_CONSOLE_H
+
+#include "LogRingBuffer.h"
+#include <climits>
+#include <cstdint>
+#include <string>
+
+#if defined(DUKTAPE)
+# include "duktape/duktape.h"
+#elif defined(QUICKJS)
+# include "quickjs/quickjs.h"
+#endif
+
+class JsBridgeContext;
+
+// Native implementation of the JS console object.
+//
+// Messages are filtered by priority and rate-limited before being formatted, then buffered and
+// written in batches to the log sink (JsBridgeConfig.ConsoleConfig.appendMessage or directly
+// logcat).
+class Console {
+
+public:
+  // Must be kept in sync with JsBridgeConfig.ConsoleConfig.Mode
+  enum class Mode {
+    AsString = 0,
+    AsJson = 1,
+    Empty = 2,
+  };
+
+  enum class Method {
+    Log, Debug, Trace, Info, Warn, Error, Exception, Assert
+  };
+
+  // Value conversion (default: according to the mode)
+  enum class Conversion {
+    Default, String, Integer, Float, Object
+  };
+
+  explicit Console(const JsBridgeContext *);
+  Console(const Console &) = delete;
+  Console &operator=(const Console &) = delete;
+
+  // Create the global console object
+  void enable(Mode mode, int minPriority, bool useNativeLog, int maxMessagesPerSecond);
+
+  // Write the buffered messages to the log sink
+  void flush();
+
+  // Android log priority of the given method
+  int getPriority(Method) const;
+  bool isLoggable(int priority) const { return priority >= m_minPriority; }
+
+  // Count a new message against the rate limit and return false if it must be dropped
+  bool countMessage();
+
+  void append(int priority, std::string &&message);
+
+#if defined(DUKTAPE)
+  // Format count values starting at the given stack index
+  std::string format(duk_idx_t idx, duk_idx_t count) const;
+#elif defined(QUICKJS)
+  std::string format(int argc, JSValueConst *argv) const;
+#endif
+
+  // Current JS stack trace (without the console function itself)
+  std::string stackTrace() const;
+
+private:
+#if defined(DUKTAPE)
+  std::string formatValue(duk_idx_t idx, Conversion) const;
+  std::string toString(duk_idx_t idx) const;
+  std::string toJsonString(duk_idx_t idx) const;
+#elif defined(QUICKJS)
+  std::string formatValue(JSValueConst, Conversion) const;
+  std::string toString(JSValueConst) const;
+  std::string toJsonString(JSValueConst) const;
+#endif
+
+  static const size_t BUFFER_CAPACITY = 256;
+  static const int64_t RATE_LIMIT_INTERVAL_MS = 1000;
+
+  const JsBridgeContext *m_jsBridgeContext;
+  LogRingBuffer m_buffer;
+  Mode m_mode = Mode::AsString;
+  int m_minPriority = INT_MAX;
+  bool m_useNativeLog = false;
+  int m_maxMessagesPerSecond = 0;  // 0 = no limit
+  int64_t m_intervalStartMs = 0;
+  int m_intervalMessageCount = 0;
+  int m_suppressedMessageCount = 0;
+};
+
+#endif
@@ -20,12 +20,14 @@
 #include "AutoReleasedJSValue.h"
 #include "ExceptionHandler.h"
 #include "JniCache.h"
+#include "JsStrings.h"
 #include "JsBridgeContext.h"
 #include "custom_stringify.h"
 #include "exceptions/JniException.h"
 #include "exceptions/JsException.h"
 #include "jni-helpers/JniContext.h"
 #include "log.h"
+#include "utf_transcode.h"
 
 #if defined(DUKTAPE)
 # include "DuktapeUtils.h"
@@ -39,6 +41,12 @@
 
 namespace {
   const char *JAVA_EXCEPTION_PROP_NAME = "__java_exception";
+
+  JStringLocalRef newJavaJsonString(const JniContext *jniContext, const std::string &json) {
+    std::u16string utf16;
+    utf8_to_utf16(json.data(), json.length(), utf16);
+    return JStringLocalRef(jniContext, std::u16string_view(utf16));
+  }
 }
 
 
@@ -121,12 +129,12 @@ JniLocalRef<jthrowable> ExceptionHandler::getJavaException(const JsException &js
   jsException.pushError();
 
   // Create the JSON string
-  const char *jsonStringRaw = nullptr;
-  if (custom_stringify(ctx, -1, false /*keepErrorStack*/) == DUK_EXEC_SUCCESS) {
-    jsonStringRaw = duk_get_string(ctx, -1);
+  std::string json;
+  const bool hasJson = custom_stringify(ctx, -1, false /*keepErrorStack*/, json) == DUK_EXEC_SUCCESS;
+  if (!hasJson) {
+    duk_pop(ctx);  // stringify error
   }
-  JStringLocalRef jsonString(jniContext, jsonStringRaw);
-  duk_pop(ctx);  // stringified string
+  JStringLocalRef jsonString = hasJson ? newJavaJsonString(jniContext, json) : JStringLocalRef();
 
   duk_dup(ctx, -1);  // JS error
   const std::string stack = duk_safe_to_stacktrace(ctx, -1);
@@ -150,8 +158,8 @@ JniLocalRef<jthrowable> ExceptionHandler::getJavaException(const JsException &js
 
   return m_jsBridgeContext->getJniCache()->newJsException(
       jsonString,  // jsonValue
-      JStringLocalRef(jniContext, jsException.what()),  // detailedMessage
-      JStringLocalRef(jniContext, strJsStacktrace.c_str()),  // jsStackTrace
+      JsStrings::toJava(jniContext, jsException.what(), strlen(jsException.what())),  // detailedMessage
+      JsStrings::toJava(jniContext, strJsStacktrace),  // jsStackTrace
       cause
   );
 #elif defined(QUICKJS)
@@ -163,13 +171,12 @@ JniLocalRef<jthrowable> ExceptionHandler::getJavaException(const JsException &js
   JniLocalRef<jthrowable> ret;
 
   JSValue exceptionValue = jsException.getValue();
-  JSValue jsonValue = custom_stringify(ctx, exceptionValue, false /*keepErrorStack*/);
-  JStringLocalRef jsonString;
-  if (JS_IsException(jsonValue)) {
-    JS_GetException(ctx);
-  } else {
-    jsonString = utils->toJString(jsonValue);
+  std::string json;
+  const bool hasJson = custom_stringify(ctx, exceptionValue, false /*keepErrorStack*/, json) >= 0;
+  if (!hasJson) {
+    JS_FreeValue(ctx, JS_GetException(ctx));
   }
+  JStringLocalRef jsonString = hasJson ? newJavaJsonString(jniContext, json) : JStringLocalRef();
 
   // Is there an exception thrown from a Java method?
   JniLocalRef<jthrowable> cause;
@@ -202,12 +209,11 @@ JniLocalRef<jthrowable> ExceptionHandler::getJavaException(const JsException &js
 
   ret = jniCache->newJsException(
       jsonString,  // jsonValue
-      JStringLocalRef(jniContext, jsException.what()),  // detailedMessage
-      JStringLocalRef(jniContext, stack.c_str()),  // jsStackTrace
+      JsStrings::toJava(jniContext, jsException.what(), strlen(jsException.what())),  // detailedMessage
+      JsStrings::toJava(jniContext, stack),  // jsStackTrace
       cause
   );
 
-  JS_FreeValue(ctx, jsonValue);
   return ret;
 #endif
 }
@@ -216,9 +222,8 @@ JniLocalRef<jthrowable> ExceptionHandler::getJavaException(const JsException &js
 
 void ExceptionHandler::pushJavaException(const JniLocalRef<jthrowable> &throwable) const {
   const JniContext *jniContext = m_jsBridgeContext->getJniContext();
-  auto exceptionClass = jniContext->getObjectClass(throwable);
-  jmethodID getMessage = jniContext->getMethodID(exceptionClass, "getMessage", "()Ljava/lang/String;");
-  JStringLocalRef messageRef = jniContext->callStringMethod(throwable, getMessage);
+  const JniIds &ids = m_jsBridgeContext->getJniCache()->getIds();
+  JStringLocalRef messageRef = jniContext->callStringMethod(throwable, ids.throwableGetMessage);
 
 
   // Propagate Java exception to JavaScript (and store pointer to Java exception)
@@ -226,9 +231,8 @@ void ExceptionHandler::pushJavaException(const JniLocalRef<jthrowable> &throwabl
 
   auto ctx = m_jsBridgeContext->getDuktapeContext();
 
-  const char *messageStr = messageRef.toUtf8Chars();
-  if (!messageStr) messageStr = "<null>";
-  duk_push_error_object(ctx, DUK_ERR_ERROR, messageStr);
+  const std::string message = messageRef.isNull() ? "<null>" : JsStrings::fromJava(messageRef);
+  duk_push_error_object(ctx, DUK_ERR_ERROR, "%s", message.c_str());
 
   m_jsBridgeContext->getUtils()->pushJavaRefValue(throwable);
   duk_put_prop_string(ctx, -2, JAVA_EXCEPTION_PROP_NAME);
@@ -238,9 +242,8 @@ void ExceptionHandler::pushJavaException(const JniLocalRef<jthrowable> &throwabl
 
 JSValue ExceptionHandler::javaExceptionToJsValue(const JniLocalRef<jthrowable> &throwable) const {
   const JniContext *jniContext = m_jsBridgeContext->getJniContext();
-  auto exceptionClass = jniContext->getObjectClass(throwable);
-  jmethodID getMessage = jniContext->getMethodID(exceptionClass, "getMessage", "()Ljava/lang/String;");
-  JStringLocalRef messageRef = jniContext->callStringMethod(throwable, getMessage);
+  const JniIds &ids = m_jsBridgeContext->getJniCache()->getIds();
+  JStringLocalRef messageRef = jniContext->callStringMethod(throwable, ids.throwableGetMessage);
 
 
   // Propagate Java exception to JavaScript (and store pointer to Java exception)
@@ -249,9 +252,8 @@ JSValue ExceptionHandler::javaExceptionToJsValue(const JniLocalRef<jthrowable> &
   auto ctx = m_jsBridgeContext->getQuickJsContext();
 
   JSValue errorValue = JS_NewError(ctx);
-  const char *messageStr = messageRef.toUtf8Chars();
-  if (!messageStr) messageStr = "<null>";
-  JSValue messageValue = JS_NewString(ctx, messageStr);
+  const std::string message = messageRef.isNull() ? "<null>" : JsStrings::fromJava(messageRef);
+  JSValue messageValue = JS_NewStringLen(ctx, message.c_str(), message.length());
   JS_SetPropertyStr(ctx, errorValue, "message", messageValue);
   // No JS_FreeValue(m_ctx, messageValue) after JS_SetPropertyStr()
 
@@ -24,11 +24,14 @@
 #include "JniCache.h"
 #include "JniTypes.h"
 #include "JsBridgeContext.h"
+#include "LocalFrameBatch.h"
 #include "exceptions/JsException.h"
+#include "java-types/Deferred.h"
 #include "jni-helpers/JniContext.h"
 #include "jni-helpers/JObjectArrayLocalRef.h"
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 JavaScriptMethod::JavaScriptMethod(const JsBridgeContext *jsBridgeContext, const JniRef<jsBridgeMethod> &method, std::string methodName, bool isLambda)
  : m_methodName(std::move(methodName))
@@ -50,13 +53,11 @@ JavaScriptMethod::JavaScriptMethod(const JsBridgeContext *jsBridgeContext, const
   JObjectArrayLocalRef parameters = methodInterface.getParameters();
   const auto numParameters = (size_t) parameters.getLength();
 
-  // Release any local objects allocated in this frame when we leave this scope.
-  //const JniLocalFrame localFrame(jniContext, numArgs);
-
   m_argumentTypes.resize(numParameters);
 
-  // Create JavaType instances
-  for (jsize i = 0; i < numParameters; ++i) {
+  // Create JavaType instances (the local objects allocated for each parameter are released
+  // with the local frames)
+  forEachInLocalFrames(jsBridgeContext->getJniContext(), (jsize) numParameters, 4, [&](jsize i) {
     JniLocalRef<jsBridgeParameter> parameter = parameters.getElement<jsBridgeParameter>(i);
 
     if (m_isVarArgs && i == numParameters - 1) {
@@ -64,14 +65,14 @@ JavaScriptMethod::JavaScriptMethod(const JsBridgeContext *jsBridgeContext, const
         JniLocalRef<jsBridgeParameter> varArgParameter = parameterInterface.getGenericParameter();
         auto javaType = jsBridgeContext->getJavaTypeProvider().makeUniqueType(varArgParameter, false /*boxed*/);
         m_argumentTypes[i] = std::move(javaType);
-        break;
+        return;
     }
 
     // Always load the boxed type instead of the primitive type (e.g. Integer vs int)
     // because we are going to a Proxy object
     auto javaType = javaTypeProvider.makeUniqueType(parameter, true /*boxed*/);
     m_argumentTypes[i] = std::move(javaType);
-  }
+  });
 }
 
 JavaScriptMethod::JavaScriptMethod(JavaScriptMethod &&other) noexcept
@@ -115,22 +116,25 @@ JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, void *js
     duk_push_string(ctx, m_methodName.c_str());
   }
 
-  jsize numArguments = args.isNull() ? 0U : args.getLength();
+  const jsize numJavaArguments = args.isNull() ? 0U : args.getLength();
+  jsize numArguments = numJavaArguments;
 
-  for (jsize i = 0; i < numArguments; ++i) {
+  // The Java arguments are not needed anymore once pushed
+  forEachInLocalFrames(jsBridgeContext->getJniContext(), numJavaArguments, 2, [&](jsize i) {
     JValue arg(args.getElement(i));
     const auto &argumentType = m_argumentTypes[i];
     try {
-      if (m_isVarArgs && i == numArguments - 1) {
+      if (m_isVarArgs && i == numJavaArguments - 1) {
         numArguments = i + argumentType->pushArray(arg.getLocalRef().staticCast<jarray>(), true /*expand*/);
-        break;
+      } else {
+        argumentType->push(arg);
       }
-      argumentType->push(arg);
     } catch (const std::exception &) {
       duk_pop_n(ctx, (m_isLambda ? 1 : 2) + i);  // lambda: func + previous args, method: obj + methodName + previous args
       throw;
     }
-  }
+    arg.detachLocalRef();  // released with the local frame
+  });
 
   duk_ret_t ret;
   if (m_isLambda) {
@@ -142,6 +146,10 @@ JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, void *js
   if (ret == DUK_EXEC_SUCCESS) {
     try {
       bool isDeferred = awaitJsPromise && duk_is_object(ctx, -1) && duk_has_prop_string(ctx, -1, "then");
+      if (isDeferred && JavaTypes::Deferred::replaceFulfilledPromise(jsBridgeContext)) {
+        // Already fulfilled: directly return its value instead of waiting for the Promise reactions
+        isDeferred = false;
+      }
       if (isDeferred && !m_returnValueType->isDeferred()) {
         result = jsBridgeContext->getJavaTypeProvider().getDeferredType(m_returnValueParameter)->pop();
       } else {
@@ -176,33 +184,36 @@ JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, JSValueC
     numJsArguments += varArgCount - 1;
   }
 
-  JSValue jsArgs[numJsArguments];
+  std::vector<JSValue> jsArgs(numJsArguments);  // (a variable-length array cannot be captured by the lambda below)
+  int convertedJsArguments = 0;
 
-  for (jsize i = 0; i < numJsArguments; ++i) {
-    JValue javaArg(javaArgs.getElement(i));
-    const auto &argumentType = m_argumentTypes[i];
-    try {
-      if (m_isVarArgs && i >= numJavaArguments - 1) {
+  // The Java arguments are not needed anymore once converted
+  try {
+    forEachInLocalFrames(jsBridgeContext->getJniContext(), numJavaArguments, 2, [&](jsize i) {
+      const auto &argumentType = m_argumentTypes[i];
+      if (m_isVarArgs && i == numJavaArguments - 1) {
         // For varargs, convert Java array to JS array and "expand" it to the JS args
         JSValue varArgJsArray = argumentType->fromJavaArray(varArgJavaArray);
-        for (int j = 0; j < varArgCount; ++j, ++i) {
-          JSValue elementJsValue = JS_GetPropertyUint32(ctx, varArgJsArray, static_cast<uint32_t>(j));
-          jsArgs[i] = elementJsValue;
+        for (int j = 0; j < varArgCount; ++j) {
+          jsArgs[convertedJsArguments++] = JS_GetPropertyUint32(ctx, varArgJsArray, static_cast<uint32_t>(j));
         }
         JS_FreeValue(ctx, varArgJsArray);
-        break;
-      }
-      jsArgs[i] = argumentType->fromJava(javaArg);
-    } catch (const std::exception &) {
-      // Free all the JSValue instances which had been added until now
-      for (int j = 0; j < i; ++j) {
-        JS_FreeValue(ctx, jsArgs[j]);
+        return;
       }
-      throw;
+
+      JValue javaArg(javaArgs.getElement(i));
+      jsArgs[convertedJsArguments++] = argumentType->fromJava(javaArg);
+      javaArg.detachLocalRef();  // released with the local frame
+    });
+  } catch (const std::exception &) {
+    // Free all the JSValue instances which had been added until now
+    for (int j = 0; j < convertedJsArguments; ++j) {
+      JS_FreeValue(ctx, jsArgs[j]);
     }
+    throw;
   }
 
-  JSValue ret = JS_Call(ctx, jsMethod, jsThis, numJsArguments, jsArgs);
+  JSValue ret = JS_Call(ctx, jsMethod, jsThis, numJsArguments, jsArgs.data());
   JS_AUTORELEASE_VALUE(ctx, ret);
 
   for (jsize i = 0; i < numJsArguments; ++i) {
@@ -214,6 +225,14 @@ JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, JSValueC
   }
 
   bool isDeferred = awaitJsPromise && JS_IsObject(ret) && jsBridgeContext->getUtils()->hasPropertyStr(ret, "then");
+  if (isDeferred) {
+    // Already fulfilled: directly return its value instead of waiting for the Promise reactions
+    JSValue fulfilledValue = JavaTypes::Deferred::getFulfilledValue(jsBridgeContext, ret);
+    if (!JS_IsUninitialized(fulfilledValue)) {
+      JS_AUTORELEASE_VALUE(ctx, fulfilledValue);
+      return m_returnValueType->toJava(fulfilledValue);
+    }
+  }
   if (isDeferred && !m_returnValueType->isDeferred()) {
     return jsBridgeContext->getJavaTypeProvider().getDeferredType(m_returnValueParameter)->toJava(ret);
   }
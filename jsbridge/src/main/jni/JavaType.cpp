@@ -21,6 +21,7 @@
 #include "JsBridgeContext.h"
 #include "JavaTypeProvider.h"
 #include "JniCache.h"
+#include "LocalFrameBatch.h"
 #include "exceptions/JniException.h"
 #include "java-types/Deferred.h"
 #include "java-types/FunctionX.h"
@@ -68,19 +69,21 @@ JValue JavaType::popArray(uint32_t count, bool expanded) const {
   throw JniException(m_jniContext);
  }
 
- for (int i = (int) count - 1; i >= 0; --i) {
+ // Elements are popped from the last one
+ forEachInLocalFrames(m_jniContext, (jsize) count, 1, [this, count, expanded, &objectArray](jsize reverseIndex) {
+  const int i = (int) count - 1 - reverseIndex;
   if (!expanded) {
     duk_get_prop_index(m_ctx, -1, static_cast<duk_uarridx_t>(i));
   }
   JValue elementValue = pop();
-  const JniLocalRef<jobject> &jElement = elementValue.getLocalRef();
-  objectArray.setElement(i, jElement);
+  objectArray.setElement(i, elementValue.getLocalRef());
+  elementValue.detachLocalRef();  // released with the local frame
 
   if (m_jniContext->exceptionCheck()) {
     duk_pop_n(m_ctx, expanded ? std::max(i, 0) : 1);  // pop remaining expanded elements or array
     throw JniException(m_jniContext);
   }
- }
+ });
 
  if (!expanded) {
    duk_pop(m_ctx);  // pop the array
@@ -99,7 +102,7 @@ duk_ret_t JavaType::pushArray(const JniLocalRef<jarray>& values, bool expand) co
   duk_push_array(m_ctx);
  }
 
- for (jsize i = 0; i < count; ++i) {
+ forEachInLocalFrames(m_jniContext, count, 1, [this, expand, &objectArray](jsize i) {
   JniLocalRef<jobject> object = objectArray.getElement(i);
   try {
    push(JValue(object));
@@ -110,7 +113,8 @@ duk_ret_t JavaType::pushArray(const JniLocalRef<jarray>& values, bool expand) co
     duk_pop_n(m_ctx, expand ? i : 1);  // pop expanded elements which have been pushed or array
     throw;
   }
- }
+  object.detach();  // released with the local frame
+ });
 
  return expand ? count : 1;
 }
@@ -135,17 +139,17 @@ JValue JavaType::toJavaArray(JSValueConst jsValue) const {
   }
 
   assert(JS_IsArray(m_ctx, jsValue));
-  for (uint32_t i = 0; i < count; ++i) {
-    JSValue elementJsValue = JS_GetPropertyUint32(m_ctx, jsValue, i);
+  forEachInLocalFrames(m_jniContext, (jsize) count, 1, [this, jsValue, &objectArray](jsize i) {
+    JSValue elementJsValue = JS_GetPropertyUint32(m_ctx, jsValue, static_cast<uint32_t>(i));
     JValue elementJavaValue = toJava(elementJsValue);
     JS_FreeValue(m_ctx, elementJsValue);
-    const JniLocalRef<jobject> &jElement = elementJavaValue.getLocalRef();
-    objectArray.setElement((jsize) i, jElement);
+    objectArray.setElement(i, elementJavaValue.getLocalRef());
+    elementJavaValue.detachLocalRef();  // released with the local frame
 
     if (m_jniContext->exceptionCheck()) {
       throw JniException(m_jniContext);
     }
-  }
+  });
 
   return JValue(objectArray);
 }
@@ -156,15 +160,16 @@ JSValue JavaType::fromJavaArray(const JniLocalRef<jarray>& values) const {
 
   JSValue jsArray = JS_NewArray(m_ctx);
 
-  for (jsize i = 0; i < size; ++i) {
-    JniLocalRef<jobject> object = objectArray.getElement(i);
-    try {
+  try {
+    forEachInLocalFrames(m_jniContext, size, 1, [this, jsArray, &objectArray](jsize i) {
+      JniLocalRef<jobject> object = objectArray.getElement(i);
       JSValue elementValue = fromJava(JValue(object));
       JS_SetPropertyUint32(m_ctx, jsArray, static_cast<uint32_t>(i), elementValue);
-    } catch (const std::exception &) {
-      JS_FreeValue(m_ctx, jsArray);
-      throw;
-    }
+      object.detach();  // released with the local frame
+    });
+  } catch (const std::exception &) {
+    JS_FreeValue(m_ctx, jsArray);
+    throw;
   }
 
   return jsArray;
@@ -78,6 +78,9 @@ static thread_local std::unordered_map<std::u16string_view, JavaTypeId> sJavaNam
   { u"de.prosiebensat1digital.oasisjsbridge.JsonObjectWrapper", JavaTypeId::JsonObjectWrapper },
   { u"de.prosiebensat1digital.oasisjsbridge.JavaObjectWrapper", JavaTypeId::JavaObjectWrapper },
   { u"de.prosiebensat1digital.oasisjsbridge.JsToJavaProxy", JavaTypeId::JsToJavaProxy },
+  { u"de.prosiebensat1digital.oasisjsbridge.PayloadObject", JavaTypeId::PayloadObject },
+  { u"de.prosiebensat1digital.oasisjsbridge.PayloadArray", JavaTypeId::PayloadArray },
+  { u"de.prosiebensat1digital.oasisjsbridge.LazyList", JavaTypeId::LazyList },
 
   { u"kotlinx.coroutines.Deferred", JavaTypeId::Deferred }
 };
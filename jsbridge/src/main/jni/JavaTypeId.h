@@ -47,6 +47,7 @@ enum class JavaTypeId {
 
   ObjectArray = 50,
   List = 51,
+  LazyList = 52,
 
   BooleanArray = 60,
   ByteArray = 61,
@@ -63,6 +64,9 @@ enum class JavaTypeId {
   Deferred = 103,
   JavaObjectWrapper = 104,
   JsToJavaProxy = 105,
+  PayloadObject = 106,
+  PayloadArray = 107,
+  DataClass = 108,  // Kotlin data class (no fixed Java name, see Parameter.isDataClass())
 };
 
 JavaTypeId getJavaTypeIdByJavaName(std::u16string_view javaName);
@@ -21,6 +21,7 @@
 #include "java-types/BoxedPrimitive.h"
 #include "java-types/Boolean.h"
 #include "java-types/Byte.h"
+#include "java-types/DataClass.h"
 #include "java-types/Deferred.h"
 #include "java-types/Double.h"
 #include "java-types/Float.h"
@@ -30,9 +31,11 @@
 #include "java-types/JsValue.h"
 #include "java-types/JavaObjectWrapper.h"
 #include "java-types/JsonObjectWrapper.h"
+#include "java-types/LazyList.h"
 #include "java-types/List.h"
 #include "java-types/Long.h"
 #include "java-types/Object.h"
+#include "java-types/Payload.h"
 #include "java-types/Short.h"
 #include "java-types/String.h"
 #include "java-types/Void.h"
@@ -120,6 +123,10 @@ const JavaType *JavaTypeProvider::newType(const JniRef<jsBridgeParameter> &param
       auto genericParameterType = getGenericParameterType(parameter);
       return new List(m_jsBridgeContext, std::move(genericParameterType));
     }
+    case JavaTypeId::LazyList: {
+      auto genericParameter = getGenericParameter(parameter);
+      return new LazyList(m_jsBridgeContext, makeUniqueType(genericParameter, true /*boxed*/), genericParameter);
+    }
     case JavaTypeId::BooleanArray:
       return createPrimitiveArray<Boolean>(m_jsBridgeContext);
     case JavaTypeId::ByteArray:
@@ -147,6 +154,11 @@ const JavaType *JavaTypeProvider::newType(const JniRef<jsBridgeParameter> &param
       return new JavaObjectWrapper(m_jsBridgeContext);
     case JavaTypeId::JsToJavaProxy:
       return new JsToJavaProxy(m_jsBridgeContext);
+    case JavaTypeId::PayloadObject:
+    case JavaTypeId::PayloadArray:
+      return new Payload(m_jsBridgeContext, id);
+    case JavaTypeId::DataClass:
+      return new DataClass(m_jsBridgeContext, m_jsBridgeContext->getJniCache()->getDataClassPlan(parameter));
 
     case JavaTypeId::Unknown:
       return nullptr;
@@ -184,6 +196,9 @@ JavaTypeId JavaTypeProvider::getJavaTypeId(const JniRef<jsBridgeParameter> &para
   }
 
   JavaTypeId id = getJavaTypeIdByJavaName(javaName.getUtf16View());
+  if (id == JavaTypeId::Unknown && m_jsBridgeContext->getJniCache()->getParameterInterface(parameter).isDataClass()) {
+    return JavaTypeId::DataClass;
+  }
   if (id == JavaTypeId::Unknown) {
     throw std::invalid_argument(std::string("Unsupported Java type: ") + javaName.toStdString());
     //return JavaTypeId::Unknown;
@@ -16,6 +16,7 @@
 #include "JniCache.h"
 
 #include "JsBridgeContext.h"
+#include "java-types/DataClass.h"
 #include "jni-helpers/JniContext.h"
 #include "log.h"
 
@@ -26,10 +27,14 @@ JniCache::JniCache(const JsBridgeContext *jsBridgeContext, const JniLocalRef<job
  , m_numberClass(m_jniContext->findClass("java/lang/Number"))
  , m_stringClass(m_jniContext->findClass("java/lang/String"))
  , m_arrayListClass(m_jniContext->findClass("java/util/ArrayList"))
+ , m_hashMapClass(m_jniContext->findClass("java/util/HashMap"))
+ , m_setClass(m_jniContext->findClass("java/util/Set"))
+ , m_mapEntryClass(m_jniContext->findClass("java/util/Map$Entry"))
  , m_javaClassClass(m_jniContext->findClass("java/lang/Class"))
  , m_listClass(m_jniContext->findClass("java/util/List"))
  , m_jsBridgeClass(m_jniContext->findClass(JSBRIDGE_PKG_PATH "/JsBridge"))
  , m_jsExceptionClass(m_jniContext->findClass(JSBRIDGE_PKG_PATH "/JsException"))
+ , m_jsArrayListClass(m_jniContext->findClass(JSBRIDGE_PKG_PATH "/JsArrayList"))
  , m_illegalArgumentExceptionClass(m_jniContext->findClass("java/lang/IllegalArgumentException"))
  , m_runtimeExceptionClass(m_jniContext->findClass("java/lang/RuntimeException"))
  , m_jsBridgeMethodClass(m_jniContext->findClass(JSBRIDGE_PKG_PATH "/Method"))
@@ -39,9 +44,13 @@ JniCache::JniCache(const JsBridgeContext *jsBridgeContext, const JniLocalRef<job
  , m_jsonObjectWrapperClass(getJavaClass(JavaTypeId::JsonObjectWrapper))
  , m_javaObjectWrapperClass(getJavaClass(JavaTypeId::JavaObjectWrapper))
  , m_jsToJavaProxyClass(getJavaClass(JavaTypeId::JsToJavaProxy))
+ , m_lazyListClass(getJavaClass(JavaTypeId::LazyList))
+ , m_ids(m_jniContext, this)
  , m_jsBridgeInterface(this, jsBridgeJavaObject) {
 }
 
+JniCache::~JniCache() = default;
+
 const JniGlobalRef<jclass> &JniCache::getJavaClass(JavaTypeId id) const {
   auto itFind = m_javaClasses.find(id);
   if (itFind != m_javaClasses.end()) {
@@ -58,27 +67,20 @@ const JniGlobalRef<jclass> &JniCache::getJavaClass(JavaTypeId id) const {
   // If the above findClass() call throws an exception, try to get the class from the primitive type
   if (jniContext->exceptionCheck()) {
     jniContext->exceptionClear();
-    JniLocalRef<jclass> classClass = jniContext->findClass("java/lang/Class");
-    jmethodID getPrimitiveClass = jniContext->getStaticMethodID(classClass, "getPrimitiveClass", "(Ljava/lang/String;)Ljava/lang/Class;");
-
-    javaClass = jniContext->callStaticObjectMethod<jclass>(classClass, getPrimitiveClass, JStringLocalRef(jniContext, javaName.c_str()));
+    // Note: primitive classes are not requested while the IDs are being resolved
+    javaClass = jniContext->callStaticObjectMethod<jclass>(m_javaClassClass, m_ids.classGetPrimitiveClass, JStringLocalRef(jniContext, javaName.c_str()));
   }
   return m_javaClasses.emplace(id, JniGlobalRef<jclass>(javaClass)).first->second;
 }
 
 JStringLocalRef JniCache::getJavaReflectedMethodName(const JniLocalRef<jobject> &javaMethod) const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_jniContext->getObjectClass(javaMethod), "getName", "()Ljava/lang/String;");
-  return m_jniContext->callStringMethod(javaMethod, methodId);
+  return m_jniContext->callStringMethod(javaMethod, m_ids.reflectedMethodGetName);
 }
 
 JniLocalRef<jthrowable> JniCache::newJsException(
     const JStringLocalRef &jsonValue, const JStringLocalRef &detailedMessage,
     const JStringLocalRef &jsStackTrace, const JniRef<jthrowable> &cause) const {
-
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(
-      m_jsExceptionClass, "<init>", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/Throwable;)V");
-
-  return m_jniContext->newObject<jthrowable>(m_jsExceptionClass, methodId, jsonValue, detailedMessage, jsStackTrace, cause);
+  return m_jniContext->newObject<jthrowable>(m_jsExceptionClass, m_ids.jsExceptionInit, jsonValue, detailedMessage, jsStackTrace, cause);
 }
 
 
@@ -90,13 +92,11 @@ JniLocalRef<jobject> JniCache::newDebugString(const char *s) const {
 }
 
 JniLocalRef<jobject> JniCache::newDebugString(const JStringLocalRef &s) const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_jsBridgeDebugStringClass, "<init>", "(Ljava/lang/String;)V");
-  return m_jniContext->newObject<jobject>(m_jsBridgeDebugStringClass, methodId, s);
+  return m_jniContext->newObject<jobject>(m_jsBridgeDebugStringClass, m_ids.debugStringInit, s);
 }
 
 JStringLocalRef JniCache::getDebugStringString(const JniRef<jobject> &debugString) const {
-  static thread_local jmethodID getString = m_jniContext->getMethodID(m_jsBridgeDebugStringClass, "getString", "()Ljava/lang/String;");
-  return m_jniContext->callStringMethod(debugString, getString);
+  return m_jniContext->callStringMethod(debugString, m_ids.debugStringGetString);
 }
 
 
@@ -104,13 +104,11 @@ JStringLocalRef JniCache::getDebugStringString(const JniRef<jobject> &debugStrin
 // ---
 
 JniLocalRef<jobject> JniCache::newJsValue(const JStringLocalRef &name) const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_jsBridgeJsValueClass, "<init>", "(L" JSBRIDGE_PKG_PATH "/JsBridge;Ljava/lang/String;)V");
-  return m_jniContext->newObject<jobject>(m_jsBridgeJsValueClass, methodId, m_jsBridgeInterface.object(), name);
+  return m_jniContext->newObject<jobject>(m_jsBridgeJsValueClass, m_ids.jsValueInit, m_jsBridgeInterface.object(), name);
 }
 
 JStringLocalRef JniCache::getJsValueName(const JniRef<jobject> &jsValue) const {
-  static thread_local jmethodID getJsName = m_jniContext->getMethodID(m_jsBridgeJsValueClass, "getAssociatedJsName", "()Ljava/lang/String;");
-  return m_jniContext->callStringMethod(jsValue, getJsName);
+  return m_jniContext->callStringMethod(jsValue, m_ids.jsValueGetAssociatedJsName);
 }
 
 
@@ -118,13 +116,11 @@ JStringLocalRef JniCache::getJsValueName(const JniRef<jobject> &jsValue) const {
 // ---
 
 JniLocalRef<jobject> JniCache::newJsonObjectWrapper(const JStringLocalRef &jsonString) const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_jsonObjectWrapperClass, "<init>", "(Ljava/lang/String;)V");
-  return m_jniContext->newObject<jobject>(m_jsonObjectWrapperClass, methodId, jsonString);
+  return m_jniContext->newObject<jobject>(m_jsonObjectWrapperClass, m_ids.jsonObjectWrapperInit, jsonString);
 }
 
 JStringLocalRef JniCache::getJsonObjectWrapperString(const JniRef<jobject> &jsonObjectWrapper) const {
-  static thread_local jmethodID getJsonString = m_jniContext->getMethodID(m_jsonObjectWrapperClass, "getJsonString", "()Ljava/lang/String;");
-  return m_jniContext->callStringMethod(jsonObjectWrapper, getJsonString);
+  return m_jniContext->callStringMethod(jsonObjectWrapper, m_ids.jsonObjectWrapperGetJsonString);
 }
 
 
@@ -132,18 +128,15 @@ JStringLocalRef JniCache::getJsonObjectWrapperString(const JniRef<jobject> &json
 // ---
 
 JniLocalRef<jobject> JniCache::getOrCreateJavaObjectWrapper(const JniRef<jobject> &javaObject) const {
-  static thread_local jmethodID methodId = m_jniContext->getStaticMethodID(m_javaObjectWrapperClass, "getOrCreate", "(Ljava/lang/Object;)L" JSBRIDGE_PKG_PATH "/JavaObjectWrapper;");
-  return m_jniContext->callStaticObjectMethod<jobject>(m_javaObjectWrapperClass, methodId, javaObject);
+  return m_jniContext->callStaticObjectMethod<jobject>(m_javaObjectWrapperClass, m_ids.javaObjectWrapperGetOrCreate, javaObject);
 }
 
 JniLocalRef<jobject> JniCache::javaObjectWrapperFromJavaObject(const JniRef<jobject> &javaObject) const {
-  static thread_local jmethodID methodId = m_jniContext->getStaticMethodID(m_javaObjectWrapperClass, "fromJavaObject", "(Ljava/lang/Object;)L" JSBRIDGE_PKG_PATH "/JavaObjectWrapper;");
-  return m_jniContext->callStaticObjectMethod<jobject>(m_javaObjectWrapperClass, methodId, javaObject);
+  return m_jniContext->callStaticObjectMethod<jobject>(m_javaObjectWrapperClass, m_ids.javaObjectWrapperFromJavaObject, javaObject);
 }
 
 JniLocalRef<jobject> JniCache::getJavaObjectWrapperJavaObject(const JniRef<jobject> &javaObjectWrapper) const {
-  static thread_local jmethodID getJavaObject = m_jniContext->getMethodID(m_javaObjectWrapperClass, "extractJavaObject", "()Ljava/lang/Object;");
-  return m_jniContext->callObjectMethod(javaObjectWrapper, getJavaObject);
+  return m_jniContext->callObjectMethod(javaObjectWrapper, m_ids.javaObjectWrapperExtractJavaObject);
 }
 
 
@@ -151,8 +144,7 @@ JniLocalRef<jobject> JniCache::getJavaObjectWrapperJavaObject(const JniRef<jobje
 // ---
 
 JniLocalRef<jobject> JniCache::newJsToJavaProxy(const JniRef<jobject> &javaObject, const JStringLocalRef &name) const {
-  static thread_local jmethodID ctorId = m_jniContext->getMethodID(m_jsToJavaProxyClass, "<init>", "(L" JSBRIDGE_PKG_PATH "/JsBridge;L" JSBRIDGE_PKG_PATH "/JsToJavaInterface;Ljava/lang/String;)V");
-  return m_jniContext->newObject<jobject>(m_jsToJavaProxyClass,ctorId, m_jsBridgeInterface.object(), javaObject, name);
+  return m_jniContext->newObject<jobject>(m_jsToJavaProxyClass, m_ids.jsToJavaProxyInit, m_jsBridgeInterface.object(), javaObject, name);
 }
 
 
@@ -160,23 +152,39 @@ JniLocalRef<jobject> JniCache::newJsToJavaProxy(const JniRef<jobject> &javaObjec
 // ---
 
 JniLocalRef<jobject> JniCache::newList() const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_arrayListClass, "<init>", "()V");
-  return m_jniContext->newObject<jobject>(m_arrayListClass, methodId);
+  return m_jniContext->newObject<jobject>(m_arrayListClass, m_ids.arrayListInit);
 }
 
 void JniCache::addToList(const JniLocalRef<jobject> &list, const JniLocalRef<jobject> &element) const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_listClass, "add", "(Ljava/lang/Object;)Z");
-  m_jniContext->callBooleanMethod(list, methodId, element);
+  m_jniContext->callBooleanMethod(list, m_ids.listAdd, element);
+}
+
+int JniCache::getListLength(const JniRef<jobject> &list) const {
+  return m_jniContext->callIntMethod(list, m_ids.listSize);
+}
+
+JniLocalRef<jobject> JniCache::getListElement(const JniRef<jobject> &list, int i) const {
+  return m_jniContext->callObjectMethod(list, m_ids.listGet, i);
 }
 
-int JniCache::getListLength(const JniLocalRef<jobject> &list) const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_listClass, "size", "()I");
-  return m_jniContext->callIntMethod(list, methodId);
+
+// LazyList
+// ---
+
+JniLocalRef<jobject> JniCache::newLazyList(const JniRef<jobject> &list) const {
+  return m_jniContext->newObject<jobject>(m_lazyListClass, m_ids.lazyListInit, list);
 }
 
-JniLocalRef<jobject> JniCache::getListElement(const JniLocalRef<jobject> &list, int i) const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_listClass, "get", "(I)Ljava/lang/Object;");
-  return m_jniContext->callObjectMethod(list, methodId, i);
+JniLocalRef<jobject> JniCache::getLazyListJsArray(const JniRef<jobject> &lazyList) const {
+  return m_jniContext->callObjectMethod(lazyList, m_ids.lazyListGetJsArray);
+}
+
+
+// JsArrayList
+// ---
+
+JniLocalRef<jobject> JniCache::newJsArrayList(const JniRef<jobject> &jsArray, const JniRef<jsBridgeParameter> &elementParameter, jint size) const {
+  return m_jniContext->newObject<jobject>(m_jsArrayListClass, m_ids.jsArrayListInit, jsArray, elementParameter, size);
 }
 
 
@@ -184,9 +192,47 @@ JniLocalRef<jobject> JniCache::getListElement(const JniLocalRef<jobject> &list,
 // ---
 
 JniLocalRef<jsBridgeParameter> JniCache::newParameter(const JniLocalRef<jclass> &javaClass) const {
-  static thread_local jmethodID getCustomClassLoader = m_jniContext->getMethodID(m_jsBridgeClass, "getCustomClassLoader", "()Ljava/lang/ClassLoader;");
-  const auto bridgeCustomClassLoader = m_jniContext->callObjectMethod(m_jsBridgeInterface.object(), getCustomClassLoader);
+  const auto bridgeCustomClassLoader = m_jniContext->callObjectMethod(m_jsBridgeInterface.object(), m_ids.jsBridgeGetCustomClassLoader);
+
+  return m_jniContext->newObject<jsBridgeParameter>(m_jsBridgeParameterClass, m_ids.parameterInit, javaClass, bridgeCustomClassLoader);
+}
+
+
+// Data classes
+// ---
+
+const JavaTypes::DataClassPlan *JniCache::getDataClassPlan(const JniRef<jsBridgeParameter> &parameter) const {
+  ParameterInterface parameterInterface = getParameterInterface(parameter);
+  JniLocalRef<jclass> javaClass = parameterInterface.getJava();
+  const std::string javaName = parameterInterface.getJavaName().toStdString();
+  JNIEnv *env = m_jniContext->getJNIEnv();
+
+  auto &plans = m_dataClassPlans[javaName];
+  for (const auto &plan : plans) {
+    if (env->IsSameObject(plan->javaClass.get(), javaClass.get())) {
+      if (!plan->error.empty()) {
+        throw std::invalid_argument(plan->error);
+      }
+      return plan.get();
+    }
+  }
+
+  // The plan is registered before being initialized so that it is re-used by recursive data classes
+  plans.emplace_back(std::make_unique<JavaTypes::DataClassPlan>());
+  JavaTypes::DataClassPlan *plan = plans.back().get();
+  plan->javaClass = JniGlobalRef<jclass>(javaClass);
+  plan->javaName = javaName;
+
+  try {
+    plan->init(m_jsBridgeContext, parameter);
+  } catch (const std::exception &e) {
+    plan->error = e.what();
+    throw;
+  }
+
+  return plan;
+}
 
-  static thread_local jmethodID parameterInit = m_jniContext->getMethodID(m_jsBridgeParameterClass, "<init>", "(Ljava/lang/Class;Ljava/lang/ClassLoader;)V");
-  return m_jniContext->newObject<jsBridgeParameter>(m_jsBridgeParameterClass, parameterInit, javaClass, bridgeCustomClassLoader);
+void JniCache::clearDataClassPlans() {
+  m_dataClassPlans.clear();
 }
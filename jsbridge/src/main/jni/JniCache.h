@@ -19,13 +19,19 @@
 #define JSBRIDGE_PKG_PATH "de/prosiebensat1digital/oasisjsbridge"
 
 #include "JavaTypeId.h"
+#include "JniIds.h"
 #include "JniInterfaces.h"
 #include "JniTypes.h"
 #include "jni-helpers/JniGlobalRef.h"
 #include "jni-helpers/JObjectArrayLocalRef.h"
 #include "jni-helpers/JStringLocalRef.h"
 #include <jni.h>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
+
+namespace JavaTypes { struct DataClassPlan; }
 
 class JsBridgeContext;
 class JniCache;
@@ -36,16 +42,26 @@ class JniCache {
 
 public:
   JniCache(const JsBridgeContext *, const JniLocalRef<jobject> &jsBridgeJavaObject);
+  ~JniCache();
 
   const JniGlobalRef<jclass> &getJavaClass(JavaTypeId) const;
   const JniRef<jclass> &getObjectClass() const { return m_objectClass; }
   const JniRef<jclass> &getNumberClass() const { return m_numberClass; }
   const JniRef<jclass> &getStringClass() const { return m_stringClass; }
   const JniRef<jclass> &getListClass() const { return m_listClass; }
+  const JniRef<jclass> &getHashMapClass() const { return m_hashMapClass; }
+  const JniRef<jclass> &getSetClass() const { return m_setClass; }
+  const JniRef<jclass> &getMapEntryClass() const { return m_mapEntryClass; }
   const JniRef<jclass> &getJavaClassClass() const { return m_javaClassClass; }
   const JniRef<jclass> &getJsBridgeClass() const { return m_jsBridgeClass; }
   const JniRef<jclass> &getJsBridgeMethodClass() const { return m_jsBridgeMethodClass; }
   const JniRef<jclass> &getJsBridgeParameterClass() const { return m_jsBridgeParameterClass; }
+  const JniRef<jclass> &getArrayListClass() const { return m_arrayListClass; }
+  const JniRef<jclass> &getJsExceptionClass() const { return m_jsExceptionClass; }
+  const JniRef<jclass> &getJsArrayListClass() const { return m_jsArrayListClass; }
+
+  // Method and field IDs, resolved once for this cache
+  const JniIds &getIds() const { return m_ids; }
 
   // Access to JniInterface's
   const JsBridgeInterface &getJsBridgeInterface() const { return m_jsBridgeInterface; }
@@ -86,12 +102,25 @@ public:
   // List (java.util.List)
   JniLocalRef<jobject> newList() const;
   void addToList(const JniLocalRef<jobject> &list, const JniLocalRef<jobject> &element) const;
-  int getListLength(const JniLocalRef<jobject> &list) const;
-  JniLocalRef<jobject> getListElement(const JniLocalRef<jobject> &list, int i) const;
+  int getListLength(const JniRef<jobject> &list) const;
+  JniLocalRef<jobject> getListElement(const JniRef<jobject> &list, int i) const;
+
+  // LazyList (de.prosiebensat1digital.oasisjsbridge.LazyList)
+  JniLocalRef<jobject> newLazyList(const JniRef<jobject> &list) const;
+  // JsValue held by the LazyList if it wraps a JsArrayList, null otherwise
+  JniLocalRef<jobject> getLazyListJsArray(const JniRef<jobject> &lazyList) const;
+
+  // JsArrayList (de.prosiebensat1digital.oasisjsbridge.JsArrayList)
+  JniLocalRef<jobject> newJsArrayList(const JniRef<jobject> &jsArray, const JniRef<jsBridgeParameter> &elementParameter, jint size) const;
 
   // Parameter (de.prosiebensat1digital.oasisjsbridge.Parameter)
   JniLocalRef<jsBridgeParameter> newParameter(const JniLocalRef<jclass> &javaClass) const;
 
+  // Data classes: the conversion plan is computed once per class and kept until the plans are
+  // cleared (which must happen before the JS context is destroyed)
+  const JavaTypes::DataClassPlan *getDataClassPlan(const JniRef<jsBridgeParameter> &parameter) const;
+  void clearDataClassPlans();
+
   const JniContext *getJniContext() const { return m_jniContext; }
 
 private:
@@ -100,14 +129,21 @@ private:
 
   mutable std::unordered_map<JavaTypeId, JniGlobalRef<jclass>> m_javaClasses;
 
+  // Java name -> plans (one per class with that name, usually only one)
+  mutable std::unordered_map<std::string, std::vector<std::unique_ptr<JavaTypes::DataClassPlan>>> m_dataClassPlans;
+
   JniGlobalRef<jclass> m_objectClass;
   JniGlobalRef<jclass> m_numberClass;
   JniGlobalRef<jclass> m_stringClass;
   JniGlobalRef<jclass> m_listClass;
   JniGlobalRef<jclass> m_javaClassClass;
   JniGlobalRef<jclass> m_arrayListClass;
+  JniGlobalRef<jclass> m_hashMapClass;
+  JniGlobalRef<jclass> m_setClass;
+  JniGlobalRef<jclass> m_mapEntryClass;
   JniGlobalRef<jclass> m_jsBridgeClass;
   JniGlobalRef<jclass> m_jsExceptionClass;
+  JniGlobalRef<jclass> m_jsArrayListClass;
   JniGlobalRef<jclass> m_illegalArgumentExceptionClass;
   JniGlobalRef<jclass> m_runtimeExceptionClass;
 
@@ -119,6 +155,10 @@ private:
   JniGlobalRef<jclass> m_jsonObjectWrapperClass;
   JniGlobalRef<jclass> m_javaObjectWrapperClass;
   JniGlobalRef<jclass> m_jsToJavaProxyClass;
+  JniGlobalRef<jclass> m_lazyListClass;
+
+  // Must be declared after the classes above (from which the IDs are resolved)
+  const JniIds m_ids;
 
   const JsBridgeInterface m_jsBridgeInterface;
 };
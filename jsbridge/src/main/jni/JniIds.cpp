@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JniIds.h"
+
+#include "JniCache.h"
+#include "jni-helpers/JniContext.h"
+
+namespace {
+  // Shorthand for the ID lookups below (counted by JniContext)
+  class IdLookup {
+  public:
+    explicit IdLookup(const JniContext *jniContext)
+     : m_jniContext(jniContext) {
+    }
+
+    jmethodID method(const JniRef<jclass> &javaClass, const char *name, const char *signature) const {
+      return m_jniContext->getMethodID(javaClass, name, signature);
+    }
+
+    jmethodID staticMethod(const JniRef<jclass> &javaClass, const char *name, const char *signature) const {
+      return m_jniContext->getStaticMethodID(javaClass, name, signature);
+    }
+
+    jfieldID field(const JniRef<jclass> &javaClass, const char *name, const char *signature) const {
+      return m_jniContext->getFieldID(javaClass, name, signature);
+    }
+
+  private:
+    const JniContext *m_jniContext;
+  };
+}
+
+// static
+uint64_t JniIds::getLookupCount() {
+  return JniContext::getIdLookupCount();
+}
+
+JniIds::JniIds(const JniContext *jniContext, const JniCache *jniCache) {
+  const IdLookup lookup(jniContext);
+
+  // java.lang.Object, java.lang.Class, java.lang.Throwable, java.lang.reflect.Method
+  const auto &classClass = jniCache->getJavaClassClass();
+  objectGetClass = lookup.method(jniCache->getObjectClass(), "getClass", "()Ljava/lang/Class;");
+  classGetName = lookup.method(classClass, "getName", "()Ljava/lang/String;");
+  classGetComponentType = lookup.method(classClass, "getComponentType", "()Ljava/lang/Class;");
+  classGetPrimitiveClass = lookup.staticMethod(classClass, "getPrimitiveClass", "(Ljava/lang/String;)Ljava/lang/Class;");
+  throwableGetMessage = lookup.method(jniContext->findClass("java/lang/Throwable"), "getMessage", "()Ljava/lang/String;");
+  reflectedMethodGetName = lookup.method(jniContext->findClass("java/lang/reflect/Method"), "getName", "()Ljava/lang/String;");
+
+  // Boxed primitives
+  const auto &booleanClass = jniCache->getJavaClass(JavaTypeId::BoxedBoolean);
+  booleanValueOf = lookup.staticMethod(booleanClass, "valueOf", "(Z)Ljava/lang/Boolean;");
+  booleanBooleanValue = lookup.method(booleanClass, "booleanValue", "()Z");
+  const auto &byteClass = jniCache->getJavaClass(JavaTypeId::BoxedByte);
+  byteValueOf = lookup.staticMethod(byteClass, "valueOf", "(B)Ljava/lang/Byte;");
+  byteByteValue = lookup.method(byteClass, "byteValue", "()B");
+  const auto &shortClass = jniCache->getJavaClass(JavaTypeId::BoxedShort);
+  shortValueOf = lookup.staticMethod(shortClass, "valueOf", "(S)Ljava/lang/Short;");
+  shortShortValue = lookup.method(shortClass, "shortValue", "()S");
+  const auto &integerClass = jniCache->getJavaClass(JavaTypeId::BoxedInt);
+  integerValueOf = lookup.staticMethod(integerClass, "valueOf", "(I)Ljava/lang/Integer;");
+  integerIntValue = lookup.method(integerClass, "intValue", "()I");
+  const auto &longClass = jniCache->getJavaClass(JavaTypeId::BoxedLong);
+  longValueOf = lookup.staticMethod(longClass, "valueOf", "(J)Ljava/lang/Long;");
+  longLongValue = lookup.method(longClass, "longValue", "()J");
+  const auto &floatClass = jniCache->getJavaClass(JavaTypeId::BoxedFloat);
+  floatValueOf = lookup.staticMethod(floatClass, "valueOf", "(F)Ljava/lang/Float;");
+  floatFloatValue = lookup.method(floatClass, "floatValue", "()F");
+  const auto &doubleClass = jniCache->getJavaClass(JavaTypeId::BoxedDouble);
+  doubleValueOf = lookup.staticMethod(doubleClass, "valueOf", "(D)Ljava/lang/Double;");
+  doubleDoubleValue = lookup.method(doubleClass, "doubleValue", "()D");
+  numberDoubleValue = lookup.method(jniCache->getNumberClass(), "doubleValue", "()D");
+  unitInit = lookup.method(jniCache->getJavaClass(JavaTypeId::Unit), "<init>", "()V");
+
+  // java.util collections
+  const auto &listClass = jniCache->getListClass();
+  arrayListInit = lookup.method(jniCache->getArrayListClass(), "<init>", "()V");
+  listAdd = lookup.method(listClass, "add", "(Ljava/lang/Object;)Z");
+  listSize = lookup.method(listClass, "size", "()I");
+  listGet = lookup.method(listClass, "get", "(I)Ljava/lang/Object;");
+  const auto &lazyListClass = jniCache->getJavaClass(JavaTypeId::LazyList);
+  lazyListInit = lookup.method(lazyListClass, "<init>", "(Ljava/util/List;)V");
+  lazyListGetJsArray = lookup.method(lazyListClass, "getJsArray", "()L" JSBRIDGE_PKG_PATH "/JsValue;");
+  jsArrayListInit = lookup.method(jniCache->getJsArrayListClass(), "<init>", "(L" JSBRIDGE_PKG_PATH "/JsValue;L" JSBRIDGE_PKG_PATH "/Parameter;I)V");
+  const auto &hashMapClass = jniCache->getHashMapClass();
+  hashMapInit = lookup.method(hashMapClass, "<init>", "(I)V");
+  hashMapPut = lookup.method(hashMapClass, "put", "(Ljava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;");
+  hashMapEntrySet = lookup.method(hashMapClass, "entrySet", "()Ljava/util/Set;");
+  setToArray = lookup.method(jniCache->getSetClass(), "toArray", "()[Ljava/lang/Object;");
+  mapEntryGetKey = lookup.method(jniCache->getMapEntryClass(), "getKey", "()Ljava/lang/Object;");
+  mapEntryGetValue = lookup.method(jniCache->getMapEntryClass(), "getValue", "()Ljava/lang/Object;");
+
+  // de.prosiebensat1digital.oasisjsbridge.JsBridge
+  const auto &jsBridgeClass = jniCache->getJsBridgeClass();
+  jsBridgeCheckJsThread = lookup.method(jsBridgeClass, "checkJsThread", "()V");
+  jsBridgeOnDebuggerPending = lookup.method(jsBridgeClass, "onDebuggerPending", "()V");
+  jsBridgeOnDebuggerReady = lookup.method(jsBridgeClass, "onDebuggerReady", "()V");
+  jsBridgeCallJsModuleLoader = lookup.method(jsBridgeClass, "callJsModuleLoader", "(Ljava/lang/String;)Ljava/lang/String;");
+  jsBridgeCreateJsLambdaProxy = lookup.method(jsBridgeClass, "createJsLambdaProxy", "(Ljava/lang/String;L" JSBRIDGE_PKG_PATH "/Method;)Lkotlin/Function;");
+  jsBridgeAppendConsoleMessages = lookup.method(jsBridgeClass, "appendConsoleMessages", "([I[Ljava/lang/String;)V");
+  jsBridgeResolveDeferred = lookup.method(jsBridgeClass, "resolveDeferred", "(Lkotlinx/coroutines/CompletableDeferred;Ljava/lang/Object;)V");
+  jsBridgeRejectDeferred = lookup.method(jsBridgeClass, "rejectDeferred", "(Lkotlinx/coroutines/CompletableDeferred;L" JSBRIDGE_PKG_PATH "/JsException;)V");
+  jsBridgeCreateCompletableDeferred = lookup.method(jsBridgeClass, "createCompletableDeferred", "()Lkotlinx/coroutines/CompletableDeferred;");
+  jsBridgeSetUpJsPromise = lookup.method(jsBridgeClass, "setUpJsPromise", "(Ljava/lang/String;Lkotlinx/coroutines/Deferred;)V");
+  jsBridgeAddUnhandledJsPromiseException = lookup.method(jsBridgeClass, "addUnhandledJsPromiseException", "(L" JSBRIDGE_PKG_PATH "/JsException;)V");
+  jsBridgeScheduleTimerWakeup = lookup.method(jsBridgeClass, "scheduleTimerWakeup", "(J)V");
+  jsBridgeOnWorkerMessagePosted = lookup.method(jsBridgeClass, "onWorkerMessagePosted", "(J)V");
+  jsBridgeGetCustomClassLoader = lookup.method(jsBridgeClass, "getCustomClassLoader", "()Ljava/lang/ClassLoader;");
+
+  // de.prosiebensat1digital.oasisjsbridge.Method
+  const auto &methodClass = jniCache->getJsBridgeMethodClass();
+  methodGetJavaMethod = lookup.method(methodClass, "getJavaMethod", "()Ljava/lang/reflect/Method;");
+  methodGetName = lookup.method(methodClass, "getName", "()Ljava/lang/String;");
+  methodCallJavaLambda = lookup.method(methodClass, "callJavaLambda", "(Ljava/lang/Object;[Ljava/lang/Object;)Ljava/lang/Object;");
+  methodGetReturnParameter = lookup.method(methodClass, "getReturnParameter", "()L" JSBRIDGE_PKG_PATH "/Parameter;");
+  methodGetParameters = lookup.method(methodClass, "getParameters", "()[L" JSBRIDGE_PKG_PATH "/Parameter;");
+  methodIsVarArgs = lookup.method(methodClass, "isVarArgs", "()Z");
+
+  // de.prosiebensat1digital.oasisjsbridge.Parameter
+  const auto &parameterClass = jniCache->getJsBridgeParameterClass();
+  parameterInit = lookup.method(parameterClass, "<init>", "(Ljava/lang/Class;Ljava/lang/ClassLoader;)V");
+  parameterGetInvokeMethod = lookup.method(parameterClass, "getInvokeMethod", "()L" JSBRIDGE_PKG_PATH "/Method;");
+  parameterGetMethods = lookup.method(parameterClass, "getMethods", "()[L" JSBRIDGE_PKG_PATH "/Method;");
+  parameterGetJava = lookup.method(parameterClass, "getJava", "()Ljava/lang/Class;");
+  parameterGetJavaName = lookup.method(parameterClass, "getJavaName", "()Ljava/lang/String;");
+  parameterIsNullable = lookup.method(parameterClass, "isNullable", "()Z");
+  parameterGetGenericParameter = lookup.method(parameterClass, "getGenericParameter", "()L" JSBRIDGE_PKG_PATH "/Parameter;");
+  parameterGetName = lookup.method(parameterClass, "getName", "()Ljava/lang/String;");
+  parameterGetParentMethod = lookup.method(parameterClass, "getParentMethod", "()L" JSBRIDGE_PKG_PATH "/Method;");
+  parameterGetParentMethodName = lookup.method(parameterClass, "getParentMethodName", "()Ljava/lang/String;");
+  parameterIsDataClass = lookup.method(parameterClass, "isDataClass", "()Z");
+  parameterGetDataClassConstructor = lookup.method(parameterClass, "getDataClassConstructor", "()Ljava/lang/reflect/Constructor;");
+  parameterGetDataClassParameters = lookup.method(parameterClass, "getDataClassParameters", "()[L" JSBRIDGE_PKG_PATH "/Parameter;");
+  parameterGetDataClassFields = lookup.method(parameterClass, "getDataClassFields", "()[Ljava/lang/reflect/Field;");
+
+  // Other de.prosiebensat1digital.oasisjsbridge classes
+  jsExceptionInit = lookup.method(jniCache->getJsExceptionClass(), "<init>", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/Throwable;)V");
+
+  const auto &debugStringClass = jniCache->getJavaClass(JavaTypeId::DebugString);
+  debugStringInit = lookup.method(debugStringClass, "<init>", "(Ljava/lang/String;)V");
+  debugStringGetString = lookup.method(debugStringClass, "getString", "()Ljava/lang/String;");
+
+  const auto &jsValueClass = jniCache->getJavaClass(JavaTypeId::JsValue);
+  jsValueInit = lookup.method(jsValueClass, "<init>", "(L" JSBRIDGE_PKG_PATH "/JsBridge;Ljava/lang/String;)V");
+  jsValueGetAssociatedJsName = lookup.method(jsValueClass, "getAssociatedJsName", "()Ljava/lang/String;");
+
+  const auto &jsonObjectWrapperClass = jniCache->getJavaClass(JavaTypeId::JsonObjectWrapper);
+  jsonObjectWrapperInit = lookup.method(jsonObjectWrapperClass, "<init>", "(Ljava/lang/String;)V");
+  jsonObjectWrapperGetJsonString = lookup.method(jsonObjectWrapperClass, "getJsonString", "()Ljava/lang/String;");
+
+  const auto &javaObjectWrapperClass = jniCache->getJavaClass(JavaTypeId::JavaObjectWrapper);
+  javaObjectWrapperGetOrCreate = lookup.staticMethod(javaObjectWrapperClass, "getOrCreate", "(Ljava/lang/Object;)L" JSBRIDGE_PKG_PATH "/JavaObjectWrapper;");
+  javaObjectWrapperFromJavaObject = lookup.staticMethod(javaObjectWrapperClass, "fromJavaObject", "(Ljava/lang/Object;)L" JSBRIDGE_PKG_PATH "/JavaObjectWrapper;");
+  javaObjectWrapperExtractJavaObject = lookup.method(javaObjectWrapperClass, "extractJavaObject", "()Ljava/lang/Object;");
+
+  jsToJavaProxyInit = lookup.method(jniCache->getJavaClass(JavaTypeId::JsToJavaProxy), "<init>", "(L" JSBRIDGE_PKG_PATH "/JsBridge;L" JSBRIDGE_PKG_PATH "/JsToJavaInterface;Ljava/lang/String;)V");
+
+  const auto &payloadObjectClass = jniCache->getJavaClass(JavaTypeId::PayloadObject);
+  payloadObjectInit = lookup.method(payloadObjectClass, "<init>", "(Ljava/util/HashMap;)V");
+  payloadObjectValues = lookup.field(payloadObjectClass, "values", "Ljava/util/HashMap;");
+
+  const auto &payloadArrayClass = jniCache->getJavaClass(JavaTypeId::PayloadArray);
+  payloadArrayInit = lookup.method(payloadArrayClass, "<init>", "(I)V");
+  payloadArrayGetArray = lookup.method(payloadArrayClass, "getArray", "()[Ljava/lang/Object;");
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JNIIDS_H
+#define _JSBRIDGE_JNIIDS_H
+
+#include <jni.h>
+#include <cstdint>
+
+class JniCache;
+class JniContext;
+
+// Registry of the JNI method and field IDs of all the Java methods called by the bridge.
+//
+// The IDs are resolved once when the JniCache is created, from the classes held by that JniCache
+// (and thus loaded by the same class loader). They are then valid on all threads for the lifetime
+// of the JniCache, so that no GetMethodID() call happens on the conversion and call paths.
+struct JniIds {
+  JniIds(const JniContext *, const JniCache *);
+
+  JniIds(const JniIds &) = delete;
+  JniIds &operator=(const JniIds &) = delete;
+
+  // Total number of ID lookups made by the bridge (for tests)
+  static uint64_t getLookupCount();
+
+  // java.lang.Object, java.lang.Class, java.lang.Throwable, java.lang.reflect.Method
+  jmethodID objectGetClass;
+  jmethodID classGetName;
+  jmethodID classGetComponentType;
+  jmethodID classGetPrimitiveClass;  // static
+  jmethodID throwableGetMessage;
+  jmethodID reflectedMethodGetName;
+
+  // Boxed primitives (static valueOf() + unboxing method)
+  jmethodID booleanValueOf;
+  jmethodID booleanBooleanValue;
+  jmethodID byteValueOf;
+  jmethodID byteByteValue;
+  jmethodID shortValueOf;
+  jmethodID shortShortValue;
+  jmethodID integerValueOf;
+  jmethodID integerIntValue;
+  jmethodID longValueOf;
+  jmethodID longLongValue;
+  jmethodID floatValueOf;
+  jmethodID floatFloatValue;
+  jmethodID doubleValueOf;
+  jmethodID doubleDoubleValue;
+  jmethodID numberDoubleValue;
+  jmethodID unitInit;
+
+  // java.util collections
+  jmethodID arrayListInit;
+  jmethodID listAdd;
+  jmethodID listSize;
+  jmethodID listGet;
+  jmethodID lazyListInit;
+  jmethodID lazyListGetJsArray;
+  jmethodID jsArrayListInit;
+  jmethodID hashMapInit;  // HashMap(int)
+  jmethodID hashMapPut;
+  jmethodID hashMapEntrySet;
+  jmethodID setToArray;
+  jmethodID mapEntryGetKey;
+  jmethodID mapEntryGetValue;
+
+  // de.prosiebensat1digital.oasisjsbridge.JsBridge
+  jmethodID jsBridgeCheckJsThread;
+  jmethodID jsBridgeOnDebuggerPending;
+  jmethodID jsBridgeOnDebuggerReady;
+  jmethodID jsBridgeCallJsModuleLoader;
+  jmethodID jsBridgeCreateJsLambdaProxy;
+  jmethodID jsBridgeAppendConsoleMessages;
+  jmethodID jsBridgeResolveDeferred;
+  jmethodID jsBridgeRejectDeferred;
+  jmethodID jsBridgeCreateCompletableDeferred;
+  jmethodID jsBridgeSetUpJsPromise;
+  jmethodID jsBridgeAddUnhandledJsPromiseException;
+  jmethodID jsBridgeScheduleTimerWakeup;
+  jmethodID jsBridgeOnWorkerMessagePosted;
+  jmethodID jsBridgeGetCustomClassLoader;
+
+  // de.prosiebensat1digital.oasisjsbridge.Method
+  jmethodID methodGetJavaMethod;
+  jmethodID methodGetName;
+  jmethodID methodCallJavaLambda;
+  jmethodID methodGetReturnParameter;
+  jmethodID methodGetParameters;
+  jmethodID methodIsVarArgs;
+
+  // de.prosiebensat1digital.oasisjsbridge.Parameter
+  jmethodID parameterInit;
+  jmethodID parameterGetInvokeMethod;
+  jmethodID parameterGetMethods;
+  jmethodID parameterGetJava;
+  jmethodID parameterGetJavaName;
+  jmethodID parameterIsNullable;
+  jmethodID parameterGetGenericParameter;
+  jmethodID parameterGetName;
+  jmethodID parameterGetParentMethod;
+  jmethodID parameterGetParentMethodName;
+  jmethodID parameterIsDataClass;
+  jmethodID parameterGetDataClassConstructor;
+  jmethodID parameterGetDataClassParameters;
+  jmethodID parameterGetDataClassFields;
+
+  // Other de.prosiebensat1digital.oasisjsbridge classes
+  jmethodID jsExceptionInit;
+  jmethodID debugStringInit;
+  jmethodID debugStringGetString;
+  jmethodID jsValueInit;
+  jmethodID jsValueGetAssociatedJsName;
+  jmethodID jsonObjectWrapperInit;
+  jmethodID jsonObjectWrapperGetJsonString;
+  jmethodID javaObjectWrapperGetOrCreate;  // static
+  jmethodID javaObjectWrapperFromJavaObject;  // static
+  jmethodID javaObjectWrapperExtractJavaObject;
+  jmethodID jsToJavaProxyInit;
+  jmethodID payloadObjectInit;  // PayloadObject(HashMap)
+  jfieldID payloadObjectValues;
+  jmethodID payloadArrayInit;  // PayloadArray(int)
+  jmethodID payloadArrayGetArray;
+};
+
+#endif
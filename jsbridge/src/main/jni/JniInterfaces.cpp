@@ -22,78 +22,61 @@
 // ---
 
 JsBridgeInterface::JsBridgeInterface(const JniCache *cache, const JniRef<jobject> &object)
- : JniInterface(cache, cache->getJsBridgeClass(), object) {
+ : JniInterface(cache, object) {
 }
 
 void JsBridgeInterface::checkJsThread() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "checkJsThread", "()V");
-  m_jniCache->getJniContext()->callVoidMethod(m_object, methodId);
+  m_jniCache->getJniContext()->callVoidMethod(m_object, m_jniCache->getIds().jsBridgeCheckJsThread);
 }
 
 void JsBridgeInterface::onDebuggerPending() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "onDebuggerPending", "()V");
-  m_jniCache->getJniContext()->callVoidMethod(m_object, methodId);
+  m_jniCache->getJniContext()->callVoidMethod(m_object, m_jniCache->getIds().jsBridgeOnDebuggerPending);
 }
 
 void JsBridgeInterface::onDebuggerReady() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "onDebuggerReady", "()V");
-  m_jniCache->getJniContext()->callVoidMethod(m_object, methodId);
+  m_jniCache->getJniContext()->callVoidMethod(m_object, m_jniCache->getIds().jsBridgeOnDebuggerReady);
 }
 
 JStringLocalRef JsBridgeInterface::callJsModuleLoader(const JStringLocalRef &moduleName) const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "callJsModuleLoader", "(Ljava/lang/String;)Ljava/lang/String;");
-  return m_jniCache->getJniContext()->callStringMethod(m_object, methodId, moduleName);
+  return m_jniCache->getJniContext()->callStringMethod(m_object, m_jniCache->getIds().jsBridgeCallJsModuleLoader, moduleName);
 }
 
 JniLocalRef<jobject> JsBridgeInterface::createJsLambdaProxy(
     const JStringLocalRef &globalName, const JniRef<jsBridgeMethod> &method) const {
 
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-      m_class, "createJsLambdaProxy",
-      "(Ljava/lang/String;L" JSBRIDGE_PKG_PATH "/Method;)Lkotlin/Function;");
-
-  return m_jniCache->getJniContext()->callObjectMethod(m_object, methodId, globalName, method);
+  return m_jniCache->getJniContext()->callObjectMethod(m_object, m_jniCache->getIds().jsBridgeCreateJsLambdaProxy, globalName, method);
 }
 
-void JsBridgeInterface::consoleLogHelper(const JStringLocalRef &logType, const JStringLocalRef &msg) const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-      m_class, "consoleLogHelper", "(Ljava/lang/String;Ljava/lang/String;)V");
-
-  m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, logType, msg);
+void JsBridgeInterface::appendConsoleMessages(const JArrayLocalRef<jint> &priorities, const JObjectArrayLocalRef &messages) const {
+  m_jniCache->getJniContext()->callVoidMethod(m_object, m_jniCache->getIds().jsBridgeAppendConsoleMessages, priorities, messages);
 }
 
 void JsBridgeInterface::resolveDeferred(const JniRef<jobject> &javaDeferred, const JValue &value) const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-      m_class, "resolveDeferred",
-      "(Lkotlinx/coroutines/CompletableDeferred;Ljava/lang/Object;)V");
-
-  m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, javaDeferred, value);
+  m_jniCache->getJniContext()->callVoidMethod(m_object, m_jniCache->getIds().jsBridgeResolveDeferred, javaDeferred, value);
 }
 
 void JsBridgeInterface::rejectDeferred(const JniRef<jobject> &javaDeferred, const JValue &exception) const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-      m_class, "rejectDeferred",
-      "(Lkotlinx/coroutines/CompletableDeferred;L" JSBRIDGE_PKG_PATH "/JsException;)V");
-
-  m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, javaDeferred, exception);
+  m_jniCache->getJniContext()->callVoidMethod(m_object, m_jniCache->getIds().jsBridgeRejectDeferred, javaDeferred, exception);
 }
 
 JniLocalRef<jobject> JsBridgeInterface::createCompletableDeferred() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-        m_class, "createCompletableDeferred", "()Lkotlinx/coroutines/CompletableDeferred;");
-  return m_jniCache->getJniContext()->callObjectMethod(m_object, methodId);
+  return m_jniCache->getJniContext()->callObjectMethod(m_object, m_jniCache->getIds().jsBridgeCreateCompletableDeferred);
 }
 
 void JsBridgeInterface::setUpJsPromise(const JStringLocalRef &name, const JniRef<jobject> &deferred) const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-        m_class, "setUpJsPromise", "(Ljava/lang/String;Lkotlinx/coroutines/Deferred;)V");
-  m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, name, deferred);
+  m_jniCache->getJniContext()->callVoidMethod(m_object, m_jniCache->getIds().jsBridgeSetUpJsPromise, name, deferred);
 }
 
 void JsBridgeInterface::addUnhandledJsPromiseException(const JValue &exception) const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-          m_class, "addUnhandledJsPromiseException", "(L" JSBRIDGE_PKG_PATH "/JsException;)V");
-  m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, exception);
+  m_jniCache->getJniContext()->callVoidMethod(m_object, m_jniCache->getIds().jsBridgeAddUnhandledJsPromiseException, exception);
+}
+
+void JsBridgeInterface::scheduleTimerWakeup(jlong delayMs) const {
+  m_jniCache->getJniContext()->callVoidMethod(m_object, m_jniCache->getIds().jsBridgeScheduleTimerWakeup, delayMs);
+}
+
+void JsBridgeInterface::onWorkerMessagePosted(jlong channelHandle) const {
+  m_jniCache->getJniContext()->callVoidMethod(m_object, m_jniCache->getIds().jsBridgeOnWorkerMessagePosted, channelHandle);
 }
 
 
@@ -101,45 +84,31 @@ void JsBridgeInterface::addUnhandledJsPromiseException(const JValue &exception)
 // ---
 
 MethodInterface::MethodInterface(const JniCache *cache, const JniRef<jsBridgeMethod> &method)
- : JniInterface(cache, cache->getJsBridgeMethodClass(), method) {
+ : JniInterface(cache, method) {
 }
 
 JniLocalRef<jobject> MethodInterface::getJavaMethod() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getJavaMethod", "()Ljava/lang/reflect/Method;");
-  return m_jniCache->getJniContext()->callObjectMethod(m_object, methodId);
+  return m_jniCache->getJniContext()->callObjectMethod(m_object, m_jniCache->getIds().methodGetJavaMethod);
 }
 
 JStringLocalRef MethodInterface::getName() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getName", "()Ljava/lang/String;");
-  return m_jniCache->getJniContext()->callStringMethod(m_object, methodId);
+  return m_jniCache->getJniContext()->callStringMethod(m_object, m_jniCache->getIds().methodGetName);
 }
 
 JniLocalRef<jobject> MethodInterface::callJavaLambda(const JniRef<jobject> &lambda, const JObjectArrayLocalRef &args) const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-          m_class, "callJavaLambda",
-          "(Ljava/lang/Object;[Ljava/lang/Object;)Ljava/lang/Object;");
-
-  return m_jniCache->getJniContext()->callObjectMethod(m_object, methodId, lambda, args);
+  return m_jniCache->getJniContext()->callObjectMethod(m_object, m_jniCache->getIds().methodCallJavaLambda, lambda, args);
 }
 
 JniLocalRef<jsBridgeParameter> MethodInterface::getReturnParameter() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-        m_class, "getReturnParameter",
-        "()L" JSBRIDGE_PKG_PATH "/Parameter;");
-
-  return m_jniCache->getJniContext()->callObjectMethod<jsBridgeParameter>(m_object, methodId);
+  return m_jniCache->getJniContext()->callObjectMethod<jsBridgeParameter>(m_object, m_jniCache->getIds().methodGetReturnParameter);
 }
 
 JObjectArrayLocalRef MethodInterface::getParameters() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-        m_class, "getParameters", "()[L" JSBRIDGE_PKG_PATH "/Parameter;");
-
-  return JObjectArrayLocalRef(m_jniCache->getJniContext()->callObjectMethod<jobjectArray>(m_object, methodId));
+  return JObjectArrayLocalRef(m_jniCache->getJniContext()->callObjectMethod<jobjectArray>(m_object, m_jniCache->getIds().methodGetParameters));
 }
 
 jboolean MethodInterface::isVarArgs() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "isVarArgs", "()Z");
-  return m_jniCache->getJniContext()->callBooleanMethod(m_object, methodId);
+  return m_jniCache->getJniContext()->callBooleanMethod(m_object, m_jniCache->getIds().methodIsVarArgs);
 }
 
 
@@ -147,62 +116,58 @@ jboolean MethodInterface::isVarArgs() const {
 // ---
 
 ParameterInterface::ParameterInterface(const JniCache *cache, const JniRef<jsBridgeParameter> &parameter)
- : JniInterface(cache, cache->getJsBridgeParameterClass(), parameter) {
+ : JniInterface(cache, parameter) {
 }
 
-
 JniLocalRef<jsBridgeMethod> ParameterInterface::getInvokeMethod() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-      m_class,
-      "getInvokeMethod",
-      "()L" JSBRIDGE_PKG_PATH "/Method;"
-  );
-
-  return m_jniCache->getJniContext()->callObjectMethod<jsBridgeMethod>(m_object, methodId);
+  return m_jniCache->getJniContext()->callObjectMethod<jsBridgeMethod>(m_object, m_jniCache->getIds().parameterGetInvokeMethod);
 }
 
 JObjectArrayLocalRef ParameterInterface::getMethods() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-          m_class,
-          "getMethods",
-          "()[L" JSBRIDGE_PKG_PATH "/Method;"
-  );
-
-  auto localRef = m_jniCache->getJniContext()->callObjectMethod<jobjectArray>(m_object, methodId);
+  auto localRef = m_jniCache->getJniContext()->callObjectMethod<jobjectArray>(m_object, m_jniCache->getIds().parameterGetMethods);
   return JObjectArrayLocalRef(localRef);
 }
 
 JniLocalRef<jclass> ParameterInterface::getJava() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getJava", "()Ljava/lang/Class;");
-  return m_jniCache->getJniContext()->callObjectMethod<jclass>(m_object, methodId);
+  return m_jniCache->getJniContext()->callObjectMethod<jclass>(m_object, m_jniCache->getIds().parameterGetJava);
 }
 
 JStringLocalRef ParameterInterface::getJavaName() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getJavaName", "()Ljava/lang/String;");
-  return m_jniCache->getJniContext()->callStringMethod(m_object, methodId);
+  return m_jniCache->getJniContext()->callStringMethod(m_object, m_jniCache->getIds().parameterGetJavaName);
 }
 
 jboolean ParameterInterface::isNullable() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "isNullable", "()Z");
-  return m_jniCache->getJniContext()->callBooleanMethod(m_object, methodId);
+  return m_jniCache->getJniContext()->callBooleanMethod(m_object, m_jniCache->getIds().parameterIsNullable);
 }
 
 JniLocalRef<jsBridgeParameter> ParameterInterface::getGenericParameter() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getGenericParameter", "()L" JSBRIDGE_PKG_PATH "/Parameter;");
-  return m_jniCache->getJniContext()->callObjectMethod<jsBridgeParameter>(m_object, methodId);
+  return m_jniCache->getJniContext()->callObjectMethod<jsBridgeParameter>(m_object, m_jniCache->getIds().parameterGetGenericParameter);
 }
 
 JStringLocalRef ParameterInterface::getName() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getName", "()Ljava/lang/String;");
-  return m_jniCache->getJniContext()->callStringMethod(m_object, methodId);
+  return m_jniCache->getJniContext()->callStringMethod(m_object, m_jniCache->getIds().parameterGetName);
 }
 
 JniLocalRef<jsBridgeMethod> ParameterInterface::getParentMethod() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getParentMethod", "()L" JSBRIDGE_PKG_PATH "/Method;");
-  return m_jniCache->getJniContext()->callObjectMethod<jsBridgeMethod>(m_object, methodId);
+  return m_jniCache->getJniContext()->callObjectMethod<jsBridgeMethod>(m_object, m_jniCache->getIds().parameterGetParentMethod);
 }
 
 JStringLocalRef ParameterInterface::getParentMethodName() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getParentMethodName", "()Ljava/lang/String;");
-  return m_jniCache->getJniContext()->callStringMethod(m_object, methodId);
+  return m_jniCache->getJniContext()->callStringMethod(m_object, m_jniCache->getIds().parameterGetParentMethodName);
+}
+
+jboolean ParameterInterface::isDataClass() const {
+  return m_jniCache->getJniContext()->callBooleanMethod(m_object, m_jniCache->getIds().parameterIsDataClass);
+}
+
+JniLocalRef<jobject> ParameterInterface::getDataClassConstructor() const {
+  return m_jniCache->getJniContext()->callObjectMethod(m_object, m_jniCache->getIds().parameterGetDataClassConstructor);
+}
+
+JObjectArrayLocalRef ParameterInterface::getDataClassParameters() const {
+  return JObjectArrayLocalRef(m_jniCache->getJniContext()->callObjectMethod<jobjectArray>(m_object, m_jniCache->getIds().parameterGetDataClassParameters));
+}
+
+JObjectArrayLocalRef ParameterInterface::getDataClassFields() const {
+  return JObjectArrayLocalRef(m_jniCache->getJniContext()->callObjectMethod<jobjectArray>(m_object, m_jniCache->getIds().parameterGetDataClassFields));
 }
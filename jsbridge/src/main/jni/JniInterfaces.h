@@ -17,6 +17,7 @@
 #define _JSBRIDGE_JNIINTERFACES_H
 
 #include "JniTypes.h"
+#include "jni-helpers/JArrayLocalRef.h"
 #include "jni-helpers/JniGlobalRef.h"
 #include "jni-helpers/JObjectArrayLocalRef.h"
 #include "jni-helpers/JStringLocalRef.h"
@@ -31,11 +32,11 @@ public:
   const JniRef<T> &object() const { return m_object; }
 
 protected:
-  JniInterface(const JniCache *cache, const JniRef<jclass> &javaClass, const JniRef<T> &object)
-    : m_jniCache(cache) , m_class(javaClass) , m_object(object) {}
+  // The method IDs are taken from the JniIds of the given cache
+  JniInterface(const JniCache *cache, const JniRef<T> &object)
+    : m_jniCache(cache) , m_object(object) {}
 
   const JniCache * const m_jniCache;
-  JniGlobalRef<jclass> m_class;
   JniGlobalRef<T> m_object;
 };
 
@@ -49,12 +50,14 @@ public:
   void onDebuggerReady() const;
   JStringLocalRef callJsModuleLoader(const JStringLocalRef &moduleName) const;
   JniLocalRef<jobject> createJsLambdaProxy(const JStringLocalRef &, const JniRef<jsBridgeMethod> &) const;
-  void consoleLogHelper(const JStringLocalRef &logType, const JStringLocalRef &msg) const;
+  void appendConsoleMessages(const JArrayLocalRef<jint> &priorities, const JObjectArrayLocalRef &messages) const;
   void resolveDeferred(const JniRef<jobject> &javaDeferred, const JValue &) const;
   void rejectDeferred(const JniRef<jobject> &javaDeferred, const JValue &exception) const;
   JniLocalRef<jobject> createCompletableDeferred() const;
   void setUpJsPromise(const JStringLocalRef &, const JniRef<jobject> &deferred) const;
   void addUnhandledJsPromiseException(const JValue &exception) const;
+  void scheduleTimerWakeup(jlong delayMs) const;
+  void onWorkerMessagePosted(jlong channelHandle) const;
 };
 
 // de.prosiebensat1digital.oasisjsbridge.Method
@@ -84,6 +87,10 @@ public:
   JStringLocalRef getName() const;
   JniLocalRef<jsBridgeMethod> getParentMethod() const;
   JStringLocalRef getParentMethodName() const;
+  jboolean isDataClass() const;
+  JniLocalRef<jobject> getDataClassConstructor() const;
+  JObjectArrayLocalRef getDataClassParameters() const;
+  JObjectArrayLocalRef getDataClassFields() const;
 };
 
 #endif
@@ -20,11 +20,15 @@
 #define _JSBRIDGE_JSBRIDGECONTEXT_H
 
 #include "JavaTypeProvider.h"
+#include "TimerWheel.h"
+#include "WorkerChannel.h"
 #include "jni-helpers/JniLocalRef.h"
 #include "jni-helpers/JniContext.h"
 #include "jni-helpers/JObjectArrayLocalRef.h"
 #include <jni.h>
+#include <memory>
 #include <string>
+#include <vector>
 
 #if defined(DUKTAPE)
 # include "duktape/duktape.h"
@@ -32,12 +36,16 @@
 # include "quickjs/quickjs.h"
 #endif
 
+class Console;
 class DuktapeUtils;
 class ExceptionHandler;
 class JavaType;
 class JniCache;
 class JObjectArrayLocalRef;
+class MappedFile;
 class QuickJsUtils;
+class ScriptCache;
+class StringInternCache;
 
 // JS context, delegating operations to the JS engine.
 class JsBridgeContext {
@@ -55,12 +63,15 @@ public:
   void startDebugger(int port);
   void cancelDebug();
 
-  void enableModuleLoader();
+  // Compiled modules are cached in memory and in the given directory (if not empty)
+  void enableModuleLoader(const std::string &compiledModuleCacheDir);
   std::string getCurrentScriptOrModuleName(int level) const;
 
   JValue evaluateString(const JStringLocalRef &strSourceCode, const JniLocalRef<jsBridgeParameter> &returnParameter,
                         bool awaitJsPromise) const;
   void evaluateFileContent(const JStringLocalRef &strSourceCode, const std::string &strFileName, bool asModule) const;
+  // Evaluate UTF-8 source code or bytecode (compiled by the same JS engine) without copying it
+  void evaluateFile(const MappedFile &file, const std::string &strFileName, bool isBytecode, bool asModule) const;
 
   void registerJavaObject(const std::string &strName, const JniLocalRef<jobject> &object,
                                   const JObjectArrayLocalRef &methods);
@@ -74,18 +85,79 @@ public:
                               bool awaitJsPromise);
 
   void assignJsValue(const std::string &strGlobalName, const JStringLocalRef &strCode);
-  void deleteJsValue(const std::string &strGlobalName);
+  // Delete the global values of released JsValue instances (batched)
+  void deleteJsValues(const std::vector<std::string> &globalNames);
   void copyJsValue(const std::string &strGlobalNameTo, const std::string &strGlobalNameFrom);
+  // Structured clone of a global value, which can be read by another context of the same engine
+  std::string writeStructuredClone(const std::string &strGlobalName) const;
+  void readStructuredClone(const std::string &strGlobalName, const std::string &buffer);
   void newJsFunction(const std::string &strGlobalName, const JObjectArrayLocalRef &args, const JStringLocalRef &strCode);
 
   void convertJavaValueToJs(const std::string &strGlobalName, const JniLocalRef<jobject> &javaValue, const JniLocalRef<jsBridgeParameter> &parameter);
 
-  void processPromiseQueue();
+  // Direct operations on the (global) JS value of a JsValue, without evaluating any JS code. A null
+  // key reads the value itself, a null method name calls the value itself.
+  JValue getJsValueProperty(const std::string &strGlobalName, const JStringLocalRef &strKey,
+                            const JniLocalRef<jsBridgeParameter> &returnParameter, bool awaitJsPromise) const;
+  void setJsValueProperty(const std::string &strGlobalName, const JStringLocalRef &strKey,
+                          const JniLocalRef<jobject> &javaValue, const JniLocalRef<jsBridgeParameter> &parameter);
+  bool hasJsValueProperty(const std::string &strGlobalName, const JStringLocalRef &strKey) const;
+  // Own enumerable string keys, like Object.keys() (empty for primitive values)
+  JObjectArrayLocalRef getJsValueKeys(const std::string &strGlobalName) const;
+  JValue callJsValue(const std::string &strGlobalName, const JStringLocalRef &strMethodName,
+                     const JObjectArrayLocalRef &args, const JObjectArrayLocalRef &argParameters,
+                     const JniLocalRef<jsBridgeParameter> &returnParameter, bool awaitJsPromise);
+
+  // Execute at most maxJobs pending jobs (e.g. promise reactions) within maxMicros microseconds
+  // (negative = no limit) and return true if some jobs are still pending afterwards
+  bool runJobs(int maxJobs, int64_t maxMicros);
+  void processPromiseQueue() { runJobs(-1, -1); }
+  uint64_t getDrainedJobCount() const { return m_drainedJobCount; }
+
+  // Native stack bounds used for the stack overflow checks of the JS engine. Must be called when
+  // another thread takes the JS context.
+  void updateStackTop();
+
+  // LRU cache of the JS strings created from short Java strings (see StringInternCache)
+  void enableStringInterning(size_t maxEntryCount, size_t maxStringLength);
+  StringInternCache *getStringInternCache() const { return m_stringInternCache; }
+
+  // LRU cache of the scripts compiled by evaluateString(), newJsFunction() and (Duktape)
+  // assignJsValue()
+  void enableScriptCache(size_t maxEntryCount, size_t maxSourceLength);
+  ScriptCache *getScriptCache() const { return m_scriptCache; }
+
+  // Native setTimeout(), setInterval(), clearTimeout() and clearInterval()
+  void enableTimers();
+  // Fire the expired timers and schedule the next wakeup (via JsBridge.scheduleTimerWakeup())
+  void runTimers();
+#if defined(DUKTAPE)
+  // Pops the timer entry ([callback, args...]) from the stack
+  int addTimer(int64_t delayMs, bool repeat);
+#elif defined(QUICKJS)
+  // Takes ownership of the timer entry ([callback, args...])
+  int addTimer(int64_t delayMs, bool repeat, JSValue entry);
+#endif
+  void removeTimer(int id);
+
+  // Worker messaging: set up postMessage() and onmessage for the given side of the channel, on
+  // the global object (worker side) or on a new object assigned to the given global name (parent side)
+  void setUpWorkerEndpoint(const std::string &strGlobalName, const std::shared_ptr<WorkerChannel> &channel,
+                           jlong channelHandle, WorkerChannel::Side side);
+  // Call onmessage({ data }) for each message posted to the given side
+  void dispatchWorkerMessages(const std::string &strGlobalName, WorkerChannel &channel, WorkerChannel::Side side);
+  // Called by postMessage() with the serialized message
+  void postWorkerMessage(const WorkerEndpoint &endpoint, std::string &&message);
+
+  // Nesting level of the JNI calls which execute JS code (JS -> Java -> JS calls are re-entrant)
+  int enterJniCall() { return ++m_jniCallDepth; }
+  int leaveJniCall() { return --m_jniCallDepth; }
 
   JniContext *getJniContext() { return m_jniContext; }
   const JniContext *getJniContext() const { return m_jniContext; }
   const JniCache *getJniCache() const { return m_jniCache; }
   const ExceptionHandler *getExceptionHandler() const { return m_exceptionHandler; }
+  Console *getConsole() const { return m_console; }
 
   const JavaTypeProvider &getJavaTypeProvider() const { return m_javaTypeProvider; }
 
@@ -99,6 +171,8 @@ public:
 
   QuickJsUtils *getUtils() const { return m_utils; }
   JSContext *getQuickJsContext() const { return m_ctx; };
+  const std::string &getCompiledModuleCacheDir() const { return m_compiledModuleCacheDir; }
+  JSValueConst getStructuredCloneIntrinsics() const { return m_structuredCloneIntrinsics; }
 #endif
 
 private:
@@ -106,9 +180,33 @@ private:
   JniContext *m_jniContext = nullptr;
   JniCache *m_jniCache = nullptr;
   ExceptionHandler *m_exceptionHandler = nullptr;
+  Console *m_console = nullptr;
+  StringInternCache *m_stringInternCache = nullptr;
+  ScriptCache *m_scriptCache = nullptr;
 
   const JavaTypeProvider m_javaTypeProvider;
 
+  int m_jniCallDepth = 0;
+  uint64_t m_drainedJobCount = 0;
+
+#if defined(DUKTAPE)
+  // [...] -> [... result] and DUK_EXEC_SUCCESS or [... error] and DUK_EXEC_ERROR
+  duk_int_t pevalScript(const char *source, size_t length) const;
+  // Pop the result of an evaluation or call and convert it to the given Java type (or guess it)
+  JValue popReturnValue(const JniLocalRef<jsBridgeParameter> &returnParameter, bool awaitJsPromise) const;
+#elif defined(QUICKJS)
+  // Evaluate a global script (via the script cache, if enabled)
+  JSValue evalScript(const char *source, size_t length, const char *fileName) const;
+  // Convert the result of an evaluation or call to the given Java type (or guess it)
+  JValue toJavaReturnValue(JSValueConst v, const JniLocalRef<jsBridgeParameter> &returnParameter, bool awaitJsPromise) const;
+  JSValue getGlobalValue(const std::string &strGlobalName) const;
+#endif
+  void scheduleTimerWakeup();
+
+  TimerWheel m_timerWheel;
+  int64_t m_scheduledTimerWakeup = -1;  // -1 = no wakeup scheduled
+  bool m_isRunningTimers = false;
+
 #if defined(DUKTAPE)
   duk_context *m_ctx = nullptr;
   DuktapeUtils *m_utils = nullptr;
@@ -116,6 +214,9 @@ private:
   JSRuntime *m_runtime = nullptr;
   JSContext *m_ctx = nullptr;
   QuickJsUtils *m_utils = nullptr;
+  JSValue m_timerEntries = JS_UNDEFINED;
+  JSValue m_structuredCloneIntrinsics = JS_UNDEFINED;
+  std::string m_compiledModuleCacheDir;
 #endif
 };
 
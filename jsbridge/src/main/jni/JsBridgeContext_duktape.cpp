@@ -18,20 +18,29 @@
  */
 #include "JsBridgeContext.h"
 
+#include "Console.h"
 #include "DuktapeUtils.h"
 #include "ExceptionHandler.h"
 #include "JavaObject.h"
 #include "JavaScriptLambda.h"
 #include "JavaScriptObject.h"
 #include "JniCache.h"
+#include "JsStrings.h"
+#include "LocalFrameBatch.h"
+#include "MappedFile.h"
+#include "ScriptCache.h"
 #include "StackChecker.h"
+#include "StringInternCache.h"
 #include "log.h"
+#include "structured_clone.h"
+#include "exceptions/JniException.h"
 #include "exceptions/JsException.h"
 #include "java-types/Deferred.h"
 #include "jni-helpers/JniGlobalRef.h"
 #include "jni-helpers/JObjectArrayLocalRef.h"
 #include "jni-helpers/JStringLocalRef.h"
 #include "duktape/duk_trans_socket.h"
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <stdexcept>
@@ -43,11 +52,50 @@
 
 namespace {
   const char *JSBRIDGE_CPP_CLASS_PROP_NAME = "\xff\xffjsbridge_cpp";
+  const char *TIMER_ENTRIES_PROP_NAME = "\xff\xfftimer_entries";
+  const char *WORKER_ENDPOINT_PROP_NAME = "\xff\xffworker_endpoint";
+  const double TIMEOUT_MAX = 2147483647.0;  // 2^31 - 1
 
   void debugger_detached(duk_context */*ctx*/, void *udata) {
       alog_info("Debugger detached, udata: %p\n", udata);
   }
 
+  // [... bytecode_buffer] -> [... function]
+  duk_ret_t loadFunction(duk_context *ctx, void *) {
+    duk_load_function(ctx);
+    return 1;
+  }
+
+  // [... object key] -> [... value]
+  duk_ret_t getProperty(duk_context *ctx, void *) {
+    duk_get_prop(ctx, -2);
+    return 1;
+  }
+
+  // [... object key value] -> [... undefined]
+  duk_ret_t putProperty(duk_context *ctx, void *) {
+    duk_put_prop(ctx, -3);
+    return 0;
+  }
+
+  // [... object key] -> [... boolean]
+  duk_ret_t hasProperty(duk_context *ctx, void *) {
+    duk_push_boolean(ctx, duk_has_prop(ctx, -2));
+    return 1;
+  }
+
+  // [... object] -> [... keyArray] (own enumerable string keys)
+  duk_ret_t getOwnKeys(duk_context *ctx, void *) {
+    duk_idx_t keysIdx = duk_push_array(ctx);
+    duk_enum(ctx, -2, DUK_ENUM_OWN_PROPERTIES_ONLY);
+    duk_uarridx_t i = 0;
+    while (duk_next(ctx, -1, 0 /*getValue*/)) {
+      duk_put_prop_index(ctx, keysIdx, i++);
+    }
+    duk_pop(ctx);  // enum
+    return 1;
+  }
+
   // Java functions called from JS
   // ---
   extern "C" {
@@ -55,6 +103,73 @@ namespace {
       alog_fatal("Fatal error: %s", msg);
       throw std::runtime_error(msg);
     }
+
+    // setTimeout(cb, msecs, args...) and setInterval(cb, msecs, args...) (magic: repeat)
+    duk_ret_t setTimeoutFunction(duk_context *ctx) {
+      const duk_idx_t argc = duk_get_top(ctx);
+      if (argc < 1 || !duk_is_function(ctx, 0)) {
+        duk_error(ctx, DUK_ERR_TYPE_ERROR, "The timer callback must be a function");
+        return DUK_RET_TYPE_ERROR;  // unreached
+      }
+
+      // undefined, null and wrong variable type (e.g. string) are valid values for timeout == no delay
+      // "1000" string is converted into a number
+      double msecs = argc >= 2 ? duk_to_number(ctx, 1) : 0;
+      if (!(msecs >= 1 && msecs <= TIMEOUT_MAX)) {
+        msecs = 0;
+      }
+
+      // Timer entry: [cb, args...]
+      duk_push_array(ctx);
+      duk_dup(ctx, 0);
+      duk_put_prop_index(ctx, -2, 0);
+      for (duk_idx_t i = 2; i < argc; ++i) {
+        duk_dup(ctx, i);
+        duk_put_prop_index(ctx, -2, i - 1);
+      }
+
+      JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+      try {
+        int id = jsBridgeContext->addTimer(static_cast<int64_t>(msecs), duk_get_current_magic(ctx) != 0);
+        duk_push_int(ctx, id);
+        return 1;
+      } catch (const std::exception &e) {
+        jsBridgeContext->getExceptionHandler()->jsThrow(e);
+        return DUK_RET_ERROR;  // unreached
+      }
+    }
+
+    // clearTimeout(id) and clearInterval(id)
+    duk_ret_t clearTimeoutFunction(duk_context *ctx) {
+      if (duk_is_number(ctx, 0)) {
+        JsBridgeContext::getInstance(ctx)->removeTimer(duk_get_int(ctx, 0));
+      }
+      return 0;
+    }
+
+    // postMessage(message) of a worker endpoint
+    duk_ret_t postMessageFunction(duk_context *ctx) {
+      duk_set_top(ctx, 1);
+
+      std::string message;
+      if (structured_clone_write(ctx, 0, message) != DUK_EXEC_SUCCESS) {
+        return duk_throw(ctx);
+      }
+
+      JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+      duk_push_current_function(ctx);
+      duk_get_prop_string(ctx, -1, WORKER_ENDPOINT_PROP_NAME);
+      auto endpoint = jsBridgeContext->getUtils()->getCppPtr<WorkerEndpoint>(-1);
+      duk_pop_2(ctx);  // endpoint wrapper + function
+
+      try {
+        jsBridgeContext->postWorkerMessage(*endpoint, std::move(message));
+        return 0;
+      } catch (const std::exception &e) {
+        jsBridgeContext->getExceptionHandler()->jsThrow(e);
+        return DUK_RET_ERROR;  // unreached
+      }
+    }
   }  // extern "C"
 } // anonymous namespace
 
@@ -70,6 +185,9 @@ JsBridgeContext::~JsBridgeContext() {
   // Delete the proxies before destroying the heap.
   duk_destroy_heap(m_ctx);
 
+  delete m_stringInternCache;
+  delete m_scriptCache;
+  delete m_console;
   delete m_exceptionHandler;
   delete m_utils;
   delete m_jniCache;
@@ -88,6 +206,9 @@ void JsBridgeContext::init(JniContext *jniContext, const JniLocalRef<jobject> &j
   m_jniCache = new JniCache(this, jsBridgeObject);
   m_utils = new DuktapeUtils(jniContext, m_ctx);
   m_exceptionHandler = new ExceptionHandler(this);
+  m_console = new Console(this);
+
+  structured_clone_init(m_ctx);
 
   // Stash the JsBridgeContext instance in the context, so we can find our way back from a Duktape C callback.
   duk_push_global_stash(m_ctx);
@@ -127,7 +248,7 @@ void JsBridgeContext::cancelDebug() {
     duk_trans_socket_finish();
 }
 
-void JsBridgeContext::enableModuleLoader() {
+void JsBridgeContext::enableModuleLoader(const std::string &) {
   throw std::invalid_argument("Cannot use JS module loader on Duktape!");
 }
 
@@ -149,21 +270,44 @@ std::string JsBridgeContext::getCurrentScriptOrModuleName(int level) const {
   return ret;
 }
 
+duk_int_t JsBridgeContext::pevalScript(const char *source, size_t length) const {
+  if (m_scriptCache == nullptr) {
+    return duk_peval_string(m_ctx, source);
+  }
+
+  if (m_scriptCache->pushCompiled(source, length) != DUK_EXEC_SUCCESS) {
+    return DUK_EXEC_ERROR;
+  }
+
+  // Same call as duk_peval_string(): global object as "this" binding
+  duk_push_global_object(m_ctx);
+  return duk_pcall_method(m_ctx, 0);
+}
+
 JValue JsBridgeContext::evaluateString(const JStringLocalRef &strCode, const JniLocalRef<jsBridgeParameter> &returnParameter,
                                        bool awaitJsPromise) const {
   CHECK_STACK(m_ctx);
 
   //alog("Evaluating string: %s", strCode.toUtf8Chars());
 
-  duk_int_t ret = duk_peval_string(m_ctx, strCode.toUtf8Chars());
-  strCode.releaseChars();  // release chars now as we don't need them anymore
+  const std::string code = JsStrings::fromJava(strCode);
+  duk_int_t ret = pevalScript(code.data(), code.length());
 
   if (ret != DUK_EXEC_SUCCESS) {
     alog("Could not evaluate string");
     throw m_exceptionHandler->getCurrentJsException();
   }
 
+  return popReturnValue(returnParameter, awaitJsPromise);
+}
+
+JValue JsBridgeContext::popReturnValue(const JniLocalRef<jsBridgeParameter> &returnParameter, bool awaitJsPromise) const {
   bool isDeferred = awaitJsPromise && duk_is_object(m_ctx, -1) && duk_has_prop_string(m_ctx, -1, "then");
+  if (isDeferred && JavaTypes::Deferred::replaceFulfilledPromise(this)) {
+    // Already fulfilled: directly return its value instead of waiting for the Promise reactions
+    isDeferred = false;
+  }
+
   if (!isDeferred && returnParameter.isNull()) {
     // No return type given: try to guess it out of the JS value
     const int supportedTypeMask = DUK_TYPE_MASK_BOOLEAN | DUK_TYPE_MASK_NUMBER | DUK_TYPE_MASK_STRING;
@@ -196,8 +340,35 @@ void JsBridgeContext::evaluateFileContent(const JStringLocalRef &strCode, const
 
   duk_push_string(m_ctx, strFileName.c_str());
 
-  duk_int_t ret = duk_pcompile_string_filename(m_ctx, DUK_COMPILE_EVAL, strCode.toUtf8Chars());
-  strCode.releaseChars();  // release chars now as we don't need them anymore
+  const std::string code = JsStrings::fromJava(strCode);
+  duk_int_t ret = duk_pcompile_lstring_filename(m_ctx, DUK_COMPILE_EVAL, code.data(), code.length());
+
+  if (ret != DUK_EXEC_SUCCESS) {
+    alog("Could not compile file %s", strFileName.c_str());
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  if (duk_pcall(m_ctx, 0) != DUK_EXEC_SUCCESS) {
+    alog("Could not execute file %s", strFileName.c_str());
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  duk_pop(m_ctx);  // unused pcall result
+}
+
+void JsBridgeContext::evaluateFile(const MappedFile &file, const std::string &strFileName, bool isBytecode, bool) const {
+  CHECK_STACK(m_ctx);
+
+  duk_int_t ret;
+  if (isBytecode) {
+    // The bytecode is copied by duk_load_function() so that the mapped content can be used as-is
+    duk_push_external_buffer(m_ctx);
+    duk_config_buffer(m_ctx, -1, const_cast<char *>(file.data()), file.size());
+    ret = duk_safe_call(m_ctx, loadFunction, nullptr, 1 /*nargs*/, 1 /*nrets*/);
+  } else {
+    duk_push_string(m_ctx, strFileName.c_str());
+    ret = duk_pcompile_lstring_filename(m_ctx, DUK_COMPILE_EVAL, file.data(), file.size());
+  }
 
   if (ret != DUK_EXEC_SUCCESS) {
     alog("Could not compile file %s", strFileName.c_str());
@@ -354,8 +525,8 @@ JValue JsBridgeContext::callJsLambda(const std::string &strFunctionName,
 void JsBridgeContext::assignJsValue(const std::string &strGlobalName, const JStringLocalRef &strCode) {
   CHECK_STACK(m_ctx);
 
-  duk_int_t ret = duk_peval_string(m_ctx, strCode.toUtf8Chars());
-  strCode.releaseChars();  // release chars now as we don't need them anymore
+  const std::string code = JsStrings::fromJava(strCode);
+  duk_int_t ret = pevalScript(code.data(), code.length());
 
   if (ret != DUK_EXEC_SUCCESS) {
     alog("Could not assign JS value %s", strGlobalName.c_str());
@@ -365,11 +536,13 @@ void JsBridgeContext::assignJsValue(const std::string &strGlobalName, const JStr
   duk_put_global_string(m_ctx, strGlobalName.c_str());
 }
 
-void JsBridgeContext::deleteJsValue(const std::string &strGlobalName) {
+void JsBridgeContext::deleteJsValues(const std::vector<std::string> &globalNames) {
   CHECK_STACK(m_ctx);
 
   duk_push_global_object(m_ctx);
-  duk_del_prop_string(m_ctx, -1, strGlobalName.c_str());
+  for (const std::string &strGlobalName : globalNames) {
+    duk_del_prop_lstring(m_ctx, -1, strGlobalName.data(), strGlobalName.length());
+  }
   duk_pop(m_ctx);
 }
 
@@ -382,9 +555,53 @@ void JsBridgeContext::copyJsValue(const std::string &strGlobalNameTo, const std:
   duk_pop(m_ctx);
 }
 
+std::string JsBridgeContext::writeStructuredClone(const std::string &strGlobalName) const {
+  CHECK_STACK(m_ctx);
+
+  std::string buffer;
+  duk_get_global_string(m_ctx, strGlobalName.c_str());
+  if (structured_clone_write(m_ctx, -1, buffer) != DUK_EXEC_SUCCESS) {
+    JsException jsException = m_exceptionHandler->getCurrentJsException();
+    duk_pop(m_ctx);  // value
+    throw jsException;
+  }
+  duk_pop(m_ctx);  // value
+  return buffer;
+}
+
+void JsBridgeContext::readStructuredClone(const std::string &strGlobalName, const std::string &buffer) {
+  CHECK_STACK(m_ctx);
+
+  if (structured_clone_read(m_ctx, buffer) != DUK_EXEC_SUCCESS) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+  duk_put_global_string(m_ctx, strGlobalName.c_str());
+}
+
 void JsBridgeContext::newJsFunction(const std::string &strGlobalName, const JObjectArrayLocalRef &args, const JStringLocalRef &strCode) {
   CHECK_STACK(m_ctx);
 
+  if (m_scriptCache != nullptr) {
+    // Compile the same source as the Function constructor, but only once
+    std::string source = "(function anonymous(";
+    jsize argCount = args.getLength();
+    for (jsize i = 0; i < argCount; ++i) {
+      JStringLocalRef argString(args.getElement<jstring>(i));
+      if (i > 0) source += ',';
+      source += JsStrings::fromJava(argString);
+    }
+    source += "\n) {\n";
+    source += JsStrings::fromJava(strCode);
+    source += "\n})";
+
+    if (pevalScript(source.c_str(), source.length()) != DUK_EXEC_SUCCESS) {
+      throw m_exceptionHandler->getCurrentJsException();
+    }
+
+    duk_put_global_string(m_ctx, strGlobalName.c_str());
+    return;
+  }
+
   // Push global Function (which can be constructed with "new Function"
   duk_get_global_string(m_ctx, "Function");
 
@@ -395,12 +612,13 @@ void JsBridgeContext::newJsFunction(const std::string &strGlobalName, const JObj
   jsize argCount = args.getLength();
   for (jsize i = 0; i < argCount; ++i) {
     JStringLocalRef argString(args.getElement<jstring>(i));
-    duk_push_string(m_ctx, argString.toUtf8Chars());
+    const std::string arg = JsStrings::fromJava(argString);
+    duk_push_lstring(m_ctx, arg.data(), arg.length());
   }
 
   // Push JS code as string
-  duk_push_string(m_ctx, strCode.toUtf8Chars());
-  strCode.releaseChars();  // release chars now as we don't need them anymore
+  const std::string code = JsStrings::fromJava(strCode);
+  duk_push_lstring(m_ctx, code.data(), code.length());
 
   // New Function(arg1, arg2, ..., jsCode)
   if (duk_pnew(m_ctx, argCount + 1) != DUK_EXEC_SUCCESS) {
@@ -418,8 +636,372 @@ void JsBridgeContext::convertJavaValueToJs(const std::string &strGlobalName, con
   duk_put_global_string(m_ctx, strGlobalName.c_str());
 }
 
-void JsBridgeContext::processPromiseQueue() {
-  // No built-in promise
+JValue JsBridgeContext::getJsValueProperty(const std::string &strGlobalName, const JStringLocalRef &strKey,
+                                           const JniLocalRef<jsBridgeParameter> &returnParameter, bool awaitJsPromise) const {
+  CHECK_STACK(m_ctx);
+
+  const std::string key = JsStrings::fromJava(strKey);
+  duk_get_global_string(m_ctx, strGlobalName.c_str());
+
+  if (!strKey.isNull()) {
+    duk_push_lstring(m_ctx, key.data(), key.length());
+    if (duk_safe_call(m_ctx, getProperty, nullptr, 2 /*nargs*/, 1 /*nrets*/) != DUK_EXEC_SUCCESS) {
+      throw m_exceptionHandler->getCurrentJsException();
+    }
+  }
+
+  return popReturnValue(returnParameter, awaitJsPromise);
+}
+
+void JsBridgeContext::setJsValueProperty(const std::string &strGlobalName, const JStringLocalRef &strKey,
+                                         const JniLocalRef<jobject> &javaValue, const JniLocalRef<jsBridgeParameter> &parameter) {
+  CHECK_STACK(m_ctx);
+
+  auto type = m_javaTypeProvider.makeUniqueType(parameter, true /*boxed*/);
+
+  const std::string key = JsStrings::fromJava(strKey);
+  duk_get_global_string(m_ctx, strGlobalName.c_str());
+  duk_push_lstring(m_ctx, key.data(), key.length());
+  try {
+    type->push(JValue(javaValue));
+  } catch (const std::exception &) {
+    duk_pop_2(m_ctx);  // object + key
+    throw;
+  }
+
+  if (duk_safe_call(m_ctx, putProperty, nullptr, 3 /*nargs*/, 1 /*nrets*/) != DUK_EXEC_SUCCESS) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+  duk_pop(m_ctx);  // unused result
+}
+
+bool JsBridgeContext::hasJsValueProperty(const std::string &strGlobalName, const JStringLocalRef &strKey) const {
+  CHECK_STACK(m_ctx);
+
+  const std::string key = JsStrings::fromJava(strKey);
+  duk_get_global_string(m_ctx, strGlobalName.c_str());
+  if (!duk_is_object(m_ctx, -1)) {
+    duk_pop(m_ctx);
+    return false;
+  }
+
+  duk_push_lstring(m_ctx, key.data(), key.length());
+  if (duk_safe_call(m_ctx, hasProperty, nullptr, 2 /*nargs*/, 1 /*nrets*/) != DUK_EXEC_SUCCESS) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  bool ret = duk_get_boolean(m_ctx, -1);
+  duk_pop(m_ctx);
+  return ret;
+}
+
+JObjectArrayLocalRef JsBridgeContext::getJsValueKeys(const std::string &strGlobalName) const {
+  CHECK_STACK(m_ctx);
+
+  duk_get_global_string(m_ctx, strGlobalName.c_str());
+  if (!duk_is_object(m_ctx, -1)) {
+    duk_pop(m_ctx);
+    return JObjectArrayLocalRef(m_jniContext, 0, m_jniCache->getStringClass());
+  }
+
+  if (duk_safe_call(m_ctx, getOwnKeys, nullptr, 1 /*nargs*/, 1 /*nrets*/) != DUK_EXEC_SUCCESS) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  const auto keyCount = static_cast<jsize>(duk_get_length(m_ctx, -1));
+  JObjectArrayLocalRef keys(m_jniContext, keyCount, m_jniCache->getStringClass());
+  for (jsize i = 0; i < keyCount; ++i) {
+    duk_get_prop_index(m_ctx, -1, static_cast<duk_uarridx_t>(i));
+    duk_size_t keyLength = 0;
+    const char *key = duk_get_lstring(m_ctx, -1, &keyLength);
+    keys.setElement(i, JsStrings::toJava(m_jniContext, key, keyLength));
+    duk_pop(m_ctx);  // key
+  }
+  duk_pop(m_ctx);  // key array
+
+  return keys;
+}
+
+JValue JsBridgeContext::callJsValue(const std::string &strGlobalName, const JStringLocalRef &strMethodName,
+                                    const JObjectArrayLocalRef &args, const JObjectArrayLocalRef &argParameters,
+                                    const JniLocalRef<jsBridgeParameter> &returnParameter, bool awaitJsPromise) {
+  CHECK_STACK(m_ctx);
+
+  const std::string methodName = JsStrings::fromJava(strMethodName);
+  duk_get_global_string(m_ctx, strGlobalName.c_str());
+
+  // [... func this]
+  if (strMethodName.isNull()) {
+    duk_push_undefined(m_ctx);
+  } else {
+    duk_dup(m_ctx, -1);
+    duk_push_lstring(m_ctx, methodName.data(), methodName.length());
+    if (duk_safe_call(m_ctx, getProperty, nullptr, 2 /*nargs*/, 1 /*nrets*/) != DUK_EXEC_SUCCESS) {
+      JsException jsException = m_exceptionHandler->getCurrentJsException();
+      duk_pop(m_ctx);  // object
+      throw jsException;
+    }
+    duk_swap_top(m_ctx, -2);
+  }
+
+  if (!duk_is_callable(m_ctx, -2)) {
+    duk_pop_2(m_ctx);
+    throw std::invalid_argument("Cannot call " + strGlobalName + (strMethodName.isNull() ? "" : std::string(".") + methodName) + " (not a function)");
+  }
+
+  const jsize argCount = args.isNull() ? 0 : args.getLength();
+  jsize pushedArgCount = 0;
+
+  // The Java arguments are not needed anymore once pushed
+  try {
+    forEachInLocalFrames(m_jniContext, argCount, 3, [&](jsize i) {
+      auto argType = m_javaTypeProvider.makeUniqueType(argParameters.getElement<jsBridgeParameter>(i), true /*boxed*/);
+      JValue javaArg(args.getElement(i));
+      argType->push(javaArg);
+      javaArg.detachLocalRef();  // released with the local frame
+      ++pushedArgCount;
+    });
+  } catch (const std::exception &) {
+    duk_pop_n(m_ctx, 2 + pushedArgCount);  // func + this + previous args
+    throw;
+  }
+
+  if (duk_pcall_method(m_ctx, argCount) != DUK_EXEC_SUCCESS) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  return popReturnValue(returnParameter, awaitJsPromise);
+}
+
+bool JsBridgeContext::runJobs(int, int64_t) {
+  // No built-in promise (the polyfill queue is processed from Java)
+  return false;
+}
+
+void JsBridgeContext::updateStackTop() {
+  // Duktape limits the recursion depth instead of checking the native stack pointer
+}
+
+void JsBridgeContext::enableScriptCache(size_t maxEntryCount, size_t maxSourceLength) {
+  if (m_scriptCache == nullptr) {
+    m_scriptCache = new ScriptCache(this, maxEntryCount, maxSourceLength);
+  }
+}
+
+void JsBridgeContext::enableStringInterning(size_t maxEntryCount, size_t maxStringLength) {
+  if (m_stringInternCache == nullptr) {
+    m_stringInternCache = new StringInternCache(this, maxEntryCount, maxStringLength);
+  }
+}
+
+void JsBridgeContext::enableTimers() {
+  CHECK_STACK(m_ctx);
+
+  duk_push_global_stash(m_ctx);
+  if (!duk_has_prop_string(m_ctx, -1, TIMER_ENTRIES_PROP_NAME)) {
+    duk_push_object(m_ctx);
+    duk_put_prop_string(m_ctx, -2, TIMER_ENTRIES_PROP_NAME);
+  }
+  duk_pop(m_ctx);
+
+  duk_push_c_function(m_ctx, setTimeoutFunction, DUK_VARARGS);
+  duk_put_global_string(m_ctx, "setTimeout");
+  duk_push_c_function(m_ctx, setTimeoutFunction, DUK_VARARGS);
+  duk_set_magic(m_ctx, -1, 1);
+  duk_put_global_string(m_ctx, "setInterval");
+  duk_push_c_function(m_ctx, clearTimeoutFunction, 1);
+  duk_put_global_string(m_ctx, "clearTimeout");
+  duk_push_c_function(m_ctx, clearTimeoutFunction, 1);
+  duk_put_global_string(m_ctx, "clearInterval");
+}
+
+void JsBridgeContext::runTimers() {
+  CHECK_STACK(m_ctx);
+
+  m_isRunningTimers = true;
+  m_scheduledTimerWakeup = -1;
+
+  duk_push_global_stash(m_ctx);
+  duk_get_prop_string(m_ctx, -1, TIMER_ENTRIES_PROP_NAME);
+
+  // Fire all the expired timers in a row and only keep the first error
+  std::unique_ptr<JsException> firstError;
+  for (int id : m_timerWheel.advance(TimerWheel::nowMs())) {
+    if (!duk_get_prop_index(m_ctx, -1, id)) {
+      // Cleared by a previous callback
+      duk_pop(m_ctx);
+      continue;
+    }
+
+    if (!m_timerWheel.hasTimer(id)) {
+      // Expired one-shot timer
+      duk_del_prop_index(m_ctx, -2, id);
+    }
+
+    // Entry: [cb, args...]
+    const auto length = static_cast<duk_idx_t>(duk_get_length(m_ctx, -1));
+    duk_get_prop_index(m_ctx, -1, 0);
+    duk_push_undefined(m_ctx);  // this
+    for (duk_idx_t i = 1; i < length; ++i) {
+      duk_get_prop_index(m_ctx, -1 - i - 1, i);
+    }
+
+    if (duk_pcall_method(m_ctx, length - 1) != DUK_EXEC_SUCCESS && !firstError) {
+      firstError = std::unique_ptr<JsException>(new JsException(this, -1));
+    }
+    duk_pop_2(m_ctx);  // result + entry
+  }
+
+  duk_pop_2(m_ctx);  // timer entries + global stash
+
+  m_isRunningTimers = false;
+  scheduleTimerWakeup();
+
+  if (firstError) {
+    // The pending Java exception would prevent the post-batch drain: run the jobs queued by the
+    // other callbacks before re-raising the error
+    processPromiseQueue();
+    throw std::move(*firstError);
+  }
+}
+
+int JsBridgeContext::addTimer(int64_t delayMs, bool repeat) {
+  CHECK_STACK_OFFSET(m_ctx, -1);
+
+  int id = m_timerWheel.addTimer(delayMs, repeat);
+
+  duk_push_global_stash(m_ctx);
+  duk_get_prop_string(m_ctx, -1, TIMER_ENTRIES_PROP_NAME);
+  duk_dup(m_ctx, -3);
+  duk_put_prop_index(m_ctx, -2, id);
+  duk_pop_3(m_ctx);  // timer entries + global stash + entry
+
+  scheduleTimerWakeup();
+  return id;
+}
+
+void JsBridgeContext::removeTimer(int id) {
+  CHECK_STACK(m_ctx);
+
+  // The entry must also be deleted when the timer is not in the wheel anymore: an expired
+  // one-shot timer may still be waiting to be fired in the current runTimers() batch
+  m_timerWheel.removeTimer(id);
+
+  duk_push_global_stash(m_ctx);
+  duk_get_prop_string(m_ctx, -1, TIMER_ENTRIES_PROP_NAME);
+  duk_del_prop_index(m_ctx, -1, id);
+  duk_pop_2(m_ctx);
+}
+
+void JsBridgeContext::scheduleTimerWakeup() {
+  if (m_isRunningTimers) {
+    // Will be done at the end of runTimers()
+    return;
+  }
+
+  // Only call Java when the next wakeup is earlier than the scheduled one
+  const int64_t nextWakeup = m_timerWheel.getNextWakeup();
+  if (nextWakeup < 0 || (m_scheduledTimerWakeup >= 0 && m_scheduledTimerWakeup <= nextWakeup)) {
+    return;
+  }
+  m_scheduledTimerWakeup = nextWakeup;
+
+  const jlong delayMs = std::max<int64_t>(nextWakeup - TimerWheel::nowMs(), 0);
+  m_jniCache->getJsBridgeInterface().scheduleTimerWakeup(delayMs);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+}
+
+void JsBridgeContext::setUpWorkerEndpoint(const std::string &strGlobalName, const std::shared_ptr<WorkerChannel> &channel,
+                                          jlong channelHandle, WorkerChannel::Side side) {
+  CHECK_STACK(m_ctx);
+
+  const bool isWorker = side == WorkerChannel::Side::Worker;
+  if (isWorker) {
+    duk_push_global_object(m_ctx);
+  } else {
+    duk_push_object(m_ctx);
+  }
+
+  duk_push_c_function(m_ctx, postMessageFunction, 1);
+  m_utils->pushCppPtrValue(new WorkerEndpoint { channel, channelHandle, side }, true /*deleteOnFinalize*/);
+  duk_put_prop_string(m_ctx, -2, WORKER_ENDPOINT_PROP_NAME);
+  duk_put_prop_string(m_ctx, -2, "postMessage");
+
+  duk_push_null(m_ctx);
+  duk_put_prop_string(m_ctx, -2, "onmessage");
+
+  if (isWorker) {
+    duk_dup(m_ctx, -1);
+    duk_put_prop_string(m_ctx, -2, "self");
+    duk_pop(m_ctx);  // global object
+  } else {
+    duk_put_global_string(m_ctx, strGlobalName.c_str());
+  }
+}
+
+void JsBridgeContext::dispatchWorkerMessages(const std::string &strGlobalName, WorkerChannel &channel, WorkerChannel::Side side) {
+  CHECK_STACK(m_ctx);
+
+  if (side == WorkerChannel::Side::Worker) {
+    duk_push_global_object(m_ctx);
+  } else {
+    duk_get_global_string(m_ctx, strGlobalName.c_str());
+  }
+
+  if (!duk_is_object(m_ctx, -1)) {
+    // Endpoint deleted
+    duk_pop(m_ctx);
+    return;
+  }
+
+  // Dispatch all the pending messages in a row and only keep the first error
+  std::unique_ptr<JsException> firstError;
+  std::string message;
+  channel.beginDispatch(side);
+  while (channel.receive(side, message)) {
+    duk_get_prop_string(m_ctx, -1, "onmessage");
+    if (!duk_is_callable(m_ctx, -1)) {
+      // No handler: the message is dropped
+      duk_pop(m_ctx);
+      continue;
+    }
+
+    duk_dup(m_ctx, -2);  // this
+    duk_push_object(m_ctx);  // event
+    if (structured_clone_read(m_ctx, message) != DUK_EXEC_SUCCESS) {
+      if (!firstError) {
+        firstError = std::unique_ptr<JsException>(new JsException(this, -1));
+      }
+      duk_pop_n(m_ctx, 4);  // error + event + this + onmessage
+      continue;
+    }
+    duk_put_prop_string(m_ctx, -2, "data");
+
+    if (duk_pcall_method(m_ctx, 1) != DUK_EXEC_SUCCESS && !firstError) {
+      firstError = std::unique_ptr<JsException>(new JsException(this, -1));
+    }
+    duk_pop(m_ctx);  // result
+  }
+
+  duk_pop(m_ctx);  // endpoint
+
+  if (firstError) {
+    throw std::move(*firstError);
+  }
+}
+
+void JsBridgeContext::postWorkerMessage(const WorkerEndpoint &endpoint, std::string &&message) {
+  if (!endpoint.channel->post(endpoint.side, std::move(message))) {
+    // A dispatch is already pending on the other side
+    return;
+  }
+
+  m_jniCache->getJsBridgeInterface().onWorkerMessagePosted(endpoint.channelHandle);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
 }
 
 // static
@@ -16,6 +16,7 @@
 #include "JsBridgeContext.h"
 
 #include "AutoReleasedJSValue.h"
+#include "Console.h"
 #include "ExceptionHandler.h"
 #include "JavaObject.h"
 #include "JavaScriptLambda.h"
@@ -23,14 +24,24 @@
 #include "JavaType.h"
 #include "JavaTypeProvider.h"
 #include "JniCache.h"
+#include "JsStrings.h"
+#include "LocalFrameBatch.h"
+#include "MappedFile.h"
+#include "ModuleCache.h"
 #include "QuickJsUtils.h"
+#include "ScriptCache.h"
+#include "StringInternCache.h"
 #include "custom_stringify.h"
 #include "log.h"
+#include "structured_clone.h"
 #include "exceptions/JniException.h"
 #include "exceptions/JsException.h"
 #include "java-types/Deferred.h"
 #include "java-types/Object.h"
+#include <algorithm>
+#include <chrono>
 #include <functional>
+#include <vector>
 
 
 // Internal
@@ -43,11 +54,17 @@ namespace {
   //  return 0;
   //}
 
+  // Compiled modules, shared by all the contexts
+  ModuleCache &getModuleCache() {
+    static ModuleCache moduleCache("quickjs-" CONFIG_VERSION, 16 * 1024 * 1024 /*maxMemorySize*/);
+    return moduleCache;
+  }
+
   JSModuleDef *jsModuleLoader(JSContext *ctx, const char *moduleName, void *opaque) {
     JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
     JniContext *jniContext = jsBridgeContext->getJniContext();
 
-    auto contentRef = jsBridgeContext->getJniCache()->getJsBridgeInterface().callJsModuleLoader(JStringLocalRef(jniContext, moduleName));
+    auto contentRef = jsBridgeContext->getJniCache()->getJsBridgeInterface().callJsModuleLoader(JsStrings::toJava(jniContext, moduleName, strlen(moduleName)));
 
     if (jniContext->exceptionCheck()) {
       jsBridgeContext->getExceptionHandler()->jsThrow(JniException(jniContext));
@@ -59,8 +76,32 @@ namespace {
       return nullptr;
     }
 
-    const char *content = contentRef.toUtf8Chars();
-    const size_t contentLength = contentRef.utf8Length();
+    std::string contentString;
+    try {
+      contentString = JsStrings::fromJava(contentRef);
+    } catch (const JniException &e) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return nullptr;
+    }
+
+    const char *content = contentString.c_str();
+    const size_t contentLength = contentString.length();
+
+    ModuleCache &moduleCache = getModuleCache();
+    const std::string &cacheDir = jsBridgeContext->getCompiledModuleCacheDir();
+    const ModuleCache::SourceId sourceId = ModuleCache::identifySource(content, contentLength);
+
+    if (auto bytecode = moduleCache.get(cacheDir, moduleName, sourceId)) {
+      JSValue moduleVal = JS_ReadObject(ctx, reinterpret_cast<const uint8_t *>(bytecode->data()), bytecode->size(), JS_READ_OBJ_BYTECODE);
+      if (!JS_IsException(moduleVal)) {
+        auto m = (JSModuleDef *) JS_VALUE_GET_PTR(moduleVal);
+        JS_FreeValue(ctx, moduleVal);
+        return m;
+      }
+
+      // Unreadable bytecode: compile the module again
+      JS_FreeValue(ctx, JS_GetException(ctx));
+    }
 
     JSValue funcVal = JS_Eval(ctx, content, contentLength, moduleName, JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
 
@@ -68,6 +109,15 @@ namespace {
       return nullptr;
     }
 
+    size_t bytecodeSize;
+    uint8_t *bytecode = JS_WriteObject(ctx, &bytecodeSize, funcVal, JS_WRITE_OBJ_BYTECODE);
+    if (bytecode != nullptr) {
+      moduleCache.put(cacheDir, moduleName, sourceId, std::string(reinterpret_cast<const char *>(bytecode), bytecodeSize));
+      js_free(ctx, bytecode);
+    } else {
+      JS_FreeValue(ctx, JS_GetException(ctx));
+    }
+
     auto m = (JSModuleDef *) JS_VALUE_GET_PTR(funcVal);
     JS_FreeValue(ctx, funcVal);
 
@@ -86,6 +136,69 @@ namespace {
     // Reject the Java Deferred
     jsBridgeContext->getJniCache()->getJsBridgeInterface().addUnhandledJsPromiseException(value);
   }
+
+  const double TIMEOUT_MAX = 2147483647.0;  // 2^31 - 1
+
+  // setTimeout(cb, msecs, args...) and setInterval(cb, msecs, args...) (magic: repeat)
+  JSValue setTimeoutFunction(JSContext *ctx, JSValueConst, int argc, JSValueConst *argv, int magic) {
+    if (argc < 1 || !JS_IsFunction(ctx, argv[0])) {
+      return JS_ThrowTypeError(ctx, "The timer callback must be a function");
+    }
+
+    // undefined, null and wrong variable type (e.g. string) are valid values for timeout == no delay
+    // "1000" string is converted into a number
+    double msecs = 0;
+    if (argc >= 2 && JS_ToFloat64(ctx, &msecs, argv[1]) < 0) {
+      return JS_EXCEPTION;
+    }
+    if (!(msecs >= 1 && msecs <= TIMEOUT_MAX)) {
+      msecs = 0;
+    }
+
+    // Timer entry: [cb, args...]
+    JSValue entry = JS_NewArray(ctx);
+    JS_SetPropertyUint32(ctx, entry, 0, JS_DupValue(ctx, argv[0]));
+    for (int i = 2; i < argc; ++i) {
+      JS_SetPropertyUint32(ctx, entry, i - 1, JS_DupValue(ctx, argv[i]));
+    }
+
+    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    try {
+      int id = jsBridgeContext->addTimer(static_cast<int64_t>(msecs), magic != 0, entry);
+      return JS_NewInt32(ctx, id);
+    } catch (const std::exception &e) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return JS_EXCEPTION;
+    }
+  }
+
+  // clearTimeout(id) and clearInterval(id)
+  JSValue clearTimeoutFunction(JSContext *ctx, JSValueConst, int argc, JSValueConst *argv) {
+    int32_t id;
+    if (argc >= 1 && JS_IsNumber(argv[0]) && JS_ToInt32(ctx, &id, argv[0]) == 0) {
+      JsBridgeContext::getInstance(ctx)->removeTimer(id);
+    }
+    return JS_UNDEFINED;
+  }
+
+  // postMessage(message) of a worker endpoint (data: endpoint)
+  JSValue postMessageFunction(JSContext *ctx, JSValueConst, int argc, JSValueConst *argv, int, JSValueConst *datav) {
+    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+
+    std::string message;
+    if (structured_clone_write(ctx, jsBridgeContext->getStructuredCloneIntrinsics(), argc >= 1 ? argv[0] : JS_UNDEFINED, message) < 0) {
+      return JS_EXCEPTION;
+    }
+
+    auto endpoint = QuickJsUtils::getCppPtr<WorkerEndpoint>(datav[0]);
+    try {
+      jsBridgeContext->postWorkerMessage(*endpoint, std::move(message));
+      return JS_UNDEFINED;
+    } catch (const std::exception &e) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return JS_EXCEPTION;
+    }
+  }
 }
 
 
@@ -97,9 +210,15 @@ JsBridgeContext::JsBridgeContext()
 }
 
 JsBridgeContext::~JsBridgeContext() {
+  m_jniCache->clearDataClassPlans();  // before the context because the plans hold atoms
+  delete m_stringInternCache;  // before the context because the cache holds JS strings
+  delete m_scriptCache;  // before the context because the cache holds compiled functions
+  JS_FreeValue(m_ctx, m_timerEntries);
+  JS_FreeValue(m_ctx, m_structuredCloneIntrinsics);
   JS_FreeContext(m_ctx);
   JS_FreeRuntime(m_runtime);
 
+  delete m_console;
   delete m_exceptionHandler;
   delete m_utils;
   delete m_jniCache;
@@ -118,6 +237,9 @@ void JsBridgeContext::init(JniContext *jniContext, const JniLocalRef<jobject> &j
   m_jniCache = new JniCache(this, jsBridgeObject);
   m_utils = new QuickJsUtils(jniContext, m_ctx);
   m_exceptionHandler = new ExceptionHandler(this);
+  m_console = new Console(this);
+
+  m_structuredCloneIntrinsics = structured_clone_new_intrinsics(m_ctx);
 
   // Store the JsBridgeContext instance in the global object so we can find our way back from a C callback
   JSValue cppWrapperObj = m_utils->createCppPtrValue(this, false);
@@ -138,7 +260,10 @@ void JsBridgeContext::cancelDebug() {
   // Not supported yet
 }
 
-void JsBridgeContext::enableModuleLoader() {
+void JsBridgeContext::enableModuleLoader(const std::string &compiledModuleCacheDir) {
+  m_compiledModuleCacheDir = compiledModuleCacheDir;
+
+  // Default module name normalization: relative names are resolved from the importing module
   JS_SetModuleLoaderFunc(m_runtime, nullptr, jsModuleLoader, nullptr);
 }
 
@@ -164,20 +289,45 @@ std::string JsBridgeContext::getCurrentScriptOrModuleName(int level) const {
     return basename;
 }
 
+JSValue JsBridgeContext::evalScript(const char *source, size_t length, const char *fileName) const {
+  if (m_scriptCache == nullptr) {
+    return JS_Eval(m_ctx, source, length, fileName, JS_EVAL_TYPE_GLOBAL);
+  }
+
+  JSValue bytecode = m_scriptCache->getCompiled(source, length, fileName, JS_EVAL_TYPE_GLOBAL);
+  if (JS_IsException(bytecode)) {
+    return bytecode;
+  }
+  return JS_EvalFunction(m_ctx, bytecode);
+}
+
 JValue JsBridgeContext::evaluateString(const JStringLocalRef &strCode, const JniLocalRef<jsBridgeParameter> &returnParameter,
                                        bool awaitJsPromise) const {
-  JSValue v = JS_Eval(m_ctx, strCode.toUtf8Chars(), strCode.utf8Length(), "eval", JS_EVAL_TYPE_GLOBAL);
+  const std::string code = JsStrings::fromJava(strCode);
+  JSValue v = evalScript(code.c_str(), code.length(), "eval");
   JS_AUTORELEASE_VALUE(m_ctx, v);
 
-  strCode.releaseChars();  // release chars now as we don't need them anymore
-
   if (JS_IsException(v)) {
     alog("Could not evaluate string");
     throw m_exceptionHandler->getCurrentJsException();
   }
 
+  return toJavaReturnValue(v, returnParameter, awaitJsPromise);
+}
+
+JValue JsBridgeContext::toJavaReturnValue(JSValueConst v, const JniLocalRef<jsBridgeParameter> &returnParameter,
+                                          bool awaitJsPromise) const {
   bool isDeferred = awaitJsPromise && JS_IsObject(v) && m_utils->hasPropertyStr(v, "then");
 
+  if (isDeferred) {
+    // Already fulfilled: directly return its value instead of waiting for the Promise reactions
+    JSValue fulfilledValue = JavaTypes::Deferred::getFulfilledValue(this, v);
+    if (!JS_IsUninitialized(fulfilledValue)) {
+      JS_AUTORELEASE_VALUE(m_ctx, fulfilledValue);
+      return toJavaReturnValue(fulfilledValue, returnParameter, false /*awaitJsPromise*/);
+    }
+  }
+
   if (!isDeferred && returnParameter.isNull()) {
     // No return type given: try to guess it out of the JS value
     if (JS_IsBool(v) || JS_IsNumber(v) || JS_IsString(v)) {
@@ -207,10 +357,39 @@ JValue JsBridgeContext::evaluateString(const JStringLocalRef &strCode, const Jni
 
 void JsBridgeContext::evaluateFileContent(const JStringLocalRef &strCode, const std::string &strFileName, bool asModule) const {
   const int flags = asModule ? JS_EVAL_TYPE_MODULE : JS_EVAL_TYPE_GLOBAL;
-  JSValue v = JS_Eval(m_ctx, strCode.toUtf8Chars(), strCode.utf8Length(), strFileName.c_str(), flags);
+  const std::string code = JsStrings::fromJava(strCode);
+  JSValue v = JS_Eval(m_ctx, code.c_str(), code.length(), strFileName.c_str(), flags);
   JS_AUTORELEASE_VALUE(m_ctx, v);
 
-  strCode.releaseChars();  // release chars now as we don't need them anymore
+  if (JS_IsException(v)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+}
+
+void JsBridgeContext::evaluateFile(const MappedFile &file, const std::string &strFileName, bool isBytecode, bool asModule) const {
+  JSValue v;
+
+  if (isBytecode) {
+    // Script or module, as compiled
+    JSValue funcVal = JS_ReadObject(m_ctx, reinterpret_cast<const uint8_t *>(file.data()), file.size(), JS_READ_OBJ_BYTECODE);
+    if (JS_IsException(funcVal)) {
+      throw m_exceptionHandler->getCurrentJsException();
+    }
+
+    if (JS_VALUE_GET_TAG(funcVal) == JS_TAG_MODULE && JS_ResolveModule(m_ctx, funcVal) < 0) {
+      JS_FreeValue(m_ctx, funcVal);
+      throw m_exceptionHandler->getCurrentJsException();
+    }
+
+    v = JS_EvalFunction(m_ctx, funcVal);
+    // No JS_FreeValue(m_ctx, funcVal) after JS_EvalFunction()
+  } else {
+    // Note: the mapped content is null-terminated, as required by JS_Eval()
+    const int flags = asModule ? JS_EVAL_TYPE_MODULE : JS_EVAL_TYPE_GLOBAL;
+    v = JS_Eval(m_ctx, file.data(), file.size(), strFileName.c_str(), flags);
+  }
+
+  JS_AUTORELEASE_VALUE(m_ctx, v);
 
   if (JS_IsException(v)) {
     throw m_exceptionHandler->getCurrentJsException();
@@ -333,8 +512,9 @@ JValue JsBridgeContext::callJsLambda(const std::string &strFunctionName,
 }
 
 void JsBridgeContext::assignJsValue(const std::string &strGlobalName, const JStringLocalRef &strCode) {
-  JSValue v = JS_Eval(m_ctx, strCode.toUtf8Chars(), strCode.utf8Length(), strGlobalName.c_str(), 0);
-  strCode.releaseChars();  // release chars now as we don't need them anymore
+  // Not cached: the file name (kept in the compiled function) is the unique global name
+  const std::string code = JsStrings::fromJava(strCode);
+  JSValue v = JS_Eval(m_ctx, code.c_str(), code.length(), strGlobalName.c_str(), JS_EVAL_TYPE_GLOBAL);
 
   if (JS_IsException(v)) {
     throw m_exceptionHandler->getCurrentJsException();
@@ -346,11 +526,13 @@ void JsBridgeContext::assignJsValue(const std::string &strGlobalName, const JStr
   JS_FreeValue(m_ctx, globalObj);
 }
 
-void JsBridgeContext::deleteJsValue(const std::string &strGlobalName) {
+void JsBridgeContext::deleteJsValues(const std::vector<std::string> &globalNames) {
   JSValue globalObj = JS_GetGlobalObject(m_ctx);
-  JSAtom atom = JS_NewAtom(m_ctx, strGlobalName.c_str());
-  JS_DeleteProperty(m_ctx, globalObj, atom, 0);
-  JS_FreeAtom(m_ctx, atom);
+  for (const std::string &strGlobalName : globalNames) {
+    JSAtom atom = JS_NewAtomLen(m_ctx, strGlobalName.data(), strGlobalName.length());
+    JS_DeleteProperty(m_ctx, globalObj, atom, 0);
+    JS_FreeAtom(m_ctx, atom);
+  }
   JS_FreeValue(m_ctx, globalObj);
 }
 
@@ -361,19 +543,71 @@ void JsBridgeContext::copyJsValue(const std::string &strGlobalNameTo, const std:
   JS_FreeValue(m_ctx, globalObj);
 }
 
+std::string JsBridgeContext::writeStructuredClone(const std::string &strGlobalName) const {
+  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+  JSValue value = JS_GetPropertyStr(m_ctx, globalObj, strGlobalName.c_str());
+  JS_FreeValue(m_ctx, globalObj);
+
+  std::string buffer;
+  int ret = structured_clone_write(m_ctx, m_structuredCloneIntrinsics, value, buffer);
+  JS_FreeValue(m_ctx, value);
+  if (ret < 0) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+  return buffer;
+}
+
+void JsBridgeContext::readStructuredClone(const std::string &strGlobalName, const std::string &buffer) {
+  JSValue value = structured_clone_read(m_ctx, m_structuredCloneIntrinsics, buffer);
+  if (JS_IsException(value)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+  JS_SetPropertyStr(m_ctx, globalObj, strGlobalName.c_str(), value);
+  // No JS_FreeValue(m_ctx, value) after JS_SetPropertyStr()
+  JS_FreeValue(m_ctx, globalObj);
+}
+
 void JsBridgeContext::newJsFunction(const std::string &strGlobalName, const JObjectArrayLocalRef &args, const JStringLocalRef &strCode) {
-  JSValue codeValue = JS_NewString(m_ctx, strCode.toUtf8Chars());
-  strCode.releaseChars();  // release chars now as we don't need them anymore
+  if (m_scriptCache != nullptr) {
+    // Compile the same source as the Function constructor, but only once
+    std::string source = "(function anonymous(";
+    jsize argCount = args.getLength();
+    for (jsize i = 0; i < argCount; ++i) {
+      JStringLocalRef argString(args.getElement<jstring>(i));
+      if (i > 0) source += ',';
+      source += JsStrings::fromJava(argString);
+    }
+    source += "\n) {\n";
+    source += JsStrings::fromJava(strCode);
+    source += "\n})";
 
-  jsize argCount = args.getLength();
-  JSValue functionArgValues[argCount + 1];
+    JSValue functionValue = evalScript(source.c_str(), source.length(), "eval");
+    if (JS_IsException(functionValue)) {
+      throw m_exceptionHandler->getCurrentJsException();
+    }
 
+    JSValue globalObj = JS_GetGlobalObject(m_ctx);
+    JS_SetPropertyStr(m_ctx, globalObj, strGlobalName.c_str(), functionValue);
+    // No JS_FreeValue(m_ctx, functionValue) after JS_SetPropertyStr
+    JS_FreeValue(m_ctx, globalObj);
+    return;
+  }
+
+  jsize argCount = args.getLength();
+  std::vector<std::string> argStrings;
+  argStrings.reserve(static_cast<size_t>(argCount) + 1);
   for (jsize i = 0; i < argCount; ++i) {
     JStringLocalRef argString(args.getElement<jstring>(i));
-    functionArgValues[i] = JS_NewString(m_ctx, argString.toUtf8Chars());
+    argStrings.push_back(JsStrings::fromJava(argString));
   }
+  argStrings.push_back(JsStrings::fromJava(strCode));
 
-  functionArgValues[argCount] = codeValue;
+  JSValue functionArgValues[argCount + 1];
+  for (jsize i = 0; i <= argCount; ++i) {
+    functionArgValues[i] = JS_NewStringLen(m_ctx, argStrings[i].c_str(), argStrings[i].length());
+  }
 
   JSValue globalObj = JS_GetGlobalObject(m_ctx);
   JSValue functionObj = JS_GetPropertyStr(m_ctx, globalObj, "Function");
@@ -409,19 +643,420 @@ void JsBridgeContext::convertJavaValueToJs(const std::string &strGlobalName, con
   JS_FreeValue(m_ctx, globalObj);
 }
 
-void JsBridgeContext::processPromiseQueue() {
-  JSContext *ctx1;
-  int err;
+JSValue JsBridgeContext::getGlobalValue(const std::string &strGlobalName) const {
+  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+  JSValue value = JS_GetPropertyStr(m_ctx, globalObj, strGlobalName.c_str());
+  JS_FreeValue(m_ctx, globalObj);
+  return value;
+}
+
+JValue JsBridgeContext::getJsValueProperty(const std::string &strGlobalName, const JStringLocalRef &strKey,
+                                           const JniLocalRef<jsBridgeParameter> &returnParameter, bool awaitJsPromise) const {
+  const std::string key = JsStrings::fromJava(strKey);
+  JSValue v = getGlobalValue(strGlobalName);
+
+  if (!strKey.isNull()) {
+    JSAtom keyAtom = JS_NewAtomLen(m_ctx, key.c_str(), key.length());
+    JSValue propertyValue = JS_GetProperty(m_ctx, v, keyAtom);
+    JS_FreeAtom(m_ctx, keyAtom);
+    JS_FreeValue(m_ctx, v);
+    v = propertyValue;
+  }
+  JS_AUTORELEASE_VALUE(m_ctx, v);
+
+  if (JS_IsException(v)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  return toJavaReturnValue(v, returnParameter, awaitJsPromise);
+}
+
+void JsBridgeContext::setJsValueProperty(const std::string &strGlobalName, const JStringLocalRef &strKey,
+                                         const JniLocalRef<jobject> &javaValue, const JniLocalRef<jsBridgeParameter> &parameter) {
+  auto type = m_javaTypeProvider.makeUniqueType(parameter, true /*boxed*/);
+  const std::string key = JsStrings::fromJava(strKey);
+
+  JSValue value = type->fromJava(JValue(javaValue));
+  if (JS_IsException(value)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
 
-  // Execute the pending jobs
-  while (true) {
-    err = JS_ExecutePendingJob(m_runtime, &ctx1);
-    if (err <= 0) {
-      if (err < 0) {
+  JSValue objectValue = getGlobalValue(strGlobalName);
+  JSAtom keyAtom = JS_NewAtomLen(m_ctx, key.c_str(), key.length());
+  int ret = JS_SetProperty(m_ctx, objectValue, keyAtom, value);
+  // No JS_FreeValue(m_ctx, value) after JS_SetProperty()
+  JS_FreeAtom(m_ctx, keyAtom);
+  JS_FreeValue(m_ctx, objectValue);
+
+  if (ret < 0) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+}
+
+bool JsBridgeContext::hasJsValueProperty(const std::string &strGlobalName, const JStringLocalRef &strKey) const {
+  const std::string key = JsStrings::fromJava(strKey);
+  JSValue objectValue = getGlobalValue(strGlobalName);
+  JS_AUTORELEASE_VALUE(m_ctx, objectValue);
+
+  if (!JS_IsObject(objectValue)) {
+    return false;
+  }
+
+  JSAtom keyAtom = JS_NewAtomLen(m_ctx, key.c_str(), key.length());
+  int ret = JS_HasProperty(m_ctx, objectValue, keyAtom);
+  JS_FreeAtom(m_ctx, keyAtom);
+
+  if (ret < 0) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+  return ret != 0;
+}
+
+JObjectArrayLocalRef JsBridgeContext::getJsValueKeys(const std::string &strGlobalName) const {
+  JSValue objectValue = getGlobalValue(strGlobalName);
+  JS_AUTORELEASE_VALUE(m_ctx, objectValue);
+
+  if (!JS_IsObject(objectValue)) {
+    return JObjectArrayLocalRef(m_jniContext, 0, m_jniCache->getStringClass());
+  }
+
+  JSPropertyEnum *properties = nullptr;
+  uint32_t propertyCount = 0;
+  if (JS_GetOwnPropertyNames(m_ctx, &properties, &propertyCount, objectValue, JS_GPN_STRING_MASK | JS_GPN_ENUM_ONLY) < 0) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  JObjectArrayLocalRef keys(m_jniContext, static_cast<jsize>(propertyCount), m_jniCache->getStringClass());
+  for (uint32_t i = 0; i < propertyCount; ++i) {
+    JSValue keyValue = JS_AtomToString(m_ctx, properties[i].atom);
+    keys.setElement(static_cast<jsize>(i), m_utils->toJString(keyValue));
+    JS_FreeValue(m_ctx, keyValue);
+  }
+
+  for (uint32_t i = 0; i < propertyCount; ++i) {
+    JS_FreeAtom(m_ctx, properties[i].atom);
+  }
+  js_free(m_ctx, properties);
+
+  return keys;
+}
+
+JValue JsBridgeContext::callJsValue(const std::string &strGlobalName, const JStringLocalRef &strMethodName,
+                                    const JObjectArrayLocalRef &args, const JObjectArrayLocalRef &argParameters,
+                                    const JniLocalRef<jsBridgeParameter> &returnParameter, bool awaitJsPromise) {
+  const std::string methodName = JsStrings::fromJava(strMethodName);
+  JSValue thisValue = JS_UNDEFINED;
+  JSValue functionValue = getGlobalValue(strGlobalName);
+
+  if (!strMethodName.isNull()) {
+    thisValue = functionValue;
+    JSAtom methodAtom = JS_NewAtomLen(m_ctx, methodName.c_str(), methodName.length());
+    functionValue = JS_GetProperty(m_ctx, thisValue, methodAtom);
+    JS_FreeAtom(m_ctx, methodAtom);
+  }
+  JS_AUTORELEASE_VALUE(m_ctx, thisValue);
+  JS_AUTORELEASE_VALUE(m_ctx, functionValue);
+
+  if (JS_IsException(functionValue)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  if (!JS_IsFunction(m_ctx, functionValue)) {
+    throw std::invalid_argument("Cannot call " + strGlobalName + (strMethodName.isNull() ? "" : std::string(".") + methodName) + " (not a function)");
+  }
+
+  const jsize argCount = args.isNull() ? 0 : args.getLength();
+  std::vector<JSValue> jsArgs;
+  jsArgs.reserve(static_cast<size_t>(argCount));
+
+  // The Java arguments are not needed anymore once converted
+  try {
+    forEachInLocalFrames(m_jniContext, argCount, 3, [&](jsize i) {
+      auto argType = m_javaTypeProvider.makeUniqueType(argParameters.getElement<jsBridgeParameter>(i), true /*boxed*/);
+      JValue javaArg(args.getElement(i));
+      JSValue jsArg = argType->fromJava(javaArg);
+      javaArg.detachLocalRef();  // released with the local frame
+      if (JS_IsException(jsArg)) {
         throw m_exceptionHandler->getCurrentJsException();
       }
+      jsArgs.push_back(jsArg);
+    });
+  } catch (const std::exception &) {
+    for (JSValue &jsArg : jsArgs) {
+      JS_FreeValue(m_ctx, jsArg);
+    }
+    throw;
+  }
+
+  JSValue ret = JS_Call(m_ctx, functionValue, thisValue, static_cast<int>(jsArgs.size()), jsArgs.data());
+  JS_AUTORELEASE_VALUE(m_ctx, ret);
+
+  for (JSValue &jsArg : jsArgs) {
+    JS_FreeValue(m_ctx, jsArg);
+  }
+
+  if (JS_IsException(ret)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  return toJavaReturnValue(ret, returnParameter, awaitJsPromise);
+}
+
+bool JsBridgeContext::runJobs(int maxJobs, int64_t maxMicros) {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(maxMicros);
+  JSContext *ctx1;
+  int jobCount = 0;
+
+  // Execute the pending jobs (at least one, if any, to always make progress)
+  while (maxJobs < 0 || jobCount < maxJobs) {
+    if (maxMicros >= 0 && jobCount > 0 && std::chrono::steady_clock::now() >= deadline) {
       break;
     }
+
+    int err = JS_ExecutePendingJob(m_runtime, &ctx1);
+    if (err == 0) {
+      return false;
+    }
+
+    ++jobCount;
+    ++m_drainedJobCount;
+
+    if (err < 0) {
+      throw m_exceptionHandler->getCurrentJsException();
+    }
+  }
+
+  return JS_IsJobPending(m_runtime);
+}
+
+void JsBridgeContext::updateStackTop() {
+  // The stack bounds are otherwise the ones of the thread which created the runtime
+  JS_UpdateStackTop(m_runtime);
+}
+
+void JsBridgeContext::enableScriptCache(size_t maxEntryCount, size_t maxSourceLength) {
+  if (m_scriptCache == nullptr) {
+    m_scriptCache = new ScriptCache(this, maxEntryCount, maxSourceLength);
+  }
+}
+
+void JsBridgeContext::enableStringInterning(size_t maxEntryCount, size_t maxStringLength) {
+  if (m_stringInternCache == nullptr) {
+    m_stringInternCache = new StringInternCache(this, maxEntryCount, maxStringLength);
+  }
+}
+
+void JsBridgeContext::enableTimers() {
+  if (JS_IsUndefined(m_timerEntries)) {
+    m_timerEntries = JS_NewObject(m_ctx);
+  }
+
+  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+  JS_SetPropertyStr(m_ctx, globalObj, "setTimeout", JS_NewCFunctionMagic(m_ctx, setTimeoutFunction, "setTimeout", 2, JS_CFUNC_generic_magic, 0));
+  JS_SetPropertyStr(m_ctx, globalObj, "setInterval", JS_NewCFunctionMagic(m_ctx, setTimeoutFunction, "setInterval", 2, JS_CFUNC_generic_magic, 1));
+  JS_SetPropertyStr(m_ctx, globalObj, "clearTimeout", JS_NewCFunction(m_ctx, clearTimeoutFunction, "clearTimeout", 1));
+  JS_SetPropertyStr(m_ctx, globalObj, "clearInterval", JS_NewCFunction(m_ctx, clearTimeoutFunction, "clearInterval", 1));
+  JS_FreeValue(m_ctx, globalObj);
+}
+
+void JsBridgeContext::runTimers() {
+  m_isRunningTimers = true;
+  m_scheduledTimerWakeup = -1;
+
+  // Fire all the expired timers in a row and only keep the first error
+  JSValue firstError = JS_UNINITIALIZED;
+  for (int id : m_timerWheel.advance(TimerWheel::nowMs())) {
+    JSValue entry = JS_GetPropertyUint32(m_ctx, m_timerEntries, id);
+    if (!JS_IsObject(entry)) {
+      // Cleared by a previous callback
+      JS_FreeValue(m_ctx, entry);
+      continue;
+    }
+
+    if (!m_timerWheel.hasTimer(id)) {
+      // Expired one-shot timer
+      JSAtom idAtom = JS_NewAtomUInt32(m_ctx, id);
+      JS_DeleteProperty(m_ctx, m_timerEntries, idAtom, 0);
+      JS_FreeAtom(m_ctx, idAtom);
+    }
+
+    JSValue lengthValue = JS_GetPropertyStr(m_ctx, entry, "length");
+    uint32_t length = 0;
+    JS_ToUint32(m_ctx, &length, lengthValue);
+    JS_FreeValue(m_ctx, lengthValue);
+
+    JSValue cb = JS_GetPropertyUint32(m_ctx, entry, 0);
+    std::vector<JSValue> args;
+    for (uint32_t i = 1; i < length; ++i) {
+      args.push_back(JS_GetPropertyUint32(m_ctx, entry, i));
+    }
+
+    JSValue ret = JS_Call(m_ctx, cb, JS_UNDEFINED, static_cast<int>(args.size()), args.data());
+    if (JS_IsException(ret)) {
+      JSValue error = JS_GetException(m_ctx);
+      if (JS_IsUninitialized(firstError)) {
+        firstError = error;
+      } else {
+        JS_FreeValue(m_ctx, error);
+      }
+    }
+
+    JS_FreeValue(m_ctx, ret);
+    for (JSValue &arg : args) {
+      JS_FreeValue(m_ctx, arg);
+    }
+    JS_FreeValue(m_ctx, cb);
+    JS_FreeValue(m_ctx, entry);
+  }
+
+  m_isRunningTimers = false;
+
+  try {
+    scheduleTimerWakeup();
+
+    if (!JS_IsUninitialized(firstError)) {
+      // The pending Java exception would prevent the post-batch drain: run the jobs queued by the
+      // other callbacks before re-raising the error
+      processPromiseQueue();
+    }
+  } catch (const std::exception &) {
+    JS_FreeValue(m_ctx, firstError);
+    throw;
+  }
+
+  if (!JS_IsUninitialized(firstError)) {
+    throw JsException(this, firstError);
+  }
+}
+
+int JsBridgeContext::addTimer(int64_t delayMs, bool repeat, JSValue entry) {
+  int id = m_timerWheel.addTimer(delayMs, repeat);
+  JS_SetPropertyUint32(m_ctx, m_timerEntries, id, entry);
+  // No JS_FreeValue(m_ctx, entry) after JS_SetPropertyUint32()
+
+  scheduleTimerWakeup();
+  return id;
+}
+
+void JsBridgeContext::removeTimer(int id) {
+  // The entry must also be deleted when the timer is not in the wheel anymore: an expired
+  // one-shot timer may still be waiting to be fired in the current runTimers() batch
+  m_timerWheel.removeTimer(id);
+
+  JSAtom idAtom = JS_NewAtomUInt32(m_ctx, id);
+  JS_DeleteProperty(m_ctx, m_timerEntries, idAtom, 0);
+  JS_FreeAtom(m_ctx, idAtom);
+}
+
+void JsBridgeContext::scheduleTimerWakeup() {
+  if (m_isRunningTimers) {
+    // Will be done at the end of runTimers()
+    return;
+  }
+
+  // Only call Java when the next wakeup is earlier than the scheduled one
+  const int64_t nextWakeup = m_timerWheel.getNextWakeup();
+  if (nextWakeup < 0 || (m_scheduledTimerWakeup >= 0 && m_scheduledTimerWakeup <= nextWakeup)) {
+    return;
+  }
+  m_scheduledTimerWakeup = nextWakeup;
+
+  const jlong delayMs = std::max<int64_t>(nextWakeup - TimerWheel::nowMs(), 0);
+  m_jniCache->getJsBridgeInterface().scheduleTimerWakeup(delayMs);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+}
+
+void JsBridgeContext::setUpWorkerEndpoint(const std::string &strGlobalName, const std::shared_ptr<WorkerChannel> &channel,
+                                          jlong channelHandle, WorkerChannel::Side side) {
+  const bool isWorker = side == WorkerChannel::Side::Worker;
+  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+  JSValue endpointObj = isWorker ? JS_DupValue(m_ctx, globalObj) : JS_NewObject(m_ctx);
+
+  JSValue endpointValue = m_utils->createCppPtrValue(new WorkerEndpoint { channel, channelHandle, side }, true /*deleteOnFinalize*/);
+  JSValue postMessageValue = JS_NewCFunctionData(m_ctx, postMessageFunction, 1 /*length*/, 0 /*magic*/, 1, &endpointValue);
+  JS_FreeValue(m_ctx, endpointValue);  // duplicated by JS_NewCFunctionData
+
+  JS_SetPropertyStr(m_ctx, endpointObj, "postMessage", postMessageValue);
+  JS_SetPropertyStr(m_ctx, endpointObj, "onmessage", JS_NULL);
+
+  if (isWorker) {
+    JS_SetPropertyStr(m_ctx, globalObj, "self", endpointObj);
+  } else {
+    JS_SetPropertyStr(m_ctx, globalObj, strGlobalName.c_str(), endpointObj);
+  }
+  // No JS_FreeValue(m_ctx, endpointObj) after JS_SetPropertyStr()
+
+  JS_FreeValue(m_ctx, globalObj);
+}
+
+void JsBridgeContext::dispatchWorkerMessages(const std::string &strGlobalName, WorkerChannel &channel, WorkerChannel::Side side) {
+  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+  JSValue endpointObj = side == WorkerChannel::Side::Worker
+      ? JS_DupValue(m_ctx, globalObj)
+      : JS_GetPropertyStr(m_ctx, globalObj, strGlobalName.c_str());
+  JS_FreeValue(m_ctx, globalObj);
+
+  if (!JS_IsObject(endpointObj)) {
+    // Endpoint deleted
+    JS_FreeValue(m_ctx, endpointObj);
+    return;
+  }
+
+  // Dispatch all the pending messages in a row and only keep the first error
+  JSValue firstError = JS_UNINITIALIZED;
+  std::string message;
+  channel.beginDispatch(side);
+  while (channel.receive(side, message)) {
+    JSValue onMessage = JS_GetPropertyStr(m_ctx, endpointObj, "onmessage");
+    JSValue ret = JS_UNDEFINED;
+
+    if (JS_IsException(onMessage)) {
+      ret = JS_EXCEPTION;
+    } else if (JS_IsFunction(m_ctx, onMessage)) {
+      JSValue data = structured_clone_read(m_ctx, m_structuredCloneIntrinsics, message);
+      if (JS_IsException(data)) {
+        ret = JS_EXCEPTION;
+      } else {
+        JSValue event = JS_NewObject(m_ctx);
+        JS_SetPropertyStr(m_ctx, event, "data", data);
+        // No JS_FreeValue(m_ctx, data) after JS_SetPropertyStr()
+        ret = JS_Call(m_ctx, onMessage, endpointObj, 1, &event);
+        JS_FreeValue(m_ctx, event);
+      }
+    }
+    // else: no handler, the message is dropped
+
+    if (JS_IsException(ret)) {
+      JSValue error = JS_GetException(m_ctx);
+      if (JS_IsUninitialized(firstError)) {
+        firstError = error;
+      } else {
+        JS_FreeValue(m_ctx, error);
+      }
+    }
+
+    JS_FreeValue(m_ctx, ret);
+    JS_FreeValue(m_ctx, onMessage);
+  }
+
+  JS_FreeValue(m_ctx, endpointObj);
+
+  if (!JS_IsUninitialized(firstError)) {
+    throw JsException(this, firstError);
+  }
+}
+
+void JsBridgeContext::postWorkerMessage(const WorkerEndpoint &endpoint, std::string &&message) {
+  if (!endpoint.channel->post(endpoint.side, std::move(message))) {
+    // A dispatch is already pending on the other side
+    return;
+  }
+
+  m_jniCache->getJsBridgeInterface().onWorkerMessagePosted(endpoint.channelHandle);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
   }
 }
 
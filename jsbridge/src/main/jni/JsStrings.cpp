@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsStrings.h"
+
+#include "exceptions/JniException.h"
+#include "utf_transcode.h"
+
+namespace {
+#if defined(DUKTAPE)
+  const bool JS_STRINGS_ARE_CESU8 = true;
+#else
+  const bool JS_STRINGS_ARE_CESU8 = false;
+#endif
+}
+
+// static
+std::string JsStrings::fromJava(const JStringLocalRef &javaString) {
+  std::string ret;
+  if (javaString.isNull()) {
+    return ret;
+  }
+
+  // The buffer is allocated for the worst case (3 bytes per UTF-16 unit) before entering the
+  // critical region, which then only contains the transcoding (and a non-allocating shrink)
+  ret.resize(3 * static_cast<size_t>(javaString.utf16Length()));
+  const bool ok = javaString.withCriticalUtf16Chars([&ret](const char16_t *chars, size_t length) {
+    if (chars == nullptr) {
+      return false;
+    }
+    ret.resize(utf16_to_utf8(chars, length, JS_STRINGS_ARE_CESU8, &ret[0]));
+    return true;
+  });
+
+  if (!ok) {
+    // OutOfMemoryError
+    throw JniException(javaString.getJniContext());
+  }
+
+  return ret;
+}
+
+// static
+JStringLocalRef JsStrings::toJava(const JniContext *jniContext, const char *s, size_t length) {
+  if (s == nullptr) {
+    return JStringLocalRef();
+  }
+
+  // The UTF-16 string has at most as many units as the UTF-8 string has bytes
+  return JStringLocalRef::fromUtf16Buffer(jniContext, length, [&](char16_t *utf16) {
+    return utf8_to_utf16(s, length, utf16);
+  });
+}
+
+// static
+JStringLocalRef JsStrings::latin1ToJava(const JniContext *jniContext, const unsigned char *s, size_t length) {
+  return JStringLocalRef::fromUtf16Buffer(jniContext, length, [&](char16_t *utf16) {
+    latin1_to_utf16(s, length, utf16);
+    return length;
+  });
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSSTRINGS_H
+#define _JSBRIDGE_JSSTRINGS_H
+
+#include "jni-helpers/JStringLocalRef.h"
+#include <cstddef>
+#include <string>
+
+class JniContext;
+
+// Java string <-> JS engine string conversions (see utf_transcode.h).
+//
+// The JS engine strings are UTF-8 on QuickJS and CESU-8 (internal encoding) on Duktape. Unlike
+// the JNI modified UTF-8 of JStringLocalRef::toUtf8Chars(), U+0000 is encoded as a 0 byte so the
+// string length must always be given to the JS engine.
+class JsStrings {
+
+public:
+  // Java string -> JS engine string (empty for a null Java string)
+  static std::string fromJava(const JStringLocalRef &javaString);
+
+  // JS engine string -> Java string
+  static JStringLocalRef toJava(const JniContext *jniContext, const char *s, size_t length);
+  static JStringLocalRef toJava(const JniContext *jniContext, const std::string &s) {
+    return toJava(jniContext, s.data(), s.length());
+  }
+
+  // Latin-1 string (e.g. QuickJS narrow string) -> Java string
+  static JStringLocalRef latin1ToJava(const JniContext *jniContext, const unsigned char *s, size_t length);
+};
+
+#endif
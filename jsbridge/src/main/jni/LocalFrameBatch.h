@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_LOCALFRAMEBATCH_H
+#define _JSBRIDGE_LOCALFRAMEBATCH_H
+
+#include "exceptions/JniException.h"
+#include "jni-helpers/JniContext.h"
+#include "jni-helpers/JniLocalFrame.h"
+#include <algorithm>
+#include <jni.h>
+
+// Max number of items converted within the same JNI local frame. It is bounded because devices
+// before Android O have a fixed-size local reference table (512 entries for all the frames).
+const jsize LOCAL_FRAME_BATCH_SIZE = 32;
+
+// Call f(i) for each i in [0, count[ inside JNI local frames of (at most) LOCAL_FRAME_BATCH_SIZE
+// items, each frame being sized for refsPerItem local refs per item.
+//
+// The local refs created for an item which are not needed anymore afterwards can then be "owned"
+// by the frame (i.e. detached from their JniLocalRef): they are all released by a single
+// PopLocalFrame() instead of one DeleteLocalRef() call per reference.
+//
+// Note: local refs created before the call (e.g. the converted collection) are not affected. A
+// JniException thrown by f() is re-created outside of the frame because its Java exception is a
+// local ref of the frame.
+template <typename F>
+void forEachInLocalFrames(const JniContext *jniContext, jsize count, jint refsPerItem, F &&f) {
+  for (jsize batchStart = 0; batchStart < count; batchStart += LOCAL_FRAME_BATCH_SIZE) {
+    const jsize batchEnd = std::min(count, batchStart + LOCAL_FRAME_BATCH_SIZE);
+    bool hasJavaException = false;
+
+    {
+      JniLocalFrame localFrame(jniContext, static_cast<std::size_t>((batchEnd - batchStart) * refsPerItem));
+      try {
+        for (jsize i = batchStart; i < batchEnd; ++i) {
+          f(i);
+        }
+      } catch (const JniException &e) {
+        // Keep the Java exception pending while the frame is popped
+        jniContext->throw_(e.getThrowable());
+        hasJavaException = true;
+      }
+    }
+
+    if (hasJavaException) {
+      throw JniException(jniContext);
+    }
+  }
+}
+
+#endif
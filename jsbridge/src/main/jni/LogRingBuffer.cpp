@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "LogRingBuffer.h"
+
+#include <utility>
+
+namespace {
+  size_t roundUpToPowerOf2(size_t n) {
+    size_t ret = 1;
+    while (ret < n) {
+      ret <<= 1;
+    }
+    return ret;
+  }
+}
+
+LogRingBuffer::LogRingBuffer(size_t capacity)
+ : m_entries(roundUpToPowerOf2(capacity))
+ , m_mask(m_entries.size() - 1) {
+}
+
+bool LogRingBuffer::push(int priority, std::string &&message) {
+  if (m_tail - m_head == m_entries.size()) {
+    // Full
+    return false;
+  }
+
+  Entry &entry = m_entries[m_tail & m_mask];
+  entry.priority = priority;
+  entry.message = std::move(message);
+
+  ++m_tail;
+  return true;
+}
+
+bool LogRingBuffer::pop(Entry &entry) {
+  if (m_head == m_tail) {
+    // Empty
+    return false;
+  }
+
+  entry = std::move(m_entries[m_head & m_mask]);
+
+  ++m_head;
+  return true;
+}
+
+bool LogRingBuffer::isEmpty() const {
+  return m_head == m_tail;
+}
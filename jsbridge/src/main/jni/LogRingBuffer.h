@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_LOGRINGBUFFER_H
+#define _JSBRIDGE_LOGRINGBUFFER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Fixed-capacity ring buffer of log messages.
+//
+// Messages are appended and consumed by the JS thread (no synchronization). When the buffer is
+// full, push() fails and the caller decides what to do (e.g. flush).
+class LogRingBuffer {
+
+public:
+  struct Entry {
+    int priority = 0;
+    std::string message;
+  };
+
+  // The capacity is rounded up to the next power of 2
+  explicit LogRingBuffer(size_t capacity);
+  LogRingBuffer(const LogRingBuffer &) = delete;
+  LogRingBuffer &operator=(const LogRingBuffer &) = delete;
+
+  // Return false if the buffer is full
+  bool push(int priority, std::string &&message);
+
+  // Return false if the buffer is empty
+  bool pop(Entry &entry);
+
+  bool isEmpty() const;
+
+private:
+  std::vector<Entry> m_entries;
+  const size_t m_mask;
+  size_t m_head = 0;  // next entry to pop
+  size_t m_tail = 0;  // next entry to push
+};
+
+#endif
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_LRUSTASHCACHE_H
+#define _JSBRIDGE_LRUSTASHCACHE_H
+
+#include "JsBridgeContext.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#if defined(DUKTAPE)
+# include "StackChecker.h"
+#endif
+
+// LRU map of JS values keyed by a string (shared by ScriptCache and StringInternCache).
+//
+// The cached JS values are kept alive by the cache: a dup'd JSValue on QuickJS, an entry of a
+// stash array (stored in the global stash under the given property name) on Duktape. When the
+// cache is full, the least recently used entry and its stash slot are re-used for the new value.
+template <class CharT>
+class LruStashCache {
+
+public:
+  using Key = std::basic_string<CharT>;
+  using KeyView = std::basic_string_view<CharT>;
+
+  LruStashCache(const JsBridgeContext *jsBridgeContext, const char *stashPropName, size_t maxEntryCount)
+   : m_jsBridgeContext(jsBridgeContext)
+   , m_maxEntryCount(std::max(maxEntryCount, size_t(1))) {
+
+#if defined(DUKTAPE)
+    m_stashPropName = stashPropName;
+
+    duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+    CHECK_STACK(ctx);
+
+    duk_push_global_stash(ctx);
+    duk_push_bare_array(ctx);
+    duk_put_prop_string(ctx, -2, m_stashPropName);
+    duk_pop(ctx);  // stash
+#else
+    (void) stashPropName;
+#endif
+  }
+
+  LruStashCache(const LruStashCache &) = delete;
+  LruStashCache &operator=(const LruStashCache &) = delete;
+
+  ~LruStashCache() {
+#if defined(QUICKJS)
+    JSContext *ctx = m_jsBridgeContext->getQuickJsContext();
+    for (Entry &entry : m_entries) {
+      JS_FreeValue(ctx, entry.value);
+    }
+#endif
+    // Duktape: the stash array is released with the heap
+  }
+
+#if defined(DUKTAPE)
+  // [...] -> [... value] and true if the key is cached, [...] and false otherwise
+  bool push(KeyView key) {
+    duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+
+    const Entry *entry = find(key);
+    if (entry == nullptr) {
+      return false;
+    }
+
+    duk_push_heapptr(ctx, entry->heapPtr);
+    return true;
+  }
+
+  // Cache the value on the top of the stack for the given (non-cached) key
+  // [... value] -> [... value]
+  void put(KeyView key) {
+    duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+    CHECK_STACK(ctx);
+
+    Entry &entry = insert(key);
+    entry.heapPtr = duk_get_heapptr(ctx, -1);
+
+    // Keep the value alive (replacing the evicted one, if any)
+    duk_push_global_stash(ctx);
+    duk_get_prop_string(ctx, -1, m_stashPropName);
+    duk_dup(ctx, -3);
+    duk_put_prop_index(ctx, -2, entry.slot);
+    duk_pop_2(ctx);  // stash array + stash
+  }
+#elif defined(QUICKJS)
+  // Return a new reference to the cached value or JS_UNINITIALIZED if the key is not cached
+  JSValue get(KeyView key) {
+    const Entry *entry = find(key);
+    if (entry == nullptr) {
+      return JS_UNINITIALIZED;
+    }
+
+    return JS_DupValue(m_jsBridgeContext->getQuickJsContext(), entry->value);
+  }
+
+  // Cache a new reference to the value for the given (non-cached) key
+  void put(KeyView key, JSValueConst value) {
+    Entry &entry = insert(key);
+    entry.value = JS_DupValue(m_jsBridgeContext->getQuickJsContext(), value);
+  }
+#endif
+
+  uint64_t getHitCount() const { return m_hitCount; }
+  uint64_t getMissCount() const { return m_missCount; }
+  uint64_t getEvictionCount() const { return m_evictionCount; }
+  size_t getEntryCount() const { return m_entries.size(); }
+
+private:
+  struct Entry {
+    Key key;
+#if defined(DUKTAPE)
+    void *heapPtr;  // kept alive in the stash array at index "slot"
+    duk_uarridx_t slot;
+#elif defined(QUICKJS)
+    JSValue value;
+#endif
+  };
+
+  using EntryList = std::list<Entry>;
+
+  // Return the entry for the given key (moved to the front) or nullptr
+  Entry *find(KeyView key) {
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+      ++m_missCount;
+      return nullptr;
+    }
+
+    ++m_hitCount;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return &*it->second;
+  }
+
+  // Insert a new entry at the front (evicting the least recently used one if needed)
+  Entry &insert(KeyView key) {
+    if (m_entries.size() < m_maxEntryCount) {
+      m_entries.emplace_front();
+#if defined(DUKTAPE)
+      m_entries.front().slot = static_cast<duk_uarridx_t>(m_entries.size() - 1);
+#endif
+    } else {
+      // Re-use the least recently used entry (the caller replaces its value)
+      m_entries.splice(m_entries.begin(), m_entries, std::prev(m_entries.end()));
+      m_index.erase(m_entries.front().key);
+#if defined(QUICKJS)
+      JS_FreeValue(m_jsBridgeContext->getQuickJsContext(), m_entries.front().value);
+#endif
+      ++m_evictionCount;
+    }
+
+    Entry &entry = m_entries.front();
+    entry.key.assign(key.data(), key.size());
+    m_index.emplace(entry.key, m_entries.begin());
+    return entry;
+  }
+
+  const JsBridgeContext *m_jsBridgeContext;
+  const size_t m_maxEntryCount;
+#if defined(DUKTAPE)
+  const char *m_stashPropName;
+#endif
+
+  EntryList m_entries;  // most recently used first
+  std::unordered_map<KeyView, typename EntryList::iterator> m_index;  // views on Entry::key
+  uint64_t m_hitCount = 0;
+  uint64_t m_missCount = 0;
+  uint64_t m_evictionCount = 0;
+};
+
+#endif
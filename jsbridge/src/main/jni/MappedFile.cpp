@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  std::runtime_error errnoError(const char *what) {
+    return std::runtime_error(std::string(what) + ": " + strerror(errno));
+  }
+}
+
+MappedFile::MappedFile(int fd, off_t offset, size_t length, bool nullTerminated)
+ : m_size(length) {
+
+  struct stat st {};
+  if (fstat(fd, &st) != 0) {
+    throw errnoError("Cannot stat file");
+  }
+
+  if (offset < 0 || offset > st.st_size || length > size_t(st.st_size - offset)) {
+    throw std::runtime_error("File region is out of bounds");
+  }
+
+  if (length == 0) {
+    m_data = m_copy.c_str();
+    return;
+  }
+
+  // mmap() offsets must be page-aligned
+  const auto pageSize = size_t(sysconf(_SC_PAGESIZE));
+  const off_t alignedOffset = offset - offset % off_t(pageSize);
+  const size_t delta = size_t(offset - alignedOffset);
+  const bool isAtEndOfFile = offset + off_t(length) == st.st_size;
+
+  int prot = PROT_READ;
+  m_mappingLength = delta + length;
+
+  if (nullTerminated) {
+    if (!isAtEndOfFile) {
+      // Make the byte following the region writable (only that page will be copied)
+      prot |= PROT_WRITE;
+      m_mappingLength += 1;
+    } else if (m_mappingLength % pageSize == 0) {
+      // The region ends exactly at the end of the last page: no room for the terminator
+      m_copy.resize(length);
+      if (pread(fd, &m_copy[0], length, offset) != ssize_t(length)) {
+        throw errnoError("Cannot read file");
+      }
+      m_data = m_copy.c_str();
+      m_mappingLength = 0;
+      return;
+    }
+    // else: the rest of the last page (beyond the end of the file) is zero-filled
+  }
+
+  m_mapping = mmap(nullptr, m_mappingLength, prot, MAP_PRIVATE, fd, alignedOffset);
+  if (m_mapping == MAP_FAILED) {
+    m_mapping = nullptr;
+    throw errnoError("Cannot map file");
+  }
+
+  auto bytes = static_cast<char *>(m_mapping) + delta;
+  if (prot & PROT_WRITE) {
+    bytes[length] = '\0';
+  }
+
+  // Content is read once, sequentially
+  madvise(m_mapping, m_mappingLength, MADV_SEQUENTIAL);
+
+  m_data = bytes;
+}
+
+MappedFile::~MappedFile() {
+  if (m_mapping != nullptr) {
+    munmap(m_mapping, m_mappingLength);
+  }
+}
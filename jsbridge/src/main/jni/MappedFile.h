@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_MAPPEDFILE_H
+#define _JSBRIDGE_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+
+// Read-only memory mapping of a file region (e.g. an uncompressed asset inside the APK).
+//
+// When nullTerminated is set, data()[size()] is guaranteed to be '\0' (as required by JS_Eval()).
+// This is usually achieved without copying the content: either the end of the region is followed
+// by the zero-filled end of the last page, or a private copy-on-write mapping is used so that the
+// byte following the region can be overwritten (which only copies that page).
+class MappedFile {
+
+public:
+  // Throws std::runtime_error if the region cannot be mapped
+  MappedFile(int fd, off_t offset, size_t length, bool nullTerminated);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const char *data() const { return m_data; }
+  size_t size() const { return m_size; }
+
+private:
+  void *m_mapping = nullptr;
+  size_t m_mappingLength = 0;
+  std::string m_copy;  // fallback when the region cannot be terminated in place
+  const char *m_data = nullptr;
+  size_t m_size = 0;
+};
+
+#endif
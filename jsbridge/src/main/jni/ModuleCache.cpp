@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "ModuleCache.h"
+#include "log.h"
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+// Cache file format:
+//   "JSBC" + file version (1 byte) + format tag + '\0' + module name + '\0'
+//   + source hash (8 bytes) + source length (8 bytes) + bytecode
+//
+// The bytecode is only given to the JS engine if the whole header matches: files with another
+// file version, format tag (JS engine version), module name or source are discarded.
+
+namespace {
+  const char FILE_MAGIC[] = "JSBC";
+  const char FILE_VERSION = 2;
+
+  // Suffix of the temporary files (unique in the process)
+  std::atomic<unsigned int> tmpFileCounter(0);
+}
+
+ModuleCache::ModuleCache(std::string formatTag, size_t maxMemorySize)
+ : m_formatTag(std::move(formatTag))
+ , m_maxMemorySize(maxMemorySize) {
+}
+
+// static
+uint64_t ModuleCache::hashSource(const char *source, size_t length) {
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= static_cast<uint8_t>(source[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// static
+ModuleCache::SourceId ModuleCache::identifySource(const char *source, size_t length) {
+  return SourceId { hashSource(source, length), static_cast<uint64_t>(length) };
+}
+
+std::shared_ptr<const std::string> ModuleCache::get(const std::string &cacheDir, const std::string &moduleName, const SourceId &sourceId) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(moduleName);
+    if (it != m_entries.end() && it->second.sourceId == sourceId) {
+      return it->second.bytecode;
+    }
+  }
+
+  if (cacheDir.empty()) {
+    return nullptr;
+  }
+
+  auto bytecode = readFile(getFilePath(cacheDir, moduleName), moduleName, sourceId);
+  if (bytecode) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    putInMemory(moduleName, sourceId, bytecode);
+  }
+  return bytecode;
+}
+
+void ModuleCache::put(const std::string &cacheDir, const std::string &moduleName, const SourceId &sourceId, std::string &&bytecode) {
+  auto sharedBytecode = std::make_shared<const std::string>(std::move(bytecode));
+
+  if (!cacheDir.empty()) {
+    writeFile(getFilePath(cacheDir, moduleName), moduleName, sourceId, *sharedBytecode);
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  putInMemory(moduleName, sourceId, std::move(sharedBytecode));
+}
+
+// Must be called with the mutex locked
+void ModuleCache::putInMemory(const std::string &moduleName, const SourceId &sourceId, std::shared_ptr<const std::string> bytecode) {
+  auto it = m_entries.find(moduleName);
+  if (it != m_entries.end()) {
+    m_memorySize -= it->second.bytecode->size();
+    m_insertionOrder.erase(it->second.orderIt);
+    m_entries.erase(it);
+  }
+
+  const size_t size = bytecode->size();
+  if (size > m_maxMemorySize) {
+    return;
+  }
+
+  while (m_memorySize + size > m_maxMemorySize) {
+    auto oldestIt = m_entries.find(m_insertionOrder.front());
+    m_memorySize -= oldestIt->second.bytecode->size();
+    m_entries.erase(oldestIt);
+    m_insertionOrder.pop_front();
+  }
+
+  m_insertionOrder.push_back(moduleName);
+  m_entries.emplace(moduleName, Entry { sourceId, std::move(bytecode), std::prev(m_insertionOrder.end()) });
+  m_memorySize += size;
+}
+
+std::string ModuleCache::getFilePath(const std::string &cacheDir, const std::string &moduleName) const {
+  char fileName[32];
+  snprintf(fileName, sizeof(fileName), "%016" PRIx64 ".jsbc", hashSource(moduleName.data(), moduleName.size()));
+  return cacheDir + "/" + fileName;
+}
+
+std::string ModuleCache::getFileHeader(const std::string &moduleName, const SourceId &sourceId) const {
+  std::string header(FILE_MAGIC);
+  header += FILE_VERSION;
+  header += m_formatTag;
+  header += '\0';
+  header += moduleName;
+  header += '\0';
+  header.append(reinterpret_cast<const char *>(&sourceId.hash), sizeof(sourceId.hash));
+  header.append(reinterpret_cast<const char *>(&sourceId.length), sizeof(sourceId.length));
+  return header;
+}
+
+std::shared_ptr<const std::string> ModuleCache::readFile(const std::string &path, const std::string &moduleName, const SourceId &sourceId) const {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return nullptr;
+  }
+
+  std::string content;
+  char buffer[16384];
+  size_t count;
+  while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    content.append(buffer, count);
+  }
+  fclose(file);
+
+  // Stale file (other source, module name or format): discarded (it is re-written after the
+  // module compilation)
+  const std::string header = getFileHeader(moduleName, sourceId);
+  if (content.size() <= header.size() || content.compare(0, header.size(), header) != 0) {
+    remove(path.c_str());
+    return nullptr;
+  }
+
+  return std::make_shared<const std::string>(content.substr(header.size()));
+}
+
+void ModuleCache::writeFile(const std::string &path, const std::string &moduleName, const SourceId &sourceId, const std::string &bytecode) const {
+  // Written into a temporary file first, so that other contexts never read a partial file
+  const std::string tmpPath = path + "." + std::to_string(getpid()) + "-" + std::to_string(tmpFileCounter++) + ".tmp";
+
+  FILE *file = fopen(tmpPath.c_str(), "wb");
+  if (file == nullptr) {
+    alog_warn("Could not create module cache file %s", tmpPath.c_str());
+    return;
+  }
+
+  const std::string header = getFileHeader(moduleName, sourceId);
+  bool ok = fwrite(header.data(), 1, header.size(), file) == header.size() &&
+            fwrite(bytecode.data(), 1, bytecode.size(), file) == bytecode.size();
+  ok = fclose(file) == 0 && ok;
+
+  if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+    alog_warn("Could not write module cache file %s", path.c_str());
+    remove(tmpPath.c_str());
+  }
+}
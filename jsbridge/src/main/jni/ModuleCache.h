@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_MODULECACHE_H
+#define _JSBRIDGE_MODULECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Cache of compiled JS modules (bytecode), keyed by module name and source (hash + length).
+//
+// The cache is shared by all the JS contexts (of the process) and is thread-safe. Entries are
+// kept in memory (the oldest ones are evicted above the given max size) and can also be stored
+// in a directory, so that the modules are not compiled again on the next app start.
+class ModuleCache {
+
+public:
+  // The format tag identifies the bytecode format (e.g. JS engine version) of the cached files
+  ModuleCache(std::string formatTag, size_t maxMemorySize);
+  ModuleCache(const ModuleCache &) = delete;
+  ModuleCache &operator=(const ModuleCache &) = delete;
+
+  // Identifies a module source (the length is checked in addition to the 64-bit hash)
+  struct SourceId {
+    uint64_t hash;
+    uint64_t length;
+
+    bool operator==(const SourceId &other) const { return hash == other.hash && length == other.length; }
+  };
+
+  static uint64_t hashSource(const char *source, size_t length);
+  static SourceId identifySource(const char *source, size_t length);
+
+  // Return the bytecode of the given module source or nullptr (cacheDir may be empty)
+  std::shared_ptr<const std::string> get(const std::string &cacheDir, const std::string &moduleName, const SourceId &sourceId);
+
+  void put(const std::string &cacheDir, const std::string &moduleName, const SourceId &sourceId, std::string &&bytecode);
+
+private:
+  struct Entry {
+    SourceId sourceId;
+    std::shared_ptr<const std::string> bytecode;
+    std::list<std::string>::iterator orderIt;
+  };
+
+  void putInMemory(const std::string &moduleName, const SourceId &sourceId, std::shared_ptr<const std::string> bytecode);
+  std::string getFilePath(const std::string &cacheDir, const std::string &moduleName) const;
+  std::string getFileHeader(const std::string &moduleName, const SourceId &sourceId) const;
+  std::shared_ptr<const std::string> readFile(const std::string &path, const std::string &moduleName, const SourceId &sourceId) const;
+  void writeFile(const std::string &path, const std::string &moduleName, const SourceId &sourceId, const std::string &bytecode) const;
+
+  const std::string m_formatTag;
+  const size_t m_maxMemorySize;
+
+  std::mutex m_mutex;
+  std::unordered_map<std::string, Entry> m_entries;
+  std::list<std::string> m_insertionOrder;  // module names, oldest first
+  size_t m_memorySize = 0;
+};
+
+#endif
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 #include "QuickJsUtils.h"
+#include "JsStrings.h"
 
 // static
 JSClassID QuickJsUtils::js_cppwrapper_class_id;
@@ -50,9 +51,21 @@ bool QuickJsUtils::hasPropertyStr(JSValueConst this_obj, const char *prop) const
 }
 
 JStringLocalRef QuickJsUtils::toJString(JSValueConst v) const {
-  const char *cstr = JS_ToCString(m_ctx, v);
-  JStringLocalRef ret(m_jniContext, cstr);
-  JS_FreeCString(m_ctx, cstr);
+  JSValue stringValue = JS_IsString(v) ? JS_DupValue(m_ctx, v) : JS_ToString(m_ctx, v);
+  if (JS_IsException(stringValue)) {
+    return JStringLocalRef();
+  }
+
+  // Direct access to the JS string chars (no UTF-8 conversion)
+  size_t length;
+  JS_BOOL isWideChar;
+  const void *chars = JS_GetStringBuffer(m_ctx, stringValue, &length, &isWideChar);
+
+  JStringLocalRef ret = isWideChar
+      ? JStringLocalRef(m_jniContext, static_cast<const jchar *>(chars), static_cast<jsize>(length))
+      : JsStrings::latin1ToJava(m_jniContext, static_cast<const unsigned char *>(chars), length);
+
+  JS_FreeValue(m_ctx, stringValue);
   return ret;
 }
 
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "ScriptCache.h"
+
+#include "JsBridgeContext.h"
+
+#if defined(DUKTAPE)
+# include "StackChecker.h"
+#endif
+
+namespace {
+  const char *STASH_PROP_NAME = "\xff\xffscript_cache";
+}
+
+ScriptCache::ScriptCache(const JsBridgeContext *jsBridgeContext, size_t maxEntryCount, size_t maxSourceLength)
+ : m_jsBridgeContext(jsBridgeContext)
+ , m_maxSourceLength(maxSourceLength)
+ , m_cache(jsBridgeContext, STASH_PROP_NAME, maxEntryCount) {
+}
+
+#if defined(DUKTAPE)
+
+duk_int_t ScriptCache::pushCompiled(const char *source, size_t length) {
+  duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+  CHECK_STACK_OFFSET(ctx, 1);
+
+  const std::string_view sourceView(source, length);
+  if (length <= m_maxSourceLength && m_cache.push(sourceView)) {
+    return DUK_EXEC_SUCCESS;
+  }
+
+  // Same compilation as duk_peval_string() (eval code, "eval" file name)
+  duk_int_t ret = duk_pcompile_lstring(ctx, DUK_COMPILE_EVAL, source, length);
+  if (ret != DUK_EXEC_SUCCESS || length > m_maxSourceLength) {
+    return ret;
+  }
+
+  m_cache.put(sourceView);
+  return DUK_EXEC_SUCCESS;
+}
+
+#elif defined(QUICKJS)
+
+JSValue ScriptCache::getCompiled(const char *source, size_t length, const char *fileName, int evalFlags) {
+  JSContext *ctx = m_jsBridgeContext->getQuickJsContext();
+
+  const bool isCacheable = length <= m_maxSourceLength;
+  if (isCacheable) {
+    // Key: flags + '\0' + file name + '\0' + source (the buffer is re-used between the calls)
+    m_keyBuffer = std::to_string(evalFlags);
+    m_keyBuffer += '\0';
+    m_keyBuffer += fileName;
+    m_keyBuffer += '\0';
+    m_keyBuffer.append(source, length);
+
+    JSValue cachedBytecode = m_cache.get(m_keyBuffer);
+    if (!JS_IsUninitialized(cachedBytecode)) {
+      return cachedBytecode;
+    }
+  }
+
+  JSValue bytecode = JS_Eval(ctx, source, length, fileName, evalFlags | JS_EVAL_FLAG_COMPILE_ONLY);
+  if (JS_IsException(bytecode) || !isCacheable) {
+    return bytecode;
+  }
+
+  // The key buffer is still valid: the compilation does not run any JS code
+  m_cache.put(m_keyBuffer, bytecode);
+  return bytecode;
+}
+
+#endif
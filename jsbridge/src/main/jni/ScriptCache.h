@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_SCRIPTCACHE_H
+#define _JSBRIDGE_SCRIPTCACHE_H
+
+#include "LruStashCache.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(DUKTAPE)
+# include "duktape/duktape.h"
+#elif defined(QUICKJS)
+# include "quickjs/quickjs.h"
+#endif
+
+
+// LRU cache of compiled global scripts (evaluateString(), newJsFunction() and, on Duktape,
+// assignJsValue()), so that the snippets which are evaluated over and over again are only parsed
+// once.
+//
+// On Duktape, all the scripts are compiled the same way (eval code with the "eval" file name) and
+// are keyed by their source. On QuickJS, they are keyed by the eval flags, the file name (which is
+// kept in the compiled function, e.g. for the stack traces) and the source.
+// The compiled functions are kept alive by the cache (see LruStashCache).
+class ScriptCache {
+
+public:
+  ScriptCache(const JsBridgeContext *, size_t maxEntryCount, size_t maxSourceLength);
+  ScriptCache(const ScriptCache &) = delete;
+  ScriptCache &operator=(const ScriptCache &) = delete;
+
+#if defined(DUKTAPE)
+  // [...] -> [... compiledFunction] and DUK_EXEC_SUCCESS or [... error] and DUK_EXEC_ERROR
+  duk_int_t pushCompiled(const char *source, size_t length);
+#elif defined(QUICKJS)
+  // Return a new reference to the function bytecode compiled with JS_Eval(..., evalFlags |
+  // JS_EVAL_FLAG_COMPILE_ONLY) (to be given to JS_EvalFunction()) or JS_EXCEPTION. The source must
+  // be null-terminated.
+  JSValue getCompiled(const char *source, size_t length, const char *fileName, int evalFlags);
+#endif
+
+  uint64_t getHitCount() const { return m_cache.getHitCount(); }
+  uint64_t getMissCount() const { return m_cache.getMissCount(); }
+  uint64_t getEvictionCount() const { return m_cache.getEvictionCount(); }
+  size_t getEntryCount() const { return m_cache.getEntryCount(); }
+
+private:
+  const JsBridgeContext *m_jsBridgeContext;
+  const size_t m_maxSourceLength;
+  LruStashCache<char> m_cache;  // source (QuickJS: flags + file name + source) -> compiled function
+#if defined(QUICKJS)
+  std::string m_keyBuffer;
+#endif
+};
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_SPSCQUEUE_H
+#define _JSBRIDGE_SPSCQUEUE_H
+
+#include <atomic>
+#include <utility>
+
+// Unbounded lock-free single-producer/single-consumer queue (linked list with a stub node).
+//
+// push() may only be called by one thread at a time (the producer) and pop() by one thread at a
+// time (the consumer). Successive producers (or consumers) on different threads must be ordered by
+// an external synchronization (e.g. the lock of their JS context).
+template <class T>
+class SpscQueue {
+
+public:
+  SpscQueue()
+   : m_head(new Node())
+   , m_tail(m_head) {
+  }
+
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  ~SpscQueue() {
+    Node *node = m_tail;
+    while (node != nullptr) {
+      Node *next = node->next.load(std::memory_order_relaxed);
+      delete node;
+      node = next;
+    }
+  }
+
+  // Producer side
+  void push(T &&value) {
+    auto node = new Node();
+    node->value = std::move(value);
+    m_head->next.store(node, std::memory_order_release);
+    m_head = node;
+  }
+
+  // Consumer side: return false if the queue is empty
+  bool pop(T &value) {
+    Node *next = m_tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+
+    value = std::move(next->value);
+    delete m_tail;
+    m_tail = next;  // next becomes the stub node
+    return true;
+  }
+
+private:
+  struct Node {
+    std::atomic<Node *> next { nullptr };
+    T value;
+  };
+
+  // Producer and consumer ends are kept on separate cache lines
+  alignas(64) Node *m_head;  // last pushed node
+  alignas(64) Node *m_tail;  // stub node, followed by the next node to pop
+};
+
+#endif
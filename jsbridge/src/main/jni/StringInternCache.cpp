@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "StringInternCache.h"
+
+#include "JsBridgeContext.h"
+#include "utf_transcode.h"
+#include "jni-helpers/JStringLocalRef.h"
+#include <algorithm>
+
+#if defined(DUKTAPE)
+# include "StackChecker.h"
+#endif
+
+namespace {
+  const char *STASH_PROP_NAME = "\xff\xffstring_intern_cache";
+}
+
+StringInternCache::StringInternCache(const JsBridgeContext *jsBridgeContext, size_t maxEntryCount, size_t maxStringLength)
+ : m_jsBridgeContext(jsBridgeContext)
+ , m_maxStringLength(std::min(maxStringLength, MAX_STRING_LENGTH))
+ , m_cache(jsBridgeContext, STASH_PROP_NAME, maxEntryCount) {
+}
+
+#if defined(DUKTAPE)
+
+bool StringInternCache::push(const JStringLocalRef &javaString) {
+  JNIEnv *env = m_jsBridgeContext->getJniContext()->getJNIEnv();
+  const jsize length = env->GetStringLength(javaString.jstr());
+  if (static_cast<size_t>(length) > m_maxStringLength) {
+    return false;
+  }
+
+  char16_t chars[MAX_STRING_LENGTH];
+  env->GetStringRegion(javaString.jstr(), 0, length, reinterpret_cast<jchar *>(chars));
+  const std::u16string_view charsView(chars, static_cast<size_t>(length));
+
+  duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+  CHECK_STACK_OFFSET(ctx, 1);
+
+  if (m_cache.push(charsView)) {
+    return true;
+  }
+
+  // Duktape strings are CESU-8 encoded
+  char utf8[3 * MAX_STRING_LENGTH];
+  const size_t utf8Length = utf16_to_utf8(chars, static_cast<size_t>(length), true /*cesu8*/, utf8);
+  duk_push_lstring(ctx, utf8, utf8Length);
+
+  m_cache.put(charsView);
+  return true;
+}
+
+#elif defined(QUICKJS)
+
+JSValue StringInternCache::get(const JStringLocalRef &javaString) {
+  JNIEnv *env = m_jsBridgeContext->getJniContext()->getJNIEnv();
+  const jsize length = env->GetStringLength(javaString.jstr());
+  if (static_cast<size_t>(length) > m_maxStringLength) {
+    return JS_UNINITIALIZED;
+  }
+
+  char16_t chars[MAX_STRING_LENGTH];
+  env->GetStringRegion(javaString.jstr(), 0, length, reinterpret_cast<jchar *>(chars));
+  const std::u16string_view charsView(chars, static_cast<size_t>(length));
+
+  JSContext *ctx = m_jsBridgeContext->getQuickJsContext();
+
+  JSValue cachedValue = m_cache.get(charsView);
+  if (!JS_IsUninitialized(cachedValue)) {
+    return cachedValue;
+  }
+
+  JSValue value = JS_NewStringUTF16(ctx, reinterpret_cast<const uint16_t *>(chars), static_cast<size_t>(length));
+  if (JS_IsException(value)) {
+    return value;
+  }
+
+  m_cache.put(charsView, value);
+  return value;
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_STRINGINTERNCACHE_H
+#define _JSBRIDGE_STRINGINTERNCACHE_H
+
+#include "LruStashCache.h"
+#include <cstddef>
+#include <cstdint>
+
+#if defined(DUKTAPE)
+# include "duktape/duktape.h"
+#elif defined(QUICKJS)
+# include "quickjs/quickjs.h"
+#endif
+
+class JStringLocalRef;
+
+// LRU cache of the JS strings created from short Java strings (e.g. event names or constants
+// which are sent over and over again), keyed by the string content.
+//
+// The cached JS strings are kept alive by the cache (see LruStashCache).
+class StringInternCache {
+
+public:
+  // Hard limit for maxStringLength (strings are copied into a stack buffer for the lookup)
+  static const size_t MAX_STRING_LENGTH = 256;
+
+  StringInternCache(const JsBridgeContext *, size_t maxEntryCount, size_t maxStringLength);
+  StringInternCache(const StringInternCache &) = delete;
+  StringInternCache &operator=(const StringInternCache &) = delete;
+
+#if defined(DUKTAPE)
+  // [...] -> [... string] and true (or [...] and false if the string is too long to be cached)
+  bool push(const JStringLocalRef &javaString);
+#elif defined(QUICKJS)
+  // Return a new reference to the JS string (or JS_UNINITIALIZED if the string is too long to be
+  // cached)
+  JSValue get(const JStringLocalRef &javaString);
+#endif
+
+  uint64_t getHitCount() const { return m_cache.getHitCount(); }
+  uint64_t getMissCount() const { return m_cache.getMissCount(); }
+  size_t getEntryCount() const { return m_cache.getEntryCount(); }
+
+private:
+  const JsBridgeContext *m_jsBridgeContext;
+  const size_t m_maxStringLength;
+  LruStashCache<char16_t> m_cache;  // Java string chars -> JS string
+};
+
+#endif
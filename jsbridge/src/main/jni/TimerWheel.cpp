@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "TimerWheel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <utility>
+
+TimerWheel::TimerWheel()
+ : m_currentTime(nowMs()) {
+}
+
+// static
+int64_t TimerWheel::nowMs() {
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+}
+
+int TimerWheel::addTimer(int64_t delayMs, bool repeat) {
+  if (delayMs < 0) {
+    delayMs = 0;
+  }
+
+  const int64_t now = nowMs();
+  if (m_timers.empty() && now > m_currentTime) {
+    // Idle wheel: move forward without cascading (the remaining slot entries are stale)
+    m_currentTime = now;
+  }
+
+  int id = ++m_lastId;
+  int64_t expiry = now + delayMs;
+  if (expiry < m_currentTime) {
+    expiry = m_currentTime;
+  }
+
+  m_timers[id] = Timer { expiry, repeat ? std::max<int64_t>(delayMs, 1) : 0 };
+  insert(id, expiry);
+  return id;
+}
+
+bool TimerWheel::removeTimer(int id) {
+  // The slot entry is lazily removed when the slot gets processed
+  return m_timers.erase(id) > 0;
+}
+
+std::vector<int> TimerWheel::advance(int64_t now) {
+  if (now < m_currentTime) {
+    now = m_currentTime;
+  }
+
+  // Collect all the timers of the slots between the current time and now
+  std::vector<int> candidates;
+  for (int level = 0; level < LEVEL_COUNT; ++level) {
+    const int shift = level * SLOT_BITS;
+    const int64_t from = m_currentTime >> shift;
+    const int64_t slotCount = std::min<int64_t>((now >> shift) - from + 1, SLOT_COUNT);
+
+    for (int64_t i = 0; i < slotCount; ++i) {
+      auto &slot = m_slots[level][(from + i) & SLOT_MASK];
+      candidates.insert(candidates.end(), slot.begin(), slot.end());
+      slot.clear();
+    }
+  }
+
+  m_currentTime = now;
+
+  // Expire or cascade them
+  std::vector<std::pair<int64_t, int>> expired;
+  for (int id : candidates) {
+    auto it = m_timers.find(id);
+    if (it == m_timers.end()) {
+      // Removed timer
+      continue;
+    }
+
+    if (it->second.expiry <= now) {
+      expired.emplace_back(it->second.expiry, id);
+    } else {
+      insert(id, it->second.expiry);
+    }
+  }
+
+  std::sort(expired.begin(), expired.end());
+
+  std::vector<int> ret;
+  ret.reserve(expired.size());
+  for (const auto &entry : expired) {
+    const int id = entry.second;
+    ret.push_back(id);
+
+    Timer &timer = m_timers[id];
+    if (timer.interval == 0) {
+      m_timers.erase(id);
+      continue;
+    }
+
+    // Re-arm repeating timer (without trying to catch up missed intervals)
+    timer.expiry += timer.interval;
+    if (timer.expiry <= now) {
+      timer.expiry = now + timer.interval;
+    }
+    insert(id, timer.expiry);
+  }
+
+  return ret;
+}
+
+int64_t TimerWheel::getNextWakeup() const {
+  if (m_timers.empty()) {
+    return -1;
+  }
+
+  int64_t ret = std::numeric_limits<int64_t>::max();
+  for (int level = 0; level < LEVEL_COUNT; ++level) {
+    const int shift = level * SLOT_BITS;
+    const int64_t base = m_currentTime >> shift;
+
+    // First non-empty slot of the level (the slot start is never later than its timers)
+    for (int64_t i = 0; i < SLOT_COUNT; ++i) {
+      if (!m_slots[level][(base + i) & SLOT_MASK].empty()) {
+        ret = std::min(ret, std::max((base + i) << shift, m_currentTime));
+        break;
+      }
+    }
+  }
+
+  return ret == std::numeric_limits<int64_t>::max() ? -1 : ret;
+}
+
+void TimerWheel::insert(int id, int64_t expiry) {
+  const int64_t delta = std::max<int64_t>(expiry - m_currentTime, 0);
+
+  // Pick the finest level covering the delta
+  int level = 0;
+  while (level < LEVEL_COUNT - 1 && (delta >> ((level + 1) * SLOT_BITS)) != 0) {
+    ++level;
+  }
+
+  m_slots[level][(expiry >> (level * SLOT_BITS)) & SLOT_MASK].push_back(id);
+}
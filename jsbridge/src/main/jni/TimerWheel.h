@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_TIMERWHEEL_H
+#define _JSBRIDGE_TIMERWHEEL_H
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Hierarchical timer wheel (millisecond resolution) used for setTimeout() and setInterval().
+//
+// Each level has 64 slots and is 64 times coarser than the previous one. Timers are cascaded
+// down to finer levels while time advances, so that adding, removing and expiring timers does
+// not depend on the number of active timers.
+//
+// Only timer ids are stored here, the JS callbacks are kept by the JS engine.
+class TimerWheel {
+
+public:
+  TimerWheel();
+  TimerWheel(const TimerWheel &) = delete;
+  TimerWheel &operator=(const TimerWheel &) = delete;
+
+  // Current (monotonic) time in milliseconds
+  static int64_t nowMs();
+
+  // Add a new timer and return its id (> 0)
+  int addTimer(int64_t delayMs, bool repeat);
+
+  // Remove an active timer and return false if it does not exist (anymore)
+  bool removeTimer(int id);
+
+  bool hasTimer(int id) const { return m_timers.find(id) != m_timers.end(); }
+  bool isEmpty() const { return m_timers.empty(); }
+
+  // Advance the wheel to the given time and return the ids of the expired timers (ordered by
+  // expiry). Repeating timers are re-armed, the other ones are removed.
+  std::vector<int> advance(int64_t now);
+
+  // Time (in ms) at which advance() needs to be called next or -1 if there is no active timer.
+  // Note: this can be earlier than the next expiry (when timers need to be cascaded).
+  int64_t getNextWakeup() const;
+
+private:
+  static const int LEVEL_COUNT = 6;  // 2^36 ms, i.e. more than the max JS timeout (2^31 - 1 ms)
+  static const int SLOT_BITS = 6;
+  static const int SLOT_COUNT = 1 << SLOT_BITS;
+  static const int SLOT_MASK = SLOT_COUNT - 1;
+
+  struct Timer {
+    int64_t expiry;
+    int64_t interval;  // 0 = no repeat
+  };
+
+  void insert(int id, int64_t expiry);
+
+  std::unordered_map<int, Timer> m_timers;
+  std::array<std::array<std::vector<int>, SLOT_COUNT>, LEVEL_COUNT> m_slots;
+  int64_t m_currentTime;
+  int m_lastId = 0;
+};
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "WorkerChannel.h"
+
+bool WorkerChannel::post(Side from, std::string &&message) {
+  Direction &direction = m_directions[directionIndex(from)];
+
+  direction.queue.push(std::move(message));
+
+  // Released so that the dispatch started by the notification sees the message
+  return !direction.isDispatchPending.exchange(true, std::memory_order_acq_rel);
+}
+
+void WorkerChannel::beginDispatch(Side to) {
+  Direction &direction = m_directions[reverseDirectionIndex(to)];
+
+  // Messages posted before are received by this dispatch (acquired from the exchange in post()).
+  // Messages posted from now on request a new notification, even if they are already received by
+  // this dispatch (the next one will then be empty).
+  direction.isDispatchPending.exchange(false, std::memory_order_acq_rel);
+}
+
+bool WorkerChannel::receive(Side to, std::string &message) {
+  return m_directions[reverseDirectionIndex(to)].queue.pop(message);
+}
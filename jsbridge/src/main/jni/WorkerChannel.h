@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_WORKERCHANNEL_H
+#define _JSBRIDGE_WORKERCHANNEL_H
+
+#include "SpscQueue.h"
+#include <atomic>
+#include <jni.h>
+#include <memory>
+#include <string>
+
+// Message channel between a JS context (parent) and a worker JS context, each of them running in
+// its own thread.
+//
+// Each direction has its own SPSC queue of messages (serialized with structured_clone): the
+// producer is the posting JS context and the consumer the receiving one. The receiving side only
+// needs to be notified (via Java) once per batch of messages: post() only requests a notification
+// if no dispatch is pending yet.
+class WorkerChannel {
+
+public:
+  enum class Side {
+    Parent = 0,
+    Worker = 1,
+  };
+
+  WorkerChannel() = default;
+  WorkerChannel(const WorkerChannel &) = delete;
+  WorkerChannel &operator=(const WorkerChannel &) = delete;
+
+  // Post a message from the given side and return true if the other side needs to be notified
+  bool post(Side from, std::string &&message);
+
+  // Must be called by the receiving side before receiving the pending messages
+  void beginDispatch(Side to);
+
+  // Receive the next message posted to the given side, return false if there is none
+  bool receive(Side to, std::string &message);
+
+private:
+  struct Direction {
+    SpscQueue<std::string> queue;
+    std::atomic<bool> isDispatchPending { false };
+  };
+
+  static int directionIndex(Side from) { return static_cast<int>(from); }
+  static int reverseDirectionIndex(Side to) { return 1 - static_cast<int>(to); }
+
+  Direction m_directions[2];  // indexed by the posting side
+};
+
+// Endpoint of a channel in a JS context (owned by its JS postMessage() function)
+struct WorkerEndpoint {
+  std::shared_ptr<WorkerChannel> channel;
+  jlong channelHandle;  // channel id given to Java
+  WorkerChannel::Side side;
+};
+
+#endif
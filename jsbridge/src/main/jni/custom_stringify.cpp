@@ -15,86 +15,836 @@
  */
 
 #include "custom_stringify.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
-static const char *customStringifyJs = R"(
-// Custom stringify which probably handles Error instances
-// See https://stackoverflow.com/questions/18391212/is-it-not-possible-to-stringify-an-error-using-json-stringify
-globalThis.__jsBridge__stringify = function(value, keepErrorStack) {
-  if (value === undefined) return "";
+// The serializer follows the steps of the JSON.stringify() implementation of each JS engine
+// (SerializeJSONProperty: toJSON(), replacer, primitive wrappers, cycle detection...) but
+// directly writes into a C++ buffer instead of calling a JS replacer function for each value.
+// The replacer is only "applied" to Error instances which are converted (like before) into a
+// plain object with the Error own properties.
 
-  var replaceErrors = function(_key, value) {
-    if (value instanceof Error) {
-      // Replace Error instance into plain JS objects using Error own properties
-      return Object.getOwnPropertyNames(value).reduce(function(acc, key) {
-        if (!keepErrorStack && key === "stack") return acc;
-        acc[key] = value[key];
-        return acc;
-      }, {});
+namespace {
+  // Max object/array nesting (same as Duktape JSON encoder)
+  const size_t MAX_DEPTH = 1000;
+
+  const char HEX_DIGITS[] = "0123456789abcdef";
+
+  void appendUnicodeEscape(std::string &out, uint32_t c) {
+    const char escaped[] = {
+        '\\', 'u',
+        HEX_DIGITS[(c >> 12) & 0xF], HEX_DIGITS[(c >> 8) & 0xF],
+        HEX_DIGITS[(c >> 4) & 0xF], HEX_DIGITS[c & 0xF]
+    };
+    out.append(escaped, sizeof(escaped));
+  }
+
+  void appendEscapedAscii(std::string &out, uint8_t c) {
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\b': out += "\\b"; break;
+      case '\f': out += "\\f"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default: appendUnicodeEscape(out, c); break;
     }
+  }
+
+#if defined(DUKTAPE)
+  // Duktape escapes U+2028 and U+2029 (DUK_USE_NONSTD_JSON_ESC_U2028_U2029) and writes the
+  // other (CESU-8) characters as they are
+  inline bool isEscapedSequence(const uint8_t *p, const uint8_t *end) {
+    return p[0] == 0xE2 && end - p >= 3 && p[1] == 0x80 && (p[2] == 0xA8 || p[2] == 0xA9);
+  }
+#elif defined(QUICKJS)
+  // QuickJS escapes unpaired surrogates (which are given as 3-byte sequences by JS_ToCStringLen())
+  inline bool isEscapedSequence(const uint8_t *p, const uint8_t *end) {
+    return p[0] == 0xED && end - p >= 3 && (p[1] & 0xE0) == 0xA0;
+  }
+#endif
+
+  void appendQuoted(std::string &out, const char *s, size_t length) {
+    out.reserve(out.size() + length + 2);
+    out += '"';
+
+    const auto *p = reinterpret_cast<const uint8_t *>(s);
+    const uint8_t *end = p + length;
+    const uint8_t *run = p;
+    while (p < end) {
+      const uint8_t c = *p;
+      if (c >= 0x20 && c != '"' && c != '\\' && (c < 0x80 || !isEscapedSequence(p, end))) {
+        ++p;
+        continue;
+      }
+
+      out.append(reinterpret_cast<const char *>(run), p - run);
+      if (c < 0x80) {
+        appendEscapedAscii(out, c);
+        ++p;
+      } else {
+        // 3-byte sequence
+        appendUnicodeEscape(out, ((c & 0x0Fu) << 12) | ((p[1] & 0x3Fu) << 6) | (p[2] & 0x3Fu));
+        p += 3;
+      }
+      run = p;
+    }
+    out.append(reinterpret_cast<const char *>(run), p - run);
+
+    out += '"';
+  }
 
-    return value;
+  void appendInt64(std::string &out, int64_t v) {
+    char buf[24];
+    char *end = buf + sizeof(buf);
+    char *p = end;
+    uint64_t u = v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+    do {
+      *--p = static_cast<char>('0' + u % 10);
+      u /= 10;
+    } while (u != 0);
+    if (v < 0) {
+      *--p = '-';
+    }
+    out.append(p, end - p);
   }
 
-  return JSON.stringify(value, replaceErrors);
-};)";
+  // Append integral numbers within the "safe integer" range (which JS formats like integers),
+  // return false for other numbers (to be formatted by the JS engine)
+  bool appendSafeInteger(std::string &out, double d) {
+    if (!(d > -9007199254740992.0 && d < 9007199254740992.0)) {
+      return false;
+    }
+    const auto i = static_cast<int64_t>(d);
+    if (static_cast<double>(i) != d) {
+      return false;
+    }
+    appendInt64(out, i);  // note: -0 is also written as "0"
+    return true;
+  }
+}
 
 #if defined(DUKTAPE)
 
-#include "StackChecker.h"
+namespace {
+  class Stringifier {
+  public:
+    Stringifier(duk_context *ctx, bool keepErrorStack, std::string &out)
+     : m_ctx(ctx)
+     , m_keepErrorStack(keepErrorStack)
+     , m_out(out) {
+    }
 
-// [... object ...] -> [... object ... jsonString]
-duk_int_t custom_stringify(duk_context *ctx, duk_idx_t idx, bool keepErrorStack) {
-  CHECK_STACK_OFFSET(ctx, 1);
+    // [... value] -> [...]
+    void run() {
+      // Note: duk_safe_call() does not create a new stack frame
+      const duk_idx_t valueIdx = duk_get_top_index(m_ctx);
 
-  idx = duk_normalize_index(ctx, idx);
+      // Intrinsics needed while serializing are kept below the serialized values
+      duk_push_string(m_ctx, "");
+      m_emptyKeyIdx = duk_normalize_index(m_ctx, -1);
+      duk_get_global_string(m_ctx, "Error");
+      m_errorCtorIdx = duk_normalize_index(m_ctx, -1);
+      duk_get_global_string(m_ctx, "Number");
+      duk_get_prop_string(m_ctx, -1, "prototype");
+      duk_remove(m_ctx, -2);
+      m_numberPrototypeIdx = duk_normalize_index(m_ctx, -1);
+      duk_get_global_string(m_ctx, "String");
+      duk_get_prop_string(m_ctx, -1, "prototype");
+      duk_remove(m_ctx, -2);
+      m_stringPrototypeIdx = duk_normalize_index(m_ctx, -1);
+      duk_get_global_string(m_ctx, "Boolean");
+      duk_get_prop_string(m_ctx, -1, "prototype");
+      duk_remove(m_ctx, -2);
+      m_booleanPrototypeIdx = duk_normalize_index(m_ctx, -1);
+      duk_dup(m_ctx, valueIdx);
 
-#if 0
-  // 1. Fast/easy way. BUT: (like JSON.stringify) does not properly serialize Error instances!
-  duk_dup(ctx, idx);
-  duk_json_encode(ctx, -1);  // object to JSON string
-  return DUK_EXEC_SUCCESS;
-#else
-  // 2. Custom stringify which properly serializes Error instances
-  duk_get_global_string(ctx, "__jsBridge__stringify");
-  if (duk_is_undefined(ctx, -1)) {
-    duk_pop(ctx);  // (undefined) __jsBridge__stringify
-    duk_eval_string_noresult(ctx, customStringifyJs);
-    duk_get_global_string(ctx, "__jsBridge__stringify");
+      if (!serialize(Key { m_emptyKeyIdx, 0 })) {
+        m_out.clear();
+      }
+      duk_set_top(m_ctx, valueIdx);
+    }
+
+  private:
+    // Property key given to toJSON(): string on the stack or array index
+    struct Key {
+      duk_idx_t idx;  // DUK_INVALID_INDEX for an array index
+      duk_uarridx_t index;
+    };
+
+    // [... value] -> [...]
+    // Return false if the value is not serialized (undefined)
+    bool serialize(const Key &key) {
+      duk_require_stack(m_ctx, 8);
+
+      if (duk_check_type_mask(m_ctx, -1, DUK_TYPE_MASK_OBJECT | DUK_TYPE_MASK_LIGHTFUNC | DUK_TYPE_MASK_BUFFER)) {
+        duk_get_prop_string(m_ctx, -1, "toJSON");
+        if (duk_is_callable(m_ctx, -1)) {
+          duk_dup(m_ctx, -2);  // this
+          pushKey(key);
+          duk_call_method(m_ctx, 1);  // [... value toJsonValue]
+          duk_remove(m_ctx, -2);
+        } else {
+          duk_pop(m_ctx);  // toJSON
+        }
+      }
+
+      // "Replacer"
+      if (duk_is_object(m_ctx, -1) && duk_instanceof(m_ctx, -1, m_errorCtorIdx)) {
+        errorToObject();
+      }
+
+      switch (duk_get_type(m_ctx, -1)) {
+        case DUK_TYPE_NULL:
+          m_out += "null";
+          break;
+        case DUK_TYPE_BOOLEAN:
+          m_out += duk_get_boolean(m_ctx, -1) ? "true" : "false";
+          break;
+        case DUK_TYPE_NUMBER:
+          appendNumber(duk_get_number(m_ctx, -1));
+          break;
+        case DUK_TYPE_STRING:
+          if (duk_is_symbol(m_ctx, -1)) {
+            duk_pop(m_ctx);
+            return false;
+          }
+          appendString(-1);
+          break;
+        case DUK_TYPE_OBJECT:
+        case DUK_TYPE_BUFFER:
+        case DUK_TYPE_LIGHTFUNC:
+          return serializeObject();
+        default:
+          duk_pop(m_ctx);
+          return false;
+      }
+
+      duk_pop(m_ctx);
+      return true;
+    }
+
+    // [... object] -> [...]
+    bool serializeObject() {
+      if (duk_is_callable(m_ctx, -1)) {
+        duk_pop(m_ctx);
+        return false;
+      }
+
+      if (serializePrimitiveObject()) {
+        return true;
+      }
+
+      void *ptr = duk_get_heapptr(m_ctx, -1);
+      if (std::find(m_visiting.begin(), m_visiting.end(), ptr) != m_visiting.end()) {
+        duk_type_error(m_ctx, "cyclic input");
+      }
+      if (m_visiting.size() >= MAX_DEPTH) {
+        duk_range_error(m_ctx, "json encode recursion limit");
+      }
+      m_visiting.push_back(ptr);
+
+      if (duk_is_array(m_ctx, -1)) {
+        serializeArray();
+      } else {
+        serializeProperties();
+      }
+
+      m_visiting.pop_back();
+      duk_pop(m_ctx);
+      return true;
+    }
+
+    // Number, String and Boolean objects are serialized as their primitive value. They are
+    // detected by their prototype as Duktape does not expose the object class.
+    // [... object] -> [... object] (return false) or [...] (return true)
+    bool serializePrimitiveObject() {
+      if (!duk_is_object(m_ctx, -1) || duk_is_buffer_data(m_ctx, -1)) {
+        return false;
+      }
+
+      duk_get_prototype(m_ctx, -1);
+      void *prototype = duk_get_heapptr(m_ctx, -1);
+      duk_pop(m_ctx);
+
+      if (prototype == nullptr) {
+        return false;
+      }
+
+      if (prototype == duk_get_heapptr(m_ctx, m_numberPrototypeIdx)) {
+        appendNumber(duk_to_number(m_ctx, -1));
+      } else if (prototype == duk_get_heapptr(m_ctx, m_stringPrototypeIdx)) {
+        duk_to_string(m_ctx, -1);
+        appendString(-1);
+      } else if (prototype == duk_get_heapptr(m_ctx, m_booleanPrototypeIdx)) {
+        duk_get_prop_string(m_ctx, m_booleanPrototypeIdx, "valueOf");
+        duk_dup(m_ctx, -2);
+        duk_call_method(m_ctx, 0);
+        m_out += duk_to_boolean(m_ctx, -1) ? "true" : "false";
+        duk_pop(m_ctx);  // primitive value
+      } else {
+        return false;
+      }
+
+      duk_pop(m_ctx);  // object
+      return true;
+    }
+
+    // [... array] -> [... array]
+    void serializeArray() {
+      const duk_idx_t arrayIdx = duk_get_top_index(m_ctx);
+      const auto length = static_cast<duk_uarridx_t>(duk_get_length(m_ctx, arrayIdx));
+
+      m_out += '[';
+      for (duk_uarridx_t i = 0; i < length; ++i) {
+        if (i > 0) {
+          m_out += ',';
+        }
+        duk_get_prop_index(m_ctx, arrayIdx, i);
+        if (!serialize(Key { DUK_INVALID_INDEX, i })) {
+          m_out += "null";
+        }
+      }
+      m_out += ']';
+    }
+
+    // [... object] -> [... object]
+    void serializeProperties() {
+      duk_enum(m_ctx, -1, DUK_ENUM_OWN_PROPERTIES_ONLY);
+
+      m_out += '{';
+      bool hasContent = false;
+      while (duk_next(m_ctx, -1, 1 /*get_value*/)) {
+        // [... object enum key value]
+        const size_t previousSize = m_out.size();
+        if (hasContent) {
+          m_out += ',';
+        }
+        appendString(-2);
+        m_out += ':';
+
+        if (serialize(Key { duk_get_top_index(m_ctx) - 1, 0 })) {
+          hasContent = true;
+        } else {
+          m_out.resize(previousSize);
+        }
+        duk_pop(m_ctx);  // key
+      }
+      m_out += '}';
+
+      duk_pop(m_ctx);  // enum
+    }
+
+    // Error instance -> plain object with the Error own properties (see Object.getOwnPropertyNames())
+    // [... error] -> [... object]
+    void errorToObject() {
+      const duk_idx_t errorIdx = duk_get_top_index(m_ctx);
+      duk_push_object(m_ctx);
+      duk_enum(m_ctx, errorIdx, DUK_ENUM_INCLUDE_NONENUMERABLE | DUK_ENUM_OWN_PROPERTIES_ONLY | DUK_ENUM_NO_PROXY_BEHAVIOR);
+
+      while (duk_next(m_ctx, -1, 0 /*get_value*/)) {
+        // [... error object enum key]
+        if (!m_keepErrorStack && strcmp(duk_get_string(m_ctx, -1), "stack") == 0) {
+          duk_pop(m_ctx);  // key
+          continue;
+        }
+        duk_dup(m_ctx, -1);
+        duk_get_prop(m_ctx, errorIdx);
+        duk_put_prop(m_ctx, errorIdx + 1);
+      }
+
+      duk_pop(m_ctx);  // enum
+      duk_remove(m_ctx, errorIdx);
+    }
+
+    void pushKey(const Key &key) {
+      if (key.idx == DUK_INVALID_INDEX) {
+        duk_push_uint(m_ctx, key.index);
+        duk_to_string(m_ctx, -1);
+      } else {
+        duk_dup(m_ctx, key.idx);
+      }
+    }
+
+    void appendNumber(double d) {
+      if (!std::isfinite(d)) {
+        m_out += "null";
+        return;
+      }
+      if (appendSafeInteger(m_out, d)) {
+        return;
+      }
+
+      duk_push_number(m_ctx, d);
+      duk_size_t length;
+      const char *str = duk_to_lstring(m_ctx, -1, &length);
+      m_out.append(str, length);
+      duk_pop(m_ctx);
+    }
+
+    void appendString(duk_idx_t idx) {
+      duk_size_t length;
+      const char *str = duk_get_lstring(m_ctx, idx, &length);
+      appendQuoted(m_out, str, length);
+    }
+
+    duk_context *m_ctx;
+    const bool m_keepErrorStack;
+    std::string &m_out;
+    std::vector<void *> m_visiting;
+    duk_idx_t m_emptyKeyIdx = DUK_INVALID_INDEX;
+    duk_idx_t m_errorCtorIdx = DUK_INVALID_INDEX;
+    duk_idx_t m_numberPrototypeIdx = DUK_INVALID_INDEX;
+    duk_idx_t m_stringPrototypeIdx = DUK_INVALID_INDEX;
+    duk_idx_t m_booleanPrototypeIdx = DUK_INVALID_INDEX;
+  };
+
+  struct StringifyParams {
+    bool keepErrorStack;
+    std::string *json;
+  };
+
+  extern "C"
+  duk_ret_t stringifyValue(duk_context *ctx, void *udata) {
+    const auto params = static_cast<const StringifyParams *>(udata);
+    Stringifier(ctx, params->keepErrorStack, *params->json).run();
+    return 0;
+  }
+}
+
+duk_int_t custom_stringify(duk_context *ctx, duk_idx_t idx, bool keepErrorStack, std::string &json) {
+  json.clear();
+
+  if (duk_is_undefined(ctx, idx)) {
+    return DUK_EXEC_SUCCESS;
   }
 
   duk_dup(ctx, idx);
-  duk_push_boolean(ctx, keepErrorStack);
-  return duk_pcall(ctx, 2);
-#endif
+  StringifyParams params { keepErrorStack, &json };
+  duk_int_t ret = duk_safe_call(ctx, stringifyValue, &params, 1 /*nargs*/, 1 /*nrets*/);
+  if (ret == DUK_EXEC_SUCCESS) {
+    duk_pop(ctx);  // (undefined) return value
+  } else {
+    json.clear();
+  }
+  return ret;
 }
 
 #elif defined(QUICKJS)
 
-JSValue custom_stringify(JSContext *ctx, JSValueConst v, bool keepErrorStack) {
-  JSValue ret;
-
-#if 0
-  // 1. JSON stringify (but does not properly serialize Error instances!)
-  ret = JS_JSONStringify(ctx, v, JS_UNDEFINED, JS_UNDEFINED);
-#else
-  // 2. Custom stringify which properly serializes Error instances
-  JSValue globalObj = JS_GetGlobalObject(ctx);
-  JSValue jsbridgeStringifyValue = JS_GetPropertyStr(ctx, globalObj, "__jsBridge__stringify");
-  if (JS_IsUndefined(jsbridgeStringifyValue)) {
-    jsbridgeStringifyValue = JS_Eval(ctx, customStringifyJs, strlen(customStringifyJs), "custom_stringify.cpp", 0);
-    JS_SetPropertyStr(ctx, globalObj, "__jsBridge__stringify", JS_DupValue(ctx, jsbridgeStringifyValue));
-  }
+namespace {
+  class Stringifier {
+  public:
+    Stringifier(JSContext *ctx, bool keepErrorStack, std::string &out)
+     : m_ctx(ctx)
+     , m_keepErrorStack(keepErrorStack)
+     , m_out(out) {
+    }
 
-  JSValue args[] = { v, JS_NewBool(ctx, keepErrorStack) };
-  ret = JS_Call(ctx, jsbridgeStringifyValue, JS_NULL, 2, args);
+    ~Stringifier() {
+      for (const auto &it : m_quotedKeys) {
+        JS_FreeAtom(m_ctx, it.first);
+      }
+      JS_FreeValue(m_ctx, m_errorCtor);
+      JS_FreeValue(m_ctx, m_numberPrototype);
+      JS_FreeValue(m_ctx, m_stringPrototype);
+      JS_FreeValue(m_ctx, m_booleanPrototype);
+      JS_FreeAtom(m_ctx, m_emptyAtom);
+      JS_FreeAtom(m_ctx, m_toJsonAtom);
+      JS_FreeAtom(m_ctx, m_stackAtom);
+    }
 
-  JS_FreeValue(ctx, jsbridgeStringifyValue);
-  JS_FreeValue(ctx, globalObj);
-#endif
-  return ret;
+    int run(JSValueConst v) {
+      JSValue globalObj = JS_GetGlobalObject(m_ctx);
+      m_errorCtor = JS_GetPropertyStr(m_ctx, globalObj, "Error");
+      m_numberPrototype = getPrototypeOf(globalObj, "Number");
+      m_stringPrototype = getPrototypeOf(globalObj, "String");
+      m_booleanPrototype = getPrototypeOf(globalObj, "Boolean");
+      JS_FreeValue(m_ctx, globalObj);
+
+      m_emptyAtom = JS_NewAtom(m_ctx, "");
+      m_toJsonAtom = JS_NewAtom(m_ctx, "toJSON");
+      m_stackAtom = JS_NewAtom(m_ctx, "stack");
+
+      int ret = serialize(JS_DupValue(m_ctx, v), Key { m_emptyAtom, 0 });
+      if (ret < 0) {
+        return -1;
+      }
+      if (ret == 0) {
+        m_out.clear();
+      }
+      return 0;
+    }
+
+  private:
+    // Property key given to toJSON(): atom or array index
+    struct Key {
+      JSAtom atom;  // JS_ATOM_NULL for an array index
+      uint32_t index;
+    };
+
+    // Serialize the given value (which is freed)
+    // Return 1 if the value has been serialized, 0 if not (undefined) or -1 on exception
+    int serialize(JSValue val, const Key &key) {
+      if (JS_IsObject(val)) {
+        JSValue toJsonFunction = JS_GetProperty(m_ctx, val, m_toJsonAtom);
+        if (JS_IsException(toJsonFunction)) {
+          JS_FreeValue(m_ctx, val);
+          return -1;
+        }
+        if (JS_IsFunction(m_ctx, toJsonFunction)) {
+          JSValue keyValue = key.atom == JS_ATOM_NULL
+              ? JS_NewString(m_ctx, std::to_string(key.index).c_str())
+              : JS_AtomToString(m_ctx, key.atom);
+          JSValue toJsonValue = JS_Call(m_ctx, toJsonFunction, val, 1, &keyValue);
+          JS_FreeValue(m_ctx, keyValue);
+          JS_FreeValue(m_ctx, val);
+          val = toJsonValue;
+        }
+        JS_FreeValue(m_ctx, toJsonFunction);
+        if (JS_IsException(val)) {
+          return -1;
+        }
+      }
+
+      // "Replacer"
+      if (JS_IsObject(val)) {
+        int isError = JS_IsInstanceOf(m_ctx, val, m_errorCtor);
+        if (isError < 0) {
+          JS_FreeValue(m_ctx, val);
+          return -1;
+        }
+        if (isError) {
+          val = errorToObject(val);
+          if (JS_IsException(val)) {
+            return -1;
+          }
+        }
+      }
+
+      switch (JS_VALUE_GET_NORM_TAG(val)) {
+        case JS_TAG_OBJECT:
+          return serializeObject(val);
+        case JS_TAG_STRING: {
+          int ret = appendString(val);
+          JS_FreeValue(m_ctx, val);
+          return ret < 0 ? -1 : 1;
+        }
+        case JS_TAG_INT:
+          appendInt64(m_out, JS_VALUE_GET_INT(val));
+          return 1;
+        case JS_TAG_FLOAT64:
+          return appendNumber(JS_VALUE_GET_FLOAT64(val)) < 0 ? -1 : 1;
+        case JS_TAG_BOOL:
+          m_out += JS_VALUE_GET_BOOL(val) ? "true" : "false";
+          return 1;
+        case JS_TAG_NULL:
+          m_out += "null";
+          return 1;
+        case JS_TAG_UNDEFINED:
+        case JS_TAG_SYMBOL:
+          // Skipped (same as JSON.stringify())
+          JS_FreeValue(m_ctx, val);
+          return 0;
+        case JS_TAG_BIG_INT:
+          JS_FreeValue(m_ctx, val);
+          JS_ThrowTypeError(m_ctx, "BigInt value can't be serialized in JSON");
+          return -1;
+        default:
+          JS_FreeValue(m_ctx, val);
+          JS_ThrowTypeError(m_ctx, "value can't be serialized in JSON");
+          return -1;
+      }
+    }
+
+    int serializeObject(JSValue val) {
+      if (JS_IsFunction(m_ctx, val)) {
+        JS_FreeValue(m_ctx, val);
+        return 0;
+      }
+
+      int ret = serializePrimitiveObject(val);
+      if (ret != 0) {
+        JS_FreeValue(m_ctx, val);
+        return ret;
+      }
+
+      void *ptr = JS_VALUE_GET_PTR(val);
+      if (std::find(m_visiting.begin(), m_visiting.end(), ptr) != m_visiting.end()) {
+        JS_ThrowTypeError(m_ctx, "circular reference");
+        JS_FreeValue(m_ctx, val);
+        return -1;
+      }
+      if (m_visiting.size() >= MAX_DEPTH) {
+        JS_ThrowInternalError(m_ctx, "stack overflow");
+        JS_FreeValue(m_ctx, val);
+        return -1;
+      }
+      m_visiting.push_back(ptr);
+
+      ret = JS_IsArray(m_ctx, val);
+      if (ret > 0) {
+        ret = serializeArray(val);
+      } else if (ret == 0) {
+        ret = serializeProperties(val);
+      }
+
+      m_visiting.pop_back();
+      JS_FreeValue(m_ctx, val);
+      return ret < 0 ? -1 : 1;
+    }
+
+    // Number, String and Boolean objects are serialized as their primitive value. They are
+    // detected by their prototype as QuickJS does not expose the object class.
+    // Return 1 if the value has been serialized, 0 if not (not a primitive object) or -1 on exception
+    int serializePrimitiveObject(JSValueConst val) {
+      JSValue prototype = JS_GetPrototype(m_ctx, val);
+      if (JS_IsException(prototype)) {
+        return -1;
+      }
+      JS_FreeValue(m_ctx, prototype);  // only the pointer is compared
+
+      if (!JS_IsObject(prototype)) {
+        return 0;
+      }
+      void *ptr = JS_VALUE_GET_PTR(prototype);
+
+      if (JS_IsObject(m_numberPrototype) && ptr == JS_VALUE_GET_PTR(m_numberPrototype)) {
+        double d;
+        if (JS_ToFloat64(m_ctx, &d, val) < 0) {
+          return -1;
+        }
+        return appendNumber(d) < 0 ? -1 : 1;
+      }
+
+      if (JS_IsObject(m_stringPrototype) && ptr == JS_VALUE_GET_PTR(m_stringPrototype)) {
+        JSValue str = JS_ToString(m_ctx, val);
+        if (JS_IsException(str)) {
+          return -1;
+        }
+        int ret = appendString(str);
+        JS_FreeValue(m_ctx, str);
+        return ret < 0 ? -1 : 1;
+      }
+
+      if (JS_IsObject(m_booleanPrototype) && ptr == JS_VALUE_GET_PTR(m_booleanPrototype)) {
+        JSValue valueOf = JS_GetPropertyStr(m_ctx, m_booleanPrototype, "valueOf");
+        JSValue b = JS_Call(m_ctx, valueOf, val, 0, nullptr);
+        JS_FreeValue(m_ctx, valueOf);
+        if (JS_IsException(b)) {
+          return -1;
+        }
+        m_out += JS_ToBool(m_ctx, b) ? "true" : "false";
+        JS_FreeValue(m_ctx, b);
+        return 1;
+      }
+
+      return 0;
+    }
+
+    int serializeArray(JSValueConst val) {
+      int64_t length;
+      JSValue lengthValue = JS_GetPropertyStr(m_ctx, val, "length");
+      int ret = JS_ToInt64(m_ctx, &length, lengthValue);
+      JS_FreeValue(m_ctx, lengthValue);
+      if (ret < 0) {
+        return -1;
+      }
+
+      m_out += '[';
+      for (int64_t i = 0; i < length; ++i) {
+        if (i > 0) {
+          m_out += ',';
+        }
+        JSValue item = JS_GetPropertyUint32(m_ctx, val, static_cast<uint32_t>(i));
+        if (JS_IsException(item)) {
+          return -1;
+        }
+        ret = serialize(item, Key { JS_ATOM_NULL, static_cast<uint32_t>(i) });
+        if (ret < 0) {
+          return -1;
+        }
+        if (ret == 0) {
+          m_out += "null";
+        }
+      }
+      m_out += ']';
+      return 1;
+    }
+
+    int serializeProperties(JSValueConst val) {
+      JSPropertyEnum *properties;
+      uint32_t count;
+      if (JS_GetOwnPropertyNames(m_ctx, &properties, &count, val, JS_GPN_STRING_MASK | JS_GPN_ENUM_ONLY) < 0) {
+        return -1;
+      }
+
+      int ret = 1;
+      bool hasContent = false;
+      m_out += '{';
+      for (uint32_t i = 0; i < count; ++i) {
+        const JSAtom atom = properties[i].atom;
+        JSValue item = JS_GetProperty(m_ctx, val, atom);
+        if (JS_IsException(item)) {
+          ret = -1;
+          break;
+        }
+
+        const size_t previousSize = m_out.size();
+        if (hasContent) {
+          m_out += ',';
+        }
+        if (appendQuotedKey(atom) < 0) {
+          JS_FreeValue(m_ctx, item);
+          ret = -1;
+          break;
+        }
+        m_out += ':';
+
+        int itemRet = serialize(item, Key { atom, 0 });
+        if (itemRet < 0) {
+          ret = -1;
+          break;
+        }
+        if (itemRet == 0) {
+          m_out.resize(previousSize);
+        } else {
+          hasContent = true;
+        }
+      }
+      m_out += '}';
+
+      freePropertyEnum(properties, count);
+      return ret;
+    }
+
+    // Error instance -> plain object with the Error own properties (see Object.getOwnPropertyNames())
+    // The given error is freed.
+    JSValue errorToObject(JSValue error) {
+      JSPropertyEnum *properties;
+      uint32_t count;
+      if (JS_GetOwnPropertyNames(m_ctx, &properties, &count, error, JS_GPN_STRING_MASK) < 0) {
+        JS_FreeValue(m_ctx, error);
+        return JS_EXCEPTION;
+      }
+
+      JSValue obj = JS_NewObject(m_ctx);
+      for (uint32_t i = 0; i < count && !JS_IsException(obj); ++i) {
+        const JSAtom atom = properties[i].atom;
+        if (!m_keepErrorStack && atom == m_stackAtom) {
+          continue;
+        }
+
+        JSValue value = JS_GetProperty(m_ctx, error, atom);
+        if (JS_IsException(value) || JS_SetProperty(m_ctx, obj, atom, value) < 0) {
+          JS_FreeValue(m_ctx, obj);
+          obj = JS_EXCEPTION;
+        }
+      }
+
+      freePropertyEnum(properties, count);
+      JS_FreeValue(m_ctx, error);
+      return obj;
+    }
+
+    // Quoted keys are cached as the same keys are usually serialized many times (e.g. in arrays)
+    int appendQuotedKey(JSAtom atom) {
+      auto it = m_quotedKeys.find(atom);
+      if (it == m_quotedKeys.end()) {
+        JSValue keyValue = JS_AtomToString(m_ctx, atom);
+        size_t length;
+        const char *str = JS_ToCStringLen(m_ctx, &length, keyValue);
+        JS_FreeValue(m_ctx, keyValue);
+        if (str == nullptr) {
+          return -1;
+        }
+        std::string quotedKey;
+        appendQuoted(quotedKey, str, length);
+        JS_FreeCString(m_ctx, str);
+        it = m_quotedKeys.emplace(JS_DupAtom(m_ctx, atom), std::move(quotedKey)).first;
+      }
+
+      m_out += it->second;
+      return 0;
+    }
+
+    int appendNumber(double d) {
+      if (!std::isfinite(d)) {
+        m_out += "null";
+        return 0;
+      }
+      if (appendSafeInteger(m_out, d)) {
+        return 0;
+      }
+
+      size_t length;
+      const char *str = JS_ToCStringLen(m_ctx, &length, JS_NewFloat64(m_ctx, d));
+      if (str == nullptr) {
+        return -1;
+      }
+      m_out.append(str, length);
+      JS_FreeCString(m_ctx, str);
+      return 0;
+    }
+
+    int appendString(JSValueConst v) {
+      size_t length;
+      const char *str = JS_ToCStringLen(m_ctx, &length, v);
+      if (str == nullptr) {
+        return -1;
+      }
+      appendQuoted(m_out, str, length);
+      JS_FreeCString(m_ctx, str);
+      return 0;
+    }
+
+    JSValue getPrototypeOf(JSValueConst globalObj, const char *ctorName) {
+      JSValue ctor = JS_GetPropertyStr(m_ctx, globalObj, ctorName);
+      JSValue prototype = JS_GetPropertyStr(m_ctx, ctor, "prototype");
+      JS_FreeValue(m_ctx, ctor);
+      return prototype;
+    }
+
+    void freePropertyEnum(JSPropertyEnum *properties, uint32_t count) {
+      for (uint32_t i = 0; i < count; ++i) {
+        JS_FreeAtom(m_ctx, properties[i].atom);
+      }
+      js_free(m_ctx, properties);
+    }
+
+    JSContext *m_ctx;
+    const bool m_keepErrorStack;
+    std::string &m_out;
+    std::vector<void *> m_visiting;
+    std::unordered_map<JSAtom, std::string> m_quotedKeys;
+    JSValue m_errorCtor = JS_UNDEFINED;
+    JSValue m_numberPrototype = JS_UNDEFINED;
+    JSValue m_stringPrototype = JS_UNDEFINED;
+    JSValue m_booleanPrototype = JS_UNDEFINED;
+    JSAtom m_emptyAtom = JS_ATOM_NULL;
+    JSAtom m_toJsonAtom = JS_ATOM_NULL;
+    JSAtom m_stackAtom = JS_ATOM_NULL;
+  };
 }
 
-#include <cstring>
+int custom_stringify(JSContext *ctx, JSValueConst v, bool keepErrorStack, std::string &json) {
+  json.clear();
+
+  if (JS_IsUndefined(v)) {
+    return 0;
+  }
+
+  int ret = Stringifier(ctx, keepErrorStack, json).run(v);
+  if (ret < 0) {
+    json.clear();
+  }
+  return ret;
+}
 
 #endif
@@ -16,17 +16,34 @@
 #ifndef _JSBRIDGE_CUSTOM_STRINGIFY_H
 #define _JSBRIDGE_CUSTOM_STRINGIFY_H
 
+#include <string>
+
+// Native JSON serializer giving the same output as:
+//   JSON.stringify(value, function(key, value) {
+//     // Error instance -> plain object with the Error own properties
+//     // ("stack" is skipped unless keepErrorStack is set)
+//   });
+//
+// The JSON string is written into the given buffer (which is cleared first, so that it can be
+// re-used between calls). An undefined value, or a value which cannot be serialized (function,
+// symbol), gives an empty string.
+
 #if defined(DUKTAPE)
 
 # include "duktape/duktape.h"
 
-duk_int_t custom_stringify(duk_context *, duk_idx_t, bool keepErrorStack);
+// [... value ...] -> [... value ...] and DUK_EXEC_SUCCESS
+// [... value ...] -> [... value ... error] and DUK_EXEC_ERROR
+//
+// Note: the JSON string is encoded in CESU-8 (like Duktape strings)
+duk_int_t custom_stringify(duk_context *, duk_idx_t, bool keepErrorStack, std::string &json);
 
 #elif defined(QUICKJS)
 
 # include "quickjs/quickjs.h"
 
-JSValue custom_stringify(JSContext *, JSValueConst, bool keepErrorStack);
+// Return -1 if a JS exception has been thrown
+int custom_stringify(JSContext *, JSValueConst, bool keepErrorStack, std::string &json);
 
 #endif
 #endif
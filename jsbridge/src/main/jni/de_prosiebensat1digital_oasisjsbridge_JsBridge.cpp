@@ -17,38 +17,82 @@
  * limitations under the License.
  */
 #include "de_prosiebensat1digital_oasisjsbridge_JsBridge.h"
+#include "Console.h"
 #include "ExceptionHandler.h"
 #include "JniCache.h"
 #include "JsBridgeContext.h"
+#include "MappedFile.h"
+#include "ScriptCache.h"
+#include "StringInternCache.h"
 #include "log.h"
 #include "java-types/Deferred.h"
+#include "jni-helpers/JArrayLocalRef.h"
 #include "jni-helpers/JniContext.h"
 #include "jni-helpers/JniLocalRef.h"
 #include "jni-helpers/JObjectArrayLocalRef.h"
 #include "jni-helpers/JStringLocalRef.h"
+#include <exception>
+#include <memory>
 #include <new>
 
 namespace {
-  // This should be instanciated in each JNI entry function to make sure that the JNI context is
-  // properly set up with the current JNIEnv
+  // This should be instanciated in each JNI entry function.
+  //
+  // The JniContext fetches the JNIEnv of the calling thread itself (JvmAuto mode) so that the JS
+  // context can be called from any Java thread, as long as the calls are serialized by the caller
+  // (i.e. the JsBridge context lock).
   JsBridgeContext *getJsBridgeContext(JNIEnv *env, jlong lctx) {
     assert(lctx != 0L);
     auto jsBridgeContext = reinterpret_cast<JsBridgeContext *>(lctx);
 
-    // Set the current JNIEnv instance of the JniContext
-    JniContext *jniContext = jsBridgeContext->getJniContext();
-    assert(jniContext != nullptr);
-    assert(jniContext->getJNIEnv() == env);
-    jniContext->setCurrentJNIEnv(env);
+    assert(jsBridgeContext->getJniContext() != nullptr);
+    assert(jsBridgeContext->getJniContext()->getJNIEnv() == env);
 
 #ifndef NDEBUG
-    // In debug mode: check that we are in the correct thread
+    // In debug mode: check that the calling thread owns the JS context
     // (everything else will lead to unexpected behavior...)
     jsBridgeContext->getJniCache()->getJsBridgeInterface().checkJsThread();
 #endif
 
     return jsBridgeContext;
   }
+
+  // This should be instanciated in each JNI entry function which executes JS code to make sure
+  // that the pending JS jobs (e.g. promise reactions) are executed at the end of the outermost
+  // call, without needing an additional JNI call from Java. The console messages of the call are
+  // then written in one batch.
+  //
+  // Note: if a Java exception is pending, the jobs will be executed at the end of the next call.
+  class AutoJobsDrainer {
+  public:
+    explicit AutoJobsDrainer(JsBridgeContext *jsBridgeContext)
+     : m_jsBridgeContext(jsBridgeContext) {
+      m_jsBridgeContext->enterJniCall();
+    }
+
+    AutoJobsDrainer(const AutoJobsDrainer &) = delete;
+    AutoJobsDrainer &operator=(const AutoJobsDrainer &) = delete;
+
+    ~AutoJobsDrainer() {
+      if (m_jsBridgeContext->leaveJniCall() > 0) {
+        // Nested call (JS -> Java -> JS)
+        return;
+      }
+
+      try {
+        if (!m_jsBridgeContext->getJniContext()->exceptionCheck()) {
+          m_jsBridgeContext->processPromiseQueue();
+        }
+
+        m_jsBridgeContext->getConsole()->flush();
+      } catch (const std::exception &e) {
+        m_jsBridgeContext->getExceptionHandler()->jniThrow(e);
+      }
+    }
+
+  private:
+    JsBridgeContext *m_jsBridgeContext;
+  };
 }
 
 extern "C" {
@@ -58,7 +102,7 @@ JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniC
   alog("jniCreateContext()");
 
   auto jsBridgeContext = new JsBridgeContext();
-  auto jniContext = new JniContext(env, JniContext::EnvironmentSource::Manual);
+  auto jniContext = new JniContext(env, JniContext::EnvironmentSource::JvmAuto);
 
   try {
     jsBridgeContext->init(jniContext, JniLocalRef<jobject>(jniContext, object, JniLocalRefMode::Borrowed));
@@ -96,10 +140,19 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDe
 }
 
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableModuleLoader
-        (JNIEnv *env, jobject, jlong lctx) {
+        (JNIEnv *env, jobject, jlong lctx, jstring compiledModuleCacheDir) {
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
-  jsBridgeContext->enableModuleLoader();
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strCompiledModuleCacheDir = compiledModuleCacheDir == nullptr ? std::string() :
+      JStringLocalRef(jniContext, compiledModuleCacheDir, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->enableModuleLoader(strCompiledModuleCacheDir);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
 }
 
 JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetCurrentScriptOrModuleName
@@ -124,6 +177,7 @@ JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jn
   //alog("jniEvaluateString()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
   JValue returnValue;
@@ -146,6 +200,7 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEv
   //alog("jniEvaluateFileContent()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
   std::string strFilename = JStringLocalRef(jniContext, filename, JniLocalRefMode::Borrowed).toStdString();
@@ -157,6 +212,26 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEv
   }
 }
 
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateFile
+    (JNIEnv *env, jobject, jlong lctx, jint fd, jlong offset, jlong length, jstring filename, jboolean isBytecode, jboolean asModule) {
+
+  //alog("jniEvaluateFile()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strFilename = JStringLocalRef(jniContext, filename, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    // The fd is owned (and closed) by the caller, the mapping stays valid until the end of the evaluation
+    MappedFile file(fd, off_t(offset), size_t(length), !isBytecode /*nullTerminated*/);
+    jsBridgeContext->evaluateFile(file, strFilename, isBytecode, asModule);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJavaObject
     (JNIEnv *env, jobject, jlong lctx, jstring name, jobject javaObject, jobjectArray javaMethods) {
 
@@ -199,6 +274,7 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRe
   //alog("jniRegisterJsObject()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
   std::string strName = JStringLocalRef(jniContext, name, JniLocalRefMode::Borrowed).toUtf8Chars();
@@ -233,6 +309,7 @@ JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jn
   //alog("jniCallJsMethod()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
   std::string strObjectName = JStringLocalRef(jniContext, objectName, JniLocalRefMode::Borrowed).toUtf8Chars();
@@ -260,6 +337,7 @@ JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jn
   //alog("jniCallJsLambda()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
   std::string strObjectName = JStringLocalRef(jniContext, objectName, JniLocalRefMode::Borrowed).toStdString();
@@ -286,6 +364,7 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniAs
   //alog("jniAssignJsValue()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
   std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toUtf8Chars();
@@ -297,18 +376,26 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniAs
   }
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteJsValue
-    (JNIEnv *env, jobject, jlong lctx, jstring globalName) {
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteJsValues
+    (JNIEnv *env, jobject, jlong lctx, jobjectArray globalNames) {
 
-  //alog("jniDeleteJsValue()");
+  //alog("jniDeleteJsValues()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
-  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+  JObjectArrayLocalRef globalNamesRef(jniContext, globalNames, JniLocalRefMode::Borrowed);
+  const jsize count = globalNamesRef.getLength();
+
+  std::vector<std::string> strGlobalNames;
+  strGlobalNames.reserve(count);
+  for (jsize i = 0; i < count; ++i) {
+    strGlobalNames.push_back(JStringLocalRef(globalNamesRef.getElement<jstring>(i)).toStdString());
+  }
 
   try {
-    jsBridgeContext->deleteJsValue(strGlobalName);
+    jsBridgeContext->deleteJsValues(strGlobalNames);
   } catch (const std::exception &e) {
     jsBridgeContext->getExceptionHandler()->jniThrow(e);
   }
@@ -332,12 +419,52 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCo
   }
 }
 
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniWriteStructuredClone
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    // Native buffer handle, which stays in C++ until read by the other context
+    return reinterpret_cast<jlong>(new std::string(jsBridgeContext->writeStructuredClone(strGlobalName)));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return 0;
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniReadStructuredClone
+    (JNIEnv *env, jobject, jlong lctx, jlong lbuffer, jstring globalName) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->readStructuredClone(strGlobalName, *reinterpret_cast<const std::string *>(lbuffer));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteStructuredClone
+    (JNIEnv *, jobject, jlong lbuffer) {
+
+  delete reinterpret_cast<std::string *>(lbuffer);
+}
+
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniNewJsFunction
     (JNIEnv *env, jobject, jlong lctx, jstring globalName, jobjectArray args, jstring jsCode) {
 
   //alog("jniNewJsFunction()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
   std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toUtf8Chars();
@@ -357,6 +484,7 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCo
   //alog("jniConvertJavaValueToJs()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
   std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
@@ -370,31 +498,370 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCo
   }
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCompleteJsPromise
-    (JNIEnv *env, jobject, jlong lctx, jstring id, jboolean isFulfilled, jobject value) {
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJsValueProperty
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jstring key, jobject returnParameter, jboolean awaitJsPromise) {
 
-  //alog("jniCompleteJsPromise()");
+  //alog("jniGetJsValueProperty()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
-  std::string strId = JStringLocalRef(jniContext, id, JniLocalRefMode::Borrowed).toUtf8Chars();
-  JniLocalRef<jobject> valueRef(jniContext, value, JniLocalRefMode::Borrowed);
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
 
+  JValue returnValue;
   try {
-    JavaTypes::Deferred::completeJsPromise(jsBridgeContext, strId, isFulfilled, valueRef);
+    returnValue = jsBridgeContext->getJsValueProperty(strGlobalName,
+                                                      JStringLocalRef(jniContext, key, JniLocalRefMode::Borrowed),
+                                                      JniLocalRef<jsBridgeParameter>(jniContext, returnParameter, JniLocalRefMode::Borrowed),
+                                                      awaitJsPromise);
   } catch (const std::exception &e) {
     jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return nullptr;
   }
+
+  // Prevent auto-releasing the localref returned to Java
+  returnValue.detachLocalRef();
+
+  return returnValue.get().l;
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniProcessPromiseQueue
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSetJsValueProperty
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jstring key, jobject value, jobject parameter) {
+
+  //alog("jniSetJsValueProperty()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->setJsValueProperty(strGlobalName,
+                                        JStringLocalRef(jniContext, key, JniLocalRefMode::Borrowed),
+                                        JniLocalRef<jobject>(jniContext, value, JniLocalRefMode::Borrowed),
+                                        JniLocalRef<jsBridgeParameter>(jniContext, parameter, JniLocalRefMode::Borrowed));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT jboolean JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniHasJsValueProperty
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jstring key) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    return jsBridgeContext->hasJsValueProperty(strGlobalName, JStringLocalRef(jniContext, key, JniLocalRefMode::Borrowed));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return false;
+  }
+}
+
+JNIEXPORT jobjectArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJsValueKeys
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    JObjectArrayLocalRef keys = jsBridgeContext->getJsValueKeys(strGlobalName);
+
+    // Prevent auto-releasing the localref returned to Java
+    keys.detach();
+    return keys.get();
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return nullptr;
+  }
+}
+
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsValue
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jstring methodName, jobjectArray args, jobjectArray argParameters,
+     jobject returnParameter, jboolean awaitJsPromise) {
+
+  //alog("jniCallJsValue()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  JValue returnValue;
+  try {
+    returnValue = jsBridgeContext->callJsValue(strGlobalName,
+                                               JStringLocalRef(jniContext, methodName, JniLocalRefMode::Borrowed),
+                                               JObjectArrayLocalRef(jniContext, args, JniLocalRefMode::Borrowed),
+                                               JObjectArrayLocalRef(jniContext, argParameters, JniLocalRefMode::Borrowed),
+                                               JniLocalRef<jsBridgeParameter>(jniContext, returnParameter, JniLocalRefMode::Borrowed),
+                                               awaitJsPromise);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return nullptr;
+  }
+
+  // Prevent auto-releasing the localref returned to Java
+  returnValue.detachLocalRef();
+
+  return returnValue.get().l;
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCompleteJsPromises
+    (JNIEnv *env, jobject, jlong lctx, jobjectArray ids, jbooleanArray isFulfilled, jobjectArray values) {
+
+  //alog("jniCompleteJsPromises()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  JObjectArrayLocalRef idsRef(jniContext, ids, JniLocalRefMode::Borrowed);
+  JArrayLocalRef<jboolean> isFulfilledRef(JniLocalRef<jarray>(jniContext, isFulfilled, JniLocalRefMode::Borrowed));
+  JObjectArrayLocalRef valuesRef(jniContext, values, JniLocalRefMode::Borrowed);
+
+  const jsize count = idsRef.getLength();
+  const jboolean *isFulfilledElements = isFulfilledRef.getElements();
+
+  // A failing completion must not prevent the other ones: the first error is thrown once all the
+  // promises have been completed and the jobs have been drained
+  std::exception_ptr firstException;
+  {
+    AutoJobsDrainer autoJobsDrainer(jsBridgeContext);
+
+    for (jsize i = 0; i < count; ++i) {
+      try {
+        std::string strId = JStringLocalRef(idsRef.getElement<jstring>(i)).toStdString();
+        JavaTypes::Deferred::completeJsPromise(jsBridgeContext, strId, isFulfilledElements[i], valuesRef.getElement(i));
+      } catch (const std::exception &) {
+        if (!firstException) {
+          firstException = std::current_exception();
+        }
+      }
+    }
+  }
+
+  if (firstException) {
+    try {
+      std::rethrow_exception(firstException);
+    } catch (const std::exception &e) {
+      jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    }
+  }
+}
+
+JNIEXPORT jboolean JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRunJobs
+  (JNIEnv *env, jobject, jlong lctx, jint maxJobs, jlong maxMicros) {
+
+  //alog("jniRunJobs()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+
+  bool hasPendingJobs = false;
+  try {
+    hasPendingJobs = jsBridgeContext->runJobs(maxJobs, maxMicros);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+
+  // No AutoJobsDrainer here (the remaining jobs are left to the next call) but the console
+  // messages of the executed jobs are still written
+  try {
+    jsBridgeContext->getConsole()->flush();
+  } catch (const std::exception &e) {
+    if (!jsBridgeContext->getJniContext()->exceptionCheck()) {
+      jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    }
+  }
+
+  return hasPendingJobs ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetDrainedJobCount
+  (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  return static_cast<jlong>(jsBridgeContext->getDrainedJobCount());
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniUpdateStackTop
+  (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  jsBridgeContext->updateStackTop();
+}
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJniIdLookupCount
+  (JNIEnv *, jobject) {
+
+  return static_cast<jlong>(JniIds::getLookupCount());
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableConsole
+  (JNIEnv *env, jobject, jlong lctx, jint mode, jint minPriority, jboolean useNativeLog, jint maxMessagesPerSecond) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+
+  try {
+    jsBridgeContext->getConsole()->enable(static_cast<Console::Mode>(mode), minPriority, useNativeLog, maxMessagesPerSecond);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableStringInterning
+  (JNIEnv *env, jobject, jlong lctx, jint maxEntryCount, jint maxStringLength) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+
+  try {
+    jsBridgeContext->enableStringInterning(static_cast<size_t>(maxEntryCount), static_cast<size_t>(maxStringLength));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetStringInternStats
+  (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  const StringInternCache *stringInternCache = jsBridgeContext->getStringInternCache();
+
+  // [hits, misses, entries]
+  jlong stats[3] = { 0, 0, 0 };
+  if (stringInternCache != nullptr) {
+    stats[0] = static_cast<jlong>(stringInternCache->getHitCount());
+    stats[1] = static_cast<jlong>(stringInternCache->getMissCount());
+    stats[2] = static_cast<jlong>(stringInternCache->getEntryCount());
+  }
+
+  jlongArray ret = env->NewLongArray(3);
+  if (ret != nullptr) {
+    env->SetLongArrayRegion(ret, 0, 3, stats);
+  }
+  return ret;
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableScriptCache
+  (JNIEnv *env, jobject, jlong lctx, jint maxEntryCount, jint maxSourceLength) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+
+  try {
+    jsBridgeContext->enableScriptCache(static_cast<size_t>(maxEntryCount), static_cast<size_t>(maxSourceLength));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetScriptCacheStats
+  (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  const ScriptCache *scriptCache = jsBridgeContext->getScriptCache();
+
+  // [hits, misses, evictions, entries]
+  jlong stats[4] = { 0, 0, 0, 0 };
+  if (scriptCache != nullptr) {
+    stats[0] = static_cast<jlong>(scriptCache->getHitCount());
+    stats[1] = static_cast<jlong>(scriptCache->getMissCount());
+    stats[2] = static_cast<jlong>(scriptCache->getEvictionCount());
+    stats[3] = static_cast<jlong>(scriptCache->getEntryCount());
+  }
+
+  jlongArray ret = env->NewLongArray(4);
+  if (ret != nullptr) {
+    env->SetLongArrayRegion(ret, 0, 4, stats);
+  }
+  return ret;
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableTimers
   (JNIEnv *env, jobject, jlong lctx) {
 
-  //alog("jniProcessPromiseQueue()");
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+
+  try {
+    jsBridgeContext->enableTimers();
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRunTimers
+  (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);  // single drain after the whole batch
+
+  try {
+    jsBridgeContext->runTimers();
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniNewWorkerChannel
+  (JNIEnv *, jobject) {
+
+  // The channel is shared by the Java handles and the JS endpoints of both contexts
+  return reinterpret_cast<jlong>(new std::shared_ptr<WorkerChannel>(std::make_shared<WorkerChannel>()));
+}
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniShareWorkerChannel
+  (JNIEnv *, jobject, jlong lchannel) {
+
+  // New handle to the same channel
+  return reinterpret_cast<jlong>(new std::shared_ptr<WorkerChannel>(*reinterpret_cast<std::shared_ptr<WorkerChannel> *>(lchannel)));
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteWorkerChannel
+  (JNIEnv *, jobject, jlong lchannel) {
+
+  delete reinterpret_cast<std::shared_ptr<WorkerChannel> *>(lchannel);
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSetUpWorkerEndpoint
+  (JNIEnv *env, jobject, jlong lctx, jlong lchannel, jstring globalName, jboolean isWorker) {
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
-  jsBridgeContext->processPromiseQueue();
+  auto jniContext = jsBridgeContext->getJniContext();
+  const auto &channel = *reinterpret_cast<std::shared_ptr<WorkerChannel> *>(lchannel);
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->setUpWorkerEndpoint(strGlobalName, channel, lchannel,
+                                         isWorker ? WorkerChannel::Side::Worker : WorkerChannel::Side::Parent);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDispatchWorkerMessages
+  (JNIEnv *env, jobject, jlong lctx, jlong lchannel, jstring globalName, jboolean isWorker) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+  AutoJobsDrainer autoJobsDrainer(jsBridgeContext);  // single drain after the whole batch
+  const auto &channel = *reinterpret_cast<std::shared_ptr<WorkerChannel> *>(lchannel);
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->dispatchWorkerMessages(strGlobalName, *channel,
+                                            isWorker ? WorkerChannel::Side::Worker : WorkerChannel::Side::Parent);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
 }
 
 }  // extern "C"
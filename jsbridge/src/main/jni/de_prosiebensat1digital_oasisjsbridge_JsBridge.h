@@ -38,7 +38,7 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDe
   (JNIEnv *, jobject, jlong);
 
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableModuleLoader
-        (JNIEnv *, jobject, jlong);
+        (JNIEnv *, jobject, jlong, jstring);
 
 JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetCurrentScriptOrModuleName
         (JNIEnv *, jobject, jlong, jint);
@@ -49,6 +49,9 @@ JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jn
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateFileContent
   (JNIEnv *, jobject, jlong, jstring, jstring, jboolean asModule);
 
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateFile
+  (JNIEnv *, jobject, jlong, jint, jlong, jlong, jstring, jboolean, jboolean);
+
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJavaObject
     (JNIEnv *, jobject, jlong, jstring, jobject, jobjectArray);
 
@@ -70,24 +73,93 @@ JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jn
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniAssignJsValue
 (JNIEnv *, jobject, jlong, jstring, jstring);
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteJsValue
-    (JNIEnv *, jobject, jlong, jstring);
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteJsValues
+    (JNIEnv *, jobject, jlong, jobjectArray);
 
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCopyJsValue
     (JNIEnv *, jobject, jlong, jstring, jstring);
 
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniWriteStructuredClone
+    (JNIEnv *, jobject, jlong, jstring);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniReadStructuredClone
+    (JNIEnv *, jobject, jlong, jlong, jstring);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteStructuredClone
+    (JNIEnv *, jobject, jlong);
+
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniNewJsFunction
 (JNIEnv *, jobject, jlong, jstring, jobjectArray, jstring);
 
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniConvertJavaValueToJs
     (JNIEnv *, jobject, jlong, jstring, jobject, jobject);
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCompleteJsPromise
-    (JNIEnv *, jobject, jlong, jstring, jboolean, jobject);
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJsValueProperty
+    (JNIEnv *, jobject, jlong, jstring, jstring, jobject, jboolean);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSetJsValueProperty
+    (JNIEnv *, jobject, jlong, jstring, jstring, jobject, jobject);
+
+JNIEXPORT jboolean JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniHasJsValueProperty
+    (JNIEnv *, jobject, jlong, jstring, jstring);
+
+JNIEXPORT jobjectArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJsValueKeys
+    (JNIEnv *, jobject, jlong, jstring);
+
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsValue
+    (JNIEnv *, jobject, jlong, jstring, jstring, jobjectArray, jobjectArray, jobject, jboolean);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCompleteJsPromises
+    (JNIEnv *, jobject, jlong, jobjectArray, jbooleanArray, jobjectArray);
+
+JNIEXPORT jboolean JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRunJobs
+    (JNIEnv *, jobject, jlong, jint, jlong);
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetDrainedJobCount
+    (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniUpdateStackTop
+    (JNIEnv *, jobject, jlong);
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJniIdLookupCount
+    (JNIEnv *, jobject);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableConsole
+    (JNIEnv *, jobject, jlong, jint, jint, jboolean, jint);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableStringInterning
+    (JNIEnv *, jobject, jlong, jint, jint);
+
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetStringInternStats
+    (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableScriptCache
+    (JNIEnv *, jobject, jlong, jint, jint);
+
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetScriptCacheStats
+    (JNIEnv *, jobject, jlong);
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniProcessPromiseQueue
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableTimers
     (JNIEnv *, jobject, jlong);
 
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRunTimers
+    (JNIEnv *, jobject, jlong);
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniNewWorkerChannel
+    (JNIEnv *, jobject);
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniShareWorkerChannel
+    (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteWorkerChannel
+    (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSetUpWorkerEndpoint
+    (JNIEnv *, jobject, jlong, jlong, jstring, jboolean);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDispatchWorkerMessages
+    (JNIEnv *, jobject, jlong, jlong, jstring, jboolean);
+
 #ifdef __cplusplus
 }
 #endif
@@ -34,13 +34,14 @@ std::string JniException::createMessage(const JniContext *jniContext, const JniL
     return "null";
   }
 
-  JniLocalRef<jclass> exceptionClass = jniContext->getObjectClass(throwable);
-  jmethodID getClass = jniContext->getMethodID(exceptionClass, "getClass", "()Ljava/lang/Class;");
+  // System classes (never unloaded): their method IDs are only resolved once per process
+  static const jmethodID getClass = jniContext->getMethodID(jniContext->findClass("java/lang/Object"), "getClass", "()Ljava/lang/Class;");
+  static const jmethodID getName = jniContext->getMethodID(jniContext->findClass("java/lang/Class"), "getName", "()Ljava/lang/String;");
+  static const jmethodID getMessage = jniContext->getMethodID(jniContext->findClass("java/lang/Throwable"), "getMessage", "()Ljava/lang/String;");
 
+  JniLocalRef<jclass> exceptionClass = jniContext->getObjectClass(throwable);
   JniLocalRef<jobject> classObject = jniContext->callObjectMethod(exceptionClass, getClass);
-  JniLocalRef<jclass> classObjectClass = jniContext->getObjectClass(classObject);
 
-  jmethodID getName = jniContext->getMethodID(classObjectClass, "getName", "()Ljava/lang/String;");
   std::string exceptionName;
   if (jniContext->exceptionCheck()) {
     exceptionName = jniContext->callStringMethod(exceptionClass, getName).toStdString();
@@ -48,7 +49,6 @@ std::string JniException::createMessage(const JniContext *jniContext, const JniL
     exceptionName = "<unknown exception>";
   }
 
-  jmethodID getMessage = jniContext->getMethodID(exceptionClass, "getMessage", "()Ljava/lang/String;");
   std::string message = jniContext->callStringMethod(throwable, getMessage).toStdString();
 
   return exceptionName + ": " + message;
@@ -39,21 +39,16 @@ namespace {
   std::unique_ptr<const JavaType> getComponentType(const JsBridgeContext *jsBridgeContext, const JniRef<jclass> &arrayJavaClass) {
     const JniContext *jniContext = jsBridgeContext->getJniContext();
 
-    JniLocalRef<jclass> javaClassClass = jsBridgeContext->getJniCache()->getJavaClassClass();
+    const JniIds &ids = jsBridgeContext->getJniCache()->getIds();
 
     // Get the component class of the array
-    jmethodID getComponentType = jniContext->getMethodID(javaClassClass, "getComponentType", "()Ljava/lang/Class;");
-    JniLocalRef<jclass> javaClassRef = jniContext->callObjectMethod<jclass>(arrayJavaClass, getComponentType);
+    JniLocalRef<jclass> javaClassRef = jniContext->callObjectMethod<jclass>(arrayJavaClass, ids.classGetComponentType);
     if (jniContext->exceptionCheck()) {
       throw JniException(jniContext);
     }
 
     // Get its Java name
-    jmethodID getName = jniContext->getMethodID(javaClassClass, "getName", "()Ljava/lang/String;");
-    if (jniContext->exceptionCheck()) {
-      throw JniException(jniContext);
-    }
-    JStringLocalRef javaNameRef = jniContext->callStringMethod(javaClassRef, getName);
+    JStringLocalRef javaNameRef = jniContext->callStringMethod(javaClassRef, ids.classGetName);
     if (jniContext->exceptionCheck()) {
       throw JniException(jniContext);
     }
@@ -18,6 +18,7 @@
  */
 #include "Boolean.h"
 
+#include "JniCache.h"
 #include "JsBridgeContext.h"
 #include "log.h"
 #include "exceptions/JniException.h"
@@ -209,15 +210,13 @@ JValue Boolean::callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
 
 JValue Boolean::box(const JValue &booleanValue) const {
   // From boolean to Boolean
-  static thread_local jmethodID boxId = m_jniContext->getStaticMethodID(getBoxedJavaClass(), "valueOf", "(Z)Ljava/lang/Boolean;");
-  auto boxedBoolean = m_jniContext->callStaticObjectMethod(getBoxedJavaClass(), boxId, booleanValue.getBool());
+  auto boxedBoolean = m_jniContext->callStaticObjectMethod(getBoxedJavaClass(), getJniCache()->getIds().booleanValueOf, booleanValue.getBool());
   return JValue(std::move(boxedBoolean));
 }
 
 JValue Boolean::unbox(const JValue &boxedValue) const {
   // From Boolean to boolean
-  static thread_local jmethodID unboxId = m_jniContext->getMethodID(getBoxedJavaClass(), "booleanValue", "()Z");
-  return JValue(m_jniContext->callBooleanMethod(boxedValue.getLocalRef(), unboxId));
+  return JValue(m_jniContext->callBooleanMethod(boxedValue.getLocalRef(), getJniCache()->getIds().booleanBooleanValue));
 }
 
 }  // namespace JavaTypes
@@ -18,6 +18,7 @@
  */
 #include "Byte.h"
 
+#include "JniCache.h"
 #include "JsBridgeContext.h"
 #include "log.h"
 #include "exceptions/JniException.h"
@@ -225,14 +226,12 @@ JValue Byte::callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
 
 JValue Byte::box(const JValue &byteValue) const {
   // From byte to Byte
-  static thread_local jmethodID boxId = m_jniContext->getStaticMethodID(getBoxedJavaClass(), "valueOf", "(B)Ljava/lang/Byte;");
-  return JValue(m_jniContext->callStaticObjectMethod(getBoxedJavaClass(), boxId, byteValue.getByte()));
+  return JValue(m_jniContext->callStaticObjectMethod(getBoxedJavaClass(), getJniCache()->getIds().byteValueOf, byteValue.getByte()));
 }
 
 JValue Byte::unbox(const JValue &boxedValue) const {
   // From Byte to byte
-  static thread_local jmethodID unboxId = m_jniContext->getMethodID(getBoxedJavaClass(), "byteValue", "()B");
-  return JValue(m_jniContext->callByteMethod(boxedValue.getLocalRef(), unboxId));
+  return JValue(m_jniContext->callByteMethod(boxedValue.getLocalRef(), getJniCache()->getIds().byteByteValue));
 }
 
 }  // namespace JavaTypes
@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "DataClass.h"
+
+#include "ExceptionHandler.h"
+#include "JniCache.h"
+#include "JsBridgeContext.h"
+#include "exceptions/JniException.h"
+#include "exceptions/JsException.h"
+#include "jni-helpers/JniContext.h"
+#include "jni-helpers/JValue.h"
+#include <string>
+
+#if defined(QUICKJS)
+# include "AutoReleasedJSValue.h"
+# include "QuickJsUtils.h"
+#endif
+
+namespace {
+  // JNI type of the field holding a value of the given (unboxed) type
+  char getJniType(JavaTypeId id) {
+    switch (id) {
+      case JavaTypeId::Boolean: return 'Z';
+      case JavaTypeId::Byte: return 'B';
+      case JavaTypeId::Short: return 'S';
+      case JavaTypeId::Int: return 'I';
+      case JavaTypeId::Long: return 'J';
+      case JavaTypeId::Float: return 'F';
+      case JavaTypeId::Double: return 'D';
+      default: return 'L';
+    }
+  }
+}
+
+namespace JavaTypes {
+
+// DataClassPlan
+// ---
+
+DataClassPlan::~DataClassPlan() {
+#if defined(QUICKJS)
+  if (jsBridgeContext == nullptr) {
+    return;
+  }
+
+  for (const Field &field : fields) {
+    if (field.atom != JS_ATOM_NULL) {
+      JS_FreeAtom(jsBridgeContext->getQuickJsContext(), field.atom);
+    }
+  }
+#endif
+}
+
+void DataClassPlan::init(const JsBridgeContext *context, const JniRef<jsBridgeParameter> &parameter) {
+  jsBridgeContext = context;
+
+  const JniContext *jniContext = jsBridgeContext->getJniContext();
+  const JniCache *jniCache = jsBridgeContext->getJniCache();
+  JNIEnv *env = jniContext->getJNIEnv();
+
+  ParameterInterface parameterInterface = jniCache->getParameterInterface(parameter);
+  JniLocalRef<jobject> constructor = parameterInterface.getDataClassConstructor();
+  JObjectArrayLocalRef parameters = parameterInterface.getDataClassParameters();
+  JObjectArrayLocalRef javaFields = parameterInterface.getDataClassFields();
+
+  if (constructor.isNull() || parameters.isNull() || javaFields.isNull() || parameters.getLength() != javaFields.getLength()) {
+    throw std::invalid_argument("Could not get the primary constructor properties of data class " + javaName);
+  }
+
+  constructorId = jniContext->fromReflectedMethod(constructor);
+
+  const jsize count = parameters.getLength();
+  fields.resize(count);
+
+  for (jsize i = 0; i < count; ++i) {
+    JniLocalRef<jsBridgeParameter> fieldParameter = parameters.getElement<jsBridgeParameter>(i);
+    JniLocalRef<jobject> javaField = javaFields.getElement<jobject>(i);
+    ParameterInterface fieldParameterInterface = jniCache->getParameterInterface(fieldParameter);
+
+    // Nullable primitives are stored as boxed values (e.g. Int? -> java.lang.Integer)
+    const bool isNullable = fieldParameterInterface.isNullable();
+
+    Field &field = fields[i];
+    field.name = fieldParameterInterface.getName().toStdString();
+    field.fieldId = env->FromReflectedField(javaField.get());
+    field.type = jsBridgeContext->getJavaTypeProvider().makeUniqueType(fieldParameter, isNullable /*boxed*/);
+    if (!field.type) {
+      throw std::invalid_argument("Unsupported type for property " + field.name + " of data class " + javaName);
+    }
+    field.jniType = isNullable ? 'L' : getJniType(field.type->getTypeId());
+#if defined(QUICKJS)
+    field.atom = JS_NewAtomLen(jsBridgeContext->getQuickJsContext(), field.name.data(), field.name.size());
+#endif
+  }
+}
+
+
+// DataClass
+// ---
+
+DataClass::DataClass(const JsBridgeContext *jsBridgeContext, const DataClassPlan *plan)
+ : JavaType(jsBridgeContext, JavaTypeId::DataClass)
+ , m_plan(plan) {
+}
+
+JniLocalRef<jclass> DataClass::getJavaClass() const {
+  return JniLocalRef<jclass>(m_plan->javaClass);
+}
+
+void DataClass::checkPlan() const {
+  if (!m_plan->error.empty()) {
+    throw std::invalid_argument(m_plan->error);
+  }
+}
+
+JValue DataClass::getFieldValue(const JniLocalRef<jobject> &object, const DataClassPlan::Field &field) const {
+  JNIEnv *env = m_jniContext->getJNIEnv();
+  jobject o = object.get();
+
+  switch (field.jniType) {
+    case 'Z': return JValue(env->GetBooleanField(o, field.fieldId));
+    case 'B': return JValue(env->GetByteField(o, field.fieldId));
+    case 'S': return JValue(env->GetShortField(o, field.fieldId));
+    case 'I': return JValue(env->GetIntField(o, field.fieldId));
+    case 'J': return JValue(env->GetLongField(o, field.fieldId));
+    case 'F': return JValue(env->GetFloatField(o, field.fieldId));
+    case 'D': return JValue(env->GetDoubleField(o, field.fieldId));
+    default: return JValue(JniLocalRef<jobject>(m_jniContext, env->GetObjectField(o, field.fieldId)));
+  }
+}
+
+JniLocalRef<jobject> DataClass::newJavaObject(const std::vector<JValue> &args) const {
+  JNIEnv *env = m_jniContext->getJNIEnv();
+
+  jvalue *rawArgs = JValue::createArray(args);
+  jobject o = env->NewObjectA(m_plan->javaClass.get(), m_plan->constructorId, rawArgs);
+  delete[] rawArgs;
+
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+
+  return JniLocalRef<jobject>(m_jniContext, o);
+}
+
+#if defined(DUKTAPE)
+
+#include "StackChecker.h"
+
+JValue DataClass::pop() const {
+  CHECK_STACK_OFFSET(m_ctx, -1);
+
+  if (duk_is_null_or_undefined(m_ctx, -1)) {
+    duk_pop(m_ctx);
+    return JValue();
+  }
+
+  const duk_idx_t top = duk_get_top(m_ctx);
+  std::vector<JValue> args;
+  args.reserve(m_plan->fields.size());
+
+  try {
+    checkPlan();
+
+    if (!duk_is_object(m_ctx, -1)) {
+      throw std::invalid_argument(std::string("Cannot convert ") + duk_safe_to_string(m_ctx, -1) + " to " + m_plan->javaName);
+    }
+
+    for (const DataClassPlan::Field &field : m_plan->fields) {
+      duk_get_prop_lstring(m_ctx, -1, field.name.data(), field.name.size());
+      args.push_back(field.type->pop());
+    }
+  } catch (const std::exception &) {
+    duk_set_top(m_ctx, top - 1);  // pop the object (and the property value, if any)
+    throw;
+  }
+
+  duk_pop(m_ctx);  // object
+  return JValue(newJavaObject(args));
+}
+
+duk_ret_t DataClass::push(const JValue &value) const {
+  CHECK_STACK_OFFSET(m_ctx, 1);
+
+  const JniLocalRef<jobject> &jObject = value.getLocalRef();
+  if (jObject.isNull()) {
+    duk_push_null(m_ctx);
+    return 1;
+  }
+
+  const duk_idx_t top = duk_get_top(m_ctx);
+  try {
+    checkPlan();
+
+    duk_push_object(m_ctx);
+    for (const DataClassPlan::Field &field : m_plan->fields) {
+      field.type->push(getFieldValue(jObject, field));
+      duk_put_prop_lstring(m_ctx, -2, field.name.data(), field.name.size());
+    }
+  } catch (const std::exception &) {
+    duk_set_top(m_ctx, top + 1);
+    CHECK_STACK_NOW();
+    duk_pop(m_ctx);
+    throw;
+  }
+
+  return 1;
+}
+
+#elif defined(QUICKJS)
+
+JValue DataClass::toJava(JSValueConst v) const {
+  if (JS_IsNull(v) || JS_IsUndefined(v)) {
+    return JValue();
+  }
+
+  checkPlan();
+
+  if (!JS_IsObject(v)) {
+    throw std::invalid_argument("Cannot convert " + getUtils()->toString(v) + " to " + m_plan->javaName);
+  }
+
+  std::vector<JValue> args;
+  args.reserve(m_plan->fields.size());
+
+  for (const DataClassPlan::Field &field : m_plan->fields) {
+    JSValue propertyValue = JS_GetProperty(m_ctx, v, field.atom);
+    if (JS_IsException(propertyValue)) {
+      throw getExceptionHandler()->getCurrentJsException();
+    }
+    JS_AUTORELEASE_VALUE(m_ctx, propertyValue);  // also released in case of exception!
+    args.push_back(field.type->toJava(propertyValue));
+  }
+
+  return JValue(newJavaObject(args));
+}
+
+JSValue DataClass::fromJava(const JValue &value) const {
+  const JniLocalRef<jobject> &jObject = value.getLocalRef();
+  if (jObject.isNull()) {
+    return JS_NULL;
+  }
+
+  checkPlan();
+
+  JSValue jsObject = JS_NewObject(m_ctx);
+
+  for (const DataClassPlan::Field &field : m_plan->fields) {
+    try {
+      JSValue propertyValue = field.type->fromJava(getFieldValue(jObject, field));
+      JS_DefinePropertyValue(m_ctx, jsObject, field.atom, propertyValue, JS_PROP_C_W_E);
+      // No JS_FreeValue(m_ctx, propertyValue) after JS_DefinePropertyValue()
+    } catch (const std::exception &) {
+      JS_FreeValue(m_ctx, jsObject);
+      throw;
+    }
+  }
+
+  return jsObject;
+}
+
+#endif
+
+}  // namespace JavaTypes
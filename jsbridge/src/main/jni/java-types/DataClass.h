@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JAVATYPES_DATACLASS_H
+#define _JSBRIDGE_JAVATYPES_DATACLASS_H
+
+#include "JavaType.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace JavaTypes {
+
+// Conversion plan of a Kotlin data class, computed once per class (see JniCache::getDataClassPlan())
+// from the primary constructor parameters and their backing fields
+struct DataClassPlan {
+  struct Field {
+    std::string name;  // UTF-8 property name
+    jfieldID fieldId = nullptr;
+    char jniType = 'L';  // JNI type signature of the field: 'Z', 'B', 'S', 'I', 'J', 'F', 'D' or 'L'
+    std::unique_ptr<const JavaType> type;
+#if defined(QUICKJS)
+    JSAtom atom = JS_ATOM_NULL;
+#endif
+  };
+
+  DataClassPlan() = default;
+  DataClassPlan(const DataClassPlan &) = delete;
+  DataClassPlan & operator=(const DataClassPlan &) = delete;
+  ~DataClassPlan();
+
+  // Fill the fields (may recursively create the plans of nested data classes)
+  void init(const JsBridgeContext *, const JniRef<jsBridgeParameter> &parameter);
+
+  const JsBridgeContext *jsBridgeContext = nullptr;
+  JniGlobalRef<jclass> javaClass;
+  std::string javaName;
+  jmethodID constructorId = nullptr;
+  std::vector<Field> fields;
+
+  // Set if init() failed (the plan stays cached because it may be referenced by other plans)
+  std::string error;
+};
+
+// Kotlin data class, converted from/to a plain JS object with one property per primary
+// constructor parameter. The fields are directly read with the Get<Type>Field() JNI functions
+// and the Java object is created with the primary constructor.
+class DataClass : public JavaType {
+
+public:
+  DataClass(const JsBridgeContext *, const DataClassPlan *);
+
+#if defined(DUKTAPE)
+  JValue pop() const override;
+  duk_ret_t push(const JValue &value) const override;
+#elif defined(QUICKJS)
+  JValue toJava(JSValueConst) const override;
+  JSValue fromJava(const JValue &value) const override;
+#endif
+
+protected:
+  JniLocalRef<jclass> getJavaClass() const override;
+
+private:
+  // Note: the plan is owned by the JniCache
+  const DataClassPlan * const m_plan;
+
+  void checkPlan() const;
+  JValue getFieldValue(const JniLocalRef<jobject> &, const DataClassPlan::Field &) const;
+  JniLocalRef<jobject> newJavaObject(const std::vector<JValue> &args) const;
+};
+
+}  // namespace JavaTypes
+
+#endif
@@ -39,6 +39,15 @@ public:
 
   static void completeJsPromise(const JsBridgeContext *, const std::string &strId, bool isFulfilled, const JniLocalRef<jobject> &value);
 
+#if defined(DUKTAPE)
+  // If the value at the stack top is an already fulfilled Promise (polyfill), replace it with
+  // its value and return true
+  static bool replaceFulfilledPromise(const JsBridgeContext *);
+#elif defined(QUICKJS)
+  // Return the value of an already fulfilled native Promise (JS_UNINITIALIZED otherwise)
+  static JSValue getFulfilledValue(const JsBridgeContext *, JSValueConst);
+#endif
+
 private:
   std::shared_ptr<const JavaType> m_componentType;
 };
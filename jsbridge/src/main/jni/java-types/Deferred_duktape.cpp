@@ -201,8 +201,10 @@ JValue Deferred::pop() const {
     throw JniException(m_jniContext);
   }
 
+  replaceFulfilledPromise(m_jsBridgeContext);
+
   if (!duk_is_object(m_ctx, -1) || !duk_has_prop_string(m_ctx, -1, "then")) {
-    // Not a Promise => directly resolve the Java Deferred with the value
+    // Not a Promise or already fulfilled => directly resolve the Java Deferred with the value
     JValue value = m_componentType->pop();
 
     getJniCache()->getJsBridgeInterface().resolveDeferred(javaDeferred, value);
@@ -291,6 +293,8 @@ duk_ret_t Deferred::push(const JValue &value) const {
   // => STASH: [... promiseFunction]
 
   // new Promise(promiseFunction)
+  // Note: Duktape has no C API for promise capabilities so we always go through the Promise
+  // constructor, which is either the built-in one or the polyfill
   if (!duk_get_global_string(m_ctx, "Promise")) {
     duk_pop_2(m_ctx);  // (undefined) "Promise" + promiseFunction
     throw std::invalid_argument("Cannot push Deferred: globalThis.Promise is undefined");
@@ -334,20 +338,33 @@ void Deferred::completeJsPromise(const JsBridgeContext *jsBridgeContext, const s
   auto componentType = *reinterpret_cast<std::shared_ptr<const JavaType> *>(duk_require_pointer(ctx, -1));
   duk_pop(ctx);  // component type pointer
 
-  // Get the resolve/reject function
-  duk_get_prop_string(ctx, -1, isFulfilled ? "resolve" : "reject");
-
-  // Call it with the Promise value
+  // Call resolve/reject with the Promise value (or reject the Promise if the value could not be
+  // converted, so that it does not stay pending forever)
   if (isFulfilled) {
     try {
+      duk_get_prop_string(ctx, -1, "resolve");
       componentType->push(JValue(value));
     } catch (const std::exception &e) {
-      duk_pop_2(ctx);  // resolve/reject function
-      throw;
+      duk_pop(ctx);  // resolve function
+      duk_get_prop_string(ctx, -1, "reject");
+      if (auto jsException = dynamic_cast<const JsException *>(&e)) {
+        jsException->pushError();
+      } else if (auto jniException = dynamic_cast<const JniException *>(&e)) {
+        jsBridgeContext->getExceptionHandler()->pushJavaException(jniException->getThrowable());
+      } else {
+        duk_push_error_object(ctx, DUK_ERR_ERROR, "%s", e.what());
+      }
     }
   } else {
+    duk_get_prop_string(ctx, -1, "reject");
     jsBridgeContext->getExceptionHandler()->pushJavaException(value.staticCast<jthrowable>());
   }
+
+  // A Promise can only be completed once: remove it from the global stash
+  duk_push_global_object(ctx);
+  duk_del_prop_string(ctx, -1, strId.c_str());
+  duk_pop(ctx);  // global object
+
   if (duk_pcall(ctx, 1) != DUK_EXEC_SUCCESS) {
     alog("Could not complete Promise with id %s", strId.c_str());
   }
@@ -355,5 +372,44 @@ void Deferred::completeJsPromise(const JsBridgeContext *jsBridgeContext, const s
   duk_pop_2(ctx);  // (undefined) call result + PromiseObject
 }
 
+// static
+bool Deferred::replaceFulfilledPromise(const JsBridgeContext *jsBridgeContext) {
+  duk_context *ctx = jsBridgeContext->getDuktapeContext();
+  CHECK_STACK(ctx);
+
+  if (!duk_is_object(ctx, -1)) {
+    return false;
+  }
+
+  // Only instances of the Promise polyfill, whose settled state is stored in the own "state"
+  // (true: fulfilled, false: rejected) and "value" properties
+  bool isPolyfillPromise = false;
+  if (duk_get_global_string(ctx, "Promise") && duk_is_function(ctx, -1)) {
+    duk_get_prop_string(ctx, -1, "isPolyfill");
+    duk_get_prop_string(ctx, -2, "prototype");
+    duk_get_prototype(ctx, -4);
+    isPolyfillPromise = duk_get_boolean(ctx, -3) && duk_strict_equals(ctx, -1, -2);
+    duk_pop_3(ctx);  // value prototype + Promise.prototype + isPolyfill
+  }
+  duk_pop(ctx);  // Promise
+
+  if (!isPolyfillPromise) {
+    return false;
+  }
+
+  // Rejected promises still go through then() so that they are marked as handled
+  duk_get_prop_string(ctx, -1, "state");
+  const bool isFulfilled = duk_is_boolean(ctx, -1) && duk_get_boolean(ctx, -1);
+  duk_pop(ctx);  // state
+
+  if (!isFulfilled) {
+    return false;
+  }
+
+  duk_get_prop_string(ctx, -1, "value");
+  duk_replace(ctx, -2);  // promise -> value
+  return true;
+}
+
 }  // namespace JavaType
 
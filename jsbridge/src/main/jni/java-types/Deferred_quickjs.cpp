@@ -15,6 +15,7 @@
  */
 #include "Deferred.h"
 
+#include "AutoReleasedJSValue.h"
 #include "ExceptionHandler.h"
 #include "JavaTypeId.h"
 #include "JniCache.h"
@@ -90,19 +91,28 @@ namespace {
     }
   }
 
-  // Add resolve and reject to bound PromiseObject instance
-  JSValue promiseFunction(JSContext *ctx, JSValueConst /*this_val*/, int argc, JSValueConst *argv, int /*magic*/, JSValueConst *datav) {
-    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
-    assert(jsBridgeContext != nullptr);
+  // Native record holding the resolving functions of a JS Promise created from a Java Deferred
+  struct PromiseCapability {
+    PromiseCapability(JSContext *ctx, JSValue resolvingFuncs[2], std::shared_ptr<const JavaType> componentType)
+     : rt(JS_GetRuntime(ctx))
+     , resolve(resolvingFuncs[0])
+     , reject(resolvingFuncs[1])
+     , componentType(std::move(componentType)) {
+    }
 
-    JSValueConst promiseObject = *datav;
+    PromiseCapability(const PromiseCapability &) = delete;
+    PromiseCapability &operator=(const PromiseCapability &) = delete;
 
-    // Set PromiseObject.resolve and PromiseObject.reject
-    JS_SetPropertyStr(ctx, promiseObject, "resolve", argc >= 1 ? JS_DupValue(ctx, argv[0]) : JS_NULL);
-    JS_SetPropertyStr(ctx, promiseObject, "reject", argc >= 2 ? JS_DupValue(ctx, argv[1]) : JS_NULL);
+    ~PromiseCapability() {
+      JS_FreeValueRT(rt, resolve);
+      JS_FreeValueRT(rt, reject);
+    }
 
-    return JS_UNDEFINED;
-  }
+    JSRuntime *rt;
+    JSValue resolve;
+    JSValue reject;
+    std::shared_ptr<const JavaType> componentType;
+  };
 }
 
 
@@ -127,10 +137,13 @@ JValue Deferred::toJava(JSValueConst v) const {
     throw JniException(m_jniContext);
   }
 
+  JSValue fulfilledValue = getFulfilledValue(m_jsBridgeContext, v);
+  JS_AUTORELEASE_VALUE(m_ctx, fulfilledValue);
+
   bool isPromise = JS_IsObject(v) && utils->hasPropertyStr(v, "then");
-  if (!isPromise) {
-    // Not a Promise => directly resolve the Java Deferred with the value
-    JValue value = m_componentType->toJava(v);
+  if (!isPromise || !JS_IsUninitialized(fulfilledValue)) {
+    // Not a Promise or already fulfilled => directly resolve the Java Deferred with the value
+    JValue value = m_componentType->toJava(isPromise ? fulfilledValue : v);
 
     getJniCache()->getJsBridgeInterface().resolveDeferred(javaDeferred, value);
     if (m_jniContext->exceptionCheck()) {
@@ -193,36 +206,31 @@ JSValue Deferred::fromJava(const JValue &value) const {
 
   const QuickJsUtils *utils = m_jsBridgeContext->getUtils();
 
-  // Create a PromiseObject which will be eventually filled with {resolve, reject}
-  JSValue promiseObject = JS_NewObject(m_ctx);
-  JSValue componentTypeValue = utils->createCppPtrValue(new std::shared_ptr<const JavaType>(m_componentType), true /*deleteOnFinalize*/);
-  JS_SetPropertyStr(m_ctx, promiseObject, PROMISE_COMPONENT_TYPE_PROP_NAME, componentTypeValue);
-  // No JS_FreeValue(m_ctx, componentTypeValue) after JS_SetPropertyStr()
+  // Create a new JS promise and directly get its resolving functions
+  JSValue resolvingFuncs[2];
+  JSValue promiseInstance = JS_NewPromiseCapability(m_ctx, resolvingFuncs);
+  if (JS_IsException(promiseInstance)) {
+    throw getExceptionHandler()->getCurrentJsException();
+  }
+
+  // Keep {resolve, reject} in a native record (which takes ownership of the resolving functions)
+  auto promiseCapability = new PromiseCapability(m_ctx, resolvingFuncs, m_componentType);
+  JSValue promiseCapabilityValue = utils->createCppPtrValue(promiseCapability, true /*deleteOnFinalize*/);
 
   static int promiseCount = 0;
   std::string promiseObjectGlobalName = PROMISE_OBJECT_GLOBAL_NAME_PREFIX + std::to_string(++promiseCount);
 
   // Put it to the global stash
   JSValue globalObj = JS_GetGlobalObject(m_ctx);
-  JS_SetPropertyStr(m_ctx, globalObj, promiseObjectGlobalName.c_str(), JS_DupValue(m_ctx, promiseObject));
+  JS_SetPropertyStr(m_ctx, globalObj, promiseObjectGlobalName.c_str(), promiseCapabilityValue);
+  // No JS_FreeValue(m_ctx, promiseCapabilityValue) after JS_SetPropertyStr()
   JS_FreeValue(m_ctx, globalObj);
 
-  // promiseFunction = function(resolve, reject) + data (promiseObject)
-  JSValue promiseFunctionValue = JS_NewCFunctionData(m_ctx, promiseFunction, 1, 0, 1, &promiseObject);
-  JS_FreeValue(m_ctx, promiseObject);
-
-  // Create a new JS promise with the promiseFunction as parameter
-  // => new Promise(promiseFunction)
-  JSValue promiseCtor = JS_GetPropertyStr(m_ctx, globalObj, "Promise");
-  JSValue promiseInstance = JS_CallConstructor(m_ctx, promiseCtor, 1, &promiseFunctionValue);
-  assert(JS_IsObject(promiseInstance));
-  JS_FreeValue(m_ctx, promiseCtor);
-  JS_FreeValue(m_ctx, promiseFunctionValue);
-
   // Call Java setUpJsPromise()
   getJniCache()->getJsBridgeInterface().setUpJsPromise(
       JStringLocalRef(m_jniContext, promiseObjectGlobalName.c_str()), jDeferred);
   if (m_jniContext->exceptionCheck()) {
+    JS_FreeValue(m_ctx, promiseInstance);
     throw JniException(m_jniContext);
   }
 
@@ -235,49 +243,67 @@ void Deferred::completeJsPromise(const JsBridgeContext *jsBridgeContext, const s
 
   const QuickJsUtils *utils = jsBridgeContext->getUtils();
 
-  // Get the global PromiseObject
+  // Get the global PromiseCapability
   JSValue globalObj = JS_GetGlobalObject(ctx);
-  JSValue promiseObj = JS_GetPropertyStr(ctx, globalObj, strId.c_str());
-  JS_FreeValue(ctx, globalObj);
-  if (!JS_IsObject(promiseObj)) {
+  JSAtom idAtom = JS_NewAtom(ctx, strId.c_str());
+  JSValue promiseCapabilityValue = JS_GetProperty(ctx, globalObj, idAtom);
+  if (!JS_IsObject(promiseCapabilityValue)) {
     alog_warn("Could not find PromiseObject with id %s", strId.c_str());
+    JS_FreeValue(ctx, promiseCapabilityValue);
+    JS_FreeAtom(ctx, idAtom);
+    JS_FreeValue(ctx, globalObj);
     return;
   }
 
-  // Get attached type ptr...
-  JSValue componentTypeValue = JS_GetPropertyStr(ctx, promiseObj, JavaTypes::Deferred::PROMISE_COMPONENT_TYPE_PROP_NAME);
-  if (JS_IsNull(componentTypeValue) || !JS_IsObject(componentTypeValue)) {
-    alog_warn("Could not get component type from Promise with id %s", strId.c_str());
-    JS_FreeValue(ctx, promiseObj);
-    return;
-  }
-  auto componentType = *utils->getCppPtr<std::shared_ptr<const JavaType>>(componentTypeValue);
-  JS_FreeValue(ctx, componentTypeValue);
-
-  // Get the resolve/reject function
-  const char *resolveOrRejectStr = isFulfilled ? "resolve" : "reject";
-  JSValue resolveOrReject = JS_GetPropertyStr(ctx, promiseObj, resolveOrRejectStr);
-  if (JS_IsFunction(ctx, resolveOrReject)) {
-    // Call it with the Promise value
-    JSValue promiseParam;
+  auto promiseCapability = utils->getCppPtr<PromiseCapability>(promiseCapabilityValue);
+
+  // Call resolve/reject with the Promise value (or reject the Promise if the value could not be
+  // converted, so that it does not stay pending forever)
+  JSValue promiseParam;
+  try {
     if (isFulfilled) {
-      promiseParam = componentType->fromJava(JValue(value));
+      promiseParam = promiseCapability->componentType->fromJava(JValue(value));
     } else {
       promiseParam = jsBridgeContext->getExceptionHandler()->javaExceptionToJsValue(value.staticCast<jthrowable>());
     }
-    JSValue ret = JS_Call(ctx, resolveOrReject, promiseObj, 1, &promiseParam);
-    if (JS_IsException(ret)) {
-      alog("Could not complete Promise with id %s", strId.c_str());
+  } catch (const std::exception &e) {
+    isFulfilled = false;
+    if (auto jsException = dynamic_cast<const JsException *>(&e)) {
+      promiseParam = JS_DupValue(ctx, jsException->getValue());
+    } else {
+      jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      promiseParam = JS_GetException(ctx);
     }
+  }
+
+  // A Promise can only be completed once: remove it from the global stash (the native record
+  // stays alive until promiseCapabilityValue is released)
+  JS_DeleteProperty(ctx, globalObj, idAtom, 0);
+  JS_FreeAtom(ctx, idAtom);
+  JS_FreeValue(ctx, globalObj);
+
+  JSValueConst resolveOrReject = isFulfilled ? promiseCapability->resolve : promiseCapability->reject;
+  JSValue ret = JS_Call(ctx, resolveOrReject, JS_UNDEFINED, 1, &promiseParam);
+  if (JS_IsException(ret)) {
+    alog("Could not complete Promise with id %s", strId.c_str());
+    JS_FreeValue(ctx, JS_GetException(ctx));
+  }
+
+  JS_FreeValue(ctx, ret);
+  JS_FreeValue(ctx, promiseParam);
+  JS_FreeValue(ctx, promiseCapabilityValue);
+}
+
+// static
+JSValue Deferred::getFulfilledValue(const JsBridgeContext *jsBridgeContext, JSValueConst v) {
+  JSContext *ctx = jsBridgeContext->getQuickJsContext();
 
-    JS_FreeValue(ctx, ret);
-    JS_FreeValue(ctx, promiseParam);
-  } else {
-    alog("Could not complete Promise with id %s: cannot find %s", strId.c_str(), resolveOrRejectStr);
+  // Rejected promises still go through then() so that they are marked as handled
+  if (JS_PromiseState(ctx, v) != JS_PROMISE_FULFILLED) {
+    return JS_UNINITIALIZED;
   }
 
-  JS_FreeValue(ctx, resolveOrReject);
-  JS_FreeValue(ctx, promiseObj);
+  return JS_PromiseResult(ctx, v);
 }
 
 }  // namespace JavaTypes
@@ -17,6 +17,7 @@
  * limitations under the License.
  */
 #include "Double.h"
+#include "JniCache.h"
 #include "JsBridgeContext.h"
 #include "log.h"
 #include "exceptions/JniException.h"
@@ -223,14 +224,12 @@ JValue Double::callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
 
 JValue Double::box(const JValue &doubleValue) const {
   // From double to Double
-  static thread_local jmethodID boxId = m_jniContext->getStaticMethodID(getBoxedJavaClass(), "valueOf", "(D)Ljava/lang/Double;");
-  return JValue(m_jniContext->callStaticObjectMethod(getBoxedJavaClass(), boxId, doubleValue.getDouble()));
+  return JValue(m_jniContext->callStaticObjectMethod(getBoxedJavaClass(), getJniCache()->getIds().doubleValueOf, doubleValue.getDouble()));
 }
 
 JValue Double::unbox(const JValue &boxedValue) const {
   // From Double to double
-  static thread_local jmethodID unboxId = m_jniContext->getMethodID(getBoxedJavaClass(), "doubleValue", "()D");
-  return JValue(m_jniContext->callDoubleMethod(boxedValue.getLocalRef(), unboxId));
+  return JValue(m_jniContext->callDoubleMethod(boxedValue.getLocalRef(), getJniCache()->getIds().doubleDoubleValue));
 }
 
 }  // namespace JavaTypes
@@ -18,6 +18,7 @@
  */
 #include "Float.h"
 
+#include "JniCache.h"
 #include "JsBridgeContext.h"
 #include "log.h"
 #include "exceptions/JniException.h"
@@ -220,14 +221,12 @@ JValue Float::callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
 
 JValue Float::box(const JValue &floatValue) const {
   // From float to Float
-  jmethodID boxId = m_jniContext->getStaticMethodID(getBoxedJavaClass(), "valueOf", "(F)Ljava/lang/Float;");
-  return JValue(m_jniContext->callStaticObjectMethod(getBoxedJavaClass(), boxId, floatValue.getFloat()));
+  return JValue(m_jniContext->callStaticObjectMethod(getBoxedJavaClass(), getJniCache()->getIds().floatValueOf, floatValue.getFloat()));
 }
 
 JValue Float::unbox(const JValue &boxedValue) const {
   // From Float to float
-  static thread_local jmethodID unboxId = m_jniContext->getMethodID(getBoxedJavaClass(), "floatValue", "()F");
-  return JValue(m_jniContext->callFloatMethod(boxedValue.getLocalRef(), unboxId));
+  return JValue(m_jniContext->callFloatMethod(boxedValue.getLocalRef(), getJniCache()->getIds().floatFloatValue));
 }
 
 }  // namespace JavaTypes
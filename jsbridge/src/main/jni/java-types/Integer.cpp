@@ -18,6 +18,7 @@
  */
 #include "Integer.h"
 
+#include "JniCache.h"
 #include "JsBridgeContext.h"
 #include "log.h"
 #include "exceptions/JniException.h"
@@ -222,14 +223,12 @@ JValue Integer::callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
 
 JValue Integer::box(const JValue &intValue) const {
   // From int to Integer
-  static thread_local jmethodID boxId = m_jniContext->getStaticMethodID(getBoxedJavaClass(), "valueOf", "(I)Ljava/lang/Integer;");
-  return JValue(m_jniContext->callStaticObjectMethod(getBoxedJavaClass(), boxId, intValue.getInt()));
+  return JValue(m_jniContext->callStaticObjectMethod(getBoxedJavaClass(), getJniCache()->getIds().integerValueOf, intValue.getInt()));
 }
 
 JValue Integer::unbox(const JValue &boxedValue) const {
   // From Integer to int
-  static thread_local jmethodID unboxId = m_jniContext->getMethodID(getBoxedJavaClass(), "intValue", "()I");
-  return JValue(m_jniContext->callIntMethod(boxedValue.getLocalRef(), unboxId));
+  return JValue(m_jniContext->callIntMethod(boxedValue.getLocalRef(), getJniCache()->getIds().integerIntValue));
 }
 
 }  // namespace JavaTypes
@@ -82,7 +82,7 @@ duk_ret_t JsValue::push(const JValue &value) const {
   }
 
   // Push the global JS value with that name
-  duk_get_global_string(m_ctx, jsValueName.toUtf8Chars());
+  duk_get_global_lstring(m_ctx, jsValueName.toUtf8Chars(), jsValueName.utf8Length());
   return 1;
 }
 
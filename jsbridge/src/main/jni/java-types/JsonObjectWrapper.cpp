@@ -20,12 +20,88 @@
 #include "JsBridgeContext.h"
 #include "custom_stringify.h"
 #include "log.h"
+#include "utf_transcode.h"
 #include "exceptions/JniException.h"
 #include "exceptions/JsException.h"
 #include "jni-helpers/JniContext.h"
+#include <string>
 
 namespace JavaTypes {
 
+namespace {
+  // Reusable transcoding buffers (JSON payloads can be large)
+  thread_local std::string utf8Buffer;
+  thread_local std::u16string utf16Buffer;
+
+  const size_t MAX_RETAINED_BUFFER_CAPACITY = 1024 * 1024;
+
+  template <class T>
+  void resetBuffer(T &buffer) {
+    if (buffer.capacity() > MAX_RETAINED_BUFFER_CAPACITY) {
+      T().swap(buffer);
+    } else {
+      buffer.clear();
+    }
+  }
+
+  // Reusable buffer for the JSON output of custom_stringify(). Stringifying might call back into
+  // JS (toJSON(), getters) and then re-enter here, in which case the nested call uses its own buffer.
+  thread_local std::string jsonBuffer;
+  thread_local bool isJsonBufferInUse = false;
+
+  class JsonBufferScope {
+  public:
+    JsonBufferScope()
+     : m_isOwner(!isJsonBufferInUse) {
+      isJsonBufferInUse = true;
+    }
+
+    ~JsonBufferScope() {
+      if (m_isOwner) {
+        resetBuffer(jsonBuffer);
+        isJsonBufferInUse = false;
+      }
+    }
+
+    std::string &get() { return m_isOwner ? jsonBuffer : m_nestedBuffer; }
+
+  private:
+    const bool m_isOwner;
+    std::string m_nestedBuffer;
+  };
+
+  // UTF-8 JSON string -> Java String (transcoded once into UTF-16 and passed to NewString())
+  JStringLocalRef newJavaJsonString(const JniContext *jniContext, const char *utf8, size_t length) {
+    utf16Buffer.clear();
+    utf8_to_utf16(utf8, length, utf16Buffer);
+    JStringLocalRef ret(jniContext, std::u16string_view(utf16Buffer));
+    resetBuffer(utf16Buffer);
+    return ret;
+  }
+
+  // Java String -> UTF-8 JSON string (in utf8Buffer), transcoded from a pinned view of the Java chars
+  const std::string &readJavaJsonString(const JniContext *jniContext, const JStringLocalRef &str, bool cesu8) {
+    utf8Buffer.clear();
+    if (str.isNull()) {
+      return utf8Buffer;
+    }
+
+    JNIEnv *env = jniContext->getJNIEnv();
+    const jsize length = env->GetStringLength(str.jstr());
+    utf8Buffer.resize(3 * static_cast<size_t>(length));  // worst case, allocated before the critical region
+    const jchar *chars = env->GetStringCritical(str.jstr(), nullptr);
+    if (chars == nullptr) {
+      utf8Buffer.clear();
+      return utf8Buffer;
+    }
+
+    // No JNI call (nor allocation) until ReleaseStringCritical()!
+    utf8Buffer.resize(utf16_to_utf8(reinterpret_cast<const char16_t *>(chars), static_cast<size_t>(length), cesu8, &utf8Buffer[0]));
+    env->ReleaseStringCritical(str.jstr(), chars);
+    return utf8Buffer;
+  }
+}
+
 JsonObjectWrapper::JsonObjectWrapper(const JsBridgeContext *jsBridgeContext, bool isNullable)
  : JavaType(jsBridgeContext, JavaTypeId::JsonObjectWrapper)
  , m_isNullable(isNullable) {
@@ -52,13 +128,14 @@ JValue JsonObjectWrapper::pop() const {
     return JValue();
   }
 
-  if (custom_stringify(m_ctx, -1, true /*keepErrorStack*/) != DUK_EXEC_SUCCESS) {
+  JsonBufferScope jsonBufferScope;
+  std::string &json = jsonBufferScope.get();
+  if (custom_stringify(m_ctx, -1, true /*keepErrorStack*/, json) != DUK_EXEC_SUCCESS) {
     duk_remove(m_ctx, -2);
     throw getExceptionHandler()->getCurrentJsException();
   }
 
-  JStringLocalRef str(m_jniContext, duk_require_string(m_ctx, -1));
-  duk_pop(m_ctx);
+  JStringLocalRef str = newJavaJsonString(m_jniContext, json.data(), json.length());
 
   JniLocalRef<jobject> localRef = getJniCache()->newJsonObjectWrapper(str);
 
@@ -80,27 +157,30 @@ duk_ret_t JsonObjectWrapper::push(const JValue &value) const {
   }
 
   JStringLocalRef strRef = getJniCache()->getJsonObjectWrapperString(jWrapper);
-  const char *str = strRef.toUtf8Chars();
 
   if (m_jniContext->exceptionCheck()) {
     throw JniException(m_jniContext);
   }
 
+  const std::string &str = readJavaJsonString(m_jniContext, strRef, true /*cesu8*/);
+
   // Undefined values are returned as an empty string
-  if (!str || strlen(str) == 0) {
+  if (str.empty()) {
     duk_push_undefined(m_ctx);
     return 1;
   }
 
-  duk_push_string(m_ctx, str);
+  duk_push_lstring(m_ctx, str.data(), str.length());
 
   if (duk_safe_call(m_ctx, tryJsonDecode, nullptr, 1, 1) != DUK_EXEC_SUCCESS) {
     CHECK_STACK_NOW();
     duk_pop(m_ctx);
     auto msg = std::string() + "Error while reading JsonObjectWrapper value (\"" + str + "\")";
+    resetBuffer(utf8Buffer);
     throw std::invalid_argument(msg);
   }
 
+  resetBuffer(utf8Buffer);
   return 1;
 }
 
@@ -111,15 +191,13 @@ JValue JsonObjectWrapper::toJava(JSValueConst v) const {
     return JValue();
   }
 
-  JSValue jsonValue = custom_stringify(m_ctx, v, true /*keepErrorStack*/);
-  if (JS_IsException(jsonValue)) {
+  JsonBufferScope jsonBufferScope;
+  std::string &json = jsonBufferScope.get();
+  if (custom_stringify(m_ctx, v, true /*keepErrorStack*/, json) < 0) {
     throw getExceptionHandler()->getCurrentJsException();
   }
 
-  const char *jsonCStr = JS_ToCString(m_ctx, jsonValue);
-  JStringLocalRef str(m_jniContext, jsonCStr);
-  JS_FreeCString(m_ctx, jsonCStr);
-  JS_FreeValue(m_ctx, jsonValue);
+  JStringLocalRef str = newJavaJsonString(m_jniContext, json.data(), json.length());
 
   JniLocalRef<jobject> localRef = getJniCache()->newJsonObjectWrapper(str);
   return JValue(localRef);
@@ -138,21 +216,25 @@ JSValue JsonObjectWrapper::fromJava(const JValue &value) const {
     throw JniException(m_jniContext);
   }
 
-  const char *str = strRef.toUtf8Chars();
+  const std::string &str = readJavaJsonString(m_jniContext, strRef, false /*cesu8*/);
+  strRef.release();
 
   // Undefined values are returned as an empty string
-  if (!str || strlen(str) == 0) {
+  if (str.empty()) {
     return JS_UNDEFINED;
   }
 
-  JSValue decodedValue = JS_ParseJSON(m_ctx, str, strlen(str), "JsonObjectWrapper.cpp");
+  // Note: std::string data is null-terminated as required by JS_ParseJSON()
+  JSValue decodedValue = JS_ParseJSON(m_ctx, str.c_str(), str.length(), "JsonObjectWrapper.cpp");
 
   if (JS_IsException(decodedValue)) {
-    JS_GetException(m_ctx);
-    throw std::invalid_argument(std::string("Error while reading JsonObjectWrapper value (\"") + str + "\")");
+    JS_FreeValue(m_ctx, JS_GetException(m_ctx));
+    auto msg = std::string("Error while reading JsonObjectWrapper value (\"") + str + "\")";
+    resetBuffer(utf8Buffer);
+    throw std::invalid_argument(msg);
   }
 
-  strRef.release();
+  resetBuffer(utf8Buffer);
   return decodedValue;
 }
 
@@ -0,0 +1,577 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "LazyList.h"
+
+#include "ExceptionHandler.h"
+#include "JniCache.h"
+#include "JsBridgeContext.h"
+#include "LocalFrameBatch.h"
+#include "exceptions/JniException.h"
+#include "exceptions/JsException.h"
+#include "jni-helpers/JniContext.h"
+#include "jni-helpers/JniGlobalRef.h"
+#include "jni-helpers/JValue.h"
+#include <cstring>
+#include <string>
+
+namespace {
+  struct LazyListData {
+    LazyListData(const JsBridgeContext *jsBridgeContext, JniGlobalRef<jobject> javaList, std::shared_ptr<const JavaType> componentType)
+     : jsBridgeContext(jsBridgeContext)
+     , javaList(std::move(javaList))
+     , componentType(std::move(componentType)) {
+    }
+
+    const JsBridgeContext *jsBridgeContext;
+    JniGlobalRef<jobject> javaList;  // LazyList instance
+    std::shared_ptr<const JavaType> componentType;
+    jsize size = -1;  // read on first access
+#if defined(QUICKJS)
+    std::vector<JSValue> elements;  // JS_UNINITIALIZED until converted
+#endif
+  };
+
+  jsize getSize(LazyListData *data) {
+    if (data->size < 0) {
+      const JniContext *jniContext = data->jsBridgeContext->getJniContext();
+      const jsize size = data->jsBridgeContext->getJniCache()->getListLength(data->javaList);
+      if (jniContext->exceptionCheck()) {
+        throw JniException(jniContext);
+      }
+      data->size = size;
+#if defined(QUICKJS)
+      data->elements.resize(static_cast<size_t>(size), JS_UNINITIALIZED);
+#endif
+    }
+    return data->size;
+  }
+
+  // Fetch the Java element and call f() with it, within a JNI local frame
+  template <typename F>
+  void withJavaElement(LazyListData *data, jsize index, F &&f) {
+    const JniContext *jniContext = data->jsBridgeContext->getJniContext();
+
+    forEachInLocalFrames(jniContext, 1, 2, [data, jniContext, index, &f](jsize) {
+      JniLocalRef<jobject> javaElement = data->jsBridgeContext->getJniCache()->getListElement(data->javaList, index);
+      if (jniContext->exceptionCheck()) {
+        throw JniException(jniContext);
+      }
+      f(JValue(javaElement));
+    });
+  }
+}
+
+#if defined(DUKTAPE)
+
+#include "StackChecker.h"
+#include <cmath>
+
+namespace {
+  const char *DATA_PROP_NAME = "\xff\xff" "lazy_list_data";
+  const char *HANDLER_PROP_NAME = "\xff\xff" "lazy_list_handler";
+
+  // Proxy traps: the target (arg 0) is an array holding the hidden data pointer and caching the
+  // converted elements. Hidden keys bypass the traps and are directly applied to the target.
+
+  LazyListData *getData(duk_context *ctx) {
+    duk_get_prop_string(ctx, 0, DATA_PROP_NAME);
+    auto data = reinterpret_cast<LazyListData *>(duk_require_pointer(ctx, -1));
+    duk_pop(ctx);
+    return data;
+  }
+
+  bool getArrayIndex(duk_context *ctx, duk_idx_t keyIdx, duk_uarridx_t *index) {
+    if (duk_is_number(ctx, keyIdx)) {
+      const double d = duk_get_number(ctx, keyIdx);
+      if (d >= 0 && d < 4294967295.0 && std::floor(d) == d) {
+        *index = static_cast<duk_uarridx_t>(d);
+        return true;
+      }
+      return false;
+    }
+
+    duk_size_t length;
+    const char *key = duk_get_lstring(ctx, keyIdx, &length);
+    if (key == nullptr || length == 0 || length > 10 || (key[0] == '0' && length > 1)) {
+      return false;
+    }
+
+    uint64_t value = 0;
+    for (duk_size_t i = 0; i < length; ++i) {
+      if (key[i] < '0' || key[i] > '9') {
+        return false;
+      }
+      value = value * 10 + (key[i] - '0');
+    }
+
+    if (value >= 4294967295ULL) {
+      return false;
+    }
+    *index = static_cast<duk_uarridx_t>(value);
+    return true;
+  }
+
+  bool isLengthKey(duk_context *ctx, duk_idx_t keyIdx) {
+    return duk_is_string(ctx, keyIdx) && strcmp(duk_get_string(ctx, keyIdx), "length") == 0;
+  }
+
+  // Push the element (converted on first access and then cached in the target)
+  void pushElement(duk_context *ctx, LazyListData *data, duk_uarridx_t index) {
+    if (duk_has_prop_index(ctx, 0, index)) {
+      duk_get_prop_index(ctx, 0, index);
+      return;
+    }
+
+    withJavaElement(data, static_cast<jsize>(index), [data](const JValue &javaElement) {
+      data->componentType->push(javaElement);
+    });
+    duk_dup(ctx, -1);
+    duk_put_prop_index(ctx, 0, index);
+  }
+
+  duk_ret_t lazyListGet(duk_context *ctx) {
+    LazyListData *data = getData(ctx);
+
+    try {
+      duk_uarridx_t index;
+      if (getArrayIndex(ctx, 1, &index)) {
+        if (static_cast<jsize>(index) >= getSize(data) || index > INT32_MAX) {
+          duk_push_undefined(ctx);
+        } else {
+          pushElement(ctx, data, index);
+        }
+        return 1;
+      }
+
+      if (isLengthKey(ctx, 1)) {
+        duk_push_uint(ctx, static_cast<duk_uint_t>(getSize(data)));
+        return 1;
+      }
+    } catch (const std::exception &e) {
+      data->jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return DUK_RET_ERROR;  // unreached
+    }
+
+    // Other keys (e.g. Array.prototype methods) are read from the target
+    duk_dup(ctx, 1);
+    duk_get_prop(ctx, 0);
+    return 1;
+  }
+
+  duk_ret_t lazyListHas(duk_context *ctx) {
+    LazyListData *data = getData(ctx);
+
+    try {
+      duk_uarridx_t index;
+      if (getArrayIndex(ctx, 1, &index)) {
+        duk_push_boolean(ctx, index <= INT32_MAX && static_cast<jsize>(index) < getSize(data));
+        return 1;
+      }
+    } catch (const std::exception &e) {
+      data->jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return DUK_RET_ERROR;  // unreached
+    }
+
+    duk_dup(ctx, 1);
+    duk_push_boolean(ctx, duk_has_prop(ctx, 0));
+    return 1;
+  }
+
+  duk_ret_t lazyListSet(duk_context *ctx) {
+    return duk_error(ctx, DUK_ERR_TYPE_ERROR, "LazyList is read-only");
+  }
+
+  duk_ret_t lazyListDeleteProperty(duk_context *ctx) {
+    LazyListData *data = getData(ctx);
+
+    try {
+      duk_uarridx_t index;
+      const bool isElement = getArrayIndex(ctx, 1, &index) && index <= INT32_MAX && static_cast<jsize>(index) < getSize(data);
+      duk_push_boolean(ctx, !isElement && !isLengthKey(ctx, 1));
+    } catch (const std::exception &e) {
+      data->jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return DUK_RET_ERROR;  // unreached
+    }
+
+    return 1;
+  }
+
+  // Duktape checks the enumerability of the keys on the target so all the elements are converted
+  duk_ret_t lazyListOwnKeys(duk_context *ctx) {
+    LazyListData *data = getData(ctx);
+
+    try {
+      const jsize size = getSize(data);
+      duk_push_array(ctx);
+      for (jsize i = 0; i < size; ++i) {
+        pushElement(ctx, data, static_cast<duk_uarridx_t>(i));
+        duk_pop(ctx);
+        duk_push_string(ctx, std::to_string(i).c_str());
+        duk_put_prop_index(ctx, -2, static_cast<duk_uarridx_t>(i));
+      }
+      duk_push_string(ctx, "length");
+      duk_put_prop_index(ctx, -2, static_cast<duk_uarridx_t>(size));
+    } catch (const std::exception &e) {
+      data->jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return DUK_RET_ERROR;  // unreached
+    }
+
+    return 1;
+  }
+
+  duk_ret_t finalizeLazyList(duk_context *ctx) {
+    CHECK_STACK(ctx);
+
+    if (duk_get_prop_string(ctx, -1, DATA_PROP_NAME)) {
+      delete reinterpret_cast<LazyListData *>(duk_require_pointer(ctx, -1));
+    }
+
+    duk_pop(ctx);  // LazyListData
+    return 0;
+  }
+
+  // The proxy handler is shared by all the lazy lists (and stored in the global stash)
+  void pushProxyHandler(duk_context *ctx) {
+    CHECK_STACK_OFFSET(ctx, 1);
+
+    duk_push_global_stash(ctx);
+
+    if (!duk_get_prop_string(ctx, -1, HANDLER_PROP_NAME)) {
+      duk_pop(ctx);  // undefined
+
+      const duk_function_list_entry traps[] = {
+          { "get", lazyListGet, 3 },
+          { "has", lazyListHas, 2 },
+          { "set", lazyListSet, 4 },
+          { "deleteProperty", lazyListDeleteProperty, 2 },
+          { "ownKeys", lazyListOwnKeys, 1 },
+          { nullptr, nullptr, 0 }
+      };
+
+      duk_push_object(ctx);
+      duk_put_function_list(ctx, -1, traps);
+      duk_dup(ctx, -1);
+      duk_put_prop_string(ctx, -3, HANDLER_PROP_NAME);
+    }
+
+    duk_remove(ctx, -2);  // global stash
+  }
+}
+
+#elif defined(QUICKJS)
+
+#include <cassert>
+
+namespace {
+  JSClassID lazyListClassId = 0;
+
+  LazyListData *getData(JSValueConst obj) {
+    return reinterpret_cast<LazyListData *>(JS_GetOpaque(obj, lazyListClassId));
+  }
+
+  bool isLengthAtom(JSContext *ctx, JSAtom atom) {
+    JSAtom lengthAtom = JS_NewAtom(ctx, "length");  // predefined atom
+    const bool ret = atom == lengthAtom;
+    JS_FreeAtom(ctx, lengthAtom);
+    return ret;
+  }
+
+  // Get the element (converted on first access and then cached)
+  JSValueConst getElement(LazyListData *data, uint32_t index) {
+    JSValue &element = data->elements[index];
+
+    if (JS_IsUninitialized(element)) {
+      JSValue convertedElement = JS_UNINITIALIZED;
+      withJavaElement(data, static_cast<jsize>(index), [data, &convertedElement](const JValue &javaElement) {
+        convertedElement = data->componentType->fromJava(javaElement);
+      });
+
+      // Failed conversions are not cached (the element is converted again on next access)
+      if (JS_IsException(convertedElement)) {
+        throw data->jsBridgeContext->getExceptionHandler()->getCurrentJsException();
+      }
+      element = convertedElement;
+    }
+
+    return element;
+  }
+
+  int lazyListGetOwnProperty(JSContext *ctx, JSPropertyDescriptor *desc, JSValueConst obj, JSAtom prop) {
+    LazyListData *data = getData(obj);
+    assert(data != nullptr);
+
+    try {
+      uint32_t index;
+      if (JS_AtomGetArrayIndex(ctx, &index, prop)) {
+        if (index > INT32_MAX || static_cast<jsize>(index) >= getSize(data)) {
+          return false;
+        }
+
+        // No conversion when only checking the existence of the element (desc == nullptr)
+        if (desc != nullptr) {
+          desc->flags = JS_PROP_ENUMERABLE;
+          desc->value = JS_DupValue(ctx, getElement(data, index));
+          desc->getter = JS_UNDEFINED;
+          desc->setter = JS_UNDEFINED;
+        }
+        return true;
+      }
+
+      if (isLengthAtom(ctx, prop)) {
+        if (desc != nullptr) {
+          desc->flags = 0;
+          desc->value = JS_NewInt32(ctx, getSize(data));
+          desc->getter = JS_UNDEFINED;
+          desc->setter = JS_UNDEFINED;
+        }
+        return true;
+      }
+    } catch (const std::exception &e) {
+      data->jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return -1;
+    }
+
+    return false;
+  }
+
+  int lazyListGetOwnPropertyNames(JSContext *ctx, JSPropertyEnum **ptab, uint32_t *plen, JSValueConst obj) {
+    LazyListData *data = getData(obj);
+    assert(data != nullptr);
+
+    jsize size;
+    try {
+      size = getSize(data);
+    } catch (const std::exception &e) {
+      data->jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return -1;
+    }
+
+    auto tab = reinterpret_cast<JSPropertyEnum *>(js_malloc(ctx, sizeof(JSPropertyEnum) * (size + 1)));
+    if (tab == nullptr) {
+      return -1;
+    }
+
+    for (jsize i = 0; i < size; ++i) {
+      tab[i].is_enumerable = true;
+      tab[i].atom = JS_NewAtomUInt32(ctx, static_cast<uint32_t>(i));
+    }
+    tab[size].is_enumerable = false;
+    tab[size].atom = JS_NewAtom(ctx, "length");
+
+    *ptab = tab;
+    *plen = static_cast<uint32_t>(size + 1);
+    return 0;
+  }
+
+  int lazyListDeleteProperty(JSContext *ctx, JSValueConst obj, JSAtom prop) {
+    // Only non-existing properties can be deleted
+    const int ret = lazyListGetOwnProperty(ctx, nullptr, obj, prop);
+    return ret < 0 ? -1 : !ret;
+  }
+
+  int lazyListDefineOwnProperty(JSContext *ctx, JSValueConst, JSAtom, JSValueConst, JSValueConst, JSValueConst, int) {
+    JS_ThrowTypeError(ctx, "LazyList is read-only");
+    return -1;
+  }
+
+  void lazyListFinalizer(JSRuntime *rt, JSValue val) {
+    LazyListData *data = getData(val);
+    for (JSValue &element : data->elements) {
+      JS_FreeValueRT(rt, element);
+    }
+    delete data;
+  }
+
+  void lazyListGcMark(JSRuntime *rt, JSValueConst val, JS_MarkFunc *markFunc) {
+    LazyListData *data = getData(val);
+    for (JSValue &element : data->elements) {
+      JS_MarkValue(rt, element, markFunc);
+    }
+  }
+
+  JSClassExoticMethods lazyListExoticMethods = {
+      .get_own_property = lazyListGetOwnProperty,
+      .get_own_property_names = lazyListGetOwnPropertyNames,
+      .delete_property = lazyListDeleteProperty,
+      .define_own_property = lazyListDefineOwnProperty,
+      .has_property = nullptr,
+      .get_property = nullptr,
+      .set_property = nullptr,
+  };
+
+  JSClassDef lazyListClass = {
+      "LazyList",
+      .finalizer = lazyListFinalizer,
+      .gc_mark = lazyListGcMark,
+      .call = nullptr,
+      .exotic = &lazyListExoticMethods,
+  };
+}
+
+#endif
+
+namespace JavaTypes {
+
+LazyList::LazyList(const JsBridgeContext *jsBridgeContext, std::shared_ptr<const JavaType> componentType,
+                   const JniLocalRef<jsBridgeParameter> &componentParameter)
+ : JavaType(jsBridgeContext, JavaTypeId::LazyList)
+ , m_componentType(std::move(componentType))
+ , m_componentParameter(componentParameter)
+ , m_jsArrayType(jsBridgeContext, false /*isNullable*/) {
+
+#if defined(QUICKJS)
+  // class ID (created once)
+  JS_NewClassID(&lazyListClassId);
+
+  // class (created once per runtime) inheriting from Array.prototype
+  JSRuntime *rt = JS_GetRuntime(m_ctx);
+  if (!JS_IsRegisteredClass(rt, lazyListClassId)) {
+    JS_NewClass(rt, lazyListClassId, &lazyListClass);
+
+    JSValue globalObj = JS_GetGlobalObject(m_ctx);
+    JSValue arrayCtor = JS_GetPropertyStr(m_ctx, globalObj, "Array");
+    JS_SetClassProto(m_ctx, lazyListClassId, JS_GetPropertyStr(m_ctx, arrayCtor, "prototype"));
+    JS_FreeValue(m_ctx, arrayCtor);
+    JS_FreeValue(m_ctx, globalObj);
+  }
+#endif
+}
+
+#if defined(DUKTAPE)
+
+JValue LazyList::pop() const {
+  CHECK_STACK_OFFSET(m_ctx, -1);
+
+  if (duk_is_object(m_ctx, -1)) {
+    duk_get_prop_string(m_ctx, -1, DATA_PROP_NAME);  // hidden key: read from the proxy target
+    auto data = reinterpret_cast<LazyListData *>(duk_get_pointer(m_ctx, -1));
+    duk_pop(m_ctx);  // (undefined) LazyListData
+
+    if (data != nullptr) {
+      duk_pop(m_ctx);
+      return JValue(JniLocalRef<jobject>(data->javaList));
+    }
+  }
+
+  if (duk_is_null_or_undefined(m_ctx, -1)) {
+    duk_pop(m_ctx);
+    return JValue();
+  }
+
+  if (!duk_is_array(m_ctx, -1)) {
+    const auto message = std::string("Cannot convert ") + duk_safe_to_string(m_ctx, -1) + " to list";
+    duk_pop(m_ctx);
+    throw std::invalid_argument(message);
+  }
+
+  const auto length = static_cast<jint>(duk_get_length(m_ctx, -1));
+  JValue jsArray = m_jsArrayType.pop();
+  return JValue(newJsArrayLazyList(jsArray.getLocalRef(), length));
+}
+
+duk_ret_t LazyList::push(const JValue &value) const {
+  CHECK_STACK_OFFSET(m_ctx, 1);
+
+  const JniLocalRef<jobject> &jLazyList = value.getLocalRef();
+
+  if (jLazyList.isNull()) {
+    duk_push_null(m_ctx);
+    return 1;
+  }
+
+  // A JS array wrapped by a JsArrayList is given back as is
+  JniLocalRef<jobject> jsArray = getJniCache()->getLazyListJsArray(jLazyList);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+  if (!jsArray.isNull()) {
+    return m_jsArrayType.push(JValue(jsArray));
+  }
+
+  // Proxy target
+  duk_push_array(m_ctx);
+  duk_push_pointer(m_ctx, new LazyListData(m_jsBridgeContext, JniGlobalRef<jobject>(jLazyList), m_componentType));
+  duk_put_prop_string(m_ctx, -2, DATA_PROP_NAME);
+  duk_push_c_function(m_ctx, finalizeLazyList, 1);
+  duk_set_finalizer(m_ctx, -2);
+
+  pushProxyHandler(m_ctx);
+  duk_push_proxy(m_ctx, 0);
+  return 1;
+}
+
+#elif defined(QUICKJS)
+
+JValue LazyList::toJava(JSValueConst v) const {
+  LazyListData *data = getData(v);
+  if (data != nullptr) {
+    return JValue(JniLocalRef<jobject>(data->javaList));
+  }
+
+  if (JS_IsNull(v) || JS_IsUndefined(v)) {
+    return JValue();
+  }
+
+  if (!JS_IsArray(m_ctx, v)) {
+    throw std::invalid_argument("Cannot convert value to list");
+  }
+
+  JSValue lengthValue = JS_GetPropertyStr(m_ctx, v, "length");
+  int32_t length = 0;
+  JS_ToInt32(m_ctx, &length, lengthValue);
+  JS_FreeValue(m_ctx, lengthValue);
+
+  JValue jsArray = m_jsArrayType.toJava(v);
+  return JValue(newJsArrayLazyList(jsArray.getLocalRef(), length));
+}
+
+JSValue LazyList::fromJava(const JValue &value) const {
+  const JniLocalRef<jobject> &jLazyList = value.getLocalRef();
+
+  if (jLazyList.isNull()) {
+    return JS_NULL;
+  }
+
+  // A JS array wrapped by a JsArrayList is given back as is
+  JniLocalRef<jobject> jsArray = getJniCache()->getLazyListJsArray(jLazyList);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+  if (!jsArray.isNull()) {
+    return m_jsArrayType.fromJava(JValue(jsArray));
+  }
+
+  JSValue lazyListObj = JS_NewObjectClass(m_ctx, lazyListClassId);
+  if (JS_IsException(lazyListObj)) {
+    throw getExceptionHandler()->getCurrentJsException();
+  }
+
+  JS_SetOpaque(lazyListObj, new LazyListData(m_jsBridgeContext, JniGlobalRef<jobject>(jLazyList), m_componentType));
+  return lazyListObj;
+}
+
+#endif
+
+JniLocalRef<jobject> LazyList::newJsArrayLazyList(const JniLocalRef<jobject> &jsArray, jint length) const {
+  JniLocalRef<jobject> jsArrayList = getJniCache()->newJsArrayList(jsArray, m_componentParameter, length);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+
+  return getJniCache()->newLazyList(jsArrayList);
+}
+
+}  // namespace JavaTypes
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JAVATYPES_LAZYLIST_H
+#define _JSBRIDGE_JAVATYPES_LAZYLIST_H
+
+#include "JavaType.h"
+#include "JsValue.h"
+#include "jni-helpers/JniGlobalRef.h"
+#include <memory>
+
+namespace JavaTypes {
+
+// de.prosiebensat1digital.oasisjsbridge.LazyList
+// - Java -> JS: read-only array-like view of the Java list (inheriting from Array.prototype) whose
+//   elements are fetched and converted on first access, and then cached. The list size is read
+//   on first access, too.
+//   QuickJS: exotic object, Duktape: proxy object (with an array target caching the elements)
+// - JS -> Java: the original LazyList instance for a view, a LazyList wrapping a JsArrayList
+//   otherwise. The JS array is held by a JsValue and its elements are converted to Java on first
+//   access (and then cached).
+//   Such a LazyList is given back to JS as the original JS array.
+class LazyList : public JavaType {
+
+public:
+  LazyList(const JsBridgeContext *, std::shared_ptr<const JavaType> componentType,
+           const JniLocalRef<jsBridgeParameter> &componentParameter);
+
+#if defined(DUKTAPE)
+  JValue pop() const override;
+  duk_ret_t push(const JValue &) const override;
+#elif defined(QUICKJS)
+  JValue toJava(JSValueConst) const override;
+  JSValue fromJava(const JValue &) const override;
+#endif
+
+private:
+  // LazyList wrapping a new JsArrayList of the given JsValue (holding a JS array)
+  JniLocalRef<jobject> newJsArrayLazyList(const JniLocalRef<jobject> &jsArray, jint length) const;
+
+  const std::shared_ptr<const JavaType> m_componentType;
+  const JniGlobalRef<jsBridgeParameter> m_componentParameter;
+  const JsValue m_jsArrayType;
+};
+
+}  // namespace JavaTypes
+
+#endif
@@ -21,6 +21,7 @@
 #include "AutoReleasedJSValue.h"
 #include "JniCache.h"
 #include "JsBridgeContext.h"
+#include "LocalFrameBatch.h"
 #include "Primitive.h"
 #include "exceptions/JniException.h"
 #include "jni-helpers/JValue.h"
@@ -61,28 +62,25 @@ JValue List::pop() const {
     throw std::invalid_argument(message);
   }
 
-  uint32_t count = duk_get_length(m_ctx, -1);
+  const auto count = static_cast<jsize>(duk_get_length(m_ctx, -1));
 
   JniLocalRef<jobject> javaList = m_jsBridgeContext->getJniCache()->newList();
 
-  for (int i = 0; i < count; ++i) {
-    duk_get_prop_index(m_ctx, -1, static_cast<duk_uarridx_t>(i));
-
-    JValue elementValue;
-
-    try {
-      elementValue = m_componentType->pop();
-    } catch (const std::exception &) {
-      duk_pop(m_ctx);  // pop array
-      throw;
-    }
-    const JniLocalRef<jobject> &jElement = elementValue.getLocalRef();
-    m_jsBridgeContext->getJniCache()->addToList(javaList, jElement);
-
-    if (m_jniContext->exceptionCheck()) {
-      duk_pop(m_ctx);  // pop array
-      throw JniException(m_jniContext);
-    }
+  try {
+    forEachInLocalFrames(m_jniContext, count, 2, [this, &javaList](jsize i) {
+      duk_get_prop_index(m_ctx, -1, static_cast<duk_uarridx_t>(i));
+
+      JValue elementValue = m_componentType->pop();
+      m_jsBridgeContext->getJniCache()->addToList(javaList, elementValue.getLocalRef());
+      elementValue.detachLocalRef();  // released with the local frame
+
+      if (m_jniContext->exceptionCheck()) {
+        throw JniException(m_jniContext);
+      }
+    });
+  } catch (const std::exception &) {
+    duk_pop(m_ctx);  // pop array
+    throw;
   }
 
   duk_pop(m_ctx);  // pop array
@@ -102,16 +100,17 @@ duk_ret_t List::push(const JValue &value) const {
   duk_push_array(m_ctx);
 
   const int count = m_jsBridgeContext->getJniCache()->getListLength(jList);
-  for (int i = 0; i < count; ++i) {
-    JniLocalRef<jobject> jElement = m_jsBridgeContext->getJniCache()->getListElement(jList, i);
 
-    try {
+  try {
+    forEachInLocalFrames(m_jniContext, count, 2, [this, &jList](jsize i) {
+      JniLocalRef<jobject> jElement = m_jsBridgeContext->getJniCache()->getListElement(jList, i);
       m_componentType->push(JValue(jElement));
       duk_put_prop_index(m_ctx, -2, static_cast<duk_uarridx_t>(i));
-    } catch (const std::exception &) {
-      duk_pop(m_ctx);  // pop array
-      throw;
-    }
+      jElement.detach();  // released with the local frame
+    });
+  } catch (const std::exception &) {
+    duk_pop(m_ctx);  // pop array
+    throw;
   }
 
   return 1;
@@ -135,18 +134,18 @@ JValue List::toJava(JSValueConst v) const {
 
   JniLocalRef<jobject> javaList = m_jsBridgeContext->getJniCache()->newList();
 
-  for (int i = 0; i < count; ++i) {
-    JSValue elementJsValue = JS_GetPropertyUint32(m_ctx, v, i);
+  forEachInLocalFrames(m_jniContext, static_cast<jsize>(count), 2, [this, v, &javaList](jsize i) {
+    JSValue elementJsValue = JS_GetPropertyUint32(m_ctx, v, static_cast<uint32_t>(i));
     JS_AUTORELEASE_VALUE(m_ctx, elementJsValue);  // also released in case of exception!
     JValue elementValue = m_componentType->toJava(elementJsValue);
 
-    const JniLocalRef<jobject> &jElement = elementValue.getLocalRef();
-    m_jsBridgeContext->getJniCache()->addToList(javaList, jElement);
+    m_jsBridgeContext->getJniCache()->addToList(javaList, elementValue.getLocalRef());
+    elementValue.detachLocalRef();  // released with the local frame
 
     if (m_jniContext->exceptionCheck()) {
       throw JniException(m_jniContext);
     }
-  }
+  });
 
   return JValue(javaList);
 }
@@ -161,16 +160,17 @@ JSValue List::fromJava(const JValue &value) const {
   JSValue jsArray = JS_NewArray(m_ctx);
 
   const int count = m_jsBridgeContext->getJniCache()->getListLength(jList);
-  for (int i = 0; i < count; ++i) {
-    JniLocalRef<jobject> jElement = m_jsBridgeContext->getJniCache()->getListElement(jList, i);
 
-    try {
+  try {
+    forEachInLocalFrames(m_jniContext, count, 2, [this, &jList, jsArray](jsize i) {
+      JniLocalRef<jobject> jElement = m_jsBridgeContext->getJniCache()->getListElement(jList, i);
       JSValue jsElement = m_componentType->fromJava(JValue(jElement));
       JS_SetPropertyUint32(m_ctx, jsArray, static_cast<uint32_t>(i), jsElement);
-    } catch (const std::exception &) {
-      JS_FreeValue(m_ctx, jsArray);
-      throw;
-    }
+      jElement.detach();  // released with the local frame
+    });
+  } catch (const std::exception &) {
+    JS_FreeValue(m_ctx, jsArray);
+    throw;
   }
 
   return jsArray;
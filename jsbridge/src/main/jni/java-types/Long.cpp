@@ -18,6 +18,7 @@
  */
 #include "Long.h"
 
+#include "JniCache.h"
 #include "JsBridgeContext.h"
 #include "exceptions/JniException.h"
 #include "jni-helpers/JArrayLocalRef.h"
@@ -228,14 +229,12 @@ JValue Long::callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
 
 JValue Long::box(const JValue &longValue) const {
   // From long to Long
-  static thread_local jmethodID boxId = m_jniContext->getStaticMethodID(getBoxedJavaClass(), "valueOf", "(J)Ljava/lang/Long;");
-  return JValue(m_jniContext->callStaticObjectMethod(getBoxedJavaClass(), boxId, longValue.getLong()));
+  return JValue(m_jniContext->callStaticObjectMethod(getBoxedJavaClass(), getJniCache()->getIds().longValueOf, longValue.getLong()));
 }
 
 JValue Long::unbox(const JValue &boxedValue) const {
   // From Long to long
-  static thread_local jmethodID unboxId = m_jniContext->getMethodID(getBoxedJavaClass(), "longValue", "()J");
-  return JValue(m_jniContext->callLongMethod(boxedValue.getLocalRef(), unboxId));
+  return JValue(m_jniContext->callLongMethod(boxedValue.getLocalRef(), getJniCache()->getIds().longLongValue));
 }
 
 }  // namespace JavaTypes
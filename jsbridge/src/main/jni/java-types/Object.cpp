@@ -32,6 +32,7 @@
 #include "JsonObjectWrapper.h"
 #include "JsBridgeContext.h"
 #include "Long.h"
+#include "Payload.h"
 #include "String.h"
 #include "JniCache.h"
 
@@ -197,23 +198,17 @@ JStringLocalRef Object::getJavaName(const JniLocalRef<jobject> &object) const {
     return JStringLocalRef(m_optJavaName.value());
   }
 
+  const JniIds &ids = getJniCache()->getIds();
+
   // Get the class of the passed Java object
-  jmethodID getClass = m_jniContext->getMethodID(m_jsBridgeContext->getJniCache()->getObjectClass(), "getClass", "()Ljava/lang/Class;");
-  JniLocalRef<jclass> javaClassRef = m_jniContext->callObjectMethod<jclass>(object, getClass);
-  JniLocalRef<jclass> javaClassClass = m_jsBridgeContext->getJniCache()->getJavaClassClass();
+  JniLocalRef<jclass> javaClassRef = m_jniContext->callObjectMethod<jclass>(object, ids.objectGetClass);
 
   if (m_jniContext->exceptionCheck()) {
     throw JniException(m_jniContext);
   }
 
   // Call java.lang.Class::getName()
-  jmethodID getName = m_jniContext->getMethodID(javaClassClass, "getName", "()Ljava/lang/String;");
-
-  if (m_jniContext->exceptionCheck()) {
-    throw JniException(m_jniContext);
-  }
-
-  JStringLocalRef javaNameRef = m_jniContext->callStringMethod(javaClassRef, getName);
+  JStringLocalRef javaNameRef = m_jniContext->callStringMethod(javaClassRef, ids.classGetName);
   if (m_jniContext->exceptionCheck()) {
     throw JniException(m_jniContext);
   }
@@ -262,10 +257,12 @@ JavaType *Object::newJavaType(const JniLocalRef<jobject> &object) const {
       // ObjectArray -> Array of Object
 
       // Get the class of the passed Java object
-      jmethodID getClass = m_jniContext->getMethodID(m_jsBridgeContext->getJniCache()->getObjectClass(), "getClass", "()Ljava/lang/Class;");
-      JniLocalRef<jclass> javaClassRef = m_jniContext->callObjectMethod<jclass>(object, getClass);
+      JniLocalRef<jclass> javaClassRef = m_jniContext->callObjectMethod<jclass>(object, getJniCache()->getIds().objectGetClass);
       return new Array(m_jsBridgeContext, javaClassRef);
     }
+    case JavaTypeId::PayloadObject:
+    case JavaTypeId::PayloadArray:
+      return new Payload(m_jsBridgeContext, id);
     case JavaTypeId::Unknown:
     default:
       return nullptr;
@@ -0,0 +1,971 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Payload.h"
+
+#include "ExceptionHandler.h"
+#include "JniCache.h"
+#include "JsBridgeContext.h"
+#include "log.h"
+#include "utf_transcode.h"
+#include "exceptions/JniException.h"
+#include "exceptions/JsException.h"
+#include "jni-helpers/JniContext.h"
+#include "jni-helpers/JniLocalFrame.h"
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace JavaTypes {
+
+namespace {
+  // Same nesting limit as for JSON strings (see custom_stringify.cpp)
+  const int MAX_DEPTH = 1000;
+
+  // Local refs needed per nesting level (the refs of each item are explicitly deleted)
+  const jint LOCAL_FRAME_CAPACITY = 16;
+
+  // Java side of the conversion.
+  //
+  // For performance reasons, it works with raw JNI local refs: they are owned by the JniLocalFrame
+  // of the current nesting level and the refs of each item are deleted as soon as they have been
+  // stored into their parent.
+  class JavaPayloadHelper {
+  public:
+    enum class ValueKind {
+      String,
+      Number,
+      Boolean,
+      PayloadObject,
+      PayloadArray,
+      ObjectArray,
+      Unsupported,
+    };
+
+    explicit JavaPayloadHelper(const JsBridgeContext *jsBridgeContext)
+     : m_jniContext(jsBridgeContext->getJniContext())
+     , m_env(m_jniContext->getJNIEnv())
+     , m_ids(jsBridgeContext->getJniCache()->getIds())
+     , m_stringClass(jsBridgeContext->getJniCache()->getStringClass().get())
+     , m_numberClass(jsBridgeContext->getJniCache()->getNumberClass().get())
+     , m_hashMapClass(jsBridgeContext->getJniCache()->getHashMapClass().get())
+     , m_booleanClass(jsBridgeContext->getJniCache()->getJavaClass(JavaTypeId::BoxedBoolean).get())
+     , m_integerClass(jsBridgeContext->getJniCache()->getJavaClass(JavaTypeId::BoxedInt).get())
+     , m_longClass(jsBridgeContext->getJniCache()->getJavaClass(JavaTypeId::BoxedLong).get())
+     , m_doubleClass(jsBridgeContext->getJniCache()->getJavaClass(JavaTypeId::BoxedDouble).get())
+     , m_payloadObjectClass(jsBridgeContext->getJniCache()->getJavaClass(JavaTypeId::PayloadObject).get())
+     , m_payloadArrayClass(jsBridgeContext->getJniCache()->getJavaClass(JavaTypeId::PayloadArray).get())
+     , m_objectArrayClass(jsBridgeContext->getJniCache()->getJavaClass(JavaTypeId::ObjectArray).get()) {
+    }
+
+    const JniContext *getJniContext() const { return m_jniContext; }
+
+    void deleteLocalRef(jobject o) const {
+      if (o != nullptr) {
+        m_env->DeleteLocalRef(o);
+      }
+    }
+
+    void checkException() const {
+      if (m_env->ExceptionCheck()) {
+        throw JniException(m_jniContext);
+      }
+    }
+
+    // JS -> Java
+    // ---
+
+    jobject newBoolean(bool b) const {
+      jobject ret = m_env->CallStaticObjectMethod(m_booleanClass, m_ids.booleanValueOf, static_cast<jboolean>(b));
+      checkException();
+      return ret;
+    }
+
+    jobject newInteger(int32_t i) const {
+      jobject ret = m_env->CallStaticObjectMethod(m_integerClass, m_ids.integerValueOf, static_cast<jint>(i));
+      checkException();
+      return ret;
+    }
+
+    // Same Java number types as parsed by org.json from the output of JSON.stringify() (Integer for
+    // 32-bit integers, Long for 64-bit integers written without exponent, Double otherwise)
+    jobject newNumber(double d) const {
+      if (!std::isfinite(d)) {
+        return nullptr;  // JSON.stringify() gives null
+      }
+
+      const bool isInteger = std::trunc(d) == d;
+      if (isInteger && d >= INT32_MIN && d <= INT32_MAX) {
+        return newInteger(static_cast<int32_t>(d));
+      }
+
+      jobject ret;
+      if (isInteger && d >= -9223372036854775808.0 && d < 9223372036854775808.0) {
+        ret = m_env->CallStaticObjectMethod(m_longClass, m_ids.longValueOf, static_cast<jlong>(d));
+      } else {
+        ret = m_env->CallStaticObjectMethod(m_doubleClass, m_ids.doubleValueOf, static_cast<jdouble>(d));
+      }
+      checkException();
+      return ret;
+    }
+
+    // From an UTF-8 (or CESU-8) string
+    jobject newString(const char *s, size_t length) {
+      m_utf16Buffer.clear();
+      utf8_to_utf16(s, length, m_utf16Buffer);
+      jobject ret = m_env->NewString(reinterpret_cast<const jchar *>(m_utf16Buffer.data()), static_cast<jsize>(m_utf16Buffer.length()));
+      checkException();
+      return ret;
+    }
+
+    jobject newHashMap(size_t count) const {
+      // Initial capacity for the default load factor (0.75)
+      const auto capacity = static_cast<jint>(count + count / 3 + 1);
+      jobject ret = m_env->NewObject(m_hashMapClass, m_ids.hashMapInit, capacity);
+      checkException();
+      return ret;
+    }
+
+    void putToHashMap(jobject map, jobject key, jobject value) const {
+      jobject previousValue = m_env->CallObjectMethod(map, m_ids.hashMapPut, key, value);
+      checkException();
+      deleteLocalRef(previousValue);
+    }
+
+    jobject newPayloadObject(jobject map) const {
+      jobject ret = m_env->NewObject(m_payloadObjectClass, m_ids.payloadObjectInit, map);
+      checkException();
+      return ret;
+    }
+
+    jobject newPayloadArray(jsize length) const {
+      jobject ret = m_env->NewObject(m_payloadArrayClass, m_ids.payloadArrayInit, length);
+      checkException();
+      return ret;
+    }
+
+    jobjectArray getPayloadArrayValues(jobject payloadArray) const {
+      auto ret = static_cast<jobjectArray>(m_env->CallObjectMethod(payloadArray, m_ids.payloadArrayGetArray));
+      checkException();
+      return ret;
+    }
+
+    void setArrayElement(jobjectArray array, jsize index, jobject value) const {
+      m_env->SetObjectArrayElement(array, index, value);
+      checkException();
+    }
+
+
+    // Java -> JS
+    // ---
+
+    ValueKind getValueKind(jobject value) const {
+      if (m_env->IsInstanceOf(value, m_stringClass)) return ValueKind::String;
+      if (m_env->IsInstanceOf(value, m_numberClass)) return ValueKind::Number;
+      if (m_env->IsInstanceOf(value, m_booleanClass)) return ValueKind::Boolean;
+      if (m_env->IsInstanceOf(value, m_payloadObjectClass)) return ValueKind::PayloadObject;
+      if (m_env->IsInstanceOf(value, m_payloadArrayClass)) return ValueKind::PayloadArray;
+      if (m_env->IsInstanceOf(value, m_objectArrayClass)) return ValueKind::ObjectArray;
+      return ValueKind::Unsupported;
+    }
+
+    double getDouble(jobject number) const {
+      jdouble ret = m_env->CallDoubleMethod(number, m_ids.numberDoubleValue);
+      checkException();
+      return ret;
+    }
+
+    bool getBoolean(jobject boolean) const {
+      jboolean ret = m_env->CallBooleanMethod(boolean, m_ids.booleanBooleanValue);
+      checkException();
+      return ret == JNI_TRUE;
+    }
+
+    // Java String -> UTF-8 (or CESU-8) string
+    // Note: the returned buffer is re-used by the next call
+    const std::string &getString(jobject s, bool cesu8) {
+      m_utf8Buffer.clear();
+
+      auto str = static_cast<jstring>(s);
+      const jsize length = m_env->GetStringLength(str);
+      m_utf8Buffer.resize(3 * static_cast<size_t>(length));  // worst case, allocated before the critical region
+      const jchar *chars = m_env->GetStringCritical(str, nullptr);
+      if (chars == nullptr) {
+        m_utf8Buffer.clear();
+        checkException();
+        return m_utf8Buffer;
+      }
+
+      // No JNI call (nor allocation) until ReleaseStringCritical()!
+      m_utf8Buffer.resize(utf16_to_utf8(reinterpret_cast<const char16_t *>(chars), static_cast<size_t>(length), cesu8, &m_utf8Buffer[0]));
+      m_env->ReleaseStringCritical(str, chars);
+      return m_utf8Buffer;
+    }
+
+    // PayloadObject -> Map.Entry[]
+    jobjectArray getPayloadObjectEntries(jobject payloadObject) const {
+      jobject map = m_env->GetObjectField(payloadObject, m_ids.payloadObjectValues);
+      jobject entrySet = m_env->CallObjectMethod(map, m_ids.hashMapEntrySet);
+      m_env->DeleteLocalRef(map);
+      checkException();
+
+      auto ret = static_cast<jobjectArray>(m_env->CallObjectMethod(entrySet, m_ids.setToArray));
+      m_env->DeleteLocalRef(entrySet);
+      checkException();
+      return ret;
+    }
+
+    void getEntry(jobject entry, jobject *key, jobject *value) const {
+      *key = m_env->CallObjectMethod(entry, m_ids.mapEntryGetKey);
+      checkException();
+      *value = m_env->CallObjectMethod(entry, m_ids.mapEntryGetValue);
+      checkException();
+    }
+
+    jsize getArrayLength(jobjectArray array) const {
+      return m_env->GetArrayLength(array);
+    }
+
+    jobject getArrayElement(jobjectArray array, jsize index) const {
+      jobject ret = m_env->GetObjectArrayElement(array, index);
+      checkException();
+      return ret;
+    }
+
+  private:
+    const JniContext *m_jniContext;
+    JNIEnv *m_env;
+    const JniIds &m_ids;
+    jclass m_stringClass;
+    jclass m_numberClass;
+    jclass m_hashMapClass;
+    jclass m_booleanClass;
+    jclass m_integerClass;
+    jclass m_longClass;
+    jclass m_doubleClass;
+    jclass m_payloadObjectClass;
+    jclass m_payloadArrayClass;
+    jclass m_objectArrayClass;
+
+    std::string m_utf8Buffer;
+    std::u16string m_utf16Buffer;
+  };
+}
+
+Payload::Payload(const JsBridgeContext *jsBridgeContext, JavaTypeId id)
+ : JavaType(jsBridgeContext, id) {
+}
+
+// Check that the converted value matches the expected PayloadObject or PayloadArray type
+JValue Payload::checkPayloadClass(const JniLocalRef<jobject> &payload) const {
+  if (payload.isNull()) {
+    return JValue();
+  }
+
+  if (!m_jniContext->isInstanceOf(payload, getJniCache()->getJavaClass(getTypeId()))) {
+    throw std::invalid_argument(getTypeId() == JavaTypeId::PayloadArray
+        ? "Cannot convert JS value to PayloadArray"
+        : "Cannot convert JS value to PayloadObject");
+  }
+
+  return JValue(payload);
+}
+
+#if defined(DUKTAPE)
+
+#include "StackChecker.h"
+
+namespace {
+  // JS value -> Payload (PayloadObject, PayloadArray, String, Number, Boolean or null)
+  class JsToPayload {
+  public:
+    JsToPayload(const JsBridgeContext *jsBridgeContext)
+     : m_ctx(jsBridgeContext->getDuktapeContext())
+     , m_java(jsBridgeContext) {
+    }
+
+    // Convert the value at the top of the stack (without popping it) into a new local ref
+    jobject convert(int depth) {
+      switch (duk_get_type(m_ctx, -1)) {
+        case DUK_TYPE_BOOLEAN:
+          return m_java.newBoolean(duk_get_boolean(m_ctx, -1));
+        case DUK_TYPE_NUMBER:
+          return m_java.newNumber(duk_get_number(m_ctx, -1));
+        case DUK_TYPE_STRING: {
+          if (duk_is_symbol(m_ctx, -1)) {
+            return nullptr;
+          }
+          duk_size_t length;
+          const char *s = duk_get_lstring(m_ctx, -1, &length);
+          return m_java.newString(s, length);
+        }
+        case DUK_TYPE_OBJECT:
+          return convertObject(depth);
+        default:
+          return nullptr;
+      }
+    }
+
+    // Values which are skipped in objects (and replaced with null in arrays)
+    bool isSkipped() const {
+      return duk_is_undefined(m_ctx, -1) || duk_is_function(m_ctx, -1) || duk_is_symbol(m_ctx, -1);
+    }
+
+  private:
+    jobject convertObject(int depth) {
+      if (duk_is_function(m_ctx, -1)) {
+        return nullptr;
+      }
+
+      if (depth >= MAX_DEPTH) {
+        throw std::invalid_argument("Payload nesting level is too deep");
+      }
+
+      duk_require_stack(m_ctx, 3);
+
+      // toJSON() (e.g. Date)
+      if (duk_get_prop_string(m_ctx, -1, "toJSON") && duk_is_function(m_ctx, -1)) {
+        duk_dup(m_ctx, -2);
+        duk_call_method(m_ctx, 0);
+        jobject ret = convert(depth + 1);
+        duk_pop(m_ctx);  // toJSON() result
+        return ret;
+      }
+      duk_pop(m_ctx);  // toJSON
+
+      void *heapPtr = duk_get_heapptr(m_ctx, -1);
+      for (void *p : m_visiting) {
+        if (p == heapPtr) {
+          throw std::invalid_argument("Cannot convert cyclic structure to Payload");
+        }
+      }
+
+      m_visiting.push_back(heapPtr);
+      jobject ret = duk_is_array(m_ctx, -1) ? convertArray(depth) : convertPlainObject(depth);
+      m_visiting.pop_back();
+      return ret;
+    }
+
+    jobject convertArray(int depth) {
+      const auto length = static_cast<jsize>(duk_get_length(m_ctx, -1));
+      jobject payloadArray = m_java.newPayloadArray(length);
+      jobjectArray values = m_java.getPayloadArrayValues(payloadArray);
+
+      {
+        JniLocalFrame localFrame(m_java.getJniContext(), LOCAL_FRAME_CAPACITY);
+
+        for (jsize i = 0; i < length; ++i) {
+          duk_get_prop_index(m_ctx, -1, static_cast<duk_uarridx_t>(i));
+          jobject element = isSkipped() ? nullptr : convert(depth + 1);
+          duk_pop(m_ctx);  // element
+
+          m_java.setArrayElement(values, i, element);
+          m_java.deleteLocalRef(element);
+        }
+      }
+
+      m_java.deleteLocalRef(values);
+      return payloadArray;
+    }
+
+    // Note: Error instances also give their own non-enumerable properties ("message"), without the stack
+    jobject convertPlainObject(int depth) {
+      const bool isError = duk_is_error(m_ctx, -1);
+      jobject map = m_java.newHashMap(0);
+
+      {
+        JniLocalFrame localFrame(m_java.getJniContext(), LOCAL_FRAME_CAPACITY);
+
+        duk_enum(m_ctx, -1, DUK_ENUM_OWN_PROPERTIES_ONLY | (isError ? DUK_ENUM_INCLUDE_NONENUMERABLE : 0));
+        while (duk_next(m_ctx, -1, 1 /*get_value*/)) {
+          duk_size_t keyLength;
+          const char *key = duk_get_lstring(m_ctx, -2, &keyLength);
+
+          if (isSkipped() || (isError && strcmp(key, "stack") == 0)) {
+            duk_pop_2(m_ctx);  // key + value
+            continue;
+          }
+
+          jobject value = convert(depth + 1);
+          jobject keyString = m_java.newString(key, keyLength);
+          duk_pop_2(m_ctx);  // key + value
+
+          m_java.putToHashMap(map, keyString, value);
+          m_java.deleteLocalRef(keyString);
+          m_java.deleteLocalRef(value);
+        }
+        duk_pop(m_ctx);  // enum
+      }
+
+      jobject payloadObject = m_java.newPayloadObject(map);
+      m_java.deleteLocalRef(map);
+      return payloadObject;
+    }
+
+    duk_context *m_ctx;
+    JavaPayloadHelper m_java;
+    std::vector<void *> m_visiting;
+  };
+
+  // Payload -> JS value
+  class PayloadToJs {
+  public:
+    PayloadToJs(const JsBridgeContext *jsBridgeContext)
+     : m_ctx(jsBridgeContext->getDuktapeContext())
+     , m_java(jsBridgeContext) {
+    }
+
+    void push(jobject value, int depth) {
+      if (value == nullptr) {
+        duk_push_null(m_ctx);
+        return;
+      }
+
+      switch (m_java.getValueKind(value)) {
+        case JavaPayloadHelper::ValueKind::String: {
+          const std::string &s = m_java.getString(value, true /*cesu8*/);
+          duk_push_lstring(m_ctx, s.data(), s.length());
+          return;
+        }
+        case JavaPayloadHelper::ValueKind::Number:
+          duk_push_number(m_ctx, m_java.getDouble(value));
+          return;
+        case JavaPayloadHelper::ValueKind::Boolean:
+          duk_push_boolean(m_ctx, m_java.getBoolean(value));
+          return;
+        case JavaPayloadHelper::ValueKind::PayloadObject:
+          pushObject(value, depth);
+          return;
+        case JavaPayloadHelper::ValueKind::PayloadArray: {
+          jobjectArray values = m_java.getPayloadArrayValues(value);
+          pushArray(values, depth);
+          m_java.deleteLocalRef(values);
+          return;
+        }
+        case JavaPayloadHelper::ValueKind::ObjectArray:
+          pushArray(static_cast<jobjectArray>(value), depth);
+          return;
+        case JavaPayloadHelper::ValueKind::Unsupported:
+          throw std::invalid_argument("Unsupported value in Payload");
+      }
+    }
+
+  private:
+    void checkDepth(int depth) const {
+      if (depth >= MAX_DEPTH) {
+        throw std::invalid_argument("Payload nesting level is too deep");
+      }
+    }
+
+    void pushObject(jobject payloadObject, int depth) {
+      checkDepth(depth);
+      duk_require_stack(m_ctx, 2);
+
+      jobjectArray entries = m_java.getPayloadObjectEntries(payloadObject);
+      const jsize count = m_java.getArrayLength(entries);
+
+      duk_push_object(m_ctx);
+
+      {
+        JniLocalFrame localFrame(m_java.getJniContext(), LOCAL_FRAME_CAPACITY);
+
+        for (jsize i = 0; i < count; ++i) {
+          jobject entry = m_java.getArrayElement(entries, i);
+          jobject key, value;
+          m_java.getEntry(entry, &key, &value);
+
+          push(value, depth + 1);
+
+          if (key == nullptr) {
+            duk_put_prop_string(m_ctx, -2, "null");
+          } else {
+            const std::string &keyString = m_java.getString(key, true /*cesu8*/);
+            duk_put_prop_lstring(m_ctx, -2, keyString.data(), keyString.length());
+          }
+
+          m_java.deleteLocalRef(value);
+          m_java.deleteLocalRef(key);
+          m_java.deleteLocalRef(entry);
+        }
+      }
+
+      m_java.deleteLocalRef(entries);
+    }
+
+    void pushArray(jobjectArray values, int depth) {
+      checkDepth(depth);
+      duk_require_stack(m_ctx, 2);
+
+      const jsize count = m_java.getArrayLength(values);
+
+      duk_push_array(m_ctx);
+
+      JniLocalFrame localFrame(m_java.getJniContext(), LOCAL_FRAME_CAPACITY);
+
+      for (jsize i = 0; i < count; ++i) {
+        jobject element = m_java.getArrayElement(values, i);
+        push(element, depth + 1);
+        duk_put_prop_index(m_ctx, -2, static_cast<duk_uarridx_t>(i));
+        m_java.deleteLocalRef(element);
+      }
+    }
+
+    duk_context *m_ctx;
+    JavaPayloadHelper m_java;
+  };
+
+  struct PopPayloadParams {
+    const JsBridgeContext *jsBridgeContext;
+    jobject payload;
+    std::exception_ptr exception;
+  };
+
+  // Run the conversion in a protected call to catch the JS errors (getters, toJSON()). C++ exceptions
+  // are forwarded to the caller.
+  extern "C"
+  duk_ret_t popPayload(duk_context *, void *udata) {
+    auto params = reinterpret_cast<PopPayloadParams *>(udata);
+
+    try {
+      params->payload = JsToPayload(params->jsBridgeContext).convert(0);
+    } catch (const std::exception &) {
+      params->exception = std::current_exception();
+    }
+    return 0;
+  }
+}
+
+JValue Payload::pop() const {
+  CHECK_STACK_OFFSET(m_ctx, -1);
+
+  if (duk_is_null_or_undefined(m_ctx, -1)) {
+    duk_pop(m_ctx);
+    return JValue();
+  }
+
+  PopPayloadParams params { m_jsBridgeContext, nullptr, nullptr };
+  if (duk_safe_call(m_ctx, popPayload, &params, 0 /*nargs*/, 1 /*nrets*/) != DUK_EXEC_SUCCESS) {
+    duk_remove(m_ctx, -2);  // value
+    throw getExceptionHandler()->getCurrentJsException();
+  }
+  duk_pop_2(m_ctx);  // safe call result + value
+
+  if (params.exception) {
+    std::rethrow_exception(params.exception);
+  }
+
+  return checkPayloadClass(JniLocalRef<jobject>(m_jniContext, params.payload));
+}
+
+duk_ret_t Payload::push(const JValue &value) const {
+  CHECK_STACK_OFFSET(m_ctx, 1);
+
+  const JniLocalRef<jobject> &jPayload = value.getLocalRef();
+  if (jPayload.isNull()) {
+    duk_push_null(m_ctx);
+    return 1;
+  }
+
+  const duk_idx_t top = duk_get_top(m_ctx);
+  try {
+    PayloadToJs(m_jsBridgeContext).push(jPayload.get(), 0);
+  } catch (const std::exception &) {
+    duk_set_top(m_ctx, top + 1);
+    CHECK_STACK_NOW();
+    duk_pop(m_ctx);
+    throw;
+  }
+
+  return 1;
+}
+
+#elif defined(QUICKJS)
+
+#include "AutoReleasedJSValue.h"
+
+namespace {
+  // JS value -> Payload (PayloadObject, PayloadArray, String, Number, Boolean or null)
+  class JsToPayload {
+  public:
+    JsToPayload(const JsBridgeContext *jsBridgeContext)
+     : m_jsBridgeContext(jsBridgeContext)
+     , m_ctx(jsBridgeContext->getQuickJsContext())
+     , m_java(jsBridgeContext)
+     , m_toJsonAtom(JS_NewAtom(m_ctx, "toJSON"))
+     , m_stackAtom(JS_NewAtom(m_ctx, "stack")) {
+    }
+
+    ~JsToPayload() {
+      JS_FreeAtom(m_ctx, m_toJsonAtom);
+      JS_FreeAtom(m_ctx, m_stackAtom);
+    }
+
+    JsToPayload(const JsToPayload &) = delete;
+    JsToPayload& operator=(const JsToPayload &) = delete;
+
+    // Convert the given value into a new local ref
+    jobject convert(JSValueConst v, int depth) {
+      switch (JS_VALUE_GET_NORM_TAG(v)) {
+        case JS_TAG_INT:
+          return m_java.newInteger(JS_VALUE_GET_INT(v));
+        case JS_TAG_FLOAT64:
+          return m_java.newNumber(JS_VALUE_GET_FLOAT64(v));
+        case JS_TAG_BOOL:
+          return m_java.newBoolean(JS_VALUE_GET_BOOL(v));
+        case JS_TAG_STRING:
+          return newString(v);
+        case JS_TAG_OBJECT:
+          return convertObject(v, depth);
+        default:
+          return nullptr;
+      }
+    }
+
+    // Values which are skipped in objects (and replaced with null in arrays)
+    bool isSkipped(JSValueConst v) const {
+      return JS_IsUndefined(v) || JS_IsSymbol(v) || JS_IsFunction(m_ctx, v);
+    }
+
+  private:
+    [[noreturn]] void throwJsException() const {
+      throw m_jsBridgeContext->getExceptionHandler()->getCurrentJsException();
+    }
+
+    jobject newString(JSValueConst v) {
+      size_t length;
+      const char *s = JS_ToCStringLen(m_ctx, &length, v);
+      if (s == nullptr) {
+        throwJsException();
+      }
+
+      jobject ret;
+      try {
+        ret = m_java.newString(s, length);
+      } catch (const std::exception &) {
+        JS_FreeCString(m_ctx, s);
+        throw;
+      }
+      JS_FreeCString(m_ctx, s);
+      return ret;
+    }
+
+    jobject newKeyString(JSAtom atom) {
+      JSValue keyValue = JS_AtomToString(m_ctx, atom);
+      if (JS_IsException(keyValue)) {
+        throwJsException();
+      }
+      JS_AUTORELEASE_VALUE(m_ctx, keyValue);
+      return newString(keyValue);
+    }
+
+    jobject convertObject(JSValueConst v, int depth) {
+      if (JS_IsFunction(m_ctx, v)) {
+        return nullptr;
+      }
+
+      if (depth >= MAX_DEPTH) {
+        throw std::invalid_argument("Payload nesting level is too deep");
+      }
+
+      // toJSON() (e.g. Date)
+      JSValue toJson = JS_GetProperty(m_ctx, v, m_toJsonAtom);
+      if (JS_IsException(toJson)) {
+        throwJsException();
+      }
+      if (JS_IsFunction(m_ctx, toJson)) {
+        JSValue jsonValue = JS_Call(m_ctx, toJson, v, 0, nullptr);
+        JS_FreeValue(m_ctx, toJson);
+        if (JS_IsException(jsonValue)) {
+          throwJsException();
+        }
+        JS_AUTORELEASE_VALUE(m_ctx, jsonValue);
+        return convert(jsonValue, depth + 1);
+      }
+      JS_FreeValue(m_ctx, toJson);
+
+      void *ptr = JS_VALUE_GET_PTR(v);
+      for (void *p : m_visiting) {
+        if (p == ptr) {
+          throw std::invalid_argument("Cannot convert cyclic structure to Payload");
+        }
+      }
+
+      m_visiting.push_back(ptr);
+      jobject ret = JS_IsArray(m_ctx, v) > 0 ? convertArray(v, depth) : convertPlainObject(v, depth);
+      m_visiting.pop_back();
+      return ret;
+    }
+
+    jobject convertArray(JSValueConst v, int depth) {
+      JSValue lengthValue = JS_GetPropertyStr(m_ctx, v, "length");
+      uint32_t length = 0;
+      const int ret = JS_ToUint32(m_ctx, &length, lengthValue);
+      JS_FreeValue(m_ctx, lengthValue);
+      if (ret < 0) {
+        throwJsException();
+      }
+
+      jobject payloadArray = m_java.newPayloadArray(static_cast<jsize>(length));
+      jobjectArray values = m_java.getPayloadArrayValues(payloadArray);
+
+      {
+        JniLocalFrame localFrame(m_java.getJniContext(), LOCAL_FRAME_CAPACITY);
+
+        for (uint32_t i = 0; i < length; ++i) {
+          JSValue elementValue = JS_GetPropertyUint32(m_ctx, v, i);
+          if (JS_IsException(elementValue)) {
+            throwJsException();
+          }
+          JS_AUTORELEASE_VALUE(m_ctx, elementValue);
+
+          jobject element = isSkipped(elementValue) ? nullptr : convert(elementValue, depth + 1);
+          m_java.setArrayElement(values, static_cast<jsize>(i), element);
+          m_java.deleteLocalRef(element);
+        }
+      }
+
+      m_java.deleteLocalRef(values);
+      return payloadArray;
+    }
+
+    // Note: Error instances also give their own non-enumerable properties ("message"), without the stack
+    jobject convertPlainObject(JSValueConst v, int depth) {
+      const bool isError = JS_IsError(m_ctx, v);
+
+      JSPropertyEnum *properties = nullptr;
+      uint32_t count = 0;
+      if (JS_GetOwnPropertyNames(m_ctx, &properties, &count, v, JS_GPN_STRING_MASK | (isError ? 0 : JS_GPN_ENUM_ONLY)) < 0) {
+        throwJsException();
+      }
+      PropertyEnumReleaser propertyEnumReleaser { m_ctx, properties, count };
+
+      jobject map = m_java.newHashMap(count);
+
+      {
+        JniLocalFrame localFrame(m_java.getJniContext(), LOCAL_FRAME_CAPACITY);
+
+        for (uint32_t i = 0; i < count; ++i) {
+          const JSAtom atom = properties[i].atom;
+          if (isError && atom == m_stackAtom) {
+            continue;
+          }
+
+          JSValue itemValue = JS_GetProperty(m_ctx, v, atom);
+          if (JS_IsException(itemValue)) {
+            throwJsException();
+          }
+          JS_AUTORELEASE_VALUE(m_ctx, itemValue);
+
+          if (isSkipped(itemValue)) {
+            continue;
+          }
+
+          jobject value = convert(itemValue, depth + 1);
+          jobject key = newKeyString(atom);
+
+          m_java.putToHashMap(map, key, value);
+          m_java.deleteLocalRef(key);
+          m_java.deleteLocalRef(value);
+        }
+      }
+
+      jobject payloadObject = m_java.newPayloadObject(map);
+      m_java.deleteLocalRef(map);
+      return payloadObject;
+    }
+
+    struct PropertyEnumReleaser {
+      ~PropertyEnumReleaser() {
+        for (uint32_t i = 0; i < count; ++i) {
+          JS_FreeAtom(ctx, properties[i].atom);
+        }
+        js_free(ctx, properties);
+      }
+
+      JSContext *ctx;
+      JSPropertyEnum *properties;
+      uint32_t count;
+    };
+
+    const JsBridgeContext *m_jsBridgeContext;
+    JSContext *m_ctx;
+    JavaPayloadHelper m_java;
+    const JSAtom m_toJsonAtom;
+    const JSAtom m_stackAtom;
+    std::vector<void *> m_visiting;
+  };
+
+  // Payload -> JS value
+  class PayloadToJs {
+  public:
+    PayloadToJs(const JsBridgeContext *jsBridgeContext)
+     : m_jsBridgeContext(jsBridgeContext)
+     , m_ctx(jsBridgeContext->getQuickJsContext())
+     , m_java(jsBridgeContext) {
+    }
+
+    JSValue convert(jobject value, int depth) {
+      if (value == nullptr) {
+        return JS_NULL;
+      }
+
+      switch (m_java.getValueKind(value)) {
+        case JavaPayloadHelper::ValueKind::String: {
+          const std::string &s = m_java.getString(value, false /*cesu8*/);
+          return checkValue(JS_NewStringLen(m_ctx, s.data(), s.length()));
+        }
+        case JavaPayloadHelper::ValueKind::Number:
+          return JS_NewFloat64(m_ctx, m_java.getDouble(value));
+        case JavaPayloadHelper::ValueKind::Boolean:
+          return JS_NewBool(m_ctx, m_java.getBoolean(value));
+        case JavaPayloadHelper::ValueKind::PayloadObject:
+          return convertObject(value, depth);
+        case JavaPayloadHelper::ValueKind::PayloadArray: {
+          jobjectArray values = m_java.getPayloadArrayValues(value);
+          try {
+            JSValue ret = convertArray(values, depth);
+            m_java.deleteLocalRef(values);
+            return ret;
+          } catch (const std::exception &) {
+            m_java.deleteLocalRef(values);
+            throw;
+          }
+        }
+        case JavaPayloadHelper::ValueKind::ObjectArray:
+          return convertArray(static_cast<jobjectArray>(value), depth);
+        case JavaPayloadHelper::ValueKind::Unsupported:
+          break;
+      }
+
+      throw std::invalid_argument("Unsupported value in Payload");
+    }
+
+  private:
+    JSValue checkValue(JSValue v) const {
+      if (JS_IsException(v)) {
+        throw m_jsBridgeContext->getExceptionHandler()->getCurrentJsException();
+      }
+      return v;
+    }
+
+    void checkDepth(int depth) const {
+      if (depth >= MAX_DEPTH) {
+        throw std::invalid_argument("Payload nesting level is too deep");
+      }
+    }
+
+    JSValue convertObject(jobject payloadObject, int depth) {
+      checkDepth(depth);
+
+      jobjectArray entries = m_java.getPayloadObjectEntries(payloadObject);
+      const jsize count = m_java.getArrayLength(entries);
+
+      JSValue jsObject = checkValue(JS_NewObject(m_ctx));
+
+      try {
+        JniLocalFrame localFrame(m_java.getJniContext(), LOCAL_FRAME_CAPACITY);
+
+        for (jsize i = 0; i < count; ++i) {
+          jobject entry = m_java.getArrayElement(entries, i);
+          jobject key, value;
+          m_java.getEntry(entry, &key, &value);
+
+          // Note: the value is converted first because the key string buffer is re-used
+          JSValue jsValue = convert(value, depth + 1);
+
+          JSAtom atom;
+          if (key == nullptr) {
+            atom = JS_NewAtom(m_ctx, "null");
+          } else {
+            const std::string &keyString = m_java.getString(key, false /*cesu8*/);
+            atom = JS_NewAtomLen(m_ctx, keyString.data(), keyString.length());
+          }
+          const int ret = JS_DefinePropertyValue(m_ctx, jsObject, atom, jsValue, JS_PROP_C_W_E);
+          // No JS_FreeValue(m_ctx, jsValue) after JS_DefinePropertyValue()
+          JS_FreeAtom(m_ctx, atom);
+          if (ret < 0) {
+            throw m_jsBridgeContext->getExceptionHandler()->getCurrentJsException();
+          }
+
+          m_java.deleteLocalRef(value);
+          m_java.deleteLocalRef(key);
+          m_java.deleteLocalRef(entry);
+        }
+      } catch (const std::exception &) {
+        JS_FreeValue(m_ctx, jsObject);
+        m_java.deleteLocalRef(entries);
+        throw;
+      }
+
+      m_java.deleteLocalRef(entries);
+      return jsObject;
+    }
+
+    JSValue convertArray(jobjectArray values, int depth) {
+      checkDepth(depth);
+
+      const jsize count = m_java.getArrayLength(values);
+      JSValue jsArray = checkValue(JS_NewArray(m_ctx));
+
+      try {
+        JniLocalFrame localFrame(m_java.getJniContext(), LOCAL_FRAME_CAPACITY);
+
+        for (jsize i = 0; i < count; ++i) {
+          jobject element = m_java.getArrayElement(values, i);
+          JSValue jsElement = convert(element, depth + 1);
+          m_java.deleteLocalRef(element);
+
+          if (JS_DefinePropertyValueUint32(m_ctx, jsArray, static_cast<uint32_t>(i), jsElement, JS_PROP_C_W_E) < 0) {
+            throw m_jsBridgeContext->getExceptionHandler()->getCurrentJsException();
+          }
+          // No JS_FreeValue(m_ctx, jsElement) after JS_DefinePropertyValueUint32()
+        }
+      } catch (const std::exception &) {
+        JS_FreeValue(m_ctx, jsArray);
+        throw;
+      }
+
+      return jsArray;
+    }
+
+    const JsBridgeContext *m_jsBridgeContext;
+    JSContext *m_ctx;
+    JavaPayloadHelper m_java;
+  };
+}
+
+JValue Payload::toJava(JSValueConst v) const {
+  if (JS_IsNull(v) || JS_IsUndefined(v)) {
+    return JValue();
+  }
+
+  jobject payload = JsToPayload(m_jsBridgeContext).convert(v, 0);
+  return checkPayloadClass(JniLocalRef<jobject>(m_jniContext, payload));
+}
+
+JSValue Payload::fromJava(const JValue &value) const {
+  const JniLocalRef<jobject> &jPayload = value.getLocalRef();
+  if (jPayload.isNull()) {
+    return JS_NULL;
+  }
+
+  return PayloadToJs(m_jsBridgeContext).convert(jPayload.get(), 0);
+}
+
+#endif
+
+}  // namespace JavaTypes
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JAVATYPES_PAYLOAD_H
+#define _JSBRIDGE_JAVATYPES_PAYLOAD_H
+
+#include "JavaType.h"
+
+namespace JavaTypes {
+
+// PayloadObject and PayloadArray, directly built from (and converted to) JS values without going
+// through a JSON string.
+// The conversion follows the JSON.stringify() rules (toJSON(), undefined/function/symbol values
+// skipped, cycle detection) and gives the same Java values as Payload.fromJsonString().
+class Payload : public JavaType {
+
+public:
+  Payload(const JsBridgeContext *, JavaTypeId id);
+
+#if defined(DUKTAPE)
+  JValue pop() const override;
+  duk_ret_t push(const JValue &value) const override;
+#elif defined(QUICKJS)
+  JValue toJava(JSValueConst) const override;
+  JSValue fromJava(const JValue &value) const override;
+#endif
+
+private:
+  JValue checkPayloadClass(const JniLocalRef<jobject> &) const;
+};
+
+}  // namespace JavaTypes
+
+#endif
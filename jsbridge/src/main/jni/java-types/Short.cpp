@@ -18,6 +18,7 @@
  */
 #include "Short.h"
 
+#include "JniCache.h"
 #include "JsBridgeContext.h"
 #include "exceptions/JniException.h"
 #include "jni-helpers/JArrayLocalRef.h"
@@ -228,14 +229,12 @@ JValue Short::callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
 
 JValue Short::box(const JValue &shortValue) const {
   // From short to Short
-  static thread_local jmethodID boxId = m_jniContext->getStaticMethodID(getBoxedJavaClass(), "valueOf", "(S)Ljava/lang/Short;");
-  return JValue(m_jniContext->callStaticObjectMethod(getBoxedJavaClass(), boxId, shortValue.getShort()));
+  return JValue(m_jniContext->callStaticObjectMethod(getBoxedJavaClass(), getJniCache()->getIds().shortValueOf, shortValue.getShort()));
 }
 
 JValue Short::unbox(const JValue &boxedValue) const {
   // From Short to short
-  static thread_local jmethodID unboxId = m_jniContext->getMethodID(getBoxedJavaClass(), "shortValue", "()S");
-  return JValue(m_jniContext->callShortMethod(boxedValue.getLocalRef(), unboxId));
+  return JValue(m_jniContext->callShortMethod(boxedValue.getLocalRef(), getJniCache()->getIds().shortShortValue));
 }
 
 }  // namespace JavaTypes
@@ -19,11 +19,15 @@
 #include "String.h"
 #include "JsBridgeContext.h"
 #include "JniCache.h"
+#include "JsStrings.h"
+#include "StringInternCache.h"
 
 #if defined(DUKTAPE)
 # include "StackChecker.h"
 #elif defined(QUICKJS)
 # include "QuickJsUtils.h"
+# include "exceptions/JniException.h"
+# include "exceptions/JsException.h"
 #endif
 
 namespace JavaTypes {
@@ -40,17 +44,19 @@ JValue String::pop() const {
 
   // When m_forDebug == true, the return JValue is a DebugString instance
   if (m_forDebug) {
-    const char *s;
+    JStringLocalRef js;
 
     if (duk_is_undefined(m_ctx, -1)) {
-      s = "undefined";
+      js = JStringLocalRef(m_jniContext, "undefined");
     } else if (duk_is_null(m_ctx, -1)) {
-      s = "null";
+      js = JStringLocalRef(m_jniContext, "null");
     } else {
-      s = duk_safe_to_string(m_ctx, -1);
+      duk_size_t length;
+      const char *s = duk_safe_to_lstring(m_ctx, -1, &length);
+      js = JsStrings::toJava(m_jniContext, s, length);
     }
 
-    auto debugString = m_jsBridgeContext->getJniCache()->newDebugString(s);
+    auto debugString = m_jsBridgeContext->getJniCache()->newDebugString(js);
 
     duk_pop(m_ctx);
     return JValue(debugString);
@@ -62,7 +68,9 @@ JValue String::pop() const {
     return JValue();
   }
 
-  JStringLocalRef stringLocalRef(m_jniContext, duk_safe_to_string(m_ctx, -1));
+  duk_size_t length;
+  const char *s = duk_safe_to_lstring(m_ctx, -1, &length);
+  JStringLocalRef stringLocalRef = JsStrings::toJava(m_jniContext, s, length);
   duk_pop(m_ctx);
   return JValue(stringLocalRef);
 }
@@ -87,7 +95,13 @@ duk_ret_t String::push(const JValue &value) const {
     return 1;
   }
 
-  duk_push_string(m_ctx, jString.toUtf8Chars());
+  StringInternCache *stringInternCache = m_jsBridgeContext->getStringInternCache();
+  if (stringInternCache != nullptr && stringInternCache->push(jString)) {
+    return 1;
+  }
+
+  const std::string s = JsStrings::fromJava(jString);
+  duk_push_lstring(m_ctx, s.data(), s.length());
   return 1;
 }
 
@@ -135,7 +149,41 @@ JSValue String::fromJava(const JValue &value) const {
     return JS_NULL;
   }
 
-  return JS_NewString(m_ctx, jString.toUtf8Chars());
+  StringInternCache *stringInternCache = m_jsBridgeContext->getStringInternCache();
+  if (stringInternCache != nullptr) {
+    JSValue internedValue = stringInternCache->get(jString);
+    if (JS_IsException(internedValue)) {
+      throw JsException(m_jsBridgeContext, JS_GetException(m_ctx));
+    }
+    if (!JS_IsUninitialized(internedValue)) {
+      return internedValue;
+    }
+  }
+
+  // Direct UTF-16 handoff (no UTF-8 conversion)
+  // Note: the JS string is created with JS_TryNewStringUTF16() which neither throws nor runs the GC
+  // (and thus finalizers calling JNI) inside the critical region; errors are thrown after it.
+  bool hasChars = false;
+  size_t length = 0;
+  JSValue ret = jString.withCriticalUtf16Chars([this, &hasChars, &length](const char16_t *chars, size_t len) {
+    if (chars == nullptr) {
+      return JS_UNINITIALIZED;
+    }
+    hasChars = true;
+    length = len;
+    return JS_TryNewStringUTF16(m_ctx, reinterpret_cast<const uint16_t *>(chars), len);
+  });
+
+  if (!hasChars) {
+    throw JniException(m_jniContext);
+  }
+
+  if (JS_IsUninitialized(ret)) {
+    JS_ThrowNewStringError(m_ctx, length);
+    throw JsException(m_jsBridgeContext, JS_GetException(m_ctx));
+  }
+
+  return ret;
 }
 
 #endif
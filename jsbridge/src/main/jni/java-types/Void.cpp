@@ -18,6 +18,7 @@
  */
 #include "Void.h"
 
+#include "JniCache.h"
 #include "JsBridgeContext.h"
 #include "exceptions/JniException.h"
 
@@ -34,10 +35,8 @@ JValue Void::pop() const {
   duk_pop(m_ctx);
 
   if (m_boxed) {
-    // Create and return a new Void or Unit instance (TODO: cache me!)
-    const auto &javaClass = getJavaClass();
-    jmethodID newInstance = m_jniContext->getMethodID(getJavaClass(), "<init>", "()V");
-    auto instance = m_jniContext->newObject<jthrowable>(getJavaClass(), newInstance);
+    // Create and return a new Unit instance
+    auto instance = m_jniContext->newObject<jobject>(getJavaClass(), getJniCache()->getIds().unitInit);
     return JValue(std::move(instance));
   }
 
@@ -69,10 +68,8 @@ duk_ret_t Void::pushArray(const JniLocalRef<jarray> &, bool /*expand*/) const {
 
 JValue Void::toJava(JSValueConst) const {
   if (m_boxed) {
-    // Create and return a new Void or Unit instance
-    const auto &javaClass = getJavaClass();
-    jmethodID newInstance = m_jniContext->getMethodID(getJavaClass(), "<init>", "()V");
-    auto instance = m_jniContext->newObject<jthrowable>(getJavaClass(), newInstance);
+    // Create and return a new Unit instance
+    auto instance = m_jniContext->newObject<jobject>(getJavaClass(), getJniCache()->getIds().unitInit);
     return JValue(instance);
   }
 
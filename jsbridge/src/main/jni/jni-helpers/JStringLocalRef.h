@@ -23,6 +23,7 @@
 #include "JniRefHelper.h"
 #include <jni.h>
 #include <cstring>
+#include <memory>
 #include <string>
 
 // Same as LocalRef<jstring> with additional conversion from/to Java string
@@ -37,7 +38,7 @@ public:
       : JniLocalRef<jstring>(jniContext, o, mode) {
   }
 
-  // From null-terminated UTF-8 string
+  // From null-terminated (modified) UTF-8 string
   JStringLocalRef(const JniContext *jniContext, const char *s)
       : JniLocalRef<jstring>(jniContext, JniRefHelper::getJNIEnv(jniContext)->NewStringUTF(s)) {
   }
@@ -53,6 +54,24 @@ public:
       : JniLocalRef<jstring>(jniContext, JniRefHelper::getJNIEnv(jniContext)->NewString(s, len)) {
   }
 
+  // From a temporary UTF-16 buffer of the given capacity, which is filled by
+  // fill(char16_t *) (returning the actual length)
+  template <class F>
+  static JStringLocalRef fromUtf16Buffer(const JniContext *jniContext, size_t capacity, F &&fill) {
+    JNIEnv *env = JniRefHelper::getJNIEnv(jniContext);
+
+    const size_t STACK_BUFFER_SIZE = 512;
+    if (capacity <= STACK_BUFFER_SIZE) {
+      char16_t utf16[STACK_BUFFER_SIZE];
+      const size_t utf16Length = fill(utf16);
+      return JStringLocalRef(jniContext, env->NewString(reinterpret_cast<const jchar *>(utf16), static_cast<jsize>(utf16Length)));
+    }
+
+    std::unique_ptr<char16_t[]> utf16(new char16_t[capacity]);
+    const size_t utf16Length = fill(utf16.get());
+    return JStringLocalRef(jniContext, env->NewString(reinterpret_cast<const jchar *>(utf16.get()), static_cast<jsize>(utf16Length)));
+  }
+
   explicit JStringLocalRef(const JniLocalRef<jstring> &localRef)
       : JniLocalRef<jstring>(localRef) {
   }
@@ -89,7 +108,8 @@ public:
     }
   }
 
-  // Return a pointer to a new null-terminated UTF-8 string converted from the UTF-16 Java string
+  // Return a pointer to a new null-terminated (JNI modified) UTF-8 string converted from the UTF-16
+  // Java string. See JsStrings for the conversion to a JS engine string.
   // WARNING: the returned const char * is invalid after the JStringLocalRef instance has been released!
   // Note: when called multiple times, only 1 Java string -> UTF8 string conversion will be done
   const char *toUtf8Chars() const {
@@ -124,6 +144,24 @@ public:
     return std::u16string_view(m_utf16Chars, static_cast<size_t>(utf16Length()));
   }
 
+  // Call f(const char16_t *chars, size_t length) with a direct pointer to the (non-null) Java
+  // String chars and return its result. chars is nullptr if they could not be accessed (i.e. an
+  // OutOfMemoryError is pending).
+  // WARNING: f is called inside a JNI critical region and must neither call JNI functions nor block!
+  template <class F>
+  auto withCriticalUtf16Chars(F &&f) const -> decltype(f(nullptr, size_t())) {
+    JNIEnv *env = getJniEnv();
+    const jsize length = env->GetStringLength(jstr());
+    const jchar *chars = env->GetStringCritical(jstr(), nullptr);
+    if (chars == nullptr) {
+      return f(nullptr, 0);
+    }
+
+    auto ret = f(reinterpret_cast<const char16_t *>(chars), static_cast<size_t>(length));
+    env->ReleaseStringCritical(jstr(), chars);
+    return ret;
+  }
+
   size_t utf8Length() const {
      return m_utf8Chars ? strlen(m_utf8Chars) :
            jstr() ? getJniEnv()->GetStringUTFLength(jstr()) : 0;
@@ -15,6 +15,11 @@
  */
 #include "JniContext.h"
 #include "JStringLocalRef.h"
+#include <atomic>
+
+namespace {
+  std::atomic<uint64_t> idLookupCount(0);
+}
 
 JniContext::JniContext(JNIEnv *env, EnvironmentSource jniEnvSetup)
  : m_currentJniEnv(jniEnvSetup == EnvironmentSource::JvmAuto ? nullptr : env)
@@ -28,20 +33,34 @@ JniContext::~JniContext() {
 }
 
 jmethodID JniContext::getMethodID(const JniRef<jclass> &clazz, const char *name, const char *sig) const {
+  ++idLookupCount;
   JNIEnv *env = getJNIEnv();
   return env->GetMethodID(clazz.get(), name, sig);
 }
 
 jmethodID JniContext::getStaticMethodID(const JniRef<jclass> &clazz, const char *name, const char *sig) const {
+  ++idLookupCount;
   JNIEnv *env = getJNIEnv();
   return env->GetStaticMethodID(clazz.get(), name, sig);
 }
 
+jfieldID JniContext::getFieldID(const JniRef<jclass> &clazz, const char *name, const char *sig) const {
+  ++idLookupCount;
+  JNIEnv *env = getJNIEnv();
+  return env->GetFieldID(clazz.get(), name, sig);
+}
+
 jfieldID JniContext::getStaticFieldID(const JniRef<jclass> &clazz, const char *name, const char *sig) const {
+  ++idLookupCount;
   JNIEnv *env = getJNIEnv();
   return env->GetStaticFieldID(clazz.get(), name, sig);
 }
 
+// static
+uint64_t JniContext::getIdLookupCount() {
+  return idLookupCount;
+}
+
 JniLocalRef<jclass> JniContext::findClass(const char *name) const {
   JNIEnv *env = getJNIEnv();
   return JniLocalRef<jclass>(this, env->FindClass(name));
@@ -72,11 +91,45 @@ void JniContext::exceptionClear() const {
   env->ExceptionClear();
 }
 
-static JNIEnv *getEnvFromJvm(JavaVM *jvm) {
-  JNIEnv *jvmEnv;
+namespace {
+  // JNIEnv instance of the current thread, fetched once from the Java VM.
+  //
+  // Threads which are not yet attached (i.e. native threads) are attached on first use and
+  // automatically detached when they exit.
+  class ThreadJniEnv {
+  public:
+    ~ThreadJniEnv() {
+      if (m_attachedJvm != nullptr) {
+        m_attachedJvm->DetachCurrentThread();
+      }
+    }
+
+    JNIEnv *get(JavaVM *jvm) {
+      if (m_env != nullptr) {
+        return m_env;
+      }
+
+      if (jvm->GetEnv(reinterpret_cast<void **>(&m_env), JNI_VERSION_1_6) == JNI_EDETACHED) {
+        if (jvm->AttachCurrentThread(&m_env, nullptr) != JNI_OK) {
+          m_env = nullptr;
+          return nullptr;
+        }
+        m_attachedJvm = jvm;
+      }
+
+      return m_env;
+    }
+
+  private:
+    JNIEnv *m_env = nullptr;
+    JavaVM *m_attachedJvm = nullptr;
+  };
+
+  thread_local ThreadJniEnv threadJniEnv;
+}
 
-  jvm->AttachCurrentThread(&jvmEnv, nullptr);
-  return jvmEnv;
+static JNIEnv *getEnvFromJvm(JavaVM *jvm) {
+  return threadJniEnv.get(jvm);
 }
 
 JNIEnv *JniContext::getJNIEnv() const {
@@ -23,6 +23,7 @@
 #include "JniLocalRef.h"
 #include <jni.h>
 #include <array>
+#include <cstdint>
 #include <string>
 
 // JNI functions wrapper with JniLocalRef/JniGlobalRef
@@ -31,7 +32,7 @@ class JniContext {
 public:
   enum class EnvironmentSource {
     Manual,  // (single-threaded only!) use ctor argument + manually call setCurrentJNIEnv() when needed
-    JvmAuto  // (single + multithreaded) JNIEnv instance fetched from the Java VM
+    JvmAuto  // (single + multithreaded) JNIEnv instance fetched from the Java VM (and cached per thread)
   };
 
   explicit JniContext(JNIEnv *env, EnvironmentSource = EnvironmentSource::Manual);
@@ -42,8 +43,12 @@ public:
 
   jmethodID getMethodID(const JniRef<jclass> &, const char *name, const char *sig) const;
   jmethodID getStaticMethodID(const JniRef<jclass> &, const char *name, const char *sig) const;
+  jfieldID getFieldID(const JniRef<jclass> &, const char *name, const char *sig) const;
   jfieldID getStaticFieldID(const JniRef<jclass> &, const char *name, const char *sig) const;
 
+  // Total number of method/field ID lookups made through all the JniContext instances
+  static uint64_t getIdLookupCount();
+
   JniLocalRef<jclass> findClass(const char *name) const;
 
   template <class T>
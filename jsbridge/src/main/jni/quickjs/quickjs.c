@@ -3145,6 +3145,12 @@ static BOOL JS_AtomIsArrayIndex(JSContext *ctx, uint32_t *pval, JSAtom atom)
     }
 }
 
+/* jsbridge extension */
+BOOL JS_AtomGetArrayIndex(JSContext *ctx, uint32_t *pval, JSAtom atom)
+{
+    return JS_AtomIsArrayIndex(ctx, pval, atom);
+}
+
 /* This test must be fast if atom is not a numeric index (e.g. a
    method name). Return JS_UNDEFINED if not a numeric
    index. JS_EXCEPTION can also be returned. */
@@ -3968,6 +3974,69 @@ JSValue JS_NewAtomString(JSContext *ctx, const char *str)
     return val;
 }
 
+/* jsbridge extension */
+JSValue JS_TryNewStringUTF16(JSContext *ctx, const uint16_t *buf, size_t len)
+{
+    JSString *str;
+    size_t i;
+    uint16_t c_max;
+
+    if (len > JS_STRING_LEN_MAX)
+        return JS_UNINITIALIZED;
+    if (len == 0)
+        return JS_AtomToString(ctx, JS_ATOM_empty_string);
+    c_max = 0;
+    for(i = 0; i < len; i++)
+        c_max |= buf[i];
+    /* js_alloc_string_rt() neither throws nor triggers the GC */
+    if (c_max >= 0x100) {
+        str = js_alloc_string_rt(ctx->rt, len, 1);
+        if (!str)
+            return JS_UNINITIALIZED;
+        memcpy(str->u.str16, buf, len * 2);
+    } else {
+        str = js_alloc_string_rt(ctx->rt, len, 0);
+        if (!str)
+            return JS_UNINITIALIZED;
+        for(i = 0; i < len; i++)
+            str->u.str8[i] = buf[i];
+        str->u.str8[len] = '\0';
+    }
+    return JS_MKPTR(JS_TAG_STRING, str);
+}
+
+/* jsbridge extension */
+JSValue JS_ThrowNewStringError(JSContext *ctx, size_t len)
+{
+    if (len > JS_STRING_LEN_MAX)
+        return JS_ThrowInternalError(ctx, "string too long");
+    return JS_ThrowOutOfMemory(ctx);
+}
+
+/* jsbridge extension */
+JSValue JS_NewStringUTF16(JSContext *ctx, const uint16_t *buf, size_t len)
+{
+    JSValue val;
+
+    val = JS_TryNewStringUTF16(ctx, buf, len);
+    if (JS_IsUninitialized(val))
+        return JS_ThrowNewStringError(ctx, len);
+    return val;
+}
+
+/* jsbridge extension */
+const void *JS_GetStringBuffer(JSContext *ctx, JSValueConst val, size_t *plen, BOOL *pwide_char)
+{
+    JSString *str;
+
+    if (JS_VALUE_GET_TAG(val) != JS_TAG_STRING)
+        return NULL;
+    str = JS_VALUE_GET_STRING(val);
+    *plen = str->len;
+    *pwide_char = str->is_wide_char;
+    return str->is_wide_char ? (const void *)str->u.str16 : (const void *)str->u.str8;
+}
+
 /* return (NULL, 0) if exception. */
 /* return pointer into a JSString with a live ref_count */
 /* cesu8 determines if non-BMP1 codepoints are encoded as 1 or 2 utf-8 sequences */
@@ -46243,12 +46312,6 @@ static const JSCFunctionListEntry js_generator_proto_funcs[] = {
 
 /* Promise */
 
-typedef enum JSPromiseStateEnum {
-    JS_PROMISE_PENDING,
-    JS_PROMISE_FULFILLED,
-    JS_PROMISE_REJECTED,
-} JSPromiseStateEnum;
-
 typedef struct JSPromiseData {
     JSPromiseStateEnum promise_state;
     /* 0=fulfill, 1=reject, list of JSPromiseReactionData.link */
@@ -46685,6 +46748,24 @@ JSValue JS_NewPromiseCapability(JSContext *ctx, JSValue *resolving_funcs)
     return js_new_promise_capability(ctx, resolving_funcs, JS_UNDEFINED);
 }
 
+/* jsbridge extension */
+JSPromiseStateEnum JS_PromiseState(JSContext *ctx, JSValueConst promise)
+{
+    JSPromiseData *s = JS_GetOpaque(promise, JS_CLASS_PROMISE);
+    if (!s)
+        return -1;
+    return s->promise_state;
+}
+
+/* jsbridge extension */
+JSValue JS_PromiseResult(JSContext *ctx, JSValueConst promise)
+{
+    JSPromiseData *s = JS_GetOpaque(promise, JS_CLASS_PROMISE);
+    if (!s)
+        return JS_UNDEFINED;
+    return JS_DupValue(ctx, s->promise_result);
+}
+
 static JSValue js_promise_resolve(JSContext *ctx, JSValueConst this_val,
                                   int argc, JSValueConst *argv, int magic)
 {
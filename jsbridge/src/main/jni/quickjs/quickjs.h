@@ -428,6 +428,8 @@ JSValue JS_AtomToValue(JSContext *ctx, JSAtom atom);
 JSValue JS_AtomToString(JSContext *ctx, JSAtom atom);
 const char *JS_AtomToCString(JSContext *ctx, JSAtom atom);
 JSAtom JS_ValueToAtom(JSContext *ctx, JSValueConst val);
+/* jsbridge extension: return TRUE and set *pval if the atom is an array index */
+JS_BOOL JS_AtomGetArrayIndex(JSContext *ctx, uint32_t *pval, JSAtom atom);
 
 /* object class support */
 
@@ -707,6 +709,18 @@ static inline const char *JS_ToCString(JSContext *ctx, JSValueConst val1)
     return JS_ToCStringLen2(ctx, NULL, val1, 0);
 }
 void JS_FreeCString(JSContext *ctx, const char *ptr);
+/* jsbridge extension: direct access to the string characters */
+/* create a string from a UTF-16 buffer (stored as 8-bit if all the characters are < 0x100) */
+JSValue JS_NewStringUTF16(JSContext *ctx, const uint16_t *buf, size_t len);
+/* same as JS_NewStringUTF16() but neither throws nor triggers the GC (e.g. inside a JNI critical
+   region): return JS_UNINITIALIZED on error, JS_ThrowNewStringError() then throws the matching
+   exception */
+JSValue JS_TryNewStringUTF16(JSContext *ctx, const uint16_t *buf, size_t len);
+JSValue JS_ThrowNewStringError(JSContext *ctx, size_t len);
+/* return the characters of the string 'val' (NULL if 'val' is not a string): 16-bit characters if
+   *pwide_char is set, 8-bit (Latin-1) characters otherwise. The buffer is valid as long as 'val'
+   is alive. */
+const void *JS_GetStringBuffer(JSContext *ctx, JSValueConst val, size_t *plen, JS_BOOL *pwide_char);
 
 JSValue JS_NewObjectProtoClass(JSContext *ctx, JSValueConst proto, JSClassID class_id);
 JSValue JS_NewObjectClass(JSContext *ctx, int class_id);
@@ -832,6 +846,16 @@ void JS_SetSharedArrayBufferFunctions(JSRuntime *rt,
                                       const JSSharedArrayBufferFunctions *sf);
 
 JSValue JS_NewPromiseCapability(JSContext *ctx, JSValue *resolving_funcs);
+/* jsbridge extension: synchronous access to the state of a native Promise */
+typedef enum JSPromiseStateEnum {
+    JS_PROMISE_PENDING,
+    JS_PROMISE_FULFILLED,
+    JS_PROMISE_REJECTED,
+} JSPromiseStateEnum;
+/* return -1 if 'promise' is not a Promise instance */
+JSPromiseStateEnum JS_PromiseState(JSContext *ctx, JSValueConst promise);
+/* return the fulfilled value or the rejection reason (undefined if still pending) */
+JSValue JS_PromiseResult(JSContext *ctx, JSValueConst promise);
 
 /* is_handled = TRUE means that the rejection is handled */
 typedef void JSHostPromiseRejectionTracker(JSContext *ctx, JSValueConst promise,
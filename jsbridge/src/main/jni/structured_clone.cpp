@@ -0,0 +1,1506 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "structured_clone.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Buffer format: each value starts with a 1-byte tag, followed by:
+// - Int32: zigzag-encoded varint
+// - Double: 8 bytes (native byte order, the buffer never leaves the process)
+// - String: varint byte length + string bytes (as given by the JS engine)
+// - Array: varint length + items
+// - Object: for each property: varint (key byte length + 1) + key bytes + value, then varint 0
+// - ObjectRef: varint index of an object written before (objects are indexed in write order,
+//   which allows shared references and cycles)
+// - Date: time value (8 bytes)
+// - ArrayBuffer: varint byte length + bytes
+// - ArrayBufferView: view kind (1 byte) + varint byte offset + varint byte length + buffer value
+//   (ArrayBuffer or ObjectRef)
+// - Map: key + value of each entry, then EndOfEntries tag
+// - Set: value of each entry, then EndOfEntries tag
+
+namespace {
+  // Max object/array nesting (same as the JSON encoder)
+  const size_t MAX_DEPTH = 1000;
+
+  const char *MALFORMED_DATA_MESSAGE = "malformed structured clone data";
+
+  enum class Tag : uint8_t {
+    Undefined = 0,
+    Null,
+    False,
+    True,
+    Int32,
+    Double,
+    String,
+    Array,
+    Object,
+    ObjectRef,
+    Date,
+    ArrayBuffer,
+    ArrayBufferView,
+    Map,
+    Set,
+    EndOfEntries,
+  };
+
+  // Objects cloned with their class, which is detected by their prototype (as the JS engines do
+  // not expose the object class)
+  enum class ObjectClass {
+    Date,
+    Map,
+    Set,
+    ArrayBuffer,
+    ArrayBufferView,
+  };
+
+  struct ViewInfo {
+    const char *ctorName;
+    size_t elementSize;
+  };
+
+  // ArrayBuffer views indexed by view kind, in the order of the Duktape DUK_BUFOBJ_xxx flags
+  // (starting from DUK_BUFOBJ_DATAVIEW)
+  const ViewInfo VIEWS[] = {
+    { "DataView", 1 },
+    { "Int8Array", 1 },
+    { "Uint8Array", 1 },
+    { "Uint8ClampedArray", 1 },
+    { "Int16Array", 2 },
+    { "Uint16Array", 2 },
+    { "Int32Array", 4 },
+    { "Uint32Array", 4 },
+    { "Float32Array", 4 },
+    { "Float64Array", 8 },
+  };
+  const uint8_t VIEW_COUNT = sizeof(VIEWS) / sizeof(VIEWS[0]);
+  const uint8_t DATA_VIEW_KIND = 0;
+
+  // Constructors captured by structured_clone_init()/structured_clone_new_intrinsics() (in
+  // addition to the views)
+  const char *INTRINSIC_CTOR_NAMES[] = { "Date", "Map", "Set", "ArrayBuffer" };
+
+  // Accessors of the internal view fields, also captured as intrinsics (an own property of a view
+  // would shadow the inherited accessor). With Duktape, they also accept typed arrays.
+  struct ViewGetter {
+    const char *propName;
+    const char *intrinsicName;
+  };
+  const ViewGetter VIEW_GETTERS[] = {
+    { "buffer", "DataView.prototype.buffer" },
+    { "byteOffset", "DataView.prototype.byteOffset" },
+    { "byteLength", "DataView.prototype.byteLength" },
+  };
+  const char *VIEW_BUFFER_GETTER_NAME = VIEW_GETTERS[0].intrinsicName;
+  const char *VIEW_BYTE_OFFSET_GETTER_NAME = VIEW_GETTERS[1].intrinsicName;
+  const char *VIEW_BYTE_LENGTH_GETTER_NAME = VIEW_GETTERS[2].intrinsicName;
+
+  inline void writeTag(std::string &out, Tag tag) {
+    out += static_cast<char>(tag);
+  }
+
+  void writeVarUint(std::string &out, uint64_t v) {
+    while (v >= 0x80) {
+      out += static_cast<char>((v & 0x7F) | 0x80);
+      v >>= 7;
+    }
+    out += static_cast<char>(v);
+  }
+
+  void writeString(std::string &out, const char *s, size_t length) {
+    writeTag(out, Tag::String);
+    writeVarUint(out, length);
+    out.append(s, length);
+  }
+
+  void writeKey(std::string &out, const char *s, size_t length) {
+    writeVarUint(out, length + 1);
+    out.append(s, length);
+  }
+
+  inline void writeEndOfObject(std::string &out) {
+    writeVarUint(out, 0);
+  }
+
+  void writeDouble(std::string &out, double d) {
+    char bytes[sizeof(double)];
+    memcpy(bytes, &d, sizeof(double));
+    out.append(bytes, sizeof(double));
+  }
+
+  void writeObjectRef(std::string &out, uint32_t index) {
+    writeTag(out, Tag::ObjectRef);
+    writeVarUint(out, index);
+  }
+
+  void writeArrayBufferData(std::string &out, const void *data, size_t size) {
+    writeTag(out, Tag::ArrayBuffer);
+    writeVarUint(out, size);
+    out.append(static_cast<const char *>(data), size);
+  }
+
+  // Followed by the buffer value
+  void writeViewHeader(std::string &out, uint8_t viewKind, uint64_t byteOffset, uint64_t byteLength) {
+    writeTag(out, Tag::ArrayBufferView);
+    out += static_cast<char>(viewKind);
+    writeVarUint(out, byteOffset);
+    writeVarUint(out, byteLength);
+  }
+
+  // The view range must be within the buffer and aligned with the view elements
+  bool isValidView(uint8_t viewKind, uint64_t byteOffset, uint64_t byteLength, size_t bufferSize) {
+    const size_t elementSize = VIEWS[viewKind].elementSize;
+    return byteOffset <= bufferSize && byteLength <= bufferSize - byteOffset &&
+        byteOffset % elementSize == 0 && byteLength % elementSize == 0;
+  }
+
+  // Integral numbers within the int32 range (except -0) are written as varints
+  void writeNumber(std::string &out, double d) {
+    if (d >= INT32_MIN && d <= INT32_MAX) {
+      const auto i = static_cast<int32_t>(d);
+      if (i == d && (i != 0 || !std::signbit(d))) {
+        writeTag(out, Tag::Int32);
+        writeVarUint(out, (static_cast<uint32_t>(i) << 1) ^ static_cast<uint32_t>(i >> 31));
+        return;
+      }
+    }
+
+    writeTag(out, Tag::Double);
+    writeDouble(out, d);
+  }
+
+  // Bounds-checked reader: all the methods return false if the data is malformed
+  class Reader {
+  public:
+    explicit Reader(const std::string &buffer)
+     : m_p(buffer.data())
+     , m_end(buffer.data() + buffer.size()) {
+    }
+
+    bool atEnd() const { return m_p == m_end; }
+    size_t remaining() const { return m_end - m_p; }
+
+    bool readTag(Tag &tag) {
+      if (m_p == m_end) {
+        return false;
+      }
+      tag = static_cast<Tag>(*m_p++);
+      return true;
+    }
+
+    bool readVarUint(uint64_t &v) {
+      v = 0;
+      for (unsigned int shift = 0; shift < 64 && m_p != m_end; shift += 7) {
+        const auto byte = static_cast<uint8_t>(*m_p++);
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    bool readInt32(int32_t &i) {
+      uint64_t v;
+      if (!readVarUint(v) || v > UINT32_MAX) {
+        return false;
+      }
+      const auto u = static_cast<uint32_t>(v);
+      i = static_cast<int32_t>((u >> 1) ^ (0 - (u & 1)));
+      return true;
+    }
+
+    bool readDouble(double &d) {
+      if (remaining() < sizeof(double)) {
+        return false;
+      }
+      memcpy(&d, m_p, sizeof(double));
+      m_p += sizeof(double);
+      return true;
+    }
+
+    bool readBytes(const char *&s, size_t &length) {
+      uint64_t v;
+      if (!readVarUint(v) || v > remaining()) {
+        return false;
+      }
+      s = m_p;
+      length = static_cast<size_t>(v);
+      m_p += length;
+      return true;
+    }
+
+    // isEnd is set at the end of the object properties
+    bool readKey(const char *&s, size_t &length, bool &isEnd) {
+      uint64_t v;
+      if (!readVarUint(v) || v > remaining() + 1) {
+        return false;
+      }
+      isEnd = v == 0;
+      if (!isEnd) {
+        s = m_p;
+        length = static_cast<size_t>(v - 1);
+        m_p += length;
+      }
+      return true;
+    }
+
+    // Array length (each item takes at least one byte)
+    bool readLength(uint64_t &length) {
+      return readVarUint(length) && length <= remaining();
+    }
+
+    bool readViewHeader(uint8_t &viewKind, uint64_t &byteOffset, uint64_t &byteLength) {
+      if (m_p == m_end) {
+        return false;
+      }
+      viewKind = static_cast<uint8_t>(*m_p++);
+      return viewKind < VIEW_COUNT && readVarUint(byteOffset) && readVarUint(byteLength);
+    }
+
+    // isEnd is set (and the tag consumed) at the end of the Map/Set entries
+    bool readEndOfEntries(bool &isEnd) {
+      if (m_p == m_end) {
+        return false;
+      }
+      isEnd = static_cast<Tag>(*m_p) == Tag::EndOfEntries;
+      if (isEnd) {
+        ++m_p;
+      }
+      return true;
+    }
+
+  private:
+    const char *m_p;
+    const char *m_end;
+  };
+}
+
+#if defined(DUKTAPE)
+
+namespace {
+  const char *INTRINSICS_PROP_NAME = "\xff\xffstructured_clone_intrinsics";
+
+  // [...] -> [... intrinsic]
+  void pushIntrinsic(duk_context *ctx, const char *name) {
+    duk_push_global_stash(ctx);
+    if (duk_get_prop_string(ctx, -1, INTRINSICS_PROP_NAME)) {
+      duk_get_prop_string(ctx, -1, name);
+    } else {
+      duk_push_undefined(ctx);
+    }
+    duk_remove(ctx, -2);  // intrinsics
+    duk_remove(ctx, -2);  // global stash
+  }
+
+  class Writer {
+  public:
+    Writer(duk_context *ctx, std::string &out)
+     : m_ctx(ctx)
+     , m_out(out) {
+    }
+
+    // [... value] -> [...]
+    void run() {
+      const duk_idx_t valueIdx = duk_get_top_index(m_ctx);
+      duk_require_stack(m_ctx, VIEW_COUNT + 6);  // prototypes + pushIntrinsic() temporaries
+
+      // Written objects are kept reachable so that their heap pointers stay unique
+      duk_push_bare_array(m_ctx);
+      m_objectsIdx = duk_get_top_index(m_ctx);
+
+      pushPrototype("Date", ObjectClass::Date, 0);
+      pushPrototype("ArrayBuffer", ObjectClass::ArrayBuffer, 0);
+      for (uint8_t viewKind = 0; viewKind < VIEW_COUNT; ++viewKind) {
+        pushPrototype(VIEWS[viewKind].ctorName, ObjectClass::ArrayBufferView, viewKind);
+      }
+
+      duk_dup(m_ctx, valueIdx);
+      write();
+      duk_set_top(m_ctx, valueIdx);
+    }
+
+  private:
+    struct Prototype {
+      void *ptr;
+      duk_idx_t idx;
+      ObjectClass objectClass;
+      uint8_t viewKind;
+    };
+
+    // [...] -> [... prototype] (if any)
+    void pushPrototype(const char *ctorName, ObjectClass objectClass, uint8_t viewKind) {
+      pushIntrinsic(m_ctx, ctorName);
+      if (duk_is_object(m_ctx, -1)) {
+        duk_get_prop_string(m_ctx, -1, "prototype");
+        duk_remove(m_ctx, -2);
+      }
+      if (!duk_is_object(m_ctx, -1)) {
+        duk_pop(m_ctx);
+        return;
+      }
+      m_prototypes.push_back({ duk_get_heapptr(m_ctx, -1), duk_get_top_index(m_ctx), objectClass, viewKind });
+    }
+
+    // [... value] -> [...]
+    void write() {
+      duk_require_stack(m_ctx, 4);
+
+      switch (duk_get_type(m_ctx, -1)) {
+        case DUK_TYPE_UNDEFINED:
+          writeTag(m_out, Tag::Undefined);
+          break;
+        case DUK_TYPE_NULL:
+          writeTag(m_out, Tag::Null);
+          break;
+        case DUK_TYPE_BOOLEAN:
+          writeTag(m_out, duk_get_boolean(m_ctx, -1) ? Tag::True : Tag::False);
+          break;
+        case DUK_TYPE_NUMBER:
+          writeNumber(m_out, duk_get_number(m_ctx, -1));
+          break;
+        case DUK_TYPE_STRING: {
+          if (duk_is_symbol(m_ctx, -1)) {
+            duk_type_error(m_ctx, "Symbol could not be cloned");
+          }
+          duk_size_t length;
+          const char *str = duk_get_lstring(m_ctx, -1, &length);
+          writeString(m_out, str, length);
+          break;
+        }
+        case DUK_TYPE_OBJECT:
+          writeObject();
+          return;
+        default:
+          duk_type_error(m_ctx, "%s could not be cloned", duk_is_function(m_ctx, -1) ? "function" : "value");
+      }
+
+      duk_pop(m_ctx);
+    }
+
+    // [... object] -> [...]
+    void writeObject() {
+      if (duk_is_callable(m_ctx, -1)) {
+        duk_type_error(m_ctx, "function could not be cloned");
+      }
+
+      void *ptr = duk_get_heapptr(m_ctx, -1);
+      auto it = m_objectIndexes.find(ptr);
+      if (it != m_objectIndexes.end()) {
+        writeObjectRef(m_out, it->second);
+        duk_pop(m_ctx);
+        return;
+      }
+      if (m_depth >= MAX_DEPTH) {
+        duk_range_error(m_ctx, "structured clone recursion limit");
+      }
+
+      const auto index = static_cast<duk_uarridx_t>(m_objectIndexes.size());
+      m_objectIndexes.emplace(ptr, index);
+      duk_dup(m_ctx, -1);
+      duk_put_prop_index(m_ctx, m_objectsIdx, index);
+
+      ++m_depth;
+      const Prototype *prototype = findPrototype();
+      if (duk_is_array(m_ctx, -1)) {
+        writeArray();
+      } else if (prototype != nullptr && prototype->objectClass == ObjectClass::Date) {
+        writeDate(*prototype);
+      } else if (duk_is_buffer_data(m_ctx, -1)) {
+        if (prototype == nullptr) {
+          duk_type_error(m_ctx, "buffer could not be cloned");
+        }
+        writeBuffer(*prototype);
+      } else {
+        writeProperties();
+      }
+      --m_depth;
+
+      duk_pop(m_ctx);
+    }
+
+    // Return nullptr for plain objects
+    const Prototype *findPrototype() {
+      duk_get_prototype(m_ctx, -1);
+      void *ptr = duk_get_heapptr(m_ctx, -1);
+      duk_pop(m_ctx);
+
+      if (ptr != nullptr) {
+        for (const Prototype &prototype : m_prototypes) {
+          if (prototype.ptr == ptr) {
+            return &prototype;
+          }
+        }
+      }
+      return nullptr;
+    }
+
+    // [... array] -> [... array]
+    void writeArray() {
+      const duk_idx_t arrayIdx = duk_get_top_index(m_ctx);
+      const auto length = static_cast<duk_uarridx_t>(duk_get_length(m_ctx, arrayIdx));
+
+      writeTag(m_out, Tag::Array);
+      writeVarUint(m_out, length);
+      for (duk_uarridx_t i = 0; i < length; ++i) {
+        duk_get_prop_index(m_ctx, arrayIdx, i);
+        write();
+      }
+    }
+
+    // [... date] -> [... date]
+    void writeDate(const Prototype &prototype) {
+      duk_get_prop_string(m_ctx, prototype.idx, "getTime");
+      duk_dup(m_ctx, -2);
+      duk_call_method(m_ctx, 0);
+
+      writeTag(m_out, Tag::Date);
+      writeDouble(m_out, duk_get_number(m_ctx, -1));
+      duk_pop(m_ctx);
+    }
+
+    // [... buffer] -> [... buffer]
+    void writeBuffer(const Prototype &prototype) {
+      if (prototype.objectClass == ObjectClass::ArrayBuffer) {
+        duk_size_t size;
+        const void *data = duk_get_buffer_data(m_ctx, -1, &size);
+        writeArrayBufferData(m_out, data, size);
+        return;
+      }
+
+      const duk_idx_t viewIdx = duk_get_top_index(m_ctx);
+      callViewGetter(viewIdx, VIEW_BYTE_OFFSET_GETTER_NAME);
+      callViewGetter(viewIdx, VIEW_BYTE_LENGTH_GETTER_NAME);
+      writeViewHeader(m_out, prototype.viewKind, duk_get_uint(m_ctx, -2), duk_get_uint(m_ctx, -1));
+      duk_pop_2(m_ctx);
+
+      callViewGetter(viewIdx, VIEW_BUFFER_GETTER_NAME);
+      write();
+    }
+
+    // [...] -> [... value]
+    void callViewGetter(duk_idx_t viewIdx, const char *getterName) {
+      pushIntrinsic(m_ctx, getterName);
+      duk_dup(m_ctx, viewIdx);
+      duk_call_method(m_ctx, 0);
+    }
+
+    // [... object] -> [... object]
+    void writeProperties() {
+      duk_enum(m_ctx, -1, DUK_ENUM_OWN_PROPERTIES_ONLY);
+
+      writeTag(m_out, Tag::Object);
+      while (duk_next(m_ctx, -1, 1 /*get_value*/)) {
+        // [... object enum key value]
+        duk_size_t length;
+        const char *key = duk_get_lstring(m_ctx, -2, &length);
+        writeKey(m_out, key, length);
+        write();
+        duk_pop(m_ctx);  // key
+      }
+      writeEndOfObject(m_out);
+
+      duk_pop(m_ctx);  // enum
+    }
+
+    duk_context *m_ctx;
+    std::string &m_out;
+    duk_idx_t m_objectsIdx = 0;
+    size_t m_depth = 0;
+    std::vector<Prototype> m_prototypes;
+    std::unordered_map<void *, duk_uarridx_t> m_objectIndexes;
+  };
+
+  class ValueReader {
+  public:
+    ValueReader(duk_context *ctx, const std::string &buffer)
+     : m_ctx(ctx)
+     , m_reader(buffer) {
+    }
+
+    // [...] -> [... value]
+    void run() {
+      // Read objects, by index
+      duk_push_bare_array(m_ctx);
+      m_objectsIdx = duk_get_top_index(m_ctx);
+
+      read(0);
+      if (!m_reader.atEnd()) {
+        malformed();
+      }
+
+      duk_remove(m_ctx, m_objectsIdx);
+    }
+
+  private:
+    // [...] -> [... value]
+    void read(size_t depth) {
+      duk_require_stack(m_ctx, 4);
+
+      Tag tag;
+      if (!m_reader.readTag(tag)) {
+        malformed();
+      }
+
+      switch (tag) {
+        case Tag::Undefined:
+          duk_push_undefined(m_ctx);
+          return;
+        case Tag::Null:
+          duk_push_null(m_ctx);
+          return;
+        case Tag::False:
+        case Tag::True:
+          duk_push_boolean(m_ctx, tag == Tag::True);
+          return;
+        case Tag::Int32: {
+          int32_t i;
+          if (!m_reader.readInt32(i)) {
+            malformed();
+          }
+          duk_push_int(m_ctx, i);
+          return;
+        }
+        case Tag::Double: {
+          double d;
+          if (!m_reader.readDouble(d)) {
+            malformed();
+          }
+          duk_push_number(m_ctx, d);
+          return;
+        }
+        case Tag::String: {
+          const char *s;
+          size_t length;
+          if (!m_reader.readBytes(s, length)) {
+            malformed();
+          }
+          duk_push_lstring(m_ctx, s, length);
+          return;
+        }
+        case Tag::Array:
+          checkDepth(depth);
+          readArray(depth + 1);
+          return;
+        case Tag::Object:
+          checkDepth(depth);
+          readProperties(depth + 1);
+          return;
+        case Tag::ObjectRef: {
+          uint64_t index;
+          if (!m_reader.readVarUint(index) || index >= m_objectCount) {
+            malformed();
+          }
+          duk_get_prop_index(m_ctx, m_objectsIdx, static_cast<duk_uarridx_t>(index));
+          return;
+        }
+        case Tag::Date: {
+          double time;
+          if (!m_reader.readDouble(time)) {
+            malformed();
+          }
+          pushIntrinsic(m_ctx, "Date");
+          duk_push_number(m_ctx, time);
+          duk_new(m_ctx, 1);
+          registerObject(m_objectCount++);
+          return;
+        }
+        case Tag::ArrayBuffer: {
+          const char *s;
+          size_t length;
+          if (!m_reader.readBytes(s, length)) {
+            malformed();
+          }
+          void *data = duk_push_fixed_buffer(m_ctx, length);
+          memcpy(data, s, length);
+          duk_push_buffer_object(m_ctx, -1, 0, length, DUK_BUFOBJ_ARRAYBUFFER);
+          duk_remove(m_ctx, -2);  // plain buffer
+          registerObject(m_objectCount++);
+          return;
+        }
+        case Tag::ArrayBufferView:
+          checkDepth(depth);
+          readView(depth + 1);
+          return;
+        case Tag::Map:
+        case Tag::Set:
+        case Tag::EndOfEntries:
+          // No Map/Set in Duktape
+          break;
+      }
+
+      malformed();
+    }
+
+    // [...] -> [... array]
+    void readArray(size_t depth) {
+      uint64_t length;
+      if (!m_reader.readLength(length)) {
+        malformed();
+      }
+
+      duk_push_array(m_ctx);
+      registerObject(m_objectCount++);
+      for (uint64_t i = 0; i < length; ++i) {
+        read(depth);
+        duk_put_prop_index(m_ctx, -2, static_cast<duk_uarridx_t>(i));
+      }
+    }
+
+    // [...] -> [... object]
+    void readProperties(size_t depth) {
+      duk_push_object(m_ctx);
+      registerObject(m_objectCount++);
+
+      while (true) {
+        const char *key;
+        size_t length;
+        bool isEnd;
+        if (!m_reader.readKey(key, length, isEnd)) {
+          malformed();
+        }
+        if (isEnd) {
+          break;
+        }
+
+        duk_push_lstring(m_ctx, key, length);
+        read(depth);
+        // Defined (and not set) so that e.g. "__proto__" does not change the prototype
+        duk_def_prop(m_ctx, -3, DUK_DEFPROP_HAVE_VALUE | DUK_DEFPROP_SET_WRITABLE | DUK_DEFPROP_SET_ENUMERABLE | DUK_DEFPROP_SET_CONFIGURABLE);
+      }
+    }
+
+    // [...] -> [... view]
+    void readView(size_t depth) {
+      uint8_t viewKind;
+      uint64_t byteOffset, byteLength;
+      if (!m_reader.readViewHeader(viewKind, byteOffset, byteLength)) {
+        malformed();
+      }
+
+      // The view is indexed before its buffer
+      const duk_uarridx_t index = m_objectCount++;
+
+      read(depth);
+      duk_size_t bufferSize;
+      if (!duk_is_object(m_ctx, -1) || duk_get_buffer_data(m_ctx, -1, &bufferSize) == nullptr ||
+          !isValidView(viewKind, byteOffset, byteLength, bufferSize)) {
+        malformed();
+      }
+
+      duk_push_buffer_object(m_ctx, -1, static_cast<duk_size_t>(byteOffset), static_cast<duk_size_t>(byteLength),
+                             DUK_BUFOBJ_DATAVIEW + viewKind);
+      duk_remove(m_ctx, -2);  // buffer
+      registerObject(index);
+    }
+
+    // [... object] -> [... object]
+    void registerObject(duk_uarridx_t index) {
+      duk_dup(m_ctx, -1);
+      duk_put_prop_index(m_ctx, m_objectsIdx, index);
+    }
+
+    void checkDepth(size_t depth) {
+      if (depth >= MAX_DEPTH) {
+        duk_range_error(m_ctx, "structured clone recursion limit");
+      }
+    }
+
+    void malformed() {
+      duk_type_error(m_ctx, "%s", MALFORMED_DATA_MESSAGE);
+    }
+
+    duk_context *m_ctx;
+    Reader m_reader;
+    duk_idx_t m_objectsIdx = 0;
+    duk_uarridx_t m_objectCount = 0;
+  };
+
+  extern "C"
+  duk_ret_t writeValue(duk_context *ctx, void *udata) {
+    Writer(ctx, *static_cast<std::string *>(udata)).run();
+    return 0;
+  }
+
+  extern "C"
+  duk_ret_t readValue(duk_context *ctx, void *udata) {
+    ValueReader(ctx, *static_cast<const std::string *>(udata)).run();
+    return 1;
+  }
+}
+
+void structured_clone_init(duk_context *ctx) {
+  duk_push_global_stash(ctx);
+  duk_push_bare_object(ctx);
+  for (const char *ctorName : INTRINSIC_CTOR_NAMES) {
+    duk_get_global_string(ctx, ctorName);
+    duk_put_prop_string(ctx, -2, ctorName);
+  }
+  for (const ViewInfo &viewInfo : VIEWS) {
+    duk_get_global_string(ctx, viewInfo.ctorName);
+    duk_put_prop_string(ctx, -2, viewInfo.ctorName);
+  }
+  duk_get_global_string(ctx, "DataView");
+  duk_get_prop_string(ctx, -1, "prototype");
+  for (const ViewGetter &viewGetter : VIEW_GETTERS) {
+    duk_push_string(ctx, viewGetter.propName);
+    duk_get_prop_desc(ctx, -2, 0);
+    duk_get_prop_string(ctx, -1, "get");
+    duk_put_prop_string(ctx, -5, viewGetter.intrinsicName);
+    duk_pop(ctx);  // descriptor
+  }
+  duk_pop_2(ctx);  // DataView prototype + DataView
+  duk_put_prop_string(ctx, -2, INTRINSICS_PROP_NAME);
+  duk_pop(ctx);  // global stash
+}
+
+duk_int_t structured_clone_write(duk_context *ctx, duk_idx_t idx, std::string &buffer) {
+  buffer.clear();
+
+  duk_dup(ctx, idx);
+  duk_int_t ret = duk_safe_call(ctx, writeValue, &buffer, 1 /*nargs*/, 1 /*nrets*/);
+  if (ret == DUK_EXEC_SUCCESS) {
+    duk_pop(ctx);  // (undefined) return value
+  } else {
+    buffer.clear();
+  }
+  return ret;
+}
+
+duk_int_t structured_clone_read(duk_context *ctx, const std::string &buffer) {
+  return duk_safe_call(ctx, readValue, const_cast<std::string *>(&buffer), 0 /*nargs*/, 1 /*nrets*/);
+}
+
+#elif defined(QUICKJS)
+
+namespace {
+  // Prototype methods used to fill the read Map/Set objects (also captured as intrinsics)
+  const char *MAP_ADDER_NAME = "Map.prototype.set";
+  const char *SET_ADDER_NAME = "Set.prototype.add";
+
+  void addIntrinsicMethod(JSContext *ctx, JSValueConst intrinsics, const char *ctorName, const char *methodName, const char *name) {
+    JSValue ctor = JS_GetPropertyStr(ctx, intrinsics, ctorName);
+    JSValue prototype = JS_GetPropertyStr(ctx, ctor, "prototype");
+    JS_SetPropertyStr(ctx, intrinsics, name, JS_GetPropertyStr(ctx, prototype, methodName));
+    JS_FreeValue(ctx, prototype);
+    JS_FreeValue(ctx, ctor);
+  }
+
+  void addIntrinsicGetter(JSContext *ctx, JSValueConst intrinsics, const char *ctorName, const char *propName, const char *name) {
+    JSValue ctor = JS_GetPropertyStr(ctx, intrinsics, ctorName);
+    JSValue prototype = JS_GetPropertyStr(ctx, ctor, "prototype");
+    JSAtom propAtom = JS_NewAtom(ctx, propName);
+    JSPropertyDescriptor desc;
+    if (JS_GetOwnProperty(ctx, &desc, prototype, propAtom) > 0) {
+      JS_SetPropertyStr(ctx, intrinsics, name, desc.getter);
+      JS_FreeValue(ctx, desc.setter);
+      JS_FreeValue(ctx, desc.value);
+    }
+    JS_FreeAtom(ctx, propAtom);
+    JS_FreeValue(ctx, prototype);
+    JS_FreeValue(ctx, ctor);
+  }
+
+  class Writer {
+  public:
+    Writer(JSContext *ctx, JSValueConst intrinsics, std::string &out)
+     : m_ctx(ctx)
+     , m_intrinsics(intrinsics)
+     , m_out(out) {
+    }
+
+    ~Writer() {
+      for (const auto &it : m_encodedKeys) {
+        JS_FreeAtom(m_ctx, it.first);
+      }
+      for (const Prototype &prototype : m_prototypes) {
+        JS_FreeValue(m_ctx, prototype.value);
+      }
+      for (JSValue object : m_objects) {
+        JS_FreeValue(m_ctx, object);
+      }
+    }
+
+    // Return -1 on exception
+    int run(JSValueConst val) {
+      int ret = addPrototype("Date", ObjectClass::Date, 0);
+      if (ret == 0) ret = addPrototype("Map", ObjectClass::Map, 0);
+      if (ret == 0) ret = addPrototype("Set", ObjectClass::Set, 0);
+      if (ret == 0) ret = addPrototype("ArrayBuffer", ObjectClass::ArrayBuffer, 0);
+      for (uint8_t viewKind = 0; viewKind < VIEW_COUNT && ret == 0; ++viewKind) {
+        ret = addPrototype(VIEWS[viewKind].ctorName, ObjectClass::ArrayBufferView, viewKind);
+      }
+
+      return ret < 0 ? -1 : write(val);
+    }
+
+  private:
+    struct Prototype {
+      JSValue value;
+      ObjectClass objectClass;
+      uint8_t viewKind;
+    };
+
+    int addPrototype(const char *ctorName, ObjectClass objectClass, uint8_t viewKind) {
+      JSValue ctor = JS_GetPropertyStr(m_ctx, m_intrinsics, ctorName);
+      if (JS_IsException(ctor)) {
+        return -1;
+      }
+      JSValue prototype = JS_IsObject(ctor) ? JS_GetPropertyStr(m_ctx, ctor, "prototype") : JS_UNDEFINED;
+      JS_FreeValue(m_ctx, ctor);
+      if (JS_IsException(prototype)) {
+        return -1;
+      }
+
+      if (JS_IsObject(prototype)) {
+        m_prototypes.push_back({ prototype, objectClass, viewKind });
+      } else {
+        JS_FreeValue(m_ctx, prototype);
+      }
+      return 0;
+    }
+
+    // Return -1 on exception
+    int write(JSValueConst val) {
+      switch (JS_VALUE_GET_NORM_TAG(val)) {
+        case JS_TAG_UNDEFINED:
+          writeTag(m_out, Tag::Undefined);
+          return 0;
+        case JS_TAG_NULL:
+          writeTag(m_out, Tag::Null);
+          return 0;
+        case JS_TAG_BOOL:
+          writeTag(m_out, JS_VALUE_GET_BOOL(val) ? Tag::True : Tag::False);
+          return 0;
+        case JS_TAG_INT:
+          writeNumber(m_out, JS_VALUE_GET_INT(val));
+          return 0;
+        case JS_TAG_FLOAT64:
+          writeNumber(m_out, JS_VALUE_GET_FLOAT64(val));
+          return 0;
+        case JS_TAG_STRING:
+          return writeStringValue(val);
+        case JS_TAG_OBJECT:
+          return writeObject(val);
+        default:
+          JS_ThrowTypeError(m_ctx, "%s could not be cloned", JS_IsSymbol(val) ? "Symbol" : "value");
+          return -1;
+      }
+    }
+
+    int writeObject(JSValueConst val) {
+      if (JS_IsFunction(m_ctx, val)) {
+        JS_ThrowTypeError(m_ctx, "function could not be cloned");
+        return -1;
+      }
+
+      void *ptr = JS_VALUE_GET_PTR(val);
+      auto it = m_objectIndexes.find(ptr);
+      if (it != m_objectIndexes.end()) {
+        writeObjectRef(m_out, it->second);
+        return 0;
+      }
+      if (m_depth >= MAX_DEPTH) {
+        JS_ThrowRangeError(m_ctx, "structured clone recursion limit");
+        return -1;
+      }
+
+      // Written objects are kept alive so that their pointers stay unique
+      m_objectIndexes.emplace(ptr, static_cast<uint32_t>(m_objects.size()));
+      m_objects.push_back(JS_DupValue(m_ctx, val));
+
+      ++m_depth;
+      int ret = writeObjectContent(val);
+      --m_depth;
+      return ret;
+    }
+
+    int writeObjectContent(JSValueConst val) {
+      int ret = JS_IsArray(m_ctx, val);
+      if (ret != 0) {
+        return ret < 0 ? -1 : writeArray(val);
+      }
+
+      const Prototype *prototype;
+      if (findPrototype(val, prototype) < 0) {
+        return -1;
+      }
+      if (prototype == nullptr) {
+        return writeProperties(val);
+      }
+
+      switch (prototype->objectClass) {
+        case ObjectClass::Date:
+          return writeDate(val, *prototype);
+        case ObjectClass::Map:
+          return writeEntries(val, *prototype, Tag::Map, "entries");
+        case ObjectClass::Set:
+          return writeEntries(val, *prototype, Tag::Set, "values");
+        case ObjectClass::ArrayBuffer:
+          return writeArrayBuffer(val);
+        case ObjectClass::ArrayBufferView:
+          return writeView(val, prototype->viewKind);
+      }
+      return writeProperties(val);
+    }
+
+    // prototype is set to nullptr for plain objects
+    int findPrototype(JSValueConst val, const Prototype *&prototype) {
+      JSValue prototypeValue = JS_GetPrototype(m_ctx, val);
+      if (JS_IsException(prototypeValue)) {
+        return -1;
+      }
+      JS_FreeValue(m_ctx, prototypeValue);  // only the pointer is compared
+
+      prototype = nullptr;
+      if (JS_IsObject(prototypeValue)) {
+        for (const Prototype &p : m_prototypes) {
+          if (JS_VALUE_GET_PTR(p.value) == JS_VALUE_GET_PTR(prototypeValue)) {
+            prototype = &p;
+            break;
+          }
+        }
+      }
+      return 0;
+    }
+
+    int writeArray(JSValueConst val) {
+      int64_t length;
+      JSValue lengthValue = JS_GetPropertyStr(m_ctx, val, "length");
+      int ret = JS_ToInt64(m_ctx, &length, lengthValue);
+      JS_FreeValue(m_ctx, lengthValue);
+      if (ret < 0) {
+        return -1;
+      }
+
+      writeTag(m_out, Tag::Array);
+      writeVarUint(m_out, static_cast<uint64_t>(length));
+      for (int64_t i = 0; i < length; ++i) {
+        if (writeItem(val, static_cast<uint32_t>(i)) < 0) {
+          return -1;
+        }
+      }
+      return 0;
+    }
+
+    int writeItem(JSValueConst val, uint32_t index) {
+      JSValue item = JS_GetPropertyUint32(m_ctx, val, index);
+      if (JS_IsException(item)) {
+        return -1;
+      }
+      int ret = write(item);
+      JS_FreeValue(m_ctx, item);
+      return ret;
+    }
+
+    int writeDate(JSValueConst val, const Prototype &prototype) {
+      JSValue getTime = JS_GetPropertyStr(m_ctx, prototype.value, "getTime");
+      JSValue timeValue = JS_Call(m_ctx, getTime, val, 0, nullptr);
+      JS_FreeValue(m_ctx, getTime);
+
+      double time;
+      int ret = JS_IsException(timeValue) ? -1 : JS_ToFloat64(m_ctx, &time, timeValue);
+      JS_FreeValue(m_ctx, timeValue);
+      if (ret < 0) {
+        return -1;
+      }
+
+      writeTag(m_out, Tag::Date);
+      writeDouble(m_out, time);
+      return 0;
+    }
+
+    // Map/Set entries, iterated with the prototype method (so that it cannot be overridden by the
+    // instance)
+    int writeEntries(JSValueConst val, const Prototype &prototype, Tag tag, const char *iteratorMethodName) {
+      JSValue iteratorMethod = JS_GetPropertyStr(m_ctx, prototype.value, iteratorMethodName);
+      JSValue iterator = JS_Call(m_ctx, iteratorMethod, val, 0, nullptr);
+      JS_FreeValue(m_ctx, iteratorMethod);
+      if (JS_IsException(iterator)) {
+        return -1;
+      }
+      JSValue next = JS_GetPropertyStr(m_ctx, iterator, "next");
+
+      writeTag(m_out, tag);
+      int ret = JS_IsException(next) ? -1 : 0;
+      while (ret == 0) {
+        JSValue result = JS_Call(m_ctx, next, iterator, 0, nullptr);
+        if (JS_IsException(result)) {
+          ret = -1;
+          break;
+        }
+
+        JSValue doneValue = JS_GetPropertyStr(m_ctx, result, "done");
+        const int done = JS_ToBool(m_ctx, doneValue);
+        JS_FreeValue(m_ctx, doneValue);
+        if (done != 0) {
+          JS_FreeValue(m_ctx, result);
+          ret = done < 0 ? -1 : 0;
+          break;
+        }
+
+        JSValue value = JS_GetPropertyStr(m_ctx, result, "value");
+        JS_FreeValue(m_ctx, result);
+        if (JS_IsException(value)) {
+          ret = -1;
+        } else if (tag == Tag::Map) {
+          // [key, value]
+          ret = writeItem(value, 0);
+          if (ret == 0) ret = writeItem(value, 1);
+        } else {
+          ret = write(value);
+        }
+        JS_FreeValue(m_ctx, value);
+      }
+      writeTag(m_out, Tag::EndOfEntries);
+
+      JS_FreeValue(m_ctx, next);
+      JS_FreeValue(m_ctx, iterator);
+      return ret;
+    }
+
+    int writeArrayBuffer(JSValueConst val) {
+      size_t size;
+      const uint8_t *data = JS_GetArrayBuffer(m_ctx, &size, val);
+      if (data == nullptr) {
+        return -1;
+      }
+      writeArrayBufferData(m_out, data, size);
+      return 0;
+    }
+
+    int writeView(JSValueConst val, uint8_t viewKind) {
+      JSValue buffer;
+      uint64_t byteOffset, byteLength;
+
+      if (viewKind == DATA_VIEW_KIND) {
+        if (getViewIndex(val, VIEW_BYTE_OFFSET_GETTER_NAME, byteOffset) < 0 || getViewIndex(val, VIEW_BYTE_LENGTH_GETTER_NAME, byteLength) < 0) {
+          return -1;
+        }
+        buffer = callViewGetter(val, VIEW_BUFFER_GETTER_NAME);
+      } else {
+        size_t typedArrayOffset, typedArrayLength;
+        buffer = JS_GetTypedArrayBuffer(m_ctx, val, &typedArrayOffset, &typedArrayLength, nullptr);
+        byteOffset = typedArrayOffset;
+        byteLength = typedArrayLength;
+      }
+      if (JS_IsException(buffer)) {
+        return -1;
+      }
+
+      writeViewHeader(m_out, viewKind, byteOffset, byteLength);
+      int ret = write(buffer);
+      JS_FreeValue(m_ctx, buffer);
+      return ret;
+    }
+
+    JSValue callViewGetter(JSValueConst val, const char *getterName) {
+      JSValue getter = JS_GetPropertyStr(m_ctx, m_intrinsics, getterName);
+      JSValue ret = JS_Call(m_ctx, getter, val, 0, nullptr);
+      JS_FreeValue(m_ctx, getter);
+      return ret;
+    }
+
+    int getViewIndex(JSValueConst val, const char *getterName, uint64_t &index) {
+      JSValue indexValue = callViewGetter(val, getterName);
+      int64_t i;
+      int ret = JS_ToInt64(m_ctx, &i, indexValue);
+      JS_FreeValue(m_ctx, indexValue);
+      if (ret < 0) {
+        return -1;
+      }
+      index = i < 0 ? 0 : static_cast<uint64_t>(i);
+      return 0;
+    }
+
+    int writeProperties(JSValueConst val) {
+      JSPropertyEnum *properties;
+      uint32_t count;
+      if (JS_GetOwnPropertyNames(m_ctx, &properties, &count, val, JS_GPN_STRING_MASK | JS_GPN_ENUM_ONLY) < 0) {
+        return -1;
+      }
+
+      int ret = 0;
+      writeTag(m_out, Tag::Object);
+      for (uint32_t i = 0; i < count && ret == 0; ++i) {
+        const JSAtom atom = properties[i].atom;
+        JSValue item = JS_GetProperty(m_ctx, val, atom);
+        if (JS_IsException(item)) {
+          ret = -1;
+          break;
+        }
+
+        ret = writeEncodedKey(atom);
+        if (ret == 0) {
+          ret = write(item);
+        }
+        JS_FreeValue(m_ctx, item);
+      }
+      writeEndOfObject(m_out);
+
+      for (uint32_t i = 0; i < count; ++i) {
+        JS_FreeAtom(m_ctx, properties[i].atom);
+      }
+      js_free(m_ctx, properties);
+      return ret;
+    }
+
+    // Encoded keys are cached as the same keys are usually written many times (e.g. in arrays)
+    int writeEncodedKey(JSAtom atom) {
+      auto it = m_encodedKeys.find(atom);
+      if (it == m_encodedKeys.end()) {
+        JSValue keyValue = JS_AtomToString(m_ctx, atom);
+        size_t length;
+        const char *str = JS_ToCStringLen(m_ctx, &length, keyValue);
+        JS_FreeValue(m_ctx, keyValue);
+        if (str == nullptr) {
+          return -1;
+        }
+        std::string encodedKey;
+        writeKey(encodedKey, str, length);
+        JS_FreeCString(m_ctx, str);
+        it = m_encodedKeys.emplace(JS_DupAtom(m_ctx, atom), std::move(encodedKey)).first;
+      }
+
+      m_out += it->second;
+      return 0;
+    }
+
+    int writeStringValue(JSValueConst v) {
+      size_t length;
+      const char *str = JS_ToCStringLen(m_ctx, &length, v);
+      if (str == nullptr) {
+        return -1;
+      }
+      writeString(m_out, str, length);
+      JS_FreeCString(m_ctx, str);
+      return 0;
+    }
+
+    JSContext *m_ctx;
+    JSValueConst m_intrinsics;
+    std::string &m_out;
+    size_t m_depth = 0;
+    std::vector<Prototype> m_prototypes;
+    std::vector<JSValue> m_objects;
+    std::unordered_map<void *, uint32_t> m_objectIndexes;
+    std::unordered_map<JSAtom, std::string> m_encodedKeys;
+  };
+
+  class ValueReader {
+  public:
+    ValueReader(JSContext *ctx, JSValueConst intrinsics, const std::string &buffer)
+     : m_ctx(ctx)
+     , m_reader(buffer)
+     , m_intrinsics(intrinsics) {
+    }
+
+    ~ValueReader() {
+      for (JSValue object : m_objects) {
+        JS_FreeValue(m_ctx, object);
+      }
+    }
+
+    JSValue run() {
+      JSValue val = read(0);
+      if (!JS_IsException(val) && !m_reader.atEnd()) {
+        JS_FreeValue(m_ctx, val);
+        return malformed();
+      }
+      return val;
+    }
+
+  private:
+    JSValue read(size_t depth) {
+      Tag tag;
+      if (!m_reader.readTag(tag)) {
+        return malformed();
+      }
+
+      switch (tag) {
+        case Tag::Undefined:
+          return JS_UNDEFINED;
+        case Tag::Null:
+          return JS_NULL;
+        case Tag::False:
+          return JS_FALSE;
+        case Tag::True:
+          return JS_TRUE;
+        case Tag::Int32: {
+          int32_t i;
+          return m_reader.readInt32(i) ? JS_NewInt32(m_ctx, i) : malformed();
+        }
+        case Tag::Double: {
+          double d;
+          return m_reader.readDouble(d) ? JS_NewFloat64(m_ctx, d) : malformed();
+        }
+        case Tag::String: {
+          const char *s;
+          size_t length;
+          return m_reader.readBytes(s, length) ? JS_NewStringLen(m_ctx, s, length) : malformed();
+        }
+        case Tag::ObjectRef: {
+          uint64_t index;
+          if (!m_reader.readVarUint(index) || index >= m_objects.size()) {
+            return malformed();
+          }
+          return JS_DupValue(m_ctx, m_objects[index]);
+        }
+        case Tag::Date: {
+          double time;
+          if (!m_reader.readDouble(time)) {
+            return malformed();
+          }
+          JSValue timeValue = JS_NewFloat64(m_ctx, time);
+          return registerObject(construct("Date", 1, &timeValue));
+        }
+        case Tag::ArrayBuffer: {
+          const char *s;
+          size_t length;
+          if (!m_reader.readBytes(s, length)) {
+            return malformed();
+          }
+          return registerObject(JS_NewArrayBufferCopy(m_ctx, reinterpret_cast<const uint8_t *>(s), length));
+        }
+        case Tag::EndOfEntries:
+          break;
+        default:
+          // Objects
+          if (depth >= MAX_DEPTH) {
+            return JS_ThrowRangeError(m_ctx, "structured clone recursion limit");
+          }
+          return readObject(tag, depth + 1);
+      }
+
+      return malformed();
+    }
+
+    JSValue readObject(Tag tag, size_t depth) {
+      switch (tag) {
+        case Tag::Array:
+          return readArray(depth);
+        case Tag::Object:
+          return readProperties(depth);
+        case Tag::ArrayBufferView:
+          return readView(depth);
+        case Tag::Map:
+          return readEntries(depth, "Map", MAP_ADDER_NAME, 2);
+        case Tag::Set:
+          return readEntries(depth, "Set", SET_ADDER_NAME, 1);
+        default:
+          return malformed();
+      }
+    }
+
+    JSValue readArray(size_t depth) {
+      uint64_t length;
+      if (!m_reader.readLength(length)) {
+        return malformed();
+      }
+
+      JSValue array = registerObject(JS_NewArray(m_ctx));
+      for (uint64_t i = 0; i < length && !JS_IsException(array); ++i) {
+        JSValue item = read(depth);
+        if (JS_IsException(item) ||
+            JS_DefinePropertyValueUint32(m_ctx, array, static_cast<uint32_t>(i), item, JS_PROP_C_W_E) < 0) {
+          JS_FreeValue(m_ctx, array);
+          array = JS_EXCEPTION;
+        }
+      }
+      return array;
+    }
+
+    JSValue readProperties(size_t depth) {
+      JSValue obj = registerObject(JS_NewObject(m_ctx));
+
+      while (!JS_IsException(obj)) {
+        const char *key;
+        size_t length;
+        bool isEnd;
+        if (!m_reader.readKey(key, length, isEnd)) {
+          JS_FreeValue(m_ctx, obj);
+          return malformed();
+        }
+        if (isEnd) {
+          break;
+        }
+
+        JSAtom atom = JS_NewAtomLen(m_ctx, key, length);
+        if (atom == JS_ATOM_NULL) {
+          JS_FreeValue(m_ctx, obj);
+          return JS_EXCEPTION;
+        }
+
+        // Defined (and not set) so that e.g. "__proto__" does not change the prototype
+        JSValue item = read(depth);
+        if (JS_IsException(item) || JS_DefinePropertyValue(m_ctx, obj, atom, item, JS_PROP_C_W_E) < 0) {
+          JS_FreeValue(m_ctx, obj);
+          obj = JS_EXCEPTION;
+        }
+        JS_FreeAtom(m_ctx, atom);
+      }
+      return obj;
+    }
+
+    JSValue readView(size_t depth) {
+      uint8_t viewKind;
+      uint64_t byteOffset, byteLength;
+      if (!m_reader.readViewHeader(viewKind, byteOffset, byteLength)) {
+        return malformed();
+      }
+
+      // The view is indexed before its buffer
+      const size_t index = m_objects.size();
+      m_objects.push_back(JS_UNDEFINED);
+
+      JSValue buffer = read(depth);
+      if (JS_IsException(buffer)) {
+        return JS_EXCEPTION;
+      }
+      size_t bufferSize;
+      if (JS_GetArrayBuffer(m_ctx, &bufferSize, buffer) == nullptr) {
+        JS_FreeValue(m_ctx, buffer);
+        return JS_EXCEPTION;
+      }
+      if (!isValidView(viewKind, byteOffset, byteLength, bufferSize)) {
+        JS_FreeValue(m_ctx, buffer);
+        return malformed();
+      }
+
+      const ViewInfo &viewInfo = VIEWS[viewKind];
+      JSValue args[] = {
+        buffer,
+        JS_NewInt64(m_ctx, static_cast<int64_t>(byteOffset)),
+        JS_NewInt64(m_ctx, static_cast<int64_t>(byteLength / viewInfo.elementSize))
+      };
+      JSValue view = construct(viewInfo.ctorName, 3, args);
+      JS_FreeValue(m_ctx, buffer);
+
+      if (!JS_IsException(view)) {
+        m_objects[index] = JS_DupValue(m_ctx, view);
+      }
+      return view;
+    }
+
+    JSValue readEntries(size_t depth, const char *ctorName, const char *adderName, int argc) {
+      JSValue collection = registerObject(construct(ctorName, 0, nullptr));
+      if (JS_IsException(collection)) {
+        return JS_EXCEPTION;
+      }
+
+      JSValue adder = JS_GetPropertyStr(m_ctx, m_intrinsics, adderName);
+      bool ok = !JS_IsException(adder);
+      while (ok) {
+        bool isEnd;
+        if (!m_reader.readEndOfEntries(isEnd)) {
+          malformed();
+          ok = false;
+          break;
+        }
+        if (isEnd) {
+          break;
+        }
+
+        // Map: key + value, Set: value
+        JSValue args[2] = { JS_UNDEFINED, JS_UNDEFINED };
+        for (int i = 0; i < argc && ok; ++i) {
+          args[i] = read(depth);
+          ok = !JS_IsException(args[i]);
+        }
+        if (ok) {
+          JSValue ret = JS_Call(m_ctx, adder, collection, argc, args);
+          ok = !JS_IsException(ret);
+          JS_FreeValue(m_ctx, ret);
+        }
+        JS_FreeValue(m_ctx, args[0]);
+        JS_FreeValue(m_ctx, args[1]);
+      }
+      JS_FreeValue(m_ctx, adder);
+
+      if (!ok) {
+        JS_FreeValue(m_ctx, collection);
+        return JS_EXCEPTION;
+      }
+      return collection;
+    }
+
+    JSValue construct(const char *ctorName, int argc, JSValueConst *argv) {
+      JSValue ctor = JS_GetPropertyStr(m_ctx, m_intrinsics, ctorName);
+      if (JS_IsException(ctor)) {
+        return JS_EXCEPTION;
+      }
+      JSValue ret = JS_CallConstructor(m_ctx, ctor, argc, argv);
+      JS_FreeValue(m_ctx, ctor);
+      return ret;
+    }
+
+    // Read objects are kept alive so that they can be referenced
+    JSValue registerObject(JSValue obj) {
+      if (!JS_IsException(obj)) {
+        m_objects.push_back(JS_DupValue(m_ctx, obj));
+      }
+      return obj;
+    }
+
+    JSValue malformed() {
+      return JS_ThrowTypeError(m_ctx, "%s", MALFORMED_DATA_MESSAGE);
+    }
+
+    JSContext *m_ctx;
+    Reader m_reader;
+    JSValueConst m_intrinsics;
+    std::vector<JSValue> m_objects;
+  };
+}
+
+JSValue structured_clone_new_intrinsics(JSContext *ctx) {
+  JSValue globalObject = JS_GetGlobalObject(ctx);
+  JSValue intrinsics = JS_NewObjectProto(ctx, JS_NULL);
+  for (const char *ctorName : INTRINSIC_CTOR_NAMES) {
+    JS_SetPropertyStr(ctx, intrinsics, ctorName, JS_GetPropertyStr(ctx, globalObject, ctorName));
+  }
+  for (const ViewInfo &viewInfo : VIEWS) {
+    JS_SetPropertyStr(ctx, intrinsics, viewInfo.ctorName, JS_GetPropertyStr(ctx, globalObject, viewInfo.ctorName));
+  }
+  addIntrinsicMethod(ctx, intrinsics, "Map", "set", MAP_ADDER_NAME);
+  addIntrinsicMethod(ctx, intrinsics, "Set", "add", SET_ADDER_NAME);
+  for (const ViewGetter &viewGetter : VIEW_GETTERS) {
+    addIntrinsicGetter(ctx, intrinsics, "DataView", viewGetter.propName, viewGetter.intrinsicName);
+  }
+  JS_FreeValue(ctx, globalObject);
+  return intrinsics;
+}
+
+int structured_clone_write(JSContext *ctx, JSValueConst intrinsics, JSValueConst v, std::string &buffer) {
+  buffer.clear();
+
+  int ret = Writer(ctx, intrinsics, buffer).run(v);
+  if (ret < 0) {
+    buffer.clear();
+  }
+  return ret;
+}
+
+JSValue structured_clone_read(JSContext *ctx, JSValueConst intrinsics, const std::string &buffer) {
+  return ValueReader(ctx, intrinsics, buffer).run();
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_STRUCTURED_CLONE_H
+#define _JSBRIDGE_STRUCTURED_CLONE_H
+
+#include <string>
+
+// Native serializer for the values exchanged between JS contexts (e.g. worker messages), following
+// the structured clone algorithm: the JS value is written into a compact binary buffer which can
+// be read by another JS context of the same engine, without going through JSON.
+//
+// Supported values: undefined, null, booleans, numbers, strings, arrays, objects (own enumerable
+// string-keyed properties), Date, ArrayBuffer, typed arrays, DataView, Map and Set (QuickJS only).
+// Shared references and cycles are preserved. Functions and symbols cannot be cloned (TypeError).
+//
+// The buffer is cleared first, so that it can be re-used between calls.
+//
+// Date, Map, Set and the typed arrays are created with the constructors (and methods) captured
+// when the context is created, so that overriding the globals from JS has no effect.
+
+#if defined(DUKTAPE)
+
+# include "duktape/duktape.h"
+
+// Capture the intrinsic constructors (in the global stash), before any user code is evaluated
+void structured_clone_init(duk_context *);
+
+// [... value ...] -> [... value ...] and DUK_EXEC_SUCCESS
+// [... value ...] -> [... value ... error] and DUK_EXEC_ERROR
+duk_int_t structured_clone_write(duk_context *, duk_idx_t, std::string &buffer);
+
+// [...] -> [... value] and DUK_EXEC_SUCCESS
+// [...] -> [... error] and DUK_EXEC_ERROR
+duk_int_t structured_clone_read(duk_context *, const std::string &buffer);
+
+#elif defined(QUICKJS)
+
+# include "quickjs/quickjs.h"
+
+// Return an object holding the intrinsic constructors, to be created before any user code is
+// evaluated and given to structured_clone_write() and structured_clone_read()
+JSValue structured_clone_new_intrinsics(JSContext *);
+
+// Return -1 if a JS exception has been thrown
+int structured_clone_write(JSContext *, JSValueConst intrinsics, JSValueConst, std::string &buffer);
+
+// Return JS_EXCEPTION if a JS exception has been thrown
+JSValue structured_clone_read(JSContext *, JSValueConst intrinsics, const std::string &buffer);
+
+#endif
+#endif
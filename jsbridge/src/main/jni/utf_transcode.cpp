@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utf_transcode.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+#endif
+
+namespace {
+  const char16_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+  inline bool isContinuationByte(uint8_t b) {
+    return (b & 0xC0) == 0x80;
+  }
+
+  // Widen the leading ASCII characters of s to UTF-16 and return their count
+  size_t widenAscii(const uint8_t *s, size_t length, char16_t *out) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+      if (_mm_movemask_epi8(v) != 0) break;
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_unpacklo_epi8(v, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8), _mm_unpackhi_epi8(v, zero));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 16 <= length; i += 16) {
+      const uint8x16_t v = vld1q_u8(s + i);
+      const uint8x8_t highBits = vand_u8(vorr_u8(vget_low_u8(v), vget_high_u8(v)), vdup_n_u8(0x80));
+      if (vget_lane_u64(vreinterpret_u64_u8(highBits), 0) != 0) break;
+      vst1q_u16(reinterpret_cast<uint16_t *>(out + i), vmovl_u8(vget_low_u8(v)));
+      vst1q_u16(reinterpret_cast<uint16_t *>(out + i + 8), vmovl_u8(vget_high_u8(v)));
+    }
+#else
+    for (; i + 8 <= length; i += 8) {
+      uint64_t word;
+      memcpy(&word, s + i, 8);
+      if ((word & 0x8080808080808080ULL) != 0) break;
+      for (size_t j = 0; j < 8; ++j) {
+        out[i + j] = s[i + j];
+      }
+    }
+#endif
+
+    for (; i < length && s[i] < 0x80; ++i) {
+      out[i] = s[i];
+    }
+    return i;
+  }
+
+  // Narrow the leading ASCII characters of s to UTF-8 and return their count
+  size_t narrowAscii(const char16_t *s, size_t length, uint8_t *out) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i nonAsciiMask = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+      const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i + 8));
+      const __m128i nonAscii = _mm_and_si128(_mm_or_si128(a, b), nonAsciiMask);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(nonAscii, zero)) != 0xFFFF) break;
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(a, b));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint16x8_t nonAsciiMask = vdupq_n_u16(0xFF80);
+    for (; i + 16 <= length; i += 16) {
+      const uint16x8_t a = vld1q_u16(reinterpret_cast<const uint16_t *>(s + i));
+      const uint16x8_t b = vld1q_u16(reinterpret_cast<const uint16_t *>(s + i + 8));
+      const uint16x8_t nonAscii = vandq_u16(vorrq_u16(a, b), nonAsciiMask);
+      const uint64x2_t nonAscii64 = vreinterpretq_u64_u16(nonAscii);
+      if ((vgetq_lane_u64(nonAscii64, 0) | vgetq_lane_u64(nonAscii64, 1)) != 0) break;
+      vst1q_u8(out + i, vcombine_u8(vmovn_u16(a), vmovn_u16(b)));
+    }
+#else
+    for (; i + 4 <= length; i += 4) {
+      uint64_t word;
+      memcpy(&word, s + i, 8);
+      if ((word & 0xFF80FF80FF80FF80ULL) != 0) break;
+      for (size_t j = 0; j < 4; ++j) {
+        out[i + j] = static_cast<uint8_t>(s[i + j]);
+      }
+    }
+#endif
+
+    for (; i < length && s[i] < 0x80; ++i) {
+      out[i] = static_cast<uint8_t>(s[i]);
+    }
+    return i;
+  }
+}
+
+size_t utf8_to_utf16(const char *s, size_t length, char16_t *out) {
+  auto p = reinterpret_cast<const uint8_t *>(s);
+  const uint8_t *end = p + length;
+  char16_t *q = out;
+
+  while (p < end) {
+    const uint8_t c = *p;
+
+    if (c < 0x80) {
+      const size_t asciiCount = widenAscii(p, static_cast<size_t>(end - p), q);
+      p += asciiCount;
+      q += asciiCount;
+      continue;
+    }
+
+    // Fast path for valid 3-byte sequences (e.g. CJK characters)
+    if ((c & 0xF0) == 0xE0 && end - p > 2 && isContinuationByte(p[1]) && isContinuationByte(p[2])) {
+      const uint32_t codePoint = ((c & 0x0Fu) << 12) | ((p[1] & 0x3Fu) << 6) | (p[2] & 0x3Fu);
+      if (codePoint >= 0x800) {
+        *q++ = static_cast<char16_t>(codePoint);
+        p += 3;
+        continue;
+      }
+    }
+
+    uint32_t codePoint;
+    int extraByteCount;
+    uint32_t minCodePoint;
+    if ((c & 0xE0) == 0xC0) {
+      codePoint = c & 0x1Fu;
+      extraByteCount = 1;
+      minCodePoint = 0x80;
+    } else if ((c & 0xF0) == 0xE0) {
+      codePoint = c & 0x0Fu;
+      extraByteCount = 2;
+      minCodePoint = 0x800;
+    } else if ((c & 0xF8) == 0xF0) {
+      codePoint = c & 0x07u;
+      extraByteCount = 3;
+      minCodePoint = 0x10000;
+    } else {
+      *q++ = REPLACEMENT_CHARACTER;
+      ++p;
+      continue;
+    }
+
+    if (end - p <= extraByteCount) {
+      // Truncated sequence
+      *q++ = REPLACEMENT_CHARACTER;
+      ++p;
+      continue;
+    }
+
+    bool isValid = true;
+    for (int i = 1; i <= extraByteCount; ++i) {
+      if (!isContinuationByte(p[i])) {
+        isValid = false;
+        break;
+      }
+      codePoint = (codePoint << 6) | (p[i] & 0x3Fu);
+    }
+
+    // Overlong sequences are invalid except for the NUL character of modified UTF-8 (0xC0 0x80)
+    if (!isValid || (codePoint < minCodePoint && !(extraByteCount == 1 && codePoint == 0)) || codePoint > 0x10FFFF) {
+      *q++ = REPLACEMENT_CHARACTER;
+      ++p;
+      continue;
+    }
+
+    p += extraByteCount + 1;
+
+    if (codePoint >= 0x10000) {
+      // A 4-byte sequence gives 2 UTF-16 units, so the output still fits in `length` units
+      codePoint -= 0x10000;
+      *q++ = static_cast<char16_t>(0xD800 + (codePoint >> 10));
+      *q++ = static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF));
+    } else {
+      *q++ = static_cast<char16_t>(codePoint);
+    }
+  }
+
+  return static_cast<size_t>(q - out);
+}
+
+void utf8_to_utf16(const char *s, size_t length, std::u16string &out) {
+  const size_t offset = out.size();
+  out.resize(offset + length);
+  out.resize(offset + utf8_to_utf16(s, length, &out[offset]));
+}
+
+size_t utf16_to_utf8(const char16_t *s, size_t length, bool cesu8, char *out) {
+  auto q = reinterpret_cast<uint8_t *>(out);
+
+  for (size_t i = 0; i < length; ++i) {
+    uint32_t c = s[i];
+
+    if (c < 0x80) {
+      const size_t asciiCount = narrowAscii(s + i, length - i, q);
+      q += asciiCount;
+      i += asciiCount - 1;
+      continue;
+    }
+
+    if (c < 0x800) {
+      *q++ = static_cast<uint8_t>(0xC0 | (c >> 6));
+      *q++ = static_cast<uint8_t>(0x80 | (c & 0x3F));
+      continue;
+    }
+
+    if (!cesu8 && c >= 0xD800 && c <= 0xDBFF && i + 1 < length && s[i + 1] >= 0xDC00 && s[i + 1] <= 0xDFFF) {
+      const uint32_t codePoint = 0x10000 + ((c - 0xD800) << 10) + (s[i + 1] - 0xDC00);
+      ++i;
+      *q++ = static_cast<uint8_t>(0xF0 | (codePoint >> 18));
+      *q++ = static_cast<uint8_t>(0x80 | ((codePoint >> 12) & 0x3F));
+      *q++ = static_cast<uint8_t>(0x80 | ((codePoint >> 6) & 0x3F));
+      *q++ = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+      continue;
+    }
+
+    // BMP character (or single surrogate)
+    *q++ = static_cast<uint8_t>(0xE0 | (c >> 12));
+    *q++ = static_cast<uint8_t>(0x80 | ((c >> 6) & 0x3F));
+    *q++ = static_cast<uint8_t>(0x80 | (c & 0x3F));
+  }
+
+  return static_cast<size_t>(q - reinterpret_cast<uint8_t *>(out));
+}
+
+void latin1_to_utf16(const unsigned char *s, size_t length, char16_t *out) {
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= length; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_unpacklo_epi8(v, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8), _mm_unpackhi_epi8(v, zero));
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  for (; i + 16 <= length; i += 16) {
+    const uint8x16_t v = vld1q_u8(s + i);
+    vst1q_u16(reinterpret_cast<uint16_t *>(out + i), vmovl_u8(vget_low_u8(v)));
+    vst1q_u16(reinterpret_cast<uint16_t *>(out + i + 8), vmovl_u8(vget_high_u8(v)));
+  }
+#endif
+
+  for (; i < length; ++i) {
+    out[i] = s[i];
+  }
+}
+
+void utf16_to_utf8(const char16_t *s, size_t length, bool cesu8, std::string &out) {
+  const size_t offset = out.size();
+  out.resize(offset + 3 * length);
+  out.resize(offset + utf16_to_utf8(s, length, cesu8, &out[offset]));
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_UTF_TRANSCODE_H
+#define _JSBRIDGE_UTF_TRANSCODE_H
+
+#include <cstddef>
+#include <string>
+
+// UTF-8 <-> UTF-16 conversions used for all the strings crossing the bridge.
+//
+// ASCII runs are converted 16 characters at a time (SSE2 on x86, NEON on ARM, 8-byte words
+// otherwise), other characters are decoded/encoded one by one.
+
+// Convert the given UTF-8 string into out, which must have room for `length` UTF-16 units, and
+// return the number of written units.
+// CESU-8 (surrogates encoded as 3-byte sequences, e.g. Duktape strings or JNI modified UTF-8) is
+// also accepted. Invalid sequences are replaced with U+FFFD.
+size_t utf8_to_utf16(const char *s, size_t length, char16_t *out);
+
+// Append the UTF-16 conversion of the given UTF-8 string to out.
+void utf8_to_utf16(const char *s, size_t length, std::u16string &out);
+
+// Convert the given UTF-16 string into out, which must have room for `3 * length` bytes, and
+// return the number of written bytes.
+// With cesu8 = true, the surrogates of a pair are encoded separately (Duktape internal encoding).
+size_t utf16_to_utf8(const char16_t *s, size_t length, bool cesu8, char *out);
+
+// Widen the given Latin-1 string into out, which must have room for `length` UTF-16 units.
+void latin1_to_utf16(const unsigned char *s, size_t length, char16_t *out);
+
+// Append the UTF-8 conversion of the given UTF-16 string to out.
+void utf16_to_utf8(const char16_t *s, size_t length, bool cesu8, std::string &out);
+
+#endif
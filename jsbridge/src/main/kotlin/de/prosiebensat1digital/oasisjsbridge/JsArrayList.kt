@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import de.prosiebensat1digital.oasisjsbridge.JsBridgeError.JsValueEvaluationError
+import java.util.concurrent.atomic.AtomicReferenceArray
+
+// Java List view of a JS array (created from JNI for a LazyList parameter or return value):
+// - the JS array is held by the given JsValue (i.e. as long as the list is alive)
+// - its length is read once, when the list is created
+// - the elements are converted on first access (and then cached)
+//
+// Note: reading an element from another thread blocks until the JS context is available.
+internal class JsArrayList<T>(
+    val jsArray: JsValue,
+    private val elementParameter: Parameter?,
+    override val size: Int
+) : AbstractList<T>() {
+
+    private val elements = AtomicReferenceArray<Any?>(size)
+
+    override fun get(index: Int): T {
+        if (index < 0 || index >= size) {
+            throw IndexOutOfBoundsException("Index: $index, Size: $size")
+        }
+
+        var element = elements.get(index)
+        if (element == null) {
+            val jsBridge = jsArray.jsBridge
+                ?: throw JsValueEvaluationError(jsArray.associatedJsName, customMessage = "Cannot get JS array element because the JS interpreter has been destroyed")
+
+            element = jsBridge.getJsArrayElement(jsArray, index, elementParameter) ?: NULL_ELEMENT
+            elements.set(index, element)
+        }
+
+        @Suppress("UNCHECKED_CAST")
+        return (if (element === NULL_ELEMENT) null else element) as T
+    }
+
+    private companion object {
+        // Cached null element (null being a non-converted element)
+        val NULL_ELEMENT = Any()
+    }
+}
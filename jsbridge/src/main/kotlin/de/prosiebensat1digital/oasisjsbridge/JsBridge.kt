@@ -21,14 +21,21 @@ package de.prosiebensat1digital.oasisjsbridge
 import android.app.Activity
 import android.content.Context
 import android.os.Looper
+import android.os.ParcelFileDescriptor
 import androidx.annotation.VisibleForTesting
 import de.prosiebensat1digital.oasisjsbridge.JsBridgeError.*
 import de.prosiebensat1digital.oasisjsbridge.extensions.*
+import java.io.File
 import java.io.FileNotFoundException
 import java.io.InputStream
 import java.lang.reflect.Method as JavaMethod
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.ConcurrentLinkedQueue
 import java.util.concurrent.CopyOnWriteArraySet
+import java.util.concurrent.Executor
 import java.util.concurrent.Executors
+import java.util.concurrent.RejectedExecutionException
+import java.util.concurrent.atomic.AtomicBoolean
 import java.util.concurrent.atomic.AtomicInteger
 import java.util.concurrent.locks.ReentrantLock
 import kotlin.concurrent.withLock
@@ -55,7 +62,8 @@ import java.lang.reflect.Proxy
  *
  * Note: all the public methods are asynchronous and will not block the caller threads. They
  * can be safely called in a "synchronous" way. though, because their executions are guaranteed
- * to be performed sequentially (via an internal queue).
+ * to be performed sequentially (via an internal queue). When the queue is empty, blocking
+ * evaluations are directly performed in the caller thread.
  *
  * @param config JsBridge configuration
  * @param context Context needed for local storage extension
@@ -65,6 +73,7 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
 
     companion object {
         private var isLibraryLoaded = false
+        private val JS_EXTENSION_REGEX = Regex("""\.js$""")
     }
 
     abstract class ErrorListener(val coroutineContext: CoroutineContext? = null) {
@@ -81,9 +90,35 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
     private var state = AtomicInteger(State.Pending.intValue)
     private val currentState get() = State.values().firstOrNull { it.intValue == state.get() }
 
+    // Owner of the JS context: the JS thread while running a task, or a Java thread directly
+    // calling into the JS context (see evaluateBlocking)
+    private val jsContextLock = ReentrantLock()
+
+    // Thread for which the native stack bounds of the JS context have been last updated
+    @Volatile
+    private var stackTopThread: Thread? = null
+
     // JS coroutine dispatcher (single thread/sequential execution)
-    private val jsDispatcher = Executors.newSingleThreadExecutor().asCoroutineDispatcher()
-    private var jsThreadId: Long? = null  // for checking thread
+    // Each task is executed while holding the JS context lock.
+    private val pendingJsTaskCount = AtomicInteger(0)
+    private val jsExecutor = Executors.newSingleThreadExecutor()
+    private val jsDispatcher = Executor { command ->
+        pendingJsTaskCount.incrementAndGet()
+        try {
+            jsExecutor.execute {
+                withJsContextLock {
+                    try {
+                        command.run()
+                    } finally {
+                        pendingJsTaskCount.decrementAndGet()
+                    }
+                }
+            }
+        } catch (e: RejectedExecutionException) {
+            pendingJsTaskCount.decrementAndGet()
+            throw e
+        }
+    }.asCoroutineDispatcher()
 
     // Handle couroutines lifecycle via a Job instance (for structured concurrency)
     private val rootJob = SupervisorJob()
@@ -96,6 +131,23 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
 
     private val errorListeners = CopyOnWriteArraySet<ErrorListener>()
 
+    // Application context (given to the worker JsBridges)
+    private val applicationContext: Context = context.applicationContext
+
+    // Workers with an endpoint in this JsBridge, by channel handle (only modified in the JS thread)
+    private val workerEndpoints = ConcurrentHashMap<Long, JsWorker>()
+
+    // Global names of released JsValues (appended from any thread, e.g. finalizers), which are
+    // deleted in a single batch by the next JS task or direct JS context call
+    private val releasedJsValueNames = ConcurrentLinkedQueue<String>()
+    private val releasedJsValuesDrainScheduled = AtomicBoolean(false)
+
+    // Java Deferreds settled during the current JS thread tick, which are completed in JS in a
+    // single batch (only accessed from the JS thread)
+    private val pendingJsPromiseCompletions = mutableListOf<JsPromiseCompletion>()
+
+    private class JsPromiseCompletion(val id: String, val isFulfilled: Boolean, val value: Any?)
+
     // Extensions
     private var jsDebuggerExtension: JsDebuggerExtension? = null
     private var promiseExtension: PromiseExtension? = null
@@ -106,14 +158,14 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
 
     private var internalCounter = AtomicInteger(0)
 
+    // Argument types of callJsValue() (after the custom class loader has been set)
+    private val anyArgParameter by lazy { Parameter(Any::class.java, customClassLoader) }
+    private val jsValueArgParameter by lazy { Parameter(JsValue::class.java, customClassLoader) }
+
     // Initialize the JS interpreter
     // - create the JS context via JNI
     // - set up the interpreter with polyfills and helpers (e.g. support for setTimeout)
     init {
-        launch {
-            jsThreadId = Thread.currentThread().id
-        }
-
         startReleaseLock.withLock {
             Timber.d("Starting JsBridge")
 
@@ -171,6 +223,26 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
                     context.applicationContext
                 )
             config.jvmConfig.customClassLoader?.let { customClassLoader = it }
+            if (config.scriptCacheConfig.enabled) {
+                val scriptCacheConfig = config.scriptCacheConfig
+                launch {
+                    jniEnableScriptCache(
+                        jniJsContextOrThrow(),
+                        scriptCacheConfig.maxEntryCount,
+                        scriptCacheConfig.maxSourceLength
+                    )
+                }
+            }
+            if (config.stringInternConfig.enabled) {
+                val stringInternConfig = config.stringInternConfig
+                launch {
+                    jniEnableStringInterning(
+                        jniJsContextOrThrow(),
+                        stringInternConfig.maxEntryCount,
+                        stringInternConfig.maxStringLength
+                    )
+                }
+            }
         }
     }
 
@@ -251,8 +323,11 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             xhrExtension?.release()
             xhrExtension = null
 
+            workerEndpoints.keys.toList().forEach(::deleteWorkerChannel)
+            releasedJsValueNames.clear()
+
             errorListeners.clear()
-            jsDispatcher.close()
+            jsExecutor.shutdown()
 
             // Releasing -> Released
             if (!state.compareAndSet(State.Releasing.intValue, State.Released.intValue)) {
@@ -306,16 +381,40 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         return jniGetCurrentScriptOrModuleName(jniJsContext, level)
     }
 
+    private var jsModuleLoaderFunc: ((moduleName: String) -> String)? = null
+    private var jsModulePrefetcher: JsModulePrefetcher? = null
+
     /**
      * Set a custom module loader which will return the content of the given module
      */
-    private var jsModuleLoaderFunc: ((moduleName: String) -> String)? = null
     fun setJsModuleLoader(func: (moduleName: String) -> String) {
+        setJsModuleLoader(false, null, func)
+    }
+
+    /**
+     * Set a custom module loader which will return the content of the given module
+     *
+     * Compiled modules are cached in memory (and shared by all the JsBridge instances) so that
+     * modules with an unchanged content are not compiled again.
+     *
+     * @param prefetchImports scan the static imports of the loaded modules and load the imported
+     * modules in parallel on IO threads (the loader function must then be thread-safe)
+     * @param compiledModuleCacheDir directory where the compiled modules are additionally cached
+     * between app starts
+     */
+    @JvmOverloads
+    fun setJsModuleLoader(
+        prefetchImports: Boolean,
+        compiledModuleCacheDir: File? = null,
+        func: (moduleName: String) -> String
+    ) {
         jsModuleLoaderFunc = func
+        jsModulePrefetcher = if (prefetchImports) JsModulePrefetcher(func, rootJob) else null
 
         launch {
             val jniJsContext = jniJsContextOrThrow()
-            jniEnableModuleLoader(jniJsContext)
+            compiledModuleCacheDir?.mkdirs()
+            jniEnableModuleLoader(jniJsContext, compiledModuleCacheDir?.absolutePath)
         }
     }
 
@@ -324,6 +423,11 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
      *
      * If the given file has a corresponding .max file, this one will be used in debug mode.
      * e.g.: "myfile.js" / "myfile.max.js"
+     *
+     * Assets stored uncompressed in the APK (e.g. aaptOptions { noCompress "js", "jsbc" }) are
+     * memory-mapped and evaluated without being copied. If a compiled "myfile.jsbc" asset (bytecode
+     * generated by the same JS engine version) is available, it will be evaluated instead of the
+     * source code (except with useMaxJs).
      */
     suspend fun evaluateLocalFile(
         context: Context,
@@ -335,17 +439,28 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             val jniJsContext = jniJsContextOrThrow()
 
             try {
-                val (inputStream, jsFileName) = getInputStream(context, filename, useMaxJs)
-                val jsString = inputStream.bufferedReader().use { it.readText() }
-                jniEvaluateFileContent(
-                    jniJsContext,
-                    jsString,
-                    jsFileName,
-                    type == JsFileEvaluationType.Module
-                )
-                Timber.d("-> $filename ($jsFileName) has been successfully evaluated!")
+                if (!useMaxJs && evaluateUncompressedLocalFile(jniJsContext, context, filename, type)) {
+                    Timber.d("-> $filename has been successfully evaluated (mapped)!")
+                } else {
+                    val (inputStream, jsFileName) = getInputStream(context, filename, useMaxJs)
+                    val jsString = inputStream.bufferedReader().use { it.readText() }
+                    if (type == JsFileEvaluationType.Module) {
+                        jsModulePrefetcher?.prefetchImports(jsFileName, jsString)
+                    }
+                    jniEvaluateFileContent(
+                        jniJsContext,
+                        jsString,
+                        jsFileName,
+                        type == JsFileEvaluationType.Module
+                    )
+                    Timber.d("-> $filename ($jsFileName) has been successfully evaluated!")
+                }
             } catch (t: Throwable) {
                 throw JsFileEvaluationError(filename, t)
+            } finally {
+                if (type == JsFileEvaluationType.Module) {
+                    jsModulePrefetcher?.evictUnusedModules()
+                }
             }
 
             processPromiseQueue()
@@ -380,6 +495,69 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         }
     }
 
+    /**
+     * Evaluate a JS file (e.g. a downloaded bundle) which is memory-mapped instead of being read
+     * into a String.
+     *
+     * If a compiled "myfile.jsbc" sibling (bytecode generated by the same JS engine version) exists,
+     * it will be evaluated instead of the source code.
+     */
+    suspend fun evaluateFile(
+        file: File,
+        type: JsFileEvaluationType = JsFileEvaluationType.Global
+    ) {
+        withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+
+            try {
+                val bytecodeFile = File(file.path.replace(JS_EXTENSION_REGEX, ".jsbc"))
+                val isBytecode = bytecodeFile != file && bytecodeFile.isFile
+                val evaluatedFile = if (isBytecode) bytecodeFile else file
+
+                ParcelFileDescriptor.open(evaluatedFile, ParcelFileDescriptor.MODE_READ_ONLY).use { pfd ->
+                    jniEvaluateFile(
+                        jniJsContext,
+                        pfd.fd,
+                        0L,
+                        evaluatedFile.length(),
+                        file.name,
+                        isBytecode,
+                        type == JsFileEvaluationType.Module
+                    )
+                }
+                Timber.d("-> $file (${evaluatedFile.name}) has been successfully evaluated!")
+            } catch (t: Throwable) {
+                throw JsFileEvaluationError(file.name, t)
+            }
+
+            processPromiseQueue()
+        }
+    }
+
+    /**
+     * Evaluate a JS file (e.g. a downloaded bundle) which is memory-mapped (fire-and-forget version).
+     */
+    fun evaluateFileUnsync(
+        file: File,
+        type: JsFileEvaluationType = JsFileEvaluationType.Global
+    ) {
+        launch {
+            evaluateFile(file, type)
+        }
+    }
+
+    /**
+     * Evaluate a JS file (e.g. a downloaded bundle) which is memory-mapped (blocking version).
+     */
+    fun evaluateFileBlocking(
+        file: File,
+        type: JsFileEvaluationType = JsFileEvaluationType.Global
+    ) {
+        runBlocking(coroutineContext) {
+            evaluateFile(file, type)
+        }
+    }
+
     /*
      * Evaluate the content of a JavaScript file (e.g. fetched from the network).
      */
@@ -392,6 +570,9 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             val jniJsContext = jniJsContextOrThrow()
 
             try {
+                if (type == JsFileEvaluationType.Module) {
+                    jsModulePrefetcher?.prefetchImports(filename, content)
+                }
                 jniEvaluateFileContent(
                     jniJsContext,
                     content,
@@ -401,6 +582,10 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
                 Timber.d("-> file content ($filename) has been successfully evaluated!")
             } catch (t: Throwable) {
                 throw JsFileEvaluationError(filename, t)
+            } finally {
+                if (type == JsFileEvaluationType.Module) {
+                    jsModulePrefetcher?.evictUnusedModules()
+                }
             }
 
             processPromiseQueue()
@@ -473,26 +658,129 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         js: String,
         context: CoroutineContext = EmptyCoroutineContext
     ): T {
-        return runBlocking(context) {
-            if (isMainThread()) {
-                Timber.w("WARNING: evaluating JS code in the main thread! Consider using non-blocking API or evaluating JS code in another thread!")
-            }
-            evaluate(js, typeOf<T>(), true)
-        }
+        return evaluateBlocking(js, typeOf<T>(), true, context)
     }
 
     // Notes:
-    // - runs in the JS thread and block the caller thread until the result has been evaluated!
+    // - block the caller thread until the result has been evaluated!
     // - from Kotlin, it is recommended to use the method with generic parameter, instead!
     fun evaluateBlocking(js: String, javaClass: Class<*>?): Any? {
-        return runBlocking {
-            if (isMainThread()) {
-                Timber.w("WARNING: evaluating JS code in the main thread! Consider using non-blocking API or evaluating JS code in another thread!")
+        return evaluateBlocking(js, javaClass?.kotlin?.createType(), false, EmptyCoroutineContext)
+    }
+
+    // Evaluate the given JS code and block the caller thread until the result has been evaluated.
+    //
+    // If no JS task is pending, the JS code is directly evaluated in the caller thread (while
+    // holding the JS context lock) instead of being dispatched to the JS thread.
+    @PublishedApi
+    internal fun <T : Any?> evaluateBlocking(
+        js: String,
+        type: KType?,
+        awaitJsPromise: Boolean,
+        context: CoroutineContext
+    ): T {
+        if (isMainThread()) {
+            Timber.w("WARNING: evaluating JS code in the main thread! Consider using non-blocking API or evaluating JS code in another thread!")
+        }
+
+        if (context != EmptyCoroutineContext || !canCallJsContextDirectly()) {
+            return runBlocking(context) {
+                evaluate(js, type, awaitJsPromise)
+            }
+        }
+
+        val parameter = type?.let { Parameter(type, customClassLoader) }
+        val doAwaitJsPromise = awaitJsPromise && type?.classifier != Deferred::class
+
+        var ret = withJsContextLock {
+            deleteReleasedJsValues()
+            val ret = jniEvaluateString(jniJsContextOrThrow(), js, parameter, doAwaitJsPromise)
+            processPromiseQueue()
+            ret
+        }
+
+        if (doAwaitJsPromise && ret is Deferred<*>) {
+            // The promise is settled by the JS thread (or another owner of the JS context)
+            val deferred = ret
+            ret = runBlocking { deferred.await() }
+        }
+
+        @Suppress("UNCHECKED_CAST")
+        return ret as T
+    }
+
+
+    /**
+     * Run the pending JS jobs (e.g. promise reactions).
+     *
+     * Note: pending jobs are automatically executed after each JS evaluation or call so this is
+     * only needed to split long job chains into several chunks and give other tasks of the JS
+     * thread a chance to run in between.
+     *
+     * @param maxJobs maximum number of jobs to run (no limit if negative)
+     * @param maxMicros maximum time budget in microseconds (no limit if negative)
+     * @return true if there are still pending jobs
+     */
+    suspend fun runJobs(maxJobs: Int = -1, maxMicros: Long = -1L): Boolean {
+        return withContext(coroutineContext) {
+            if (promiseExtension?.config?.needsPolyfill == true) {
+                processPromiseQueue()
+                false
+            } else {
+                jniRunJobs(jniJsContextOrThrow(), maxJobs, maxMicros)
             }
-            evaluate(js, javaClass?.kotlin?.createType(), false)
         }
     }
 
+    /**
+     * Get the total number of JS jobs (e.g. promise reactions) which have been executed so far by
+     * the JS engine (for metrics).
+     */
+    suspend fun getDrainedJobCount(): Long {
+        return withContext(coroutineContext) {
+            jniGetDrainedJobCount(jniJsContextOrThrow())
+        }
+    }
+
+    /**
+     * Statistics of the compiled script cache (see JsBridgeConfig.scriptCacheConfig).
+     */
+    data class ScriptCacheStats(val hitCount: Long, val missCount: Long, val evictionCount: Long, val entryCount: Int)
+
+    /**
+     * Get the statistics of the compiled script cache (all zero if it is disabled).
+     */
+    suspend fun getScriptCacheStats(): ScriptCacheStats {
+        return withContext(coroutineContext) {
+            val stats = jniGetScriptCacheStats(jniJsContextOrThrow())
+            ScriptCacheStats(hitCount = stats[0], missCount = stats[1], evictionCount = stats[2], entryCount = stats[3].toInt())
+        }
+    }
+
+    /**
+     * Statistics of the Java -> JS string intern cache (see JsBridgeConfig.stringInternConfig).
+     */
+    data class StringInternStats(val hitCount: Long, val missCount: Long, val entryCount: Int)
+
+    /**
+     * Get the statistics of the Java -> JS string intern cache (all zero if it is not enabled).
+     */
+    suspend fun getStringInternStats(): StringInternStats {
+        return withContext(coroutineContext) {
+            val stats = jniGetStringInternStats(jniJsContextOrThrow())
+            StringInternStats(hitCount = stats[0], missCount = stats[1], entryCount = stats[2].toInt())
+        }
+    }
+
+    /**
+     * Get the total number of JNI method and field ID lookups made so far by the native bridge.
+     *
+     * The IDs are resolved once when a JsBridge instance is created so the count must not change
+     * afterwards (for tests).
+     */
+    @VisibleForTesting(otherwise = VisibleForTesting.PRIVATE)
+    internal fun getJniIdLookupCount(): Long = jniGetJniIdLookupCount()
+
 
     // Internal
     // ---
@@ -534,8 +822,7 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         type: KType?,
         awaitJsPromise: Boolean
     ): T {
-        jsValue.codeEvaluationDeferred?.await()
-        return evaluate("$jsValue", type, awaitJsPromise)
+        return getJsValueProperty(jsValue, null, type, awaitJsPromise)
     }
 
     // Evaluate the given JS value and return the result as a deferred
@@ -545,6 +832,117 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             evaluateJsValue(jsValue, type, true)
         }
 
+    // Read a property of the given JS value (or the value itself if key is null) without
+    // evaluating any JS code
+    @PublishedApi
+    internal suspend fun <T : Any?> getJsValueProperty(
+        jsValue: JsValue,
+        key: String?,
+        type: KType?,
+        awaitJsPromise: Boolean
+    ): T {
+        val parameter = type?.let { Parameter(type, customClassLoader) }
+        val doAwaitJsPromise = awaitJsPromise && type?.classifier != Deferred::class
+
+        val ret = withContext(coroutineContext) {
+            jsValue.codeEvaluationDeferred?.await()
+
+            // Exceptions must be directly caught by the caller
+            var ret = jniGetJsValueProperty(jniJsContextOrThrow(), jsValue.associatedJsName, key, parameter, doAwaitJsPromise)
+
+            if (doAwaitJsPromise && ret is Deferred<*>) {
+                processPromiseQueue()
+                ret = ret.await()
+            }
+
+            processPromiseQueue()
+            ret
+        }
+
+        @Suppress("UNCHECKED_CAST")
+        return ret as T
+    }
+
+    @PublishedApi
+    internal suspend fun setJsValueProperty(jsValue: JsValue, key: String, value: Any?, parameter: Parameter) {
+        withContext(coroutineContext) {
+            jsValue.codeEvaluationDeferred?.await()
+            (value as? JsValue)?.codeEvaluationDeferred?.await()
+
+            jniSetJsValueProperty(jniJsContextOrThrow(), jsValue.associatedJsName, key, value, parameter)
+            processPromiseQueue()
+        }
+    }
+
+    // Read (and convert) an element of the JS array held by a JsArrayList, blocking the caller
+    // thread if the JS context cannot be directly called
+    internal fun getJsArrayElement(jsArray: JsValue, index: Int, parameter: Parameter?): Any? {
+        val getElement = {
+            val ret = jniGetJsValueProperty(jniJsContextOrThrow(), jsArray.associatedJsName, index.toString(), parameter, false)
+            processPromiseQueue()
+            ret
+        }
+
+        if (!canCallJsContextDirectly()) {
+            return runBlocking {
+                withContext(this@JsBridge.coroutineContext) { getElement() }
+            }
+        }
+
+        return withJsContextLock(getElement)
+    }
+
+    internal suspend fun hasJsValueProperty(jsValue: JsValue, key: String): Boolean {
+        return withContext(coroutineContext) {
+            jsValue.codeEvaluationDeferred?.await()
+            jniHasJsValueProperty(jniJsContextOrThrow(), jsValue.associatedJsName, key)
+        }
+    }
+
+    internal suspend fun getJsValueKeys(jsValue: JsValue): List<String> {
+        return withContext(coroutineContext) {
+            jsValue.codeEvaluationDeferred?.await()
+            jniGetJsValueKeys(jniJsContextOrThrow(), jsValue.associatedJsName).asList()
+        }
+    }
+
+    // Call the given JS value (or its method if methodName is not null) without evaluating any JS
+    // code. The arguments are dynamically mapped like Any? values (except JsValue instances).
+    @PublishedApi
+    internal suspend fun <T : Any?> callJsValue(
+        jsValue: JsValue,
+        methodName: String?,
+        args: Array<out Any?>,
+        type: KType?,
+        awaitJsPromise: Boolean
+    ): T {
+        val parameter = type?.let { Parameter(type, customClassLoader) }
+        val doAwaitJsPromise = awaitJsPromise && type?.classifier != Deferred::class
+        val argParameters = Array(args.size) { i ->
+            if (args[i] is JsValue) jsValueArgParameter else anyArgParameter
+        }
+
+        val ret = withContext(coroutineContext) {
+            jsValue.codeEvaluationDeferred?.await()
+            args.forEach { (it as? JsValue)?.codeEvaluationDeferred?.await() }
+
+            // Exceptions must be directly caught by the caller
+            var ret = jniCallJsValue(jniJsContextOrThrow(), jsValue.associatedJsName, methodName,
+                arrayOf(*args), argParameters, parameter, doAwaitJsPromise)
+
+            if (doAwaitJsPromise && ret is Deferred<*>) {
+                processPromiseQueue()
+                ret = ret.await()
+            }
+
+            processPromiseQueue()
+            ret
+        }
+
+        @Suppress("UNCHECKED_CAST")
+        return ret as T
+    }
+
     @VisibleForTesting(otherwise = VisibleForTesting.PACKAGE_PRIVATE)
     fun newJsFunctionAsync(
         jsValue: JsValue,
@@ -813,9 +1211,41 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         val globalName = jsValue.associatedJsName
         val codeEvaluationDeferred = jsValue.codeEvaluationDeferred
 
+        if (codeEvaluationDeferred == null || codeEvaluationDeferred.isCompleted) {
+            queueReleasedJsValue(globalName)
+            return
+        }
+
+        // The JS value must be assigned before being deleted
         launch {
-            codeEvaluationDeferred?.await()
-            jniJsContext?.let { jniDeleteJsValue(it, globalName) }
+            codeEvaluationDeferred.await()
+            queueReleasedJsValue(globalName)
+        }
+    }
+
+    // Can be called from any thread: only the first released value of a batch schedules a JS task
+    private fun queueReleasedJsValue(globalName: String) {
+        releasedJsValueNames.add(globalName)
+
+        if (releasedJsValuesDrainScheduled.compareAndSet(false, true)) {
+            launch { deleteReleasedJsValues() }
+        }
+    }
+
+    // Must be called while owning the JS context
+    private fun deleteReleasedJsValues() {
+        releasedJsValuesDrainScheduled.set(false)
+        if (releasedJsValueNames.isEmpty()) return
+
+        val jniJsContext = jniJsContext ?: return
+        val globalNames = generateSequence { releasedJsValueNames.poll() }.toList()
+        try {
+            jniDeleteJsValues(jniJsContext, globalNames.toTypedArray())
+        } catch (t: Throwable) {
+            // Put the names back so that the values are deleted with the next batch instead of
+            // leaking (deleting an already deleted global is a no-op)
+            releasedJsValueNames.addAll(globalNames)
+            throw t
         }
     }
 
@@ -828,6 +1258,40 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         }
     }
 
+    // Clone the given JsValue of the source JsBridge into a new JsValue of this JsBridge (the
+    // serialized value stays in a native buffer)
+    internal fun readStructuredClone(jsValueFrom: JsValue, sourceJsBridge: JsBridge): JsValue {
+        val jsValue = JsValue(this)
+        val codeEvaluationDeferred = jsValueFrom.codeEvaluationDeferred
+
+        jsValue.codeEvaluationDeferred = async {
+            // The buffer is assigned inside withContext() so that it is also deleted when the
+            // coroutine is cancelled before withContext() returns
+            var buffer = 0L
+            try {
+                withContext(sourceJsBridge.coroutineContext) {
+                    codeEvaluationDeferred?.await()
+                    buffer = sourceJsBridge.writeStructuredClone(jsValueFrom)
+                }
+
+                jniReadStructuredClone(jniJsContextOrThrow(), buffer, jsValue.associatedJsName)
+            } finally {
+                if (buffer != 0L) {
+                    jniDeleteStructuredClone(buffer)
+                }
+            }
+        }
+
+        return jsValue
+    }
+
+    // Called in the JS thread of the source JsBridge
+    private fun writeStructuredClone(jsValue: JsValue): Long {
+        checkJsThread()
+
+        return jniWriteStructuredClone(jniJsContextOrThrow(), jsValue.associatedJsName)
+    }
+
     @PublishedApi
     internal fun convertJavaValueToJs(value: Any?, parameter: Parameter): JsValue {
         val jsValue = JsValue(this)
@@ -840,18 +1304,89 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         return jsValue
     }
 
-    // Simulate a "Promise" tick. Needs to be manually triggered as we don't use an event loop.
+    // Simulate a "Promise" tick. Needs to be manually triggered for the polyfill as we don't use an
+    // event loop. JS engines with built-in promise support automatically run their pending jobs at
+    // the end of each JNI call executing JS code.
     internal fun processPromiseQueue() {
         val promiseExtension = promiseExtension ?: return
+        if (!promiseExtension.config.needsPolyfill) return
+
+        checkJsThread()
+
+        // Manually process promise queue of the polyfill
+        promiseExtension.processPolyfillQueue()
+    }
+
+    // Called by ConsoleExtension
+    internal fun enableConsole(mode: Int, minPriority: Int, useNativeLog: Boolean, maxMessagesPerSecond: Int) {
+        launch {
+            val jniJsContext = jniJsContextOrThrow()
+            jniEnableConsole(jniJsContext, mode, minPriority, useNativeLog, maxMessagesPerSecond)
+        }
+    }
+
+    // Called by SetTimeoutExtension
+    internal fun enableTimers() {
+        launch {
+            val jniJsContext = jniJsContextOrThrow()
+            jniEnableTimers(jniJsContext)
+        }
+    }
 
+    // Fire the expired timers. Called by SetTimeoutExtension in the JS thread.
+    internal fun runTimers() {
         checkJsThread()
 
-        if (promiseExtension.config.needsPolyfill) {
-            // Manually process promise queue of the polyfill
-            promiseExtension.processPolyfillQueue()
+        jniJsContext?.let { jniRunTimers(it) }
+    }
+
+    /**
+     * Create a worker running the given script in its own JsBridge (own JS context and JS thread)
+     *
+     * @see JsWorker
+     */
+    fun createWorker(script: String, config: JsBridgeConfig = JsBridgeConfig.bareConfig()): JsWorker =
+        JsWorker(this, script, config, applicationContext)
+
+    // Called by JsWorker
+    internal fun newWorkerChannel(): Long = jniNewWorkerChannel()
+    internal fun shareWorkerChannel(channel: Long): Long = jniShareWorkerChannel(channel)
+
+    // Set up the worker endpoint with the given channel handle (owned by this JsBridge):
+    // - parent side: postMessage() and onmessage on the given JsValue
+    // - worker side (jsValue == null): global postMessage() and onmessage
+    internal fun setUpWorkerEndpoint(worker: JsWorker, channel: Long, jsValue: JsValue?) {
+        if (jsValue != null) {
+            jsValue.codeEvaluationDeferred = async {
+                setUpWorkerEndpointHelper(worker, channel, jsValue)
+            }
         } else {
-            // Run pending jobs of the JS engine with built-in promise support
-            jniJsContext?.let { jniProcessPromiseQueue(it) }
+            launch {
+                setUpWorkerEndpointHelper(worker, channel, null)
+            }
+        }
+    }
+
+    internal fun removeWorkerEndpoint(channel: Long) {
+        launch {
+            deleteWorkerChannel(channel)
+        }
+    }
+
+    // Call onmessage() with the messages posted to the worker endpoint of this JsBridge
+    internal fun dispatchWorkerMessages(channel: Long, jsValue: JsValue?) {
+        val codeEvaluationDeferred = jsValue?.codeEvaluationDeferred
+
+        launch {
+            codeEvaluationDeferred?.await()
+            if (!workerEndpoints.containsKey(channel)) return@launch
+
+            val jniJsContext = jniJsContext ?: return@launch
+            try {
+                jniDispatchWorkerMessages(jniJsContext, channel, jsValue?.associatedJsName ?: "", jsValue == null)
+            } catch (e: JsException) {
+                throw JsCallbackError(e)
+            }
         }
     }
 
@@ -905,9 +1440,44 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
     private fun callJsModuleLoader(moduleName: String): String {
         // Note: it is perfectly fine if the function throws an exception
         // (it will be properly caught by JNI and thrown as a JS exception)
+        jsModulePrefetcher?.let { return it.load(moduleName) }
         return jsModuleLoaderFunc!!(moduleName)
     }
 
+    // Evaluate the mapped asset (or its compiled .jsbc sibling) if it is stored uncompressed in the APK
+    // and return true, or return false if the asset needs to be read via an InputStream
+    // Note: the imports of a mapped module are not prefetched (but the ones of the imported modules are)
+    private fun evaluateUncompressedLocalFile(
+        jniJsContext: Long,
+        context: Context,
+        filename: String,
+        type: JsFileEvaluationType
+    ): Boolean {
+        val bytecodeFilename = filename.replace(JS_EXTENSION_REGEX, ".jsbc")
+        val bytecodeFd = if (bytecodeFilename != filename) openUncompressedAsset(context, bytecodeFilename) else null
+        val fd = bytecodeFd ?: openUncompressedAsset(context, filename) ?: return false
+
+        fd.use {
+            jniEvaluateFile(
+                jniJsContext,
+                it.parcelFileDescriptor.fd,
+                it.startOffset,
+                it.length,
+                filename.substringAfterLast("/"),
+                bytecodeFd != null,
+                type == JsFileEvaluationType.Module
+            )
+        }
+        return true
+    }
+
+    // Return null if the asset does not exist or if it is compressed
+    private fun openUncompressedAsset(context: Context, filename: String) = try {
+        context.assets.openFd(filename)
+    } catch (e: FileNotFoundException) {
+        null
+    }
+
     @Throws
     private fun getInputStream(
         context: Context,
@@ -1239,8 +1809,6 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
     @Suppress("UNUSED")  // Called from JNI
     private fun setUpJsPromise(id: String, deferred: Deferred<Any>) {
         launch {
-            val jniJsContext = jniJsContextOrThrow()
-
             var isFulfilled = false
 
             val promiseValue = try {
@@ -1258,17 +1826,70 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
                 t
             }
 
-            jniCompleteJsPromise(jniJsContext, id, isFulfilled, promiseValue)
-            processPromiseQueue()
+            queueJsPromiseCompletion(JsPromiseCompletion(id, isFulfilled, promiseValue))
         }
     }
 
+    // The completion is delayed to a new JS task so that the Deferreds which are settled at the
+    // same time (and whose continuations are already queued) are completed together
+    private fun queueJsPromiseCompletion(completion: JsPromiseCompletion) {
+        checkJsThread()
+
+        pendingJsPromiseCompletions.add(completion)
+        if (pendingJsPromiseCompletions.size == 1) {
+            launch { completePendingJsPromises() }
+        }
+    }
+
+    private fun completePendingJsPromises() {
+        val jniJsContext = jniJsContextOrThrow()
+
+        val completions = pendingJsPromiseCompletions.toList()
+        pendingJsPromiseCompletions.clear()
+
+        jniCompleteJsPromises(
+            jniJsContext,
+            Array(completions.size) { completions[it].id },
+            BooleanArray(completions.size) { completions[it].isFulfilled },
+            Array(completions.size) { completions[it].value }
+        )
+        processPromiseQueue()
+    }
+
     @Suppress("UNUSED")  // Called from JNI
     private fun addUnhandledJsPromiseException(exception: JsException) {
         val e = UnhandledJsPromiseError(exception)
         notifyErrorListeners(e)
     }
 
+    @Suppress("UNUSED")  // Called from JNI
+    private fun appendConsoleMessages(priorities: IntArray, messages: Array<String>) {
+        consoleExtension?.appendMessages(priorities, messages)
+    }
+
+    @Suppress("UNUSED")  // Called from JNI
+    private fun scheduleTimerWakeup(delayMs: Long) {
+        setTimeoutExtension?.scheduleWakeup(delayMs)
+    }
+
+    @Suppress("UNUSED")  // Called from JNI
+    private fun onWorkerMessagePosted(channel: Long) {
+        workerEndpoints[channel]?.onMessagePosted(this)
+    }
+
+    private fun setUpWorkerEndpointHelper(worker: JsWorker, channel: Long, jsValue: JsValue?) {
+        val jniJsContext = jniJsContextOrThrow()
+        workerEndpoints[channel] = worker
+        jniSetUpWorkerEndpoint(jniJsContext, channel, jsValue?.associatedJsName ?: "", jsValue == null)
+    }
+
+    // Must be called in the JS thread (so that the channel handle is not used by a pending dispatch)
+    private fun deleteWorkerChannel(channel: Long) {
+        if (workerEndpoints.remove(channel) != null) {
+            jniDeleteWorkerChannel(channel)
+        }
+    }
+
     private fun launchInJsThread(block: suspend () -> Unit) {
         launch {
             block()
@@ -1299,7 +1920,29 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
 
     @PublishedApi
     internal fun isMainThread(): Boolean = (Looper.myLooper() == Looper.getMainLooper())
-    fun isJsThread(): Boolean = (Thread.currentThread().id == jsThreadId)
+
+    // True if the current thread owns the JS context (either the JS thread while running a task,
+    // or a Java thread directly calling into the JS context)
+    fun isJsThread(): Boolean = jsContextLock.isHeldByCurrentThread
+
+    // The JS context can be directly called from the current thread if it already owns it (nested
+    // call) or if the JsBridge is started and no JS task is pending (to keep the order of the calls)
+    private fun canCallJsContextDirectly(): Boolean =
+        jsContextLock.isHeldByCurrentThread ||
+            (state.get() == State.Started.intValue && pendingJsTaskCount.get() == 0)
+
+    // Take the JS context. The engine checks stack overflows against the stack of the thread which
+    // last took it, so the bounds are updated when the owner thread changes.
+    private inline fun <T> withJsContextLock(block: () -> T): T = jsContextLock.withLock {
+        val currentThread = Thread.currentThread()
+        if (jsContextLock.holdCount == 1 && stackTopThread !== currentThread) {
+            jniJsContext?.let {
+                jniUpdateStackTop(it)
+                stackTopThread = currentThread
+            }
+        }
+        block()
+    }
 
     private fun jniJsContextOrThrow() =
         jniJsContext ?: throw InternalError("Missing JNI JS context!")
@@ -1310,7 +1953,7 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
     private external fun jniStartDebugger(context: Long, port: Int)
     private external fun jniCancelDebug(context: Long)
     private external fun jniDeleteContext(context: Long)
-    private external fun jniEnableModuleLoader(context: Long)
+    private external fun jniEnableModuleLoader(context: Long, compiledModuleCacheDir: String?)
     private external fun jniGetCurrentScriptOrModuleName(context: Long, level: Int): String
     private external fun jniEvaluateString(
         context: Long,
@@ -1326,6 +1969,16 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         asModule: Boolean
     )
 
+    private external fun jniEvaluateFile(
+        context: Long,
+        fd: Int,
+        offset: Long,
+        length: Long,
+        filename: String,
+        isBytecode: Boolean,
+        asModule: Boolean
+    )
+
     private external fun jniRegisterJavaLambda(context: Long, name: String, obj: Any, method: Any)
     private external fun jniRegisterJavaObject(
         context: Long,
@@ -1365,8 +2018,11 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
     ): Any?
 
     private external fun jniAssignJsValue(context: Long, globalName: String, jsCode: String)
-    private external fun jniDeleteJsValue(context: Long, globalName: String)
+    private external fun jniDeleteJsValues(context: Long, globalNames: Array<String>)
     private external fun jniCopyJsValue(context: Long, globalNameTo: String, globalNameFrom: String)
+    private external fun jniWriteStructuredClone(context: Long, globalName: String): Long
+    private external fun jniReadStructuredClone(context: Long, buffer: Long, globalName: String)
+    private external fun jniDeleteStructuredClone(buffer: Long)
     private external fun jniNewJsFunction(
         context: Long,
         globalName: String,
@@ -1381,14 +2037,58 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         parameter: Parameter
     )
 
-    private external fun jniCompleteJsPromise(
+    private external fun jniGetJsValueProperty(
+        context: Long,
+        globalName: String,
+        key: String?,
+        parameter: Parameter?,
+        awaitJsPromise: Boolean
+    ): Any?
+
+    private external fun jniSetJsValueProperty(
+        context: Long,
+        globalName: String,
+        key: String,
+        value: Any?,
+        parameter: Parameter
+    )
+
+    private external fun jniHasJsValueProperty(context: Long, globalName: String, key: String): Boolean
+    private external fun jniGetJsValueKeys(context: Long, globalName: String): Array<String>
+
+    private external fun jniCallJsValue(
+        context: Long,
+        globalName: String,
+        methodName: String?,
+        args: Array<Any?>,
+        argParameters: Array<Parameter>,
+        returnParameter: Parameter?,
+        awaitJsPromise: Boolean
+    ): Any?
+
+    private external fun jniCompleteJsPromises(
         context: Long,
-        id: String,
-        isFulfilled: Boolean,
-        value: Any
+        ids: Array<String>,
+        isFulfilled: BooleanArray,
+        values: Array<Any?>
     )
 
-    private external fun jniProcessPromiseQueue(context: Long)
+    private external fun jniRunJobs(context: Long, maxJobs: Int, maxMicros: Long): Boolean
+    private external fun jniGetDrainedJobCount(context: Long): Long
+    private external fun jniUpdateStackTop(context: Long)
+    private external fun jniGetJniIdLookupCount(): Long
+    private external fun jniEnableConsole(context: Long, mode: Int, minPriority: Int, useNativeLog: Boolean, maxMessagesPerSecond: Int)
+    private external fun jniEnableScriptCache(context: Long, maxEntryCount: Int, maxSourceLength: Int)
+    private external fun jniGetScriptCacheStats(context: Long): LongArray
+    private external fun jniEnableStringInterning(context: Long, maxEntryCount: Int, maxStringLength: Int)
+    private external fun jniGetStringInternStats(context: Long): LongArray
+    private external fun jniEnableTimers(context: Long)
+    private external fun jniRunTimers(context: Long)
+    private external fun jniNewWorkerChannel(): Long
+    private external fun jniShareWorkerChannel(channel: Long): Long
+    private external fun jniDeleteWorkerChannel(channel: Long)
+    private external fun jniSetUpWorkerEndpoint(context: Long, channel: Long, globalName: String, isWorker: Boolean)
+    private external fun jniDispatchWorkerMessages(context: Long, channel: Long, globalName: String, isWorker: Boolean)
 
     @Suppress("UNUSED_PARAMETER")
     private fun handleCoroutineException(context: CoroutineContext, t: Throwable) {
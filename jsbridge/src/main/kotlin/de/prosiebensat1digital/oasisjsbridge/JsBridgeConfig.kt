@@ -38,6 +38,8 @@ private constructor() {
     val jsDebuggerConfig = JsDebuggerConfig()
     val localStorageConfig = LocalStorageConfig()
     val jvmConfig = JvmConfig()
+    val scriptCacheConfig = ScriptCacheConfig()
+    val stringInternConfig = StringInternConfig()
 
     class SetTimeoutExtensionConfig {
         var enabled: Boolean = false
@@ -61,6 +63,16 @@ private constructor() {
 
         var enabled: Boolean = false
         var mode: Mode = Mode.AsString
+
+        // Messages with a lower priority (see android.util.Log) are dropped before being formatted
+        var minPriority: Int = Log.VERBOSE
+
+        // Write the messages directly to logcat from native code (appendMessage is then not called)
+        var useNativeLog: Boolean = false
+
+        // Messages above this rate are dropped and reported as a single warning (0 = no limit)
+        var maxMessagesPerSecond: Int = 0
+
         var appendMessage: (priority: Int, message: String) -> Unit = { priority, message ->
             Log.println(priority, "JavaScript", message)
         }
@@ -80,4 +92,28 @@ private constructor() {
     class JvmConfig {
         var customClassLoader: ClassLoader? = null
     }
+
+    // Cache of the compiled scripts given to evaluate(), JsValue.newFunction() and (Duktape only)
+    // JsValue(jsBridge, code), see JsBridge.getScriptCacheStats()
+    class ScriptCacheConfig {
+        var enabled: Boolean = false
+
+        // Least recently used scripts are evicted above this count
+        var maxEntryCount: Int = 128
+
+        // Longer scripts (UTF-8 bytes) are compiled but not cached
+        var maxSourceLength: Int = 16 * 1024
+    }
+
+    // Cache of the JS strings created from short Java strings which are sent over and over again
+    // (e.g. event names), see JsBridge.getStringInternStats()
+    class StringInternConfig {
+        var enabled: Boolean = false
+
+        // Least recently used strings are evicted above this count
+        var maxEntryCount: Int = 256
+
+        // Longer strings are not cached (max: 256)
+        var maxStringLength: Int = 64
+    }
 }
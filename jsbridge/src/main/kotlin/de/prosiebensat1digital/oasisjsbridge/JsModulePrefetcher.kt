@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import java.util.concurrent.ConcurrentHashMap
+import kotlinx.coroutines.*
+
+/**
+ * Prefetch of the ES modules statically imported by the loaded modules.
+ *
+ * The static imports ("import ... from", "import '...'" and "export ... from") of each loaded
+ * module are scanned and the imported modules are loaded in parallel on IO threads (and scanned in
+ * turn), so that the JS thread does not fetch the whole dependency graph serially. Module names
+ * are resolved relative to the importing module, like the QuickJS module name normalization.
+ *
+ * Note: the scan is best-effort (e.g. imports in comments are prefetched, too, and then evicted
+ * after the import pass, see [evictUnusedModules]) and the loader function is called from multiple
+ * threads.
+ */
+internal class JsModulePrefetcher(
+    private val loader: (moduleName: String) -> String,
+    parentJob: Job,
+) {
+    private val scope = CoroutineScope(SupervisorJob(parentJob) + Dispatchers.IO)
+
+    // Module name -> prefetched content, or LOADED once the module has been given to the JS engine
+    private val modules = ConcurrentHashMap<String, Deferred<String>>()
+
+    // Called in the JS thread by the JS module loader
+    fun load(moduleName: String): String {
+        val prefetched = modules.put(moduleName, LOADED)
+        if (prefetched != null && prefetched !== LOADED) {
+            return runBlocking { prefetched.await() }
+        }
+
+        return loader(moduleName).also { content ->
+            scope.launch { prefetchImports(moduleName, content) }
+        }
+    }
+
+    // Called in the JS thread once a top-level module has been evaluated (i.e. all its static
+    // imports have been loaded): the modules which were prefetched but not imported (e.g. because
+    // of an import in a comment) are dropped instead of being kept for the life of the context
+    fun evictUnusedModules() {
+        scope.coroutineContext.cancelChildren()
+        modules.values.removeAll { it !== LOADED }
+    }
+
+    // Prefetch the modules imported by the given module (e.g. the main module)
+    fun prefetchImports(moduleName: String, content: String) {
+        IMPORT_REGEX.findAll(content).forEach { match ->
+            val importedName = resolveModuleName(moduleName, match.groupValues[1])
+            if (modules.containsKey(importedName)) return@forEach
+
+            val deferred = scope.async(start = CoroutineStart.LAZY) {
+                loader(importedName).also { if (isActive) prefetchImports(importedName, it) }
+            }
+            if (modules.putIfAbsent(importedName, deferred) == null) {
+                deferred.start()
+            } else {
+                deferred.cancel()
+            }
+        }
+    }
+
+    companion object {
+        private val LOADED: Deferred<String> = CompletableDeferred("")
+
+        // Static imports and re-exports, e.g.: import a from "m", import { a } from 'm', import "m",
+        // export * from "m" (but not dynamic imports)
+        private val IMPORT_REGEX = Regex("""(?:^|[;}\s])(?:import|export)\s*(?:[\w*${'$'}{}\s,]*?\s*from\s*)?["']([^"'\s]+)["']""")
+
+        // Same as the QuickJS (default) module name normalization: "./" and "../" are resolved
+        // relative to the importing module, other names are kept as-is
+        internal fun resolveModuleName(baseName: String, moduleName: String): String {
+            if (!moduleName.startsWith(".")) return moduleName
+
+            var dirName = baseName.substringBeforeLast('/', "")
+            var name = moduleName
+            while (true) {
+                if (name.startsWith("./")) {
+                    name = name.substring(2)
+                } else if (name.startsWith("../")) {
+                    val lastSegment = dirName.substringAfterLast('/')
+                    if (dirName.isEmpty() || lastSegment == "." || lastSegment == "..") break
+                    dirName = dirName.substringBeforeLast('/', "")
+                    name = name.substring(3)
+                } else {
+                    break
+                }
+            }
+
+            return if (dirName.isEmpty()) name else "$dirName/$name"
+        }
+    }
+}
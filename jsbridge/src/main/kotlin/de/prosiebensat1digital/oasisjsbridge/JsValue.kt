@@ -215,7 +215,8 @@ internal constructor(
 
     /**
      * Delete a JsValue via deleting the associated (global) JS variable. This can either be
-     * called manually or automatically when the JsValue has been garbage-collected
+     * called manually or automatically when the JsValue has been garbage-collected.
+     * Can be called from any thread: released values are deleted in batches by the JS thread.
      */
     fun release() {
         val jsBridge = jsBridgeRef.get() ?: run {
@@ -250,6 +251,21 @@ internal constructor(
         jsBridge?.copyJsValue(globalName, this@JsValue)
     }
 
+    /**
+     * Structured clone of this value into a new JsValue of the given JsBridge, e.g. to move state
+     * between JS contexts without going through JSON. The value is serialized natively and never
+     * converted to Java objects.
+     *
+     * Supported: primitives, arrays, objects, Date, ArrayBuffer, typed arrays and DataView, Map and
+     * Set (QuickJS), including shared references and cycles. Functions and symbols cannot be cloned.
+     */
+    fun transferTo(jsBridge: JsBridge): JsValue {
+        val sourceJsBridge = this.jsBridge
+                ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot transfer JS value because the JS interpreter has been destroyed")
+
+        return jsBridge.readStructuredClone(this, sourceJsBridge)
+    }
+
     @OptIn(ExperimentalStdlibApi::class)
     suspend inline fun <reified T: Any?> evaluate(): T {
         val jsBridge = jsBridge
@@ -309,6 +325,83 @@ internal constructor(
     }
 
 
+    // Properties and calls
+    // ---
+    //
+    // These operations directly use the JS engine API instead of evaluating JS code generated from
+    // toString() (e.g. "$jsValue.key"), so that nothing has to be parsed and compiled.
+
+    /**
+     * Read a property of the JS value (e.g. an object key or an array index) and convert it to T.
+     */
+    @OptIn(ExperimentalStdlibApi::class)
+    suspend inline fun <reified T: Any?> getProperty(key: String): T {
+        val jsBridge = jsBridge
+                ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot get JS value property because the JS interpreter has been destroyed")
+
+        return jsBridge.getJsValueProperty(this, key, typeOf<T>(), true)
+    }
+
+    /**
+     * Convert the given value from T and assign it to a property of the JS value.
+     */
+    @OptIn(ExperimentalStdlibApi::class)
+    suspend inline fun <reified T: Any?> setProperty(key: String, value: T) {
+        val jsBridge = jsBridge
+                ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot set JS value property because the JS interpreter has been destroyed")
+
+        jsBridge.setJsValueProperty(this, key, value, Parameter(typeOf<T>(), jsBridge.customClassLoader))
+    }
+
+    /**
+     * Return true if the JS value is an object which has the given property (like the JS "in"
+     * operator).
+     */
+    suspend fun hasProperty(key: String): Boolean {
+        val jsBridge = jsBridge
+                ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot check JS value property because the JS interpreter has been destroyed")
+
+        return jsBridge.hasJsValueProperty(this, key)
+    }
+
+    /**
+     * Return the own enumerable keys of the JS value, like Object.keys() (empty for primitive
+     * values).
+     */
+    suspend fun keys(): List<String> {
+        val jsBridge = jsBridge
+                ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot get JS value keys because the JS interpreter has been destroyed")
+
+        return jsBridge.getJsValueKeys(this)
+    }
+
+    /**
+     * Call the JS value (which must be a function) and convert the result to R.
+     *
+     * The arguments are dynamically mapped like Any? values (string, number, boolean, array or
+     * wrapped Java object). JsValue arguments are mapped to their JS value.
+     */
+    @OptIn(ExperimentalStdlibApi::class)
+    suspend inline fun <reified R: Any?> callFunction(vararg args: Any?): R {
+        val jsBridge = jsBridge
+                ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot call JS value because the JS interpreter has been destroyed")
+
+        return jsBridge.callJsValue(this, null, args, typeOf<R>(), true)
+    }
+
+    /**
+     * Call the given method of the JS value (with the JS value as "this") and convert the result to
+     * R. The arguments are mapped like with callFunction().
+     */
+    @OptIn(ExperimentalStdlibApi::class)
+    suspend inline fun <reified R: Any?> callMethod(name: String, vararg args: Any?): R {
+        val jsBridge = jsBridge
+                ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot call JS value method because the JS interpreter has been destroyed")
+
+        return jsBridge.callJsValue(this, name, args, typeOf<R>(), true)
+    }
+
+
     // Proxy JS to Java object
     // ---
 
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import android.content.Context
+
+/**
+ * JS worker running a script in its own JsBridge (i.e. its own JS context and JS thread), so that
+ * JS code can be executed in parallel on multiple cores.
+ *
+ * Like Web Workers, the parent and the worker communicate via postMessage() and onmessage:
+ * - parent side: via the JS object given by [jsValue], e.g.:
+ *   `$jsValue.onmessage = function(e) { console.log(e.data); }; $jsValue.postMessage({ a: 1 });`
+ * - worker side: via the global postMessage() function and onmessage handler
+ *
+ * Messages are structured-cloned natively (in a compact binary form) and exchanged via lock-free
+ * queues: Java is only notified once per batch of messages to dispatch them in the JS thread of
+ * the receiving side.
+ *
+ * The worker shares the (process-wide) compiled module cache with its parent. The compiled
+ * script cache is per JS context, so the worker has its own one.
+ *
+ * @see JsBridge.createWorker
+ */
+class JsWorker
+internal constructor(
+    private val parentBridge: JsBridge,
+    script: String,
+    config: JsBridgeConfig,
+    context: Context,
+) {
+    /**
+     * JsBridge of the worker (e.g. to register error listeners or JS interfaces)
+     */
+    val workerBridge = JsBridge(config, context)
+
+    /**
+     * Worker object in the parent JsBridge, with postMessage() and onmessage
+     */
+    val jsValue = JsValue(parentBridge)
+
+    // Each JsBridge holds its own handle to the native channel
+    private val parentChannel = parentBridge.newWorkerChannel()
+    private val workerChannel = parentBridge.shareWorkerChannel(parentChannel)
+
+    init {
+        parentBridge.setUpWorkerEndpoint(this, parentChannel, jsValue)
+        workerBridge.setUpWorkerEndpoint(this, workerChannel, null)
+        workerBridge.evaluateUnsync(script)
+    }
+
+    /**
+     * Stop the worker: release its JsBridge and the worker object in the parent JsBridge
+     */
+    fun terminate() {
+        parentBridge.removeWorkerEndpoint(parentChannel)
+        jsValue.release()
+        workerBridge.release()
+    }
+
+    /**
+     * JS name of the worker object in the parent JsBridge (see JsValue.toString())
+     */
+    override fun toString() = jsValue.toString()
+
+    // Called (via JNI) by the JsBridge in which the message has been posted
+    internal fun onMessagePosted(from: JsBridge) {
+        if (from === workerBridge) {
+            parentBridge.dispatchWorkerMessages(parentChannel, jsValue)
+        } else {
+            workerBridge.dispatchWorkerMessages(workerChannel, null)
+        }
+    }
+}
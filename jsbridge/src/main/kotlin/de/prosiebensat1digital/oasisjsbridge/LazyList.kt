@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+// Opt-in alternative to List for the parameters and return values of the bridged methods:
+// - Java -> JS: JS gets a read-only array-like view of the list whose elements are fetched and
+//   converted on first access (and cached), instead of a JS array with all the converted elements.
+//   The size of the list is read on first access.
+//   The view inherits from Array.prototype but is not a real JS array (e.g. Array.isArray() returns
+//   false with QuickJS). Array.from() or slice() can be used to get a real JS array.
+// - JS -> Java: Java gets a read-only view of the JS array whose elements are converted on first
+//   access (and then cached). The JS array is kept alive as long as the list and its length is
+//   read once. If the JS value is a view of a Java list, the original LazyList is given back.
+//   Such a list is also given back to JS as the original JS array.
+class LazyList<out T>(val list: List<T>) : List<T> by list {
+    @Suppress("UNUSED")  // Called from JNI
+    private fun getJsArray(): JsValue? = (list as? JsArrayList<*>)?.jsArray
+
+    override fun equals(other: Any?) = list == (other as? LazyList<*>)?.list ?: other
+    override fun hashCode() = list.hashCode()
+    override fun toString() = list.toString()
+}
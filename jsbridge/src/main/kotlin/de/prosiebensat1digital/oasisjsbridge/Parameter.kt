@@ -18,6 +18,10 @@ package de.prosiebensat1digital.oasisjsbridge
 import com.google.gson.Gson
 import kotlin.reflect.*
 import kotlin.reflect.full.memberFunctions
+import kotlin.reflect.full.memberProperties
+import kotlin.reflect.full.primaryConstructor
+import kotlin.reflect.jvm.javaConstructor
+import kotlin.reflect.jvm.javaField
 
 // Represents a (reflected) function parameter (or return value) with its (optional) name based on:
 // - (ideally) Kotlin KParameter or KType which has the (full) reflection info
@@ -81,6 +85,62 @@ internal open class Parameter private constructor(
     }
 
 
+    // For data classes
+    // ---
+
+    // Primary constructor and matching properties of a Kotlin data class (or a @Serializable
+    // class whose primary constructor only has properties), null otherwise
+    //
+    // Note: kotlinx.serialization is not a dependency, the @Serializable annotation is detected
+    // by name
+    private val dataClassInfo: Pair<KFunction<*>, List<KProperty1<*, *>>>? by lazy {
+        val kotlinClass = (kotlinType?.classifier as? KClass<*>) ?: javaClass?.kotlin ?: return@lazy null
+        try {
+            val isSerializable = kotlinClass.annotations.any {
+                it.annotationClass.qualifiedName == "kotlinx.serialization.Serializable"
+            }
+            if (!kotlinClass.isData && !isSerializable) {
+                return@lazy null
+            }
+            if (kotlinClass.typeParameters.isNotEmpty()) {
+                // Generic data classes are not supported
+                return@lazy null
+            }
+
+            val constructor = kotlinClass.primaryConstructor ?: return@lazy null
+            val properties = constructor.parameters.map { kotlinParameter ->
+                kotlinClass.memberProperties.firstOrNull { it.name == kotlinParameter.name && it.javaField != null }
+                    ?: return@lazy null
+            }
+            Pair(constructor, properties)
+        } catch (t: Throwable) {
+            null
+        }
+    }
+
+    @Suppress("UNUSED")  // Called from JNI
+    fun isDataClass(): Boolean {
+        return dataClassInfo != null
+    }
+
+    @Suppress("UNUSED")  // Called from JNI
+    fun getDataClassConstructor(): java.lang.reflect.Constructor<*>? {
+        return dataClassInfo?.first?.javaConstructor
+    }
+
+    // Return the primary constructor parameters (with their name and type)
+    @Suppress("UNUSED")  // Called from JNI
+    fun getDataClassParameters(): Array<Parameter>? {
+        return dataClassInfo?.first?.parameters?.map { Parameter(it, customClassLoader) }?.toTypedArray()
+    }
+
+    // Return the backing fields of the primary constructor properties (in the same order)
+    @Suppress("UNUSED")  // Called from JNI
+    fun getDataClassFields(): Array<java.lang.reflect.Field>? {
+        return dataClassInfo?.second?.mapNotNull { it.javaField }?.toTypedArray()
+    }
+
+
     // For Lambdas
     // ---
 
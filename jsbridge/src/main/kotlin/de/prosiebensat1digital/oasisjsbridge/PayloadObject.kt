@@ -22,9 +22,10 @@ import java.util.*
 
 fun payloadObjectOf(vararg values: Pair<String, Any?>) = PayloadObject.fromValues(*values)
 
-class PayloadObject: Payload {
+// Note: the HashMap constructor and the values field are also used from JNI (Payload.cpp)
+class PayloadObject internal constructor(private val values: HashMap<String, Any?>): Payload {
 
-    private val values = HashMap<String, Any?>()
+    constructor(): this(HashMap())
 
     companion object {
         fun fromValues(vararg values: Pair<String, Any?>): PayloadObject = fromMap(hashMapOf(*values))
@@ -15,128 +15,24 @@
  */
 package de.prosiebensat1digital.oasisjsbridge.extensions
 
-import android.util.Log
 import de.prosiebensat1digital.oasisjsbridge.*
 
-// Still missing: trace functionality (currently: alias to debug)
-
-internal interface StringConsole : JsToJavaInterface {
-    fun log(vararg args: DebugString)
-    fun debug(vararg args: DebugString)
-    fun assert(assertion: Boolean, vararg args: DebugString)
-    fun trace(vararg args: DebugString)
-    fun info(vararg args: DebugString)
-    fun warn(vararg args: DebugString)
-    fun error(vararg args: DebugString)
-    fun exception(vararg args: DebugString)
-}
-
-internal interface JsonConsole : JsToJavaInterface {
-    fun log(vararg args: JsonObjectWrapper)
-    fun debug(vararg args: JsonObjectWrapper)
-    fun assert(assertion: Boolean, vararg args: JsonObjectWrapper)
-    fun trace(vararg args: JsonObjectWrapper)
-    fun info(vararg args: JsonObjectWrapper)
-    fun warn(vararg args: JsonObjectWrapper)
-    fun error(vararg args: JsonObjectWrapper)
-    fun exception(vararg args: JsonObjectWrapper)
-}
-
-internal interface EmptyConsole : JsToJavaInterface {
-    fun log(vararg args: Unit)
-    fun debug(vararg args: Unit)
-    fun assert(assertion: Boolean, vararg args: Unit)
-    fun trace(vararg args: Unit)
-    fun info(vararg args: Unit)
-    fun warn(vararg args: Unit)
-    fun error(vararg args: Unit)
-    fun exception(vararg args: Unit)
-}
-
+// The console object is natively implemented: messages are filtered (config.minPriority),
+// rate-limited (config.maxMessagesPerSecond) and formatted in the JS engine and then written in
+// batches via appendMessages().
 internal class ConsoleExtension(
     private val jsBridge: JsBridge,
     val config: JsBridgeConfig.ConsoleConfig
 ) {
-    private val consoleJsValue: JsValue
-
     init {
-        consoleJsValue = when (config.mode) {
-            JsBridgeConfig.ConsoleConfig.Mode.AsString -> createStringConsole()
-            JsBridgeConfig.ConsoleConfig.Mode.AsJson -> createJsonConsole()
-            JsBridgeConfig.ConsoleConfig.Mode.Empty -> createEmptyConsole()
-        }
-
-        consoleJsValue.assignToGlobal("console")
+        // Note: the native mode values match the Mode enum ordinals
+        jsBridge.enableConsole(config.mode.ordinal, config.minPriority, config.useNativeLog, config.maxMessagesPerSecond)
     }
 
-    private fun createStringConsole(): JsValue {
-        val consoleJavaObject = object: StringConsole {
-            override fun log(vararg args: DebugString) = message(Log.DEBUG, ds2s(args))
-            override fun debug(vararg args: DebugString) = message(Log.VERBOSE, ds2s(args))
-            override fun trace(vararg args: DebugString) = message(Log.VERBOSE, ds2s(args))
-            override fun info(vararg args: DebugString) = message(Log.INFO, ds2s(args))
-            override fun warn(vararg args: DebugString) = message(Log.WARN, ds2s(args))
-            override fun error(vararg args: DebugString) = message(Log.ERROR, ds2s(args))
-            override fun exception(vararg args: DebugString) = message(Log.ERROR, ds2s(args))
-
-            override fun assert(assertion: Boolean, vararg args: DebugString) {
-                if (!assertion) {
-                    message(Log.ASSERT, arrayOf("Assertion failed:", *ds2s(args)))
-                }
-            }
+    // Called in the JS thread
+    fun appendMessages(priorities: IntArray, messages: Array<String>) {
+        priorities.forEachIndexed { i, priority ->
+            config.appendMessage(priority, messages[i])
         }
-
-        return JsValue.createJsToJavaProxy(jsBridge, consoleJavaObject)
-    }
-
-    private fun createJsonConsole(): JsValue {
-        val consoleJavaObject = object: JsonConsole {
-            override fun log(vararg args: JsonObjectWrapper) = message(Log.DEBUG, j2s(args))
-            override fun debug(vararg args: JsonObjectWrapper) = message(Log.DEBUG, j2s(args))
-            override fun trace(vararg args: JsonObjectWrapper) = message(Log.DEBUG, j2s(args))
-            override fun info(vararg args: JsonObjectWrapper) = message(Log.INFO, j2s(args))
-            override fun warn(vararg args: JsonObjectWrapper) = message(Log.WARN, j2s(args))
-            override fun error(vararg args: JsonObjectWrapper) = message(Log.ERROR, j2s(args))
-            override fun exception(vararg args: JsonObjectWrapper) = message(Log.ERROR, j2s(args))
-
-            override fun assert(assertion: Boolean, vararg args: JsonObjectWrapper) {
-                if (!assertion) {
-                    message(Log.ASSERT, arrayOf("Assertion failed:", *j2s(args)))
-                }
-            }
-        }
-
-        return JsValue.createJsToJavaProxy(jsBridge, consoleJavaObject)
-    }
-
-    private fun createEmptyConsole(): JsValue {
-        val consoleJavaObject = object: EmptyConsole {
-            override fun log(vararg args: Unit) = Unit
-            override fun debug(vararg args: Unit) = Unit
-            override fun trace(vararg args: Unit) = Unit
-            override fun info(vararg args: Unit) = Unit
-            override fun warn(vararg args: Unit) = Unit
-            override fun error(vararg args: Unit) = Unit
-            override fun exception(vararg args: Unit) = Unit
-            override fun assert(assertion: Boolean, vararg args: Unit) = Unit
-        }
-
-        return JsValue.createJsToJavaProxy(jsBridge, consoleJavaObject)
-    }
-
-    private fun j2s(json: Array<out JsonObjectWrapper>): Array<out String> {
-        return json.map {
-            val jsonString = if (it == JsonObjectWrapper.Undefined) "undefined" else it.toString()
-            jsonString.replace("^\"(.*)\"$".toRegex(), "$1")  // remove quotes of simple strings
-        }.toTypedArray()
-    }
-
-    private fun ds2s(ds: Array<out DebugString>): Array<out String> {
-        return ds.map { it.string }.toTypedArray()
-    }
-
-    private fun message(priority: Int, args: Array<out String>) {
-        val message = args.joinToString(" ")
-        config.appendMessage(priority, message)
     }
 }